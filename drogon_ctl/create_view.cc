@@ -29,6 +29,9 @@ static const std::string cxx_val_start = "[[";
 static const std::string cxx_val_end = "]]";
 static const std::string sub_view_start = "<%view";
 static const std::string sub_view_end = "%>";
+static const std::string cxx_model = "<%model";
+static const std::string cxx_flush = "<%flush%>";
+static const std::string cxx_end_cache = "<%endcache%>";
 
 using namespace drogon_ctl;
 
@@ -52,6 +55,93 @@ static std::string &replace_all(std::string &str,
     }
     return str;
 }
+// The static text which is not written to the source file yet, consecutive
+// static fragments are merged into one string literal.
+static std::string staticText;
+static const size_t maxStaticTextLength = 16 * 1024;
+
+static void flushStaticText(std::ofstream &oSrcFile,
+                            const std::string &streamName)
+{
+    if (staticText.empty())
+        return;
+    oSrcFile << "\t" << streamName << ".write(\"";
+    for (size_t i = 0; i < staticText.length(); ++i)
+    {
+        auto c = staticText[i];
+        switch (c)
+        {
+            case '\\':
+                oSrcFile << "\\\\";
+                break;
+            case '"':
+                oSrcFile << "\\\"";
+                break;
+            case '\r':
+                oSrcFile << "\\r";
+                break;
+            case '\n':
+                oSrcFile << "\\n";
+                if (i + 1 < staticText.length())
+                    oSrcFile << "\"\n\t\t\"";
+                break;
+            default:
+                oSrcFile << c;
+                break;
+        }
+    }
+    oSrcFile << "\", " << staticText.length() << ");\n";
+    staticText.clear();
+}
+
+static void outputStaticText(std::ofstream &oSrcFile,
+                             const std::string &streamName,
+                             const std::string &text)
+{
+    staticText.append(text);
+    if (staticText.length() > maxStaticTextLength)
+        flushStaticText(oSrcFile, streamName);
+}
+
+// The name of the model variable of a view with a typed model, it's empty when
+// the view renders the HttpViewData only.
+static std::string modelName;
+
+// Translate the <%cache key ttl%> and <%endcache%> directives to c++ code. A
+// cached fragment is written to the stream directly, otherwise the fragment is
+// rendered into a separate stream (which hides the stream of the view in the
+// block), put into the ViewFragmentCache and then written to the stream.
+static std::string parseCacheDirectives(const std::string &line)
+{
+    static const std::regex re(
+        "<%cache[ \\t]+(((?!%>).)+?)[ \\t]+([^ \\t%]+)[ \\t]*%>");
+    std::string result;
+    std::smatch match;
+    auto begin = line.cbegin();
+    while (std::regex_search(begin, line.cend(), match, re))
+    {
+        result.append(begin, match[0].first);
+        result.append("<%c++ {drogon::OStringStream $$_fragment_key; "
+                      "$$_fragment_key<<(");
+        result.append(match[1].str());
+        result.append(
+            "); double $$_fragment_ttl=(" + match[3].str() +
+            "); auto $$_fragment=drogon::ViewFragmentCache::instance().get("
+            "$$_fragment_key.str()); if(!$$_fragment){ "
+            "drogon::OStringStream $$_fragment_stream; "
+            "{auto &$$=$$_fragment_stream;%>");
+        begin = match[0].second;
+    }
+    result.append(begin, line.cend());
+    replace_all(result,
+                cxx_end_cache,
+                "<%c++ } $$_fragment=drogon::ViewFragmentCache::instance()."
+                "put($$_fragment_key.str(), "
+                "std::move($$_fragment_stream.str()), $$_fragment_ttl);} "
+                "$$.write($$_fragment->data(), $$_fragment->size());}%>");
+    return result;
+}
+
 static void parseCxxLine(std::ofstream &oSrcFile,
                          const std::string &line,
                          const std::string &streamName,
@@ -59,6 +149,7 @@ static void parseCxxLine(std::ofstream &oSrcFile,
 {
     if (line.length() > 0)
     {
+        flushStaticText(oSrcFile, streamName);
         std::string tmp = line;
         replace_all(tmp, cxx_output, streamName);
         replace_all(tmp, cxx_view_data, viewDataName);
@@ -70,6 +161,14 @@ static void outputVal(std::ofstream &oSrcFile,
                       const std::string &viewDataName,
                       const std::string &keyName)
 {
+    flushStaticText(oSrcFile, streamName);
+    if (!modelName.empty())
+    {
+        // The field is resolved by the compiler, no lookup at runtime.
+        oSrcFile << "\t" << streamName << "<<" << modelName << "." << keyName
+                 << ";\n";
+        return;
+    }
     oSrcFile << "{\n";
     oSrcFile << "    auto & val=" << viewDataName << "[\"" << keyName
              << "\"];\n";
@@ -90,11 +189,12 @@ static void outputSubView(std::ofstream &oSrcFile,
                           const std::string &viewDataName,
                           const std::string &keyName)
 {
+    flushStaticText(oSrcFile, streamName);
     oSrcFile << "{\n";
     oSrcFile << "    auto templ=DrTemplateBase::newTemplate(\"" << keyName
              << "\");\n";
     oSrcFile << "    if(templ){\n";
-    oSrcFile << "      " << streamName << "<< templ->genText(" << viewDataName
+    oSrcFile << "      templ->renderTo(" << viewDataName << ", " << streamName
              << ");\n";
     oSrcFile << "    }\n";
     oSrcFile << "}\n";
@@ -114,7 +214,7 @@ static void parseLine(std::ofstream &oSrcFile,
         // std::cout<<"blank line!"<<std::endl;
         // std::cout<<streamName<<"<<\"\\n\";\n";
         if (returnFlag)
-            oSrcFile << streamName << "<<\"\\n\";\n";
+            outputStaticText(oSrcFile, streamName, "\n");
         return;
     }
     if (cxx_flag == 0)
@@ -206,15 +306,9 @@ static void parseLine(std::ofstream &oSrcFile,
             else
             {
                 if (line.length() > 0)
-                {
-                    replace_all(line, "\\", "\\\\");
-                    replace_all(line, "\"", "\\\"");
-                    oSrcFile << "\t" << streamName << " << \"" << line;
-                }
+                    outputStaticText(oSrcFile, streamName, line);
                 if (returnFlag)
-                    oSrcFile << "\\n\";\n";
-                else
-                    oSrcFile << "\";\n";
+                    outputStaticText(oSrcFile, streamName, "\n");
             }
         }
     }
@@ -296,8 +390,19 @@ int create_view::createViewFile(const std::string &script_filename)
             if (!oHeadFile || !oSourceFile)
                 return -1;
 
-            newViewHeaderFile(oHeadFile, className);
-            newViewSourceFile(oSourceFile, className, infile);
+            std::string modelType;
+            parseModel(infile, modelType, modelName);
+            std::string includes;
+            parseIncludes(infile, includes);
+            newViewHeaderFile(oHeadFile,
+                              className,
+                              modelType,
+                              modelType.empty() ? "" : includes);
+            newViewSourceFile(oSourceFile,
+                              className,
+                              infile,
+                              modelType,
+                              modelType.empty() ? includes : "");
         }
         else
             return -1;
@@ -309,53 +414,65 @@ int create_view::createViewFile(const std::string &script_filename)
     }
     return 0;
 }
-void create_view::newViewHeaderFile(std::ofstream &file,
-                                    const std::string &className)
+void create_view::parseModel(std::ifstream &infile,
+                             std::string &modelType,
+                             std::string &name)
 {
-    file << "//this file is generated by program automatically,don't modify "
-            "it!\n";
-    file << "#include <drogon/DrTemplate.h>\n";
-    file << "using namespace drogon;\n";
-    file << "class " << className << ":public DrTemplate<" << className
-         << ">\n";
-    file << "{\npublic:\n\t" << className << "(){};\n\tvirtual ~" << className
-         << "(){};\n\t"
-            "virtual std::string genText(const DrTemplateData &) override;\n};";
+    // <%model TypeName [variableName]%>, the variable name is "model" by
+    // default.
+    modelType.clear();
+    name.clear();
+    std::string buffer;
+    while (std::getline(infile, buffer))
+    {
+        auto pos = buffer.find(cxx_model);
+        if (pos == std::string::npos)
+            continue;
+        auto endPos = buffer.find(cxx_end, pos);
+        if (endPos == std::string::npos)
+        {
+            std::cerr << "format err!" << std::endl;
+            exit(1);
+        }
+        std::string decl = buffer.substr(pos + cxx_model.length(),
+                                         endPos - pos - cxx_model.length());
+        auto first = decl.find_first_not_of(" \t");
+        auto last = decl.find_last_not_of(" \t\r");
+        if (first == std::string::npos)
+        {
+            std::cerr << "format err!" << std::endl;
+            exit(1);
+        }
+        decl = decl.substr(first, last - first + 1);
+        // The last word is the variable name if it's an identifier, so that
+        // template types like std::map<int, int> work without a name.
+        auto space = decl.find_last_of(" \t");
+        if (space != std::string::npos)
+        {
+            auto word = decl.substr(space + 1);
+            if (std::all_of(word.begin(), word.end(), [](char c) {
+                    return isalnum((unsigned char)c) || c == '_';
+                }))
+            {
+                name = word;
+                decl = decl.substr(0, decl.find_last_not_of(" \t", space) + 1);
+            }
+        }
+        modelType = decl;
+        if (name.empty())
+            name = "model";
+        break;
+    }
+    infile.clear();
+    infile.seekg(0, std::ifstream::beg);
 }
-
-void create_view::newViewSourceFile(std::ofstream &file,
-                                    const std::string &className,
-                                    std::ifstream &infile)
+void create_view::parseIncludes(std::ifstream &infile, std::string &includes)
 {
-    file << "//this file is generated by program(drogon_ctl) "
-            "automatically,don't modify it!\n";
-    file << "#include \"" << className << ".h\"\n";
-    file << "#include <string>\n";
-    file << "#include <sstream>\n";
-    file << "#include <map>\n";
-    file << "#include <vector>\n";
-    file << "#include <set>\n";
-    file << "#include <iostream>\n";
-    file << "#include <unordered_map>\n";
-    file << "#include <unordered_set>\n";
-    file << "#include <algorithm>\n";
-    file << "#include <list>\n";
-    file << "#include <deque>\n";
-    file << "#include <queue>\n";
-
-    //    file << "using namespace std;\n";
-    //    file <<"void __attribute__((constructor)) startup()\n";
-    //    file <<"{std::cout<<\"dynamic lib start to load!\"<<std::endl;}\n";
-    //    file <<"void __attribute__((destructor)) shutdown()\n";
-    //    file <<"{std::cout<<\"dynamic lib start to unload!\"<<std::endl;}\n";
     std::string buffer;
-    char line[8192];
     int import_flag = 0;
 
-    while (infile.getline(line, sizeof(line)))
+    while (std::getline(infile, buffer))
     {
-        buffer = line;
-
         std::string::size_type pos(0);
 
         if (!import_flag)
@@ -367,67 +484,172 @@ void create_view::newViewSourceFile(std::ofstream &file,
                            ::tolower);
             if ((pos = lowerBuffer.find(cxx_include)) != std::string::npos)
             {
-                // std::cout<<"haha find it!"<<endl;
                 std::string newLine = buffer.substr(pos + cxx_include.length());
                 import_flag = 1;
                 if ((pos = newLine.find(cxx_end)) != std::string::npos)
                 {
                     newLine = newLine.substr(0, pos);
-                    file << newLine << "\n";
+                    includes.append(newLine).append("\n");
                     break;
                 }
                 else
                 {
-                    file << newLine << "\n";
+                    includes.append(newLine).append("\n");
                 }
             }
         }
         else
         {
-            // std::cout<<buffer<<endl;
             if ((pos = buffer.find(cxx_end)) != std::string::npos)
             {
                 std::string newLine = buffer.substr(0, pos);
-                file << newLine << "\n";
+                includes.append(newLine).append("\n");
 
                 break;
             }
             else
             {
-                // std::cout<<"to source file"<<buffer<<endl;
-                file << buffer << "\n";
+                includes.append(buffer).append("\n");
             }
         }
     }
-    // std::cout<<"import_flag="<<import_flag<<std::endl;
     if (import_flag == 0)
     {
         infile.clear();
         infile.seekg(0, std::ifstream::beg);
     }
+}
+void create_view::newViewHeaderFile(std::ofstream &file,
+                                    const std::string &className,
+                                    const std::string &modelType,
+                                    const std::string &includes)
+{
+    file << "//this file is generated by program automatically,don't modify "
+            "it!\n";
+    file << "#include <drogon/DrTemplate.h>\n";
+    // The model type must be complete in the header, so the included files of
+    // a view with a typed model are included here.
+    file << includes;
+    file << "using namespace drogon;\n";
+    file << "class " << className << ":public DrTemplate<" << className
+         << ">\n";
+    file << "{\npublic:\n\t";
+    if (!modelType.empty())
+        file << "using ModelType = " << modelType << ";\n\t";
+    file << className << "(){};\n\tvirtual ~" << className
+         << "(){};\n\t"
+            "virtual std::string genText(const DrTemplateData &) override;\n";
+    file << "\tvirtual void renderTo(const DrTemplateData &, "
+            "drogon::OStringStream &) override;\n";
+    if (!modelType.empty())
+    {
+        file << "\tstd::string genText(const ModelType &);\n";
+        file << "\tstd::string genText(const ModelType &, const "
+                "DrTemplateData &);\n";
+        file << "\tvoid renderTo(const ModelType &, const DrTemplateData &, "
+                "drogon::OStringStream &);\n";
+    }
+    file << "};";
+}
 
-    // std::cout<<"file pos:"<<infile.tellg()<<std::endl;
+void create_view::newViewSourceFile(std::ofstream &file,
+                                    const std::string &className,
+                                    std::ifstream &infile,
+                                    const std::string &modelType,
+                                    const std::string &includes)
+{
+    file << "//this file is generated by program(drogon_ctl) "
+            "automatically,don't modify it!\n";
+    file << "#include \"" << className << ".h\"\n";
+    file << "#include <drogon/ViewFragmentCache.h>\n";
+    file << "#include <drogon/utils/OStringStream.h>\n";
+    file << "#include <string>\n";
+    file << "#include <sstream>\n";
+    file << "#include <map>\n";
+    file << "#include <vector>\n";
+    file << "#include <set>\n";
+    file << "#include <iostream>\n";
+    file << "#include <unordered_map>\n";
+    file << "#include <unordered_set>\n";
+    file << "#include <algorithm>\n";
+    file << "#include <list>\n";
+    file << "#include <deque>\n";
+    file << "#include <queue>\n";
+    file << includes;
 
     std::string viewDataName = className + "_view_data";
-    // virtual std::string genText(const DrTemplateData &)
-    file << "std::string " << className << "::genText(const DrTemplateData& "
-         << viewDataName << ")\n{\n";
-    // std::string bodyName=className+"_bodystr";
     std::string streamName = className + "_tmp_stream";
-
-    // oSrcFile <<"\tstd::string "<<bodyName<<";\n";
-    file << "\tstd::stringstream " << streamName << ";\n";
+    // genText() renders the text into a string with the capacity learned from
+    // the previous renderings, renderTo() renders it into a stream.
+    auto outputGenText = [&](const std::string &params,
+                             const std::string &args) {
+        file << "std::string " << className << "::genText(" << params
+             << ")\n{\n";
+        file << "\tdrogon::OStringStream " << streamName << ";\n";
+        file << "\t" << streamName << ".reserve(capacityHint());\n";
+        file << "\trenderTo(" << args << streamName << ");\n";
+        file << "\tupdateCapacityHint(" << streamName << ".size());\n";
+        file << "\treturn std::move(" << streamName << ".str());\n}\n";
+    };
+    if (modelType.empty())
+    {
+        outputGenText("const DrTemplateData& " + viewDataName,
+                      viewDataName + ", ");
+        file << "void " << className << "::renderTo(const DrTemplateData& "
+             << viewDataName << ", drogon::OStringStream& " << streamName
+             << ")\n{\n";
+    }
+    else
+    {
+        // The model in the view data is used when the view is rendered by its
+        // name, e.g. by HttpResponse::newHttpViewResponse("view", data).
+        file << "std::string " << className
+             << "::genText(const DrTemplateData& " << viewDataName << ")\n{\n";
+        file << "\treturn genText(" << viewDataName << ".get<ModelType>(\""
+             << modelName << "\"), " << viewDataName << ");\n}\n";
+        file << "void " << className << "::renderTo(const DrTemplateData& "
+             << viewDataName << ", drogon::OStringStream& " << streamName
+             << ")\n{\n";
+        file << "\trenderTo(" << viewDataName << ".get<ModelType>(\""
+             << modelName << "\"), " << viewDataName << ", " << streamName
+             << ");\n}\n";
+        file << "std::string " << className << "::genText(const ModelType& "
+             << modelName << ")\n{\n";
+        file << "\treturn genText(" << modelName << ", DrTemplateData());\n}\n";
+        outputGenText("const ModelType& " + modelName +
+                          ", const DrTemplateData& " + viewDataName,
+                      modelName + ", " + viewDataName + ", ");
+        file << "void " << className << "::renderTo(const ModelType& "
+             << modelName << ", const DrTemplateData& " << viewDataName
+             << ", drogon::OStringStream& " << streamName << ")\n{\n";
+    }
     int cxx_flag = 0;
+    std::string buffer;
+    char line[8192];
     while (infile.getline(line, sizeof(line)))
     {
         buffer = line;
+        std::string::size_type pos;
+        if (!modelType.empty() &&
+            (pos = buffer.find(cxx_model)) != std::string::npos)
+        {
+            auto endPos = buffer.find(cxx_end, pos);
+            buffer.erase(pos, endPos + cxx_end.length() - pos);
+            if (buffer.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+        }
         if (buffer.length() > 0)
         {
+            replace_all(buffer, cxx_flush, "<%c++$$.flush();%>");
+            if (buffer.find("<%cache") != std::string::npos ||
+                buffer.find(cxx_end_cache) != std::string::npos)
+                buffer = parseCacheDirectives(buffer);
             std::regex re("\\{%[ \\t]*(((?!%\\}).)*[^ \\t])[ \\t]*%\\}");
             buffer = std::regex_replace(buffer, re, "<%c++$$$$<<$1;%>");
         }
         parseLine(file, buffer, streamName, viewDataName, cxx_flag);
     }
 
-    file << "return " << streamName << ".str();\n}\n";
+    flushStaticText(file, streamName);
+    file << "}\n";
 }
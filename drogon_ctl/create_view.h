@@ -32,9 +32,18 @@ class create_view : public DrObject<create_view>, public CommandHandler
     std::string outputPath_{"."};
     void createViewFiles(std::vector<std::string> &cspFileNames);
     int createViewFile(const std::string &script_filename);
-    void newViewHeaderFile(std::ofstream &file, const std::string &className);
+    void parseModel(std::ifstream &infile,
+                    std::string &modelType,
+                    std::string &name);
+    void parseIncludes(std::ifstream &infile, std::string &includes);
+    void newViewHeaderFile(std::ofstream &file,
+                           const std::string &className,
+                           const std::string &modelType,
+                           const std::string &includes);
     void newViewSourceFile(std::ofstream &file,
                            const std::string &className,
-                           std::ifstream &infile);
+                           std::ifstream &infile,
+                           const std::string &modelType,
+                           const std::string &includes);
 };
 }  // namespace drogon_ctl
@@ -0,0 +1,57 @@
+#include "CoroutineCtrl.h"
+
+// An asynchronous step which completes in the next iteration of the event
+// loop, like a database query or a http request would.
+static void asyncStep(int value, std::function<void(int)> &&callback)
+{
+    trantor::EventLoop::getEventLoopOfCurrentThread()->queueInLoop(
+        [value, callback = std::move(callback)]() { callback(value + 1); });
+}
+
+static HttpResponsePtr makeResponse(int value)
+{
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setBody("<p>Hello, world! " + std::to_string(value) + "</p>");
+    resp->setExpiredTime(0);
+    return resp;
+}
+
+void CoroutineCtrl::callback(
+    const HttpRequestPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback)
+{
+    asyncStep(0, [callback = std::move(callback)](int v1) mutable {
+        asyncStep(v1, [callback = std::move(callback)](int v2) mutable {
+            asyncStep(v2, [callback = std::move(callback)](int v3) {
+                callback(makeResponse(v3));
+            });
+        });
+    });
+}
+
+#ifdef __cpp_impl_coroutine
+class AsyncStepAwaiter : public CallbackAwaiter<int>
+{
+  public:
+    explicit AsyncStepAwaiter(int value) : value_(value)
+    {
+    }
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        setHandle(handle);
+        asyncStep(value_, [this](int v) { setValue(v); });
+        return suspend();
+    }
+
+  private:
+    int value_;
+};
+
+Task<HttpResponsePtr> CoroutineCtrl::coroutine(HttpRequestPtr req)
+{
+    auto v1 = co_await AsyncStepAwaiter(0);
+    auto v2 = co_await AsyncStepAwaiter(v1);
+    auto v3 = co_await AsyncStepAwaiter(v2);
+    co_return makeResponse(v3);
+}
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+#include <drogon/HttpController.h>
+using namespace drogon;
+/// Compare the overhead of a handler chaining three asynchronous steps with
+/// callbacks and with coroutines, e.g. run
+/// wrk -c 100 -d 10 http://127.0.0.1:7770/coro/callback
+/// wrk -c 100 -d 10 http://127.0.0.1:7770/coro/coroutine
+class CoroutineCtrl : public drogon::HttpController<CoroutineCtrl>
+{
+  public:
+    METHOD_LIST_BEGIN
+    METHOD_ADD(CoroutineCtrl::callback, "/callback", Get);
+#ifdef __cpp_impl_coroutine
+    METHOD_ADD(CoroutineCtrl::coroutine, "/coroutine", Get);
+#endif
+    METHOD_LIST_END
+    void callback(const HttpRequestPtr &req,
+                  std::function<void(const HttpResponsePtr &)> &&callback);
+#ifdef __cpp_impl_coroutine
+    Task<HttpResponsePtr> coroutine(HttpRequestPtr req);
+#endif
+};
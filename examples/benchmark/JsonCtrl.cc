@@ -3,8 +3,41 @@ void JsonCtrl::asyncHandleHttpRequest(
     const HttpRequestPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
-    Json::Value ret;
-    ret["message"] = "Hello, World!";
-    auto resp = HttpResponse::newHttpJsonResponse(ret);
+    if (req->path() == "/json")
+    {
+        Json::Value ret;
+        ret["message"] = "Hello, World!";
+        auto resp = HttpResponse::newHttpJsonResponse(ret);
+        callback(resp);
+        return;
+    }
+    Json::Value records(Json::arrayValue);
+    for (int i = 0; i < 100; ++i)
+    {
+        Json::Value record;
+        record["id"] = i;
+        record["name"] = "record " + std::to_string(i);
+        record["price"] = i * 1.25;
+        record["available"] = (i % 2 == 0);
+        record["tags"].append("benchmark");
+        record["tags"].append("json");
+        record["description"] = "A \"quoted\" description\nwith escapes";
+        records.append(std::move(record));
+    }
+    if (req->getParameter("writer") == "jsoncpp")
+    {
+        static std::once_flag once;
+        static Json::StreamWriterBuilder builder;
+        std::call_once(once, []() {
+            builder["commentStyle"] = "None";
+            builder["indentation"] = "";
+        });
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setContentTypeCode(CT_APPLICATION_JSON);
+        resp->setBody(Json::writeString(builder, records));
+        callback(resp);
+        return;
+    }
+    auto resp = HttpResponse::newHttpJsonResponse(std::move(records));
     callback(resp);
-}
\ No newline at end of file
+}
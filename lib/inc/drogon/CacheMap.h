@@ -293,6 +293,13 @@ class CacheMap
         std::lock_guard<std::mutex> lock(mtx_);
         map_.erase(key);
     }
+
+    /// Get the number of the values in the cache map.
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return map_.size();
+    }
     /**
      * @brief Get the event loop object
      *
@@ -42,6 +42,8 @@ class DrClassMap
      *
      * @param className The name of the class
      * @param func The function which can create a new instance of the class.
+     * @note Registering a class name again replaces the function, e.g. when a
+     * view is reloaded from a new shared library.
      */
     static void registerClass(const std::string &className,
                               const DrAllocFunc &func);
@@ -58,10 +60,10 @@ class DrClassMap
      * @brief Get the singleton object of the class named by className
      *
      * @param className The name of the class
-     * @return const std::shared_ptr<DrObjectBase>& The smart pointer to the
+     * @return std::shared_ptr<DrObjectBase> The smart pointer to the
      * instance.
      */
-    static const std::shared_ptr<DrObjectBase> &getSingleInstance(
+    static std::shared_ptr<DrObjectBase> getSingleInstance(
         const std::string &className);
 
     /**
@@ -83,7 +85,9 @@ class DrClassMap
     /**
      * @brief Set a singleton object into the map.
      *
-     * @param ins The smart pointer to the instance.
+     * @param ins The smart pointer to the instance, it replaces the previous
+     * instance of the same class. The users of the previous instance keep it
+     * until they release it.
      */
     static void setSingleInstance(const std::shared_ptr<DrObjectBase> &ins);
 
@@ -16,6 +16,8 @@
 
 #include <drogon/DrObject.h>
 #include <drogon/HttpViewData.h>
+#include <drogon/utils/OStringStream.h>
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -50,8 +52,46 @@ class DrTemplateBase : public virtual DrObjectBase
     virtual std::string genText(
         const DrTemplateData &data = DrTemplateData()) = 0;
 
+    /// Render the text into a stream
+    /**
+     * The views generated by drogon_ctl write the text into the stream
+     * directly, and so do their sub-views. If the stream has a sink, the parts
+     * flushed by the stream (or by the <%flush%> directive) are sent to the
+     * client while the rest of the page is being rendered. The default
+     * implementation writes the result of genText().
+     */
+    virtual void renderTo(const DrTemplateData &data, OStringStream &stream)
+    {
+        stream << genText(data);
+    }
+
     virtual ~DrTemplateBase(){};
     DrTemplateBase(){};
+
+  protected:
+    /// The capacity reserved for the output buffer of the next rendering,
+    /// which is learned from the lengths of the previous ones.
+    size_t capacityHint() const
+    {
+        return capacityHint_.load(std::memory_order_relaxed);
+    }
+
+    /// Update the capacity hint with the length of a rendered text.
+    /**
+     * The hint grows at once to a bit more than the largest length, and
+     * shrinks slowly when the texts get shorter.
+     */
+    void updateCapacityHint(size_t length)
+    {
+        auto hint = capacityHint_.load(std::memory_order_relaxed);
+        if (length > hint)
+            capacityHint_.store(length + length / 8, std::memory_order_relaxed);
+        else if (length < hint / 2)
+            capacityHint_.store(hint - hint / 16, std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<size_t> capacityHint_{0};
 };
 
 }  // namespace drogon
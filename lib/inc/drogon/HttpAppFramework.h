@@ -23,6 +23,8 @@
 #include <drogon/MultiPart.h>
 #include <drogon/NotFound.h>
 #include <drogon/drogon_callbacks.h>
+#include <drogon/utils/EventLoopStats.h>
+#include <drogon/utils/ServerState.h>
 #include <drogon/utils/Utilities.h>
 #include <drogon/plugins/Plugin.h>
 #include <drogon/HttpRequest.h>
@@ -93,6 +95,73 @@ class HttpAppFramework : public trantor::NonCopyable
      */
     virtual void quit() = 0;
 
+    /// Set the timeout of the graceful shutdown.
+    /**
+     * If the timeout is positive, quit() stops accepting new connections,
+     * closes the idle keep-alive connections and the websocket connections
+     * at once, and closes the other connections after their in-flight and
+     * pipelined responses are sent. The framework stops when all connections
+     * are closed or the timeout (in seconds) expires. The default value of 0
+     * means quit() stops the framework at once.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setGracefulShutdownTimeout(double timeout) = 0;
+
+    /// Enable the hot restart through a unix domain socket.
+    /**
+     * Drogon creates the listening sockets of the listeners without SSL
+     * itself, and waits for a new process on the unix socket. A new process
+     * started with the same path takes the listening sockets over by
+     * SCM_RIGHTS, so no connection queued on them is lost. When the new
+     * process accepts on them, the running one stops accepting, sends the
+     * responses of the requests on its connections and quits when they're
+     * closed or the timeout of the graceful shutdown (30 seconds if it's not
+     * set) expires.
+     *
+     * @param socketPath The path of the unix socket.
+     *
+     * @note
+     * Only available on Linux. The listeners with SSL are not handed over,
+     * the processes share their ports by SO_REUSEPORT.
+     * This operation can be performed by an option in the configuration file.
+     * It must be called before the framework runs.
+     */
+    virtual HttpAppFramework &enableHotRestart(
+        const std::string &socketPath) = 0;
+
+    /// Set the timeout of the requests.
+    /**
+     * The deadline of a request is the timeout after it's received. When it
+     * passes, the cancellation token of the request expires: the filters and
+     * the handlers not started yet are skipped with the 504 response, the
+     * commands queued in database clients for the request are dropped and its
+     * calls of HTTP clients are aborted, see CancellationToken.
+     *
+     * @param timeout The timeout in seconds, the default value of 0 means the
+     * requests have no deadline.
+     * @param pathPattern A regular expression, if it's not empty, the timeout
+     * only applies to the requests whose paths match it, instead of the
+     * default timeout. The first matching pattern applies.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setRequestTimeout(
+        double timeout,
+        const std::string &pathPattern = "") = 0;
+
+    /// Set the header carrying the timeout of a request in seconds, e.g.
+    /// "X-Request-Timeout", the smaller one of it and the timeout set by
+    /// setRequestTimeout() applies.
+    /**
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setRequestTimeoutHeader(
+        const std::string &header) = 0;
+
     /// Get the main event loop of the framework;
     /**
      * @note
@@ -627,6 +696,10 @@ class HttpAppFramework : public trantor::NonCopyable
      *
      * @param libPaths is a vactor that contains paths to view files.
      *
+     * The views are compiled and loaded when the application starts, then
+     * recompiled and reloaded in background threads when their files are
+     * modified. The modifications are watched by inotify on Linux.
+     *
      * @note
      * It is disabled by default.
      * This operation can be performed by an option in the configuration file.
@@ -816,6 +889,73 @@ class HttpAppFramework : public trantor::NonCopyable
     virtual HttpAppFramework &setPipeliningRequestsNumber(
         const size_t number) = 0;
 
+    /// Set the fraction of responses with the Server-Timing header.
+    /**
+     * The header of a sampled response carries the durations of the parse,
+     * queue, filters and handler stages of its request, e.g.
+     * "parse;dur=0.021, queue;dur=0.004, filters;dur=0.010, handler;dur=1.2"
+     * (in milliseconds), so they can be seen in the developer tools of
+     * browsers. The durations of all requests are recorded in the
+     * drogon_http_stage_duration_seconds histograms of the metrics registry.
+     *
+     * @param rate From 0 to 1, the default value of 0 means the header is
+     * never added.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setServerTimingSampleRate(double rate) = 0;
+
+    /// Enable the monitor of the health of the event loops.
+    /**
+     * The main loop, the IO loops and the loops of the database clients are
+     * monitored. A timer on every loop measures how late it fires (the lag)
+     * and how long a functor queued by it waits, the time of the loops is
+     * split into the I/O callbacks, the queued functors and the rest. See
+     * getEventLoopStats().
+     *
+     * @param interval The interval of the timer in seconds.
+     * @param watchdogThreshold If it's positive, a watchdog thread logs a
+     * warning when a loop is blocked longer than the threshold (in
+     * seconds), with the request being handled.
+     * @param dumpStacks If it's true, the blocked thread prints its stack to
+     * the standard error (Linux only). The SIGURG signal is used for it.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     * It must be called before the framework runs.
+     */
+    virtual HttpAppFramework &enableEventLoopMonitor(
+        double interval = 0.1,
+        double watchdogThreshold = 0.0,
+        bool dumpStacks = false) = 0;
+
+    /// Get the snapshots of the health of the event loops.
+    /**
+     * @note
+     * The result is empty if the monitor is not enabled.
+     */
+    virtual std::vector<EventLoopStats> getEventLoopStats() const = 0;
+
+    /// Take a snapshot of the runtime state of the framework asynchronously.
+    /**
+     * The state includes the connections and the pipelined requests of every
+     * IO loop, the connections and the waiting commands of every database
+     * client, the number of the sessions and the cached static files. Every
+     * IO loop takes the snapshot of its own structures in a functor queued to
+     * it, so the snapshot of a loop is consistent while the traffic isn't
+     * stopped.
+     *
+     * @param callback The callback is called with the state after all loops
+     * take their snapshots, in the thread of the last one.
+     *
+     * @note
+     * The IO loops and the fast database clients are not included if the
+     * framework isn't running.
+     */
+    virtual void getServerState(
+        const std::function<void(const ServerState &)> &callback) const = 0;
+
     /// Set the gzip_static option.
     /**
      * If it is set to true, when the client requests a static file, drogon
@@ -895,9 +1035,18 @@ class HttpAppFramework : public trantor::NonCopyable
      * @param filename The file name of sqlite3 database file.
      * @param name The client name.
      * @param isFast Indicates if the client is a fast database client.
+     * @param maxConnectionNum The maximum number of connections, if it is
+     * greater than the connectionNum, the pool grows when commands wait too
+     * long and shrinks when connections stay idle. It's valid only if @param
+     * isFast is false.
+     * @param keepaliveInterval If it is greater than 0, idle connections are
+     * pinged every keepaliveInterval seconds. It's valid only if @param isFast
+     * is false.
      *
      * @note
      * This operation can be performed by an option in the configuration file.
+     * Clients which are not in the fast mode are connected before the
+     * framework starts serving requests.
      */
     virtual HttpAppFramework &createDbClient(
         const std::string &dbType,
@@ -909,7 +1058,21 @@ class HttpAppFramework : public trantor::NonCopyable
         const size_t connectionNum = 1,
         const std::string &filename = "",
         const std::string &name = "default",
-        const bool isFast = false) = 0;
+        const bool isFast = false,
+        const size_t maxConnectionNum = 0,
+        const double keepaliveInterval = 0.0) = 0;
+
+    /// Set the timeout in seconds of waiting for the initial connections of
+    /// the database clients.
+    /**
+     * @param timeout The framework starts serving requests after the clients
+     * which are not in the fast mode are connected or the timeout expires. If
+     * it is 0, the framework doesn't wait. The default value is 5 seconds.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setDbWarmUpTimeout(double timeout) = 0;
 
     /// Get the DNS resolver
     /**
@@ -20,7 +20,9 @@
 #include <drogon/DrClassMap.h>
 #include <drogon/DrObject.h>
 #include <drogon/utils/FunctionTraits.h>
+#include <drogon/utils/JsonBinding.h>
 #include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
 #include <list>
 #include <memory>
 #include <sstream>
@@ -213,6 +215,37 @@ class HttpBinder : public HttpBinderBase
         value = std::stold(p);
     }
 
+    template <typename T>
+    typename std::enable_if<!IsJsonReflected<T>::value, bool>::type
+    getArgumentFromRequest(T &value, const HttpRequestPtr &req, size_t index)
+    {
+        try
+        {
+            value = req->as<T>();
+        }
+        catch (const std::exception &)
+        {
+            LOG_ERROR << "Error converting HttpRequest to the " << index
+                      << "th argument";
+        }
+        return true;
+    }
+
+    // The structs declared by DROGON_JSON_FIELDS are decoded from the json
+    // body directly, the request is rejected if the body doesn't match.
+    template <typename T>
+    typename std::enable_if<IsJsonReflected<T>::value, bool>::type
+    getArgumentFromRequest(T &value, const HttpRequestPtr &req, size_t index)
+    {
+        if (!fromJson(req->jsonView(), value))
+        {
+            LOG_ERROR << "Error converting the json body to the " << index
+                      << "th argument";
+            return false;
+        }
+        return true;
+    }
+
     template <typename... Values, std::size_t Boundary = argument_count>
     typename std::enable_if<(sizeof...(Values) < Boundary), void>::type run(
         std::list<std::string> &pathArguments,
@@ -226,6 +259,11 @@ class HttpBinder : public HttpBinderBase
             BinderArgTypeTraits<nth_argument_type<sizeof...(Values)>>::isValid,
             "your handler argument type must be value type or const left "
             "reference type or right reference type");
+        static_assert(!traits::isCoroutine ||
+                          !std::is_reference<
+                              nth_argument_type<sizeof...(Values)>>::value,
+                      "the argument types of a coroutine handler must be value "
+                      "types");
         using ValueType =
             typename std::remove_cv<typename std::remove_reference<
                 nth_argument_type<sizeof...(Values)>>::type>::type;
@@ -244,17 +282,12 @@ class HttpBinder : public HttpBinderBase
                           << sizeof...(Values) + 1 << "th argument";
             }
         }
-        else
+        else if (!getArgumentFromRequest(value, req, sizeof...(Values) + 1))
         {
-            try
-            {
-                value = req->as<ValueType>();
-            }
-            catch (const std::exception &)
-            {
-                LOG_ERROR << "Error converting HttpRequest to the "
-                          << sizeof...(Values) + 1 << "th argument";
-            }
+            auto resp = HttpResponse::newHttpResponse();
+            resp->setStatusCode(k400BadRequest);
+            callback(resp);
+            return;
         }
 
         run(pathArguments,
@@ -275,9 +308,11 @@ class HttpBinder : public HttpBinderBase
     template <typename... Values,
               bool isClassFunction = traits::isClassFunction,
               bool isDrObjectClass = traits::isDrObjectClass,
+              bool isCoroutine = traits::isCoroutine,
               bool isNormal = std::is_same<typename traits::first_param_type,
                                            HttpRequestPtr>::value>
-    typename std::enable_if<isClassFunction && !isDrObjectClass && isNormal,
+    typename std::enable_if<isClassFunction && !isDrObjectClass && isNormal &&
+                                !isCoroutine,
                             void>::type
     callFunction(const HttpRequestPtr &req,
                  std::function<void(const HttpResponsePtr &)> &&callback,
@@ -289,9 +324,11 @@ class HttpBinder : public HttpBinderBase
     template <typename... Values,
               bool isClassFunction = traits::isClassFunction,
               bool isDrObjectClass = traits::isDrObjectClass,
+              bool isCoroutine = traits::isCoroutine,
               bool isNormal = std::is_same<typename traits::first_param_type,
                                            HttpRequestPtr>::value>
-    typename std::enable_if<isClassFunction && isDrObjectClass && isNormal,
+    typename std::enable_if<isClassFunction && isDrObjectClass && isNormal &&
+                                !isCoroutine,
                             void>::type
     callFunction(const HttpRequestPtr &req,
                  std::function<void(const HttpResponsePtr &)> &&callback,
@@ -303,9 +340,11 @@ class HttpBinder : public HttpBinderBase
     }
     template <typename... Values,
               bool isClassFunction = traits::isClassFunction,
+              bool isCoroutine = traits::isCoroutine,
               bool isNormal = std::is_same<typename traits::first_param_type,
                                            HttpRequestPtr>::value>
-    typename std::enable_if<!isClassFunction && isNormal, void>::type
+    typename std::enable_if<!isClassFunction && isNormal && !isCoroutine,
+                            void>::type
     callFunction(const HttpRequestPtr &req,
                  std::function<void(const HttpResponsePtr &)> &&callback,
                  Values &&... values)
@@ -353,6 +392,69 @@ class HttpBinder : public HttpBinderBase
     {
         func_((*req), std::move(callback), std::move(values)...);
     }
+
+#ifdef __cpp_impl_coroutine
+    template <typename... Values, bool isCoroutine = traits::isCoroutine>
+    typename std::enable_if<isCoroutine, void>::type callFunction(
+        const HttpRequestPtr &req,
+        std::function<void(const HttpResponsePtr &)> &&callback,
+        Values &&... values)
+    {
+        handleCoroutine(callCoroutine(req, std::move(values)...),
+                        std::move(callback));
+    }
+    template <typename... Values,
+              bool isClassFunction = traits::isClassFunction,
+              bool isDrObjectClass = traits::isDrObjectClass>
+    typename std::enable_if<isClassFunction && !isDrObjectClass,
+                            Task<HttpResponsePtr>>::type
+    callCoroutine(const HttpRequestPtr &req, Values &&... values)
+    {
+        static auto &obj = getControllerObj<typename traits::class_type>();
+        return (obj.*func_)(req, std::move(values)...);
+    }
+    template <typename... Values,
+              bool isClassFunction = traits::isClassFunction,
+              bool isDrObjectClass = traits::isDrObjectClass>
+    typename std::enable_if<isClassFunction && isDrObjectClass,
+                            Task<HttpResponsePtr>>::type
+    callCoroutine(const HttpRequestPtr &req, Values &&... values)
+    {
+        static auto objPtr =
+            DrClassMap::getSingleInstance<typename traits::class_type>();
+        return (*objPtr.*func_)(req, std::move(values)...);
+    }
+    template <typename... Values,
+              bool isClassFunction = traits::isClassFunction>
+    typename std::enable_if<!isClassFunction, Task<HttpResponsePtr>>::type
+    callCoroutine(const HttpRequestPtr &req, Values &&... values)
+    {
+        return func_(req, std::move(values)...);
+    }
+    static AsyncTask handleCoroutine(
+        Task<HttpResponsePtr> task,
+        std::function<void(const HttpResponsePtr &)> callback)
+    {
+        HttpResponsePtr resp;
+        try
+        {
+            resp = co_await task;
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR << "Exception in the coroutine handler: " << e.what();
+            resp = HttpResponse::newHttpResponse();
+            resp->setStatusCode(k500InternalServerError);
+        }
+        catch (...)
+        {
+            LOG_ERROR << "Exception in the coroutine handler";
+            resp = HttpResponse::newHttpResponse();
+            resp->setStatusCode(k500InternalServerError);
+        }
+        callback(resp);
+    }
+#endif
 };
 
 }  // namespace internal
@@ -18,8 +18,10 @@
 #include <drogon/drogon_callbacks.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/HttpRequest.h>
+#include <drogon/utils/coroutine.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoop.h>
+#include <exception>
 #include <functional>
 #include <memory>
 #include <future>
@@ -29,6 +31,41 @@ namespace drogon
 class HttpClient;
 using HttpClientPtr = std::shared_ptr<HttpClient>;
 
+/// The exception thrown by the coroutine interface of HttpClient when a
+/// request fails.
+class HttpException : public std::exception
+{
+  public:
+    explicit HttpException(ReqResult result) : result_(result)
+    {
+    }
+    virtual const char *what() const noexcept override
+    {
+        switch (result_)
+        {
+            case ReqResult::BadResponse:
+                return "Bad response";
+            case ReqResult::NetworkFailure:
+                return "Network failure";
+            case ReqResult::BadServerAddress:
+                return "Bad server address";
+            case ReqResult::Timeout:
+                return "Timeout";
+            case ReqResult::Cancelled:
+                return "Cancelled";
+            default:
+                return "Unknown error";
+        }
+    }
+    ReqResult result() const
+    {
+        return result_;
+    }
+
+  private:
+    ReqResult result_;
+};
+
 /// Asynchronous http client
 /**
  * HttpClient implementation object uses the HttpAppFramework's event loop by
@@ -94,6 +131,34 @@ class HttpClient : public trantor::NonCopyable
         return f.get();
     }
 
+#ifdef __cpp_impl_coroutine
+    /**
+     * @brief Send a request to the server in a coroutine, co_await the
+     * returned object to get the response.
+     *
+     * @note An HttpException is thrown by co_await if the request fails. The
+     * awaiting coroutine is resumed in the event loop of the thread which
+     * awaited it.
+     */
+    auto sendRequestCoro(HttpRequestPtr req)
+    {
+        return internal::makeCallbackAwaiter<HttpResponsePtr>(
+            [this, req = std::move(req)](
+                CallbackAwaiter<HttpResponsePtr> &awaiter) {
+                sendRequest(req,
+                            [&awaiter](ReqResult result,
+                                       const HttpResponsePtr &resp) {
+                                if (result == ReqResult::Ok)
+                                    awaiter.setValue(resp);
+                                else
+                                    awaiter.setException(
+                                        std::make_exception_ptr(
+                                            HttpException(result)));
+                            });
+            });
+    }
+#endif
+
     /// Set the pipelining depth, which is the number of requests that are not
     /// responding.
     /**
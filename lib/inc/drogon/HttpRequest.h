@@ -20,6 +20,8 @@
 #include <drogon/Session.h>
 #include <drogon/Attribute.h>
 #include <drogon/UploadFile.h>
+#include <drogon/utils/CancellationToken.h>
+#include <drogon/utils/JsonView.h>
 #include <json/json.h>
 #include <trantor/net/InetAddress.h>
 #include <trantor/utils/Date.h>
@@ -278,6 +280,27 @@ class HttpRequest
         return creationDate();
     }
 
+    /// Get the cancellation token of the request.
+    /**
+     * The token of a request received by the server is cancelled when the
+     * connection is closed before the response is sent, and expires at the
+     * deadline of the request, see CancellationToken. It's nullptr for the
+     * requests created by users.
+     */
+    virtual const CancellationTokenPtr &cancellationToken() const = 0;
+    const CancellationTokenPtr &getCancellationToken() const
+    {
+        return cancellationToken();
+    }
+
+    /// Return true if the request is cancelled or its deadline has passed,
+    /// the response is useless then.
+    bool isCancelled() const
+    {
+        auto &token = cancellationToken();
+        return token && token->isCancelled();
+    }
+
     /// Get the Json object of the request
     /**
      * The content type of the request must be 'application/json', and the query
@@ -292,6 +315,24 @@ class HttpRequest
         return jsonObject();
     }
 
+    /// Get an on-demand view of the Json body of the request
+    /**
+     * The body is validated and indexed in one pass when the method is called
+     * for the first time, but no Json::Value tree is built, values are
+     * converted only when they are read. It's much faster than the
+     * jsonObject() method for handlers which read a few fields of a large
+     * body. The content type must be 'application/json', otherwise an invalid
+     * view is returned. The view refers to the body, so it must not be used
+     * after the request is destroyed.
+     */
+    virtual JsonView jsonView() const = 0;
+
+    /// Get an on-demand view of the Json body of the request
+    JsonView getJsonView() const
+    {
+        return jsonView();
+    }
+
     /// Get the content type
     virtual ContentType contentType() const = 0;
     ContentType getContentType() const
@@ -332,7 +373,15 @@ class HttpRequest
     /// Version: Http1.1
     /// Content type: application/json, the @param data is serialized into the
     /// content of the request.
-    static HttpRequestPtr newHttpJsonRequest(const Json::Value &data);
+    /**
+     * @param type If it's CT_APPLICATION_MSGPACK or CT_APPLICATION_CBOR, the
+     * data is encoded in the binary format instead of json, and the accept
+     * header of the request asks for a response in the same format. The
+     * jsonObject() method of the response decodes either format.
+     */
+    static HttpRequestPtr newHttpJsonRequest(
+        const Json::Value &data,
+        ContentType type = CT_APPLICATION_JSON);
 
     /// Create a http request with:
     /// Method: Post
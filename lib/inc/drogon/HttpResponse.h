@@ -18,7 +18,9 @@
 #include <drogon/Cookie.h>
 #include <drogon/HttpTypes.h>
 #include <drogon/HttpViewData.h>
+#include <drogon/utils/JsonBinding.h>
 #include <json/json.h>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -28,6 +30,9 @@ namespace drogon
 class HttpResponse;
 using HttpResponsePtr = std::shared_ptr<HttpResponse>;
 
+/// The function used by a streaming response to write a part of its body.
+using StreamWriter = std::function<void(const char *data, size_t length)>;
+
 /**
  * @brief This template is used to convert a response object to a custom
  * type object. Users must specialize the template for a particular type.
@@ -290,6 +295,26 @@ class HttpResponse
     /// to set/json.
     static HttpResponsePtr newHttpJsonResponse(const Json::Value &data);
     static HttpResponsePtr newHttpJsonResponse(Json::Value &&data);
+    /// Create a response which returns a json text serialized from an object
+    /// directly, without any intermediate Json::Value object.
+    /**
+     * @param obj The object, its type could be a struct declared by
+     * DROGON_JSON_FIELDS, an ORM model, or a container of them, see the
+     * appendJson() function.
+     */
+    template <typename T>
+    static typename std::enable_if<
+        !std::is_convertible<const T &, Json::Value>::value,
+        HttpResponsePtr>::type
+    newHttpJsonResponse(const T &obj)
+    {
+        auto res = newHttpResponse();
+        res->setContentTypeCode(CT_APPLICATION_JSON);
+        std::string body;
+        appendJson(obj, body);
+        res->setBody(std::move(body));
+        return res;
+    }
     /// Create a response that returns a page rendered by a view named
     /// viewName.
     /**
@@ -301,6 +326,53 @@ class HttpResponse
         const std::string &viewName,
         const HttpViewData &data = HttpViewData());
 
+    /// Create a response that streams a page rendered by a view named
+    /// viewName.
+    /**
+     * The page is sent in parts while it's being rendered, a part is sent
+     * when the <%flush%> directive is reached in the view or when 16KB of text
+     * are rendered. So the head of a large page arrives at the client before
+     * the rest of it is rendered.
+     * @param viewName The name of the view
+     * @param data is the data displayed on the page, it's copied into the
+     * response.
+     */
+    static HttpResponsePtr newStreamViewResponse(
+        const std::string &viewName,
+        const HttpViewData &data = HttpViewData());
+
+    /// Create a response whose body is produced while it's being sent.
+    /**
+     * @param producer is called when the response is sent, it writes the body
+     * part by part with the writer, and each part is sent to the client
+     * immediately as a chunk of the chunked transfer coding.
+     * @param type The content type of the response.
+     * @note The producer is called in the IO thread of the connection. The
+     * body is collected before it's sent when the client uses HTTP/1.0. A
+     * streaming response is never compressed and must not be cached.
+     */
+    static HttpResponsePtr newStreamResponse(
+        const std::function<void(const StreamWriter &)> &producer,
+        ContentType type = CT_TEXT_HTML);
+
+    /// Create a response that returns a page rendered by a view with a typed
+    /// model.
+    /**
+     * @tparam ViewType The class generated from a csp file which declares its
+     * model with the <%model TypeName [name]%> directive.
+     * @param model The model rendered by the view, its fields are accessed
+     * directly without any lookup in a HttpViewData object.
+     */
+    template <typename ViewType>
+    static HttpResponsePtr newHttpViewResponse(
+        const typename ViewType::ModelType &model)
+    {
+        static auto view = DrClassMap::getSingleInstance<ViewType>();
+        auto res = newHttpResponse();
+        res->setBody(view->genText(model));
+        return res;
+    }
+
     /// Create a response that returns a redirection page, redirecting to
     /// another page located in the location parameter.
     /**
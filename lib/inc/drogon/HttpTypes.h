@@ -95,7 +95,9 @@ enum ContentType
     CT_IMAGE_XICON,
     CT_IMAGE_ICNS,
     CT_IMAGE_BMP,
-    CT_MULTIPART_FORM_DATA
+    CT_MULTIPART_FORM_DATA,
+    CT_APPLICATION_MSGPACK,
+    CT_APPLICATION_CBOR
 };
 
 enum HttpMethod
@@ -115,7 +117,8 @@ enum class ReqResult
     BadResponse,
     NetworkFailure,
     BadServerAddress,
-    Timeout
+    Timeout,
+    Cancelled
 };
 
 enum class WebSocketMessageType
@@ -135,9 +135,13 @@ class HttpViewData
      * @code
        " --> &quot;
        & --> &amp;
+       ' --> &#39;
        < --> &lt;
        > --> &gt;
        @endcode
+     * The string is scanned 16 bytes at a time for the special characters
+     * where SSE2 is available, and the spans between them are appended at
+     * once.
      */
     static std::string htmlTranslate(const char *str, size_t length);
     static std::string htmlTranslate(const std::string &str)
@@ -148,44 +152,40 @@ class HttpViewData
     {
         return htmlTranslate(str.data(), str.length());
     }
+
+    /// Append the translated string to the output.
+    static void htmlTranslate(const char *str,
+                              size_t length,
+                              std::string &output);
+
+    /// Translate the string without copying it if it contains no special
+    /// characters.
+    /**
+     * @return The str parameter itself if it contains no special characters,
+     * otherwise a view of the translated string stored in the buffer.
+     */
+    static string_view htmlTranslate(const string_view &str,
+                                     std::string &buffer);
+
     static bool needTranslation(const std::string &str)
     {
-        for (auto const &c : str)
-        {
-            switch (c)
-            {
-                case '"':
-                case '&':
-                case '<':
-                case '>':
-                    return true;
-                default:
-                    continue;
-            }
-        }
-        return false;
+        return findSpecialChar(str.data(), str.data() + str.length()) !=
+               str.data() + str.length();
     }
     static bool needTranslation(const string_view &str)
     {
-        for (auto const &c : str)
-        {
-            switch (c)
-            {
-                case '"':
-                case '&':
-                case '<':
-                case '>':
-                    return true;
-                default:
-                    continue;
-            }
-        }
-        return false;
+        return findSpecialChar(str.data(), str.data() + str.length()) !=
+               str.data() + str.length();
     }
 
   protected:
     using ViewDataMap = std::unordered_map<std::string, any>;
     mutable ViewDataMap viewData_;
+
+  private:
+    /// Return the first special character in [str, end), or end if there is
+    /// none.
+    static const char *findSpecialChar(const char *str, const char *end);
 };
 
 }  // namespace drogon
@@ -0,0 +1,110 @@
+/**
+ *
+ *  ViewFragmentCache.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace drogon
+{
+/**
+ * @brief The cache of the fragments rendered by the <%cache key ttl%> ...
+ * <%endcache%> blocks in views.
+ *
+ * All views share one cache, so a fragment rendered by one view with a key is
+ * reused by the other views with the same key. The cache is bounded by the
+ * memory occupied by the fragments, the least recently used fragments are
+ * dropped when it's full. It's thread-safe, the keys are distributed into
+ * several shards which are locked separately.
+ */
+class ViewFragmentCache : public trantor::NonCopyable
+{
+  public:
+    static ViewFragmentCache &instance();
+
+    /// Get the fragment identified by the key, nullptr is returned if the
+    /// fragment is not cached or is expired.
+    std::shared_ptr<const std::string> get(const std::string &key);
+
+    /// Put a fragment into the cache.
+    /**
+     * @param key The key of the fragment.
+     * @param fragment The rendered text.
+     * @param timeout The fragment expires after the timeout (in seconds), if
+     * the timeout is 0, the fragment is only dropped when the cache is full or
+     * the fragment is invalidated.
+     * @return The cached fragment.
+     */
+    std::shared_ptr<const std::string> put(const std::string &key,
+                                           std::string &&fragment,
+                                           double timeout);
+
+    /// Drop the fragment identified by the key.
+    void invalidate(const std::string &key);
+
+    /// Drop all fragments whose keys start with the prefix.
+    void invalidatePrefix(const std::string &prefix);
+
+    /// Drop all fragments.
+    void clear();
+
+    /// Set the maximum memory (in bytes) occupied by the fragments, 32MB by
+    /// default.
+    void setCapacity(size_t capacity);
+
+    /// Get the memory (in bytes) occupied by the fragments.
+    size_t size() const;
+
+  private:
+    ViewFragmentCache() = default;
+    using Clock = std::chrono::steady_clock;
+    struct Entry
+    {
+        std::string key_;
+        std::shared_ptr<const std::string> fragment_;
+        Clock::time_point expiry_;
+        bool expires_;
+        size_t cost() const
+        {
+            // The key is stored twice, plus the overhead of the containers.
+            return 2 * key_.length() + fragment_->length() + 96;
+        }
+    };
+    struct Shard
+    {
+        mutable std::mutex mutex_;
+        std::list<Entry> entries_;  // The most recently used ones are first.
+        std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+        size_t size_{0};
+    };
+    static constexpr size_t shardsNumber = 16;
+
+    Shard &shardOf(const std::string &key)
+    {
+        return shards_[std::hash<std::string>{}(key) % shardsNumber];
+    }
+    static void erase(Shard &shard, std::list<Entry>::iterator iter);
+
+    Shard shards_[shardsNumber];
+    std::atomic<size_t> shardCapacity_{32 * 1024 * 1024 / shardsNumber};
+};
+
+}  // namespace drogon
@@ -24,10 +24,19 @@
 #include <drogon/HttpClient.h>
 #include <drogon/HttpController.h>
 #include <drogon/HttpSimpleController.h>
+#include <drogon/utils/CancellationToken.h>
+#include <drogon/utils/Metrics.h>
+#include <drogon/utils/Tracing.h>
 #include <drogon/utils/Utilities.h>
 #include <drogon/MultiPart.h>
 #include <drogon/plugins/Plugin.h>
+#include <drogon/plugins/AccessLogger.h>
+#include <drogon/plugins/ConcurrencyLimiter.h>
+#include <drogon/plugins/Profiler.h>
+#include <drogon/plugins/PrometheusExporter.h>
 #include <drogon/plugins/SecureSSLRedirector.h>
+#include <drogon/plugins/ServerStateExporter.h>
+#include <drogon/plugins/TraceFileExporter.h>
 #include <drogon/Cookie.h>
 #include <drogon/Session.h>
 #include <drogon/IOThreadStorage.h>
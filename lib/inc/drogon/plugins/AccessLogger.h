@@ -0,0 +1,194 @@
+/**
+ *
+ *  drogon_plugin_AccessLogger.h
+ *
+ */
+
+#pragma once
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpTypes.h>
+#include <drogon/IOThreadStorage.h>
+#include <drogon/plugins/Plugin.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief This plugin writes an access log of the responses sent by the HTTP
+ * servers, without going through the logger of the framework.
+ *
+ * The record of a response is formatted into a buffer of the IO thread
+ * sending it, a background thread takes the buffers of all IO threads and
+ * writes them to the file in batches.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+   {
+      "name": "drogon::plugin::AccessLogger",
+      "dependencies": [],
+      "config": {
+            "path": "./access.log",
+            "format": "text",
+            "fields": ["time", "remote_addr", "method", "path", "route",
+                       "status", "bytes", "latency", "user_agent"],
+            "sample_rate": 1.0,
+            "always_log_errors": true,
+            "buffer_size": 65536,
+            "flush_interval": 1.0,
+            "max_file_size": 0,
+            "max_files": 10
+      }
+   }
+   @endcode
+ *
+ * path: The log file, "./access.log" by default.
+ * format: "text" or "binary". A text record is a line of the fields separated
+ * by tabs, every text file starts with a "#fields:" line. A binary record is
+ * the size of the rest of the record (uint32_t) followed by the fields, the
+ * numbers are int64_t and the strings are their lengths (uint16_t) followed by
+ * their bytes, all in the native byte order.
+ * fields: The fields of a record in order:
+ * - time: When the request was received, e.g. 2020-01-01T00:00:00.000000Z
+ * in text, microseconds since the epoch in binary.
+ * - remote_addr: The IP address of the client.
+ * - method, path, user_agent: Those of the request.
+ * - route: The path pattern matched by the request, "-" (an empty string in
+ * binary) if there is none.
+ * - status: The status code of the response.
+ * - bytes: The size of the response, including the files sent by sendfile and
+ * the chunks of the streamed bodies.
+ * - latency: Microseconds from receiving the request to sending the response.
+ * sample_rate: The fraction of the responses which are logged.
+ * always_log_errors: Whether the responses with the 5xx codes are logged
+ * regardless of the sample rate.
+ * buffer_size: The size in bytes of the buffer of an IO thread, the
+ * background thread is woken up when it's exceeded. Records are dropped when
+ * the buffer grows to 16 times of the size because the file can't keep up.
+ * flush_interval: The interval in seconds at which the buffers are written.
+ * max_file_size: The file is rotated when it exceeds the size in bytes, 0
+ * means no rotation. The rotated files are named path.1 (the latest),
+ * path.2...
+ * max_files: The number of the rotated files kept.
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file.
+ *
+ */
+class AccessLogger : public drogon::Plugin<AccessLogger>
+{
+  public:
+    AccessLogger()
+    {
+    }
+    /// This method must be called by drogon to initialize and start the plugin.
+    /// It must be implemented by the user.
+    virtual void initAndStart(const Json::Value &config) override;
+
+    /// This method must be called by drogon to shutdown the plugin.
+    /// It must be implemented by the user.
+    virtual void shutdown() override;
+
+    /// The started access logger, nullptr if the plugin is not enabled.
+    static AccessLogger *current()
+    {
+        return current_.load(std::memory_order_acquire);
+    }
+
+    /// Log a response, called by the HTTP server in the IO thread sending it.
+    /**
+     * @param bytes The size of the response.
+     * @param latency The nanoseconds from receiving the request to sending
+     * the response.
+     */
+    void log(const HttpRequestPtr &req,
+             HttpStatusCode code,
+             size_t bytes,
+             int64_t latency);
+
+    /// The number of records dropped because the buffers were full.
+    uint64_t droppedRecords() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    enum Field
+    {
+        kTime,
+        kRemoteAddr,
+        kMethod,
+        kPath,
+        kRoute,
+        kStatus,
+        kBytes,
+        kLatency,
+        kUserAgent
+    };
+    struct ThreadBuffer
+    {
+        std::mutex mutex_;
+        std::string buffer_;
+        // Accessed by the IO thread only.
+        int64_t cachedSecond_{-1};
+        char cachedTime_[32]{0};
+    };
+
+    void appendText(ThreadBuffer &threadBuffer,
+                    const HttpRequestPtr &req,
+                    HttpStatusCode code,
+                    size_t bytes,
+                    int64_t latency) const;
+    void appendBinary(std::string &buffer,
+                      const HttpRequestPtr &req,
+                      HttpStatusCode code,
+                      size_t bytes,
+                      int64_t latency) const;
+    void run();
+    void flush();
+    void write(const std::string &data);
+    void openFile();
+    void rotate();
+
+    static std::atomic<AccessLogger *> current_;
+
+    std::string path_{"./access.log"};
+    bool binary_{false};
+    std::vector<Field> fields_;
+    double sampleRate_{1.0};
+    bool alwaysLogErrors_{true};
+    size_t bufferSize_{65536};
+    double flushInterval_{1.0};
+    size_t maxFileSize_{0};
+    size_t maxFiles_{10};
+
+    std::unique_ptr<IOThreadStorage<std::unique_ptr<ThreadBuffer>>> buffers_;
+    // The buffers of all threads, for the background thread.
+    std::vector<ThreadBuffer *> allBuffers_;
+    std::atomic<uint64_t> dropped_{0};
+
+    // Accessed by the background thread only (and by shutdown() after it
+    // stops).
+    FILE *file_{nullptr};
+    size_t fileSize_{0};
+    std::string spare_;
+    uint64_t reportedDrops_{0};
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stopping_{false};
+    std::atomic<bool> flushRequested_{false};
+    std::thread thread_;
+};
+
+}  // namespace plugin
+}  // namespace drogon
@@ -0,0 +1,178 @@
+/**
+ *
+ *  drogon_plugin_ConcurrencyLimiter.h
+ *
+ */
+
+#pragma once
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+#include <drogon/plugins/Plugin.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief This plugin limits the number of the requests being handled at the
+ * same time, and adapts the limits to the latencies of the responses. The
+ * requests over the limits are rejected with 503 before they're routed, so
+ * they don't pile up in the handlers and the queues of the database clients
+ * when a backend slows down.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+   {
+      "name": "drogon::plugin::ConcurrencyLimiter",
+      "dependencies": [],
+      "config": {
+            "algorithm": "gradient",
+            "initial_limit": 100,
+            "min_limit": 10,
+            "max_limit": 1000,
+            "window": 1.0,
+            "min_window_samples": 10,
+            "rtt_tolerance": 1.5,
+            "smoothing": 0.2,
+            "long_window": 100,
+            "latency_threshold": 0.5,
+            "backoff_ratio": 0.9,
+            "low_priority_ratio": 0.8,
+            "retry_after": 1,
+            "routes": [
+                {
+                    "path": "^/api/reports/",
+                    "initial_limit": 10,
+                    "max_limit": 50
+                }
+            ],
+            "priorities": [
+                {
+                    "path": "^/health$",
+                    "class": "critical"
+                },
+                {
+                    "path": "^/api/batch/",
+                    "method": "POST",
+                    "class": "low"
+                }
+            ]
+      }
+   }
+   @endcode
+ *
+ * algorithm: "gradient" or "aimd". Both adjust a limit at the end of every
+ * window of samples:
+ * - gradient: Compare the average latency of the window with the long term
+ * average, shrink the limit by their ratio when the latency grows, and grow
+ * it by its square root otherwise.
+ * - aimd: Multiply the limit by the backoff_ratio when the average latency of
+ * the window exceeds the latency_threshold, add 1 to it otherwise.
+ * The limit only grows when at least half of it is used.
+ * initial_limit, min_limit, max_limit: The limit of the concurrent requests
+ * starts from the initial one and stays in the range.
+ * window: The minimum duration in seconds of a window.
+ * min_window_samples: The minimum number of the responses in a window.
+ * rtt_tolerance: The gradient algorithm tolerates the latency growing up to
+ * the ratio of the long term average without shrinking the limit.
+ * smoothing: The weight of a new limit of the gradient algorithm against the
+ * current one.
+ * long_window: The number of the windows the long term average latency of the
+ * gradient algorithm is averaged over.
+ * latency_threshold: The latency threshold in seconds of the aimd algorithm.
+ * backoff_ratio: The ratio the aimd algorithm shrinks the limit by.
+ * low_priority_ratio: The requests of the low priority class are rejected
+ * when the limit is used over the ratio.
+ * retry_after: The value in seconds of the Retry-After header of the 503
+ * responses.
+ * routes: The routes with their own limiters, a request to one of them must
+ * be admitted by both its limiter and the global one. The path is a regular
+ * expression matched against the path of a request, the first matching one
+ * applies. The other options of a route default to the global ones.
+ * priorities: The priority classes of the requests, the first rule whose path
+ * (a regular expression) and method (any method if it's absent) match a
+ * request applies, other requests are of the normal class. The requests of
+ * the critical class, e.g. health checks, are never rejected.
+ *
+ * The limits, the requests being handled and the rejected requests are
+ * exported as the drogon_concurrency_limit, drogon_concurrency_in_flight and
+ * drogon_concurrency_rejected_requests_total metrics, labeled by the limiter
+ * ("global" or the path of a route).
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file.
+ *
+ */
+class ConcurrencyLimiter : public drogon::Plugin<ConcurrencyLimiter>
+{
+  public:
+    ConcurrencyLimiter();
+    ~ConcurrencyLimiter();
+
+    /// This method must be called by drogon to initialize and start the plugin.
+    /// It must be implemented by the user.
+    virtual void initAndStart(const Json::Value &config) override;
+
+    /// This method must be called by drogon to shutdown the plugin.
+    /// It must be implemented by the user.
+    virtual void shutdown() override;
+
+    /// The started limiter, nullptr if the plugin is not enabled.
+    static ConcurrencyLimiter *current()
+    {
+        return current_.load(std::memory_order_acquire);
+    }
+
+    /// Admit a request, called by the framework before routing it.
+    /**
+     * @return false if the request is rejected, the 503 response has been
+     * passed to the callback then. Otherwise the callback is wrapped to
+     * release the request from the limiters and sample its latency when it's
+     * called or destroyed.
+     */
+    bool admit(const HttpRequestPtr &req,
+               std::function<void(const HttpResponsePtr &)> &callback);
+
+  private:
+    enum Priority
+    {
+        kCritical,
+        kNormal,
+        kLow
+    };
+    class Limiter;
+    struct Permit;
+    struct RouteRule
+    {
+        std::regex regex_;
+        std::shared_ptr<Limiter> limiter_;
+    };
+    struct PriorityRule
+    {
+        std::regex regex_;
+        std::string method_;
+        Priority priority_;
+    };
+
+    Priority priority(const HttpRequestPtr &req) const;
+    void reject(
+        const std::function<void(const HttpResponsePtr &)> &callback) const;
+
+    static std::atomic<ConcurrencyLimiter *> current_;
+
+    double lowPriorityRatio_{0.8};
+    std::string retryAfter_{"1"};
+    std::shared_ptr<Limiter> global_;
+    std::vector<RouteRule> routes_;
+    std::vector<PriorityRule> priorities_;
+};
+
+}  // namespace plugin
+}  // namespace drogon
@@ -0,0 +1,139 @@
+/**
+ *
+ *  drogon_plugin_Profiler.h
+ *
+ */
+
+#pragma once
+#include <drogon/HttpRequest.h>
+#include <drogon/IOThreadStorage.h>
+#include <drogon/drogon_callbacks.h>
+#include <drogon/plugins/Plugin.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief This plugin profiles the running application on demand, through
+ * an admin endpoint.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+   {
+      "name": "drogon::plugin::Profiler",
+      "dependencies": [],
+      "config": {
+            "path": "/admin/profile",
+            "token": "a secret token",
+            "allow_remote": false,
+            "max_seconds": 60
+      }
+   }
+   @endcode
+ *
+ * path: The prefix of the endpoints, "/admin/profile" by default.
+ * token: The requests must carry the "Authorization: Bearer <token>" header,
+ * the plugin is disabled if it's empty.
+ * allow_remote: Whether the requests from other hosts than the localhost are
+ * accepted, false by default.
+ * max_seconds: The maximum duration of a profiling session.
+ *
+ * The endpoints are:
+ * - GET <path>/cpu?seconds=10&frequency=99: Sample the stacks of the main,
+ * IO and database client threads by timer signals firing at the frequency
+ * (in Hz) of the CPU time of each thread, for the seconds, then respond with
+ * the stacks in the folded format of the flamegraph tools, e.g.
+ * "io:0;main;trantor::EventLoop::loop();... 42". Only available on Linux.
+ * The functions of the executable are named only when it's linked with
+ * -rdynamic, otherwise they're shown as the offsets in it.
+ * - GET <path>/routes?seconds=10: Measure the CPU time the IO threads spend
+ * on routing and handling the requests of every route for the seconds, then
+ * respond with json.
+ * - GET <path>/allocations: Respond with the counts of the allocations of
+ * every thread since the start, in json. The allocations are counted only
+ * when drogon is built with the COUNT_ALLOCATIONS option.
+ *
+ * Only one session of cpu or routes runs at a time, the others get 409.
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file.
+ *
+ */
+class Profiler : public drogon::Plugin<Profiler>
+{
+  public:
+    Profiler();
+    ~Profiler();
+
+    /// This method must be called by drogon to initialize and start the plugin.
+    /// It must be implemented by the user.
+    virtual void initAndStart(const Json::Value &config) override;
+
+    /// This method must be called by drogon to shutdown the plugin.
+    /// It must be implemented by the user.
+    virtual void shutdown() override;
+
+    /// A scope in which an IO thread routes and handles a request, its CPU
+    /// time is accounted to the route of the request while routes are being
+    /// profiled.
+    class RouteCpuScope : public trantor::NonCopyable
+    {
+      public:
+        explicit RouteCpuScope(const HttpRequest &req)
+            : req_(req),
+              profiler_(routesProfiler_.load(std::memory_order_acquire))
+        {
+            if (profiler_)
+                start_ = threadCpuTime();
+        }
+        ~RouteCpuScope()
+        {
+            if (profiler_)
+                profiler_->addRouteCpuTime(req_, threadCpuTime() - start_);
+        }
+
+      private:
+        const HttpRequest &req_;
+        Profiler *profiler_;
+        int64_t start_{0};
+    };
+
+  private:
+    struct ThreadInfo;
+    struct RouteTimes;
+    class CpuSession;
+
+    /// The CPU time of the current thread in nanoseconds.
+    static int64_t threadCpuTime();
+    void addRouteCpuTime(const HttpRequest &req, int64_t cpuTime);
+
+    void handleRequest(const HttpRequestPtr &req,
+                       AdviceCallback &&callback,
+                       AdviceChainCallback &&chainCallback);
+    void profileCpu(double seconds, int frequency, AdviceCallback &&callback);
+    void profileRoutes(double seconds, AdviceCallback &&callback);
+    HttpResponsePtr allocations() const;
+
+    static std::atomic<Profiler *> routesProfiler_;
+
+    std::string path_{"/admin/profile"};
+    std::string token_;
+    bool allowRemote_{false};
+    double maxSeconds_{60.0};
+
+    std::vector<std::shared_ptr<ThreadInfo>> threads_;
+    std::unique_ptr<IOThreadStorage<std::unique_ptr<RouteTimes>>> routeTimes_;
+    // The route times of all threads, for collecting them.
+    std::vector<RouteTimes *> allRouteTimes_;
+    std::atomic<bool> busy_{false};
+};
+
+}  // namespace plugin
+}  // namespace drogon
@@ -0,0 +1,68 @@
+/**
+ *
+ *  drogon_plugin_PrometheusExporter.h
+ *
+ */
+
+#pragma once
+#include <drogon/drogon_callbacks.h>
+#include <drogon/plugins/Plugin.h>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief This plugin exposes the metrics of the MetricsRegistry in the
+ * Prometheus text format, including the metrics of HTTP requests recorded by
+ * the framework.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+   {
+      "name": "drogon::plugin::PrometheusExporter",
+      "dependencies": [],
+      "config": {
+            "path": "/metrics",
+            "buckets": [0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5]
+      }
+   }
+   @endcode
+ *
+ * path: The path of the metrics, "/metrics" by default. Only GET requests of
+ * the path are answered by the plugin.
+ * buckets: The upper bounds of the buckets of histograms in seconds. The
+ * histograms are recorded with finer buckets, which are folded into these
+ * ones when the metrics are scraped.
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file.
+ *
+ */
+class PrometheusExporter : public drogon::Plugin<PrometheusExporter>
+{
+  public:
+    PrometheusExporter()
+    {
+    }
+    /// This method must be called by drogon to initialize and start the plugin.
+    /// It must be implemented by the user.
+    virtual void initAndStart(const Json::Value &config) override;
+
+    /// This method must be called by drogon to shutdown the plugin.
+    /// It must be implemented by the user.
+    virtual void shutdown() override;
+
+  private:
+    HttpResponsePtr exportingAdvice(const HttpRequestPtr &) const;
+
+    std::string path_{"/metrics"};
+    std::vector<double> buckets_{
+        0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+};
+
+}  // namespace plugin
+}  // namespace drogon
@@ -0,0 +1,76 @@
+/**
+ *
+ *  drogon_plugin_ServerStateExporter.h
+ *
+ */
+
+#pragma once
+#include <drogon/HttpRequest.h>
+#include <drogon/drogon_callbacks.h>
+#include <drogon/plugins/Plugin.h>
+#include <drogon/utils/ServerState.h>
+#include <json/json.h>
+#include <string>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief This plugin exposes the runtime state of the framework (see
+ * HttpAppFramework::getServerState()) in json through an admin endpoint.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+   {
+      "name": "drogon::plugin::ServerStateExporter",
+      "dependencies": [],
+      "config": {
+            "path": "/admin/state",
+            "token": "a secret token",
+            "allow_remote": false
+      }
+   }
+   @endcode
+ *
+ * path: The path of the endpoint, "/admin/state" by default.
+ * token: The requests must carry the "Authorization: Bearer <token>" header,
+ * the plugin is disabled if it's empty.
+ * allow_remote: Whether the requests from other hosts than the localhost are
+ * accepted, false by default.
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file.
+ *
+ */
+class ServerStateExporter : public drogon::Plugin<ServerStateExporter>
+{
+  public:
+    ServerStateExporter()
+    {
+    }
+
+    /// This method must be called by drogon to initialize and start the plugin.
+    /// It must be implemented by the user.
+    virtual void initAndStart(const Json::Value &config) override;
+
+    /// This method must be called by drogon to shutdown the plugin.
+    /// It must be implemented by the user.
+    virtual void shutdown() override;
+
+    /// Convert a state to json.
+    static Json::Value toJson(const ServerState &state);
+
+  private:
+    void handleRequest(const HttpRequestPtr &req,
+                       AdviceCallback &&callback,
+                       AdviceChainCallback &&chainCallback);
+
+    std::string path_{"/admin/state"};
+    std::string token_;
+    bool allowRemote_{false};
+};
+
+}  // namespace plugin
+}  // namespace drogon
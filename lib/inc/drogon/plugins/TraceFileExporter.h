@@ -0,0 +1,88 @@
+/**
+ *
+ *  drogon_plugin_TraceFileExporter.h
+ *
+ */
+
+#pragma once
+#include <drogon/plugins/Plugin.h>
+#include <drogon/utils/Tracing.h>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief This plugin sets the sample rate of the Tracer and writes the spans
+ * recorded by it to a local file, one json object per line, e.g.
+ *
+ * @code
+   {"trace_id":"4bf92f3577b34da6a3ce929d0e0e4736","span_id":"a3ce929d0e0e4736",
+    "parent_id":"00f067aa0ba902b7","name":"sql","detail":"select 1",
+    "start":1600000000000000,"duration":350,"status":0}
+   @endcode
+ * (in one line), in which the start time is in microseconds since the epoch
+ * and the duration is in microseconds.
+ *
+ * The json configuration is as follows:
+ *
+ * @code
+   {
+      "name": "drogon::plugin::TraceFileExporter",
+      "dependencies": [],
+      "config": {
+            "path": "./trace.log",
+            "sample_rate": 0.01,
+            "flush_interval": 1.0
+      }
+   }
+   @endcode
+ *
+ * path: The file the spans are appended to, "./trace.log" by default.
+ * sample_rate: The fraction of the requests without a sampled traceparent
+ * header which are traced, 0.01 by default.
+ * flush_interval: The interval in seconds at which a background thread
+ * drains the spans and writes them, 1.0 by default.
+ *
+ * Enable the plugin by adding the configuration to the list of plugins in the
+ * configuration file.
+ *
+ */
+class TraceFileExporter : public drogon::Plugin<TraceFileExporter>
+{
+  public:
+    TraceFileExporter()
+    {
+    }
+    /// This method must be called by drogon to initialize and start the plugin.
+    /// It must be implemented by the user.
+    virtual void initAndStart(const Json::Value &config) override;
+
+    /// This method must be called by drogon to shutdown the plugin.
+    /// It must be implemented by the user.
+    virtual void shutdown() override;
+
+  private:
+    void run();
+    void writeSpans();
+
+    std::string path_{"./trace.log"};
+    double flushInterval_{1.0};
+    FILE *file_{nullptr};
+    std::vector<SpanData> spans_;
+    uint64_t reportedDrops_{0};
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stopping_{false};
+    std::thread thread_;
+};
+
+}  // namespace plugin
+}  // namespace drogon
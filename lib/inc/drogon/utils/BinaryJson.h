@@ -0,0 +1,57 @@
+/**
+ *
+ *  BinaryJson.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpTypes.h>
+#include <drogon/utils/JsonView.h>
+#include <drogon/utils/string_view.h>
+#include <json/json.h>
+#include <string>
+
+/// The codecs of the binary formats which carry the same data as json, the
+/// type parameters must be CT_APPLICATION_MSGPACK (MessagePack) or
+/// CT_APPLICATION_CBOR (CBOR, RFC 7049).
+namespace drogon
+{
+/// Encode a json value and append the result to the output.
+void encodeBinaryJson(const Json::Value &value,
+                      ContentType type,
+                      std::string &output);
+
+/// Encode the value of a json view and append the result to the output.
+void encodeBinaryJson(const JsonView &value,
+                      ContentType type,
+                      std::string &output);
+
+/// Decode a binary document into a json value.
+/**
+ * Binary strings are decoded as strings, map keys which are integers are
+ * converted to strings, and the tags of CBOR are ignored.
+ * @return false if the data is invalid or not representable by json, in which
+ * case the reason is stored into the errorMessage if it isn't null.
+ */
+bool decodeBinaryJson(const string_view &data,
+                      ContentType type,
+                      Json::Value &value,
+                      std::string *errorMessage = nullptr);
+
+/// Decode a binary document and append its json text to the output, so it
+/// can be read by a JsonView without building a Json::Value tree.
+bool binaryJsonToText(const string_view &data,
+                      ContentType type,
+                      std::string &output,
+                      std::string *errorMessage = nullptr);
+
+}  // namespace drogon
@@ -0,0 +1,131 @@
+/**
+ *
+ *  CancellationToken.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/Date.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace drogon
+{
+class CancellationToken;
+using CancellationTokenPtr = std::shared_ptr<CancellationToken>;
+
+/**
+ * @brief The cancellation state of a request, shared by the work done for it.
+ *
+ * The framework gives every request received by the server a token, which is
+ * cancelled when the connection is closed before the response is sent, and
+ * expires when the deadline of the request passes (see
+ * HttpAppFramework::setRequestTimeout()).
+ *
+ * The token of the request being handled is the current token of the IO
+ * thread, and the callbacks of the database clients and the HTTP clients are
+ * called with the token of the calls current, so the work started in them is
+ * bound to the request too. The commands queued in database clients for a
+ * cancelled request are dropped with the orm::CommandCancelled exception and
+ * its calls of HTTP clients are aborted with ReqResult::Cancelled (or
+ * ReqResult::Timeout when the deadline passes). The work which must be done
+ * regardless of the request can be started in a scope without a token:
+ * @code
+   {
+       CancellationToken::Scope scope(nullptr);
+       dbClient->execSqlAsync(...);
+   }
+   @endcode
+ */
+class CancellationToken
+    : public trantor::NonCopyable,
+      public std::enable_shared_from_this<CancellationToken>
+{
+  public:
+    /// Return true if the token is cancelled or its deadline has passed.
+    bool isCancelled() const
+    {
+        if (cancelled_.load(std::memory_order_acquire))
+            return true;
+        auto deadline = deadline_.load(std::memory_order_relaxed);
+        return deadline != 0 &&
+               trantor::Date::now().microSecondsSinceEpoch() >= deadline;
+    }
+
+    /// The deadline, an invalid date (0 microseconds) if there is none.
+    trantor::Date deadline() const
+    {
+        return trantor::Date(deadline_.load(std::memory_order_relaxed));
+    }
+
+    void setDeadline(const trantor::Date &deadline)
+    {
+        deadline_.store(deadline.microSecondsSinceEpoch(),
+                        std::memory_order_relaxed);
+    }
+
+    /// Cancel the token and call the callbacks in this thread.
+    void cancel();
+
+    /// Register a callback called when the token is cancelled, it's not
+    /// called when the deadline passes.
+    /**
+     * @return The id for removing the callback. If the token is cancelled
+     * already, the callback is not registered and 0 is returned.
+     */
+    uint64_t onCancel(std::function<void()> &&callback);
+
+    void removeCallback(uint64_t id);
+
+    /// Clear the token for a new request, it must not be shared.
+    void reset();
+
+    /// The token of the current thread, nullptr if there is none.
+    static CancellationToken *current()
+    {
+        return currentRef();
+    }
+
+    /// Make a token the current token of this thread in a scope.
+    class Scope : public trantor::NonCopyable
+    {
+      public:
+        explicit Scope(CancellationToken *token) : previous_(currentRef())
+        {
+            currentRef() = token;
+        }
+        ~Scope()
+        {
+            currentRef() = previous_;
+        }
+
+      private:
+        CancellationToken *previous_;
+    };
+
+  private:
+    static CancellationToken *&currentRef();
+
+    std::atomic<bool> cancelled_{false};
+    std::atomic<int64_t> deadline_{0};
+    std::mutex mutex_;
+    uint64_t nextCallbackId_{0};
+    std::vector<std::pair<uint64_t, std::function<void()>>> callbacks_;
+};
+
+}  // namespace drogon
@@ -0,0 +1,49 @@
+/**
+ *
+ *  EventLoopStats.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/utils/LatencyHistogram.h>
+#include <string>
+#include <stdint.h>
+
+namespace drogon
+{
+/// A snapshot of the health of an event loop, see
+/// HttpAppFramework::enableEventLoopMonitor().
+struct EventLoopStats
+{
+    /// "main", "io:<index>" or "db:<client name>:<index>".
+    std::string name_;
+    /// How late a timer firing every monitoring interval runs.
+    LatencySummary lag_;
+    /// How long a functor queued by queueInLoop() waits before it runs,
+    /// measured by a probe queued every monitoring interval.
+    LatencySummary queueDelay_;
+    /// The time (in seconds since the monitoring started) spent in the I/O
+    /// callbacks of the HTTP server, i.e. parsing, routing and the handlers
+    /// called in the loop.
+    double ioTime_{0.0};
+    /// The time spent in the functors queued by the framework, e.g. sending
+    /// the responses produced in other threads.
+    double functorTime_{0.0};
+    /// The rest of the time, mostly polling.
+    double pollTime_{0.0};
+    /// The ratio of the I/O and functor time in the last interval.
+    double busyRatio_{0.0};
+    /// The number of times the watchdog found the loop blocked.
+    uint64_t blocks_{0};
+};
+
+}  // namespace drogon
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <drogon/DrObject.h>
+#include <drogon/utils/coroutine.h>
 #include <functional>
 #include <memory>
 #include <tuple>
@@ -120,6 +121,22 @@ struct FunctionTraits<
     using first_param_type = T;
 };
 
+#ifdef __cpp_impl_coroutine
+// coroutine function for HTTP handling, the response is returned by the
+// coroutine. The request and the other parameters must be passed by value,
+// because they must stay valid after the coroutine is suspended.
+template <typename... Arguments>
+struct FunctionTraits<Task<HttpResponsePtr> (*)(HttpRequestPtr req,
+                                                Arguments...)>
+    : FunctionTraits<Task<HttpResponsePtr> (*)(Arguments...)>
+{
+    static const bool isHTTPFunction = true;
+    static const bool isCoroutine = true;
+    using class_type = void;
+    using first_param_type = HttpRequestPtr;
+};
+#endif
+
 // normal function
 template <typename ReturnType, typename... Arguments>
 struct FunctionTraits<ReturnType (*)(Arguments...)>
@@ -135,6 +152,7 @@ struct FunctionTraits<ReturnType (*)(Arguments...)>
     static const bool isHTTPFunction = false;
     static const bool isClassFunction = false;
     static const bool isDrObjectClass = false;
+    static const bool isCoroutine = false;
     static const std::string name()
     {
         return std::string("Normal or Static Function");
@@ -0,0 +1,560 @@
+/**
+ *
+ *  JsonBinding.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/utils/JsonView.h>
+#include <drogon/utils/string_view.h>
+#include <json/json.h>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Declare the fields of a struct which are converted from and to json
+ * directly, without any Json::Value object.
+ *
+ * Use the macro in the namespace of the struct, after its definition:
+ * @code
+   namespace api
+   {
+   struct User
+   {
+       int64_t id{0};
+       std::string name;
+       std::vector<std::string> tags;
+   };
+   DROGON_JSON_FIELDS(User, id, name, tags)
+   }
+   @endcode
+ * The name of a field is the name of its member. Up to 32 fields are
+ * supported, and a field could be of any type supported by the appendJson()
+ * and fromJson() functions below, including other declared structs. A struct
+ * declared by the macro can be a parameter of a handler, which is decoded from
+ * the json body of the request, and can be returned by the
+ * HttpResponse::newHttpJsonResponse() method.
+ */
+#define DROGON_JSON_FIELDS(Type, ...)                                        \
+    template <typename Visitor>                                              \
+    inline void drogonVisitJsonFields(Type &obj, Visitor &&visitor)          \
+    {                                                                        \
+        DROGON_JSON_INTERNAL_FOR_EACH(DROGON_JSON_INTERNAL_VISIT,            \
+                                      __VA_ARGS__)                           \
+    }                                                                        \
+    template <typename Visitor>                                              \
+    inline void drogonVisitJsonFields(const Type &obj, Visitor &&visitor)    \
+    {                                                                        \
+        DROGON_JSON_INTERNAL_FOR_EACH(DROGON_JSON_INTERNAL_VISIT,            \
+                                      __VA_ARGS__)                           \
+    }
+
+#define DROGON_JSON_INTERNAL_VISIT(field) visitor(#field, obj.field);
+#define DROGON_JSON_INTERNAL_EXPAND(x) x
+#define DROGON_JSON_INTERNAL_FOR_EACH_1(m, x) m(x)
+#define DROGON_JSON_INTERNAL_FOR_EACH_2(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_1(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_3(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_2(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_4(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_3(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_5(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_4(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_6(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_5(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_7(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_6(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_8(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_7(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_9(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_8(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_10(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_9(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_11(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_10(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_12(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_11(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_13(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_12(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_14(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_13(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_15(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_14(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_16(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_15(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_17(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_16(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_18(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_17(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_19(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_18(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_20(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_19(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_21(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_20(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_22(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_21(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_23(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_22(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_24(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_23(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_25(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_24(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_26(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_25(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_27(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_26(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_28(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_27(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_29(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_28(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_30(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_29(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_31(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_30(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_FOR_EACH_32(m, x, ...) \
+    m(x) DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_FOR_EACH_31(m, __VA_ARGS__))
+#define DROGON_JSON_INTERNAL_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, name, ...) name
+#define DROGON_JSON_INTERNAL_FOR_EACH(m, ...)                      \
+    DROGON_JSON_INTERNAL_EXPAND(DROGON_JSON_INTERNAL_SELECT(__VA_ARGS__, \
+    DROGON_JSON_INTERNAL_FOR_EACH_32, \
+    DROGON_JSON_INTERNAL_FOR_EACH_31, \
+    DROGON_JSON_INTERNAL_FOR_EACH_30, \
+    DROGON_JSON_INTERNAL_FOR_EACH_29, \
+    DROGON_JSON_INTERNAL_FOR_EACH_28, \
+    DROGON_JSON_INTERNAL_FOR_EACH_27, \
+    DROGON_JSON_INTERNAL_FOR_EACH_26, \
+    DROGON_JSON_INTERNAL_FOR_EACH_25, \
+    DROGON_JSON_INTERNAL_FOR_EACH_24, \
+    DROGON_JSON_INTERNAL_FOR_EACH_23, \
+    DROGON_JSON_INTERNAL_FOR_EACH_22, \
+    DROGON_JSON_INTERNAL_FOR_EACH_21, \
+    DROGON_JSON_INTERNAL_FOR_EACH_20, \
+    DROGON_JSON_INTERNAL_FOR_EACH_19, \
+    DROGON_JSON_INTERNAL_FOR_EACH_18, \
+    DROGON_JSON_INTERNAL_FOR_EACH_17, \
+    DROGON_JSON_INTERNAL_FOR_EACH_16, \
+    DROGON_JSON_INTERNAL_FOR_EACH_15, \
+    DROGON_JSON_INTERNAL_FOR_EACH_14, \
+    DROGON_JSON_INTERNAL_FOR_EACH_13, \
+    DROGON_JSON_INTERNAL_FOR_EACH_12, \
+    DROGON_JSON_INTERNAL_FOR_EACH_11, \
+    DROGON_JSON_INTERNAL_FOR_EACH_10, \
+    DROGON_JSON_INTERNAL_FOR_EACH_9, \
+    DROGON_JSON_INTERNAL_FOR_EACH_8, \
+    DROGON_JSON_INTERNAL_FOR_EACH_7, \
+    DROGON_JSON_INTERNAL_FOR_EACH_6, \
+    DROGON_JSON_INTERNAL_FOR_EACH_5, \
+    DROGON_JSON_INTERNAL_FOR_EACH_4, \
+    DROGON_JSON_INTERNAL_FOR_EACH_3, \
+    DROGON_JSON_INTERNAL_FOR_EACH_2, \
+    DROGON_JSON_INTERNAL_FOR_EACH_1)(m, __VA_ARGS__))
+
+namespace drogon
+{
+namespace internal
+{
+/// The writers used by the converters, they produce the same text as
+/// Json::StreamWriter.
+void appendJsonString(const char *str, size_t length, std::string &output);
+void appendJsonInt(int64_t value, std::string &output);
+void appendJsonUInt(uint64_t value, std::string &output);
+void appendJsonDouble(double value, std::string &output);
+void appendJsonValue(const Json::Value &value, std::string &output);
+
+template <typename T>
+struct IsJsonReflected
+{
+  private:
+    struct NullVisitor
+    {
+        template <typename Field>
+        void operator()(const char *, const Field &) const
+        {
+        }
+    };
+    template <typename U>
+    static auto test(U *p)
+        -> decltype(drogonVisitJsonFields(*p, std::declval<NullVisitor &>()),
+                    std::true_type());
+    template <typename>
+    static std::false_type test(...);
+
+  public:
+    static constexpr bool value = decltype(test<T>(nullptr))::value;
+};
+
+/// True for the classes which write themselves with an appendJson(std::string
+/// &) const method, such as the models of the ORM.
+template <typename T>
+struct HasAppendJson
+{
+  private:
+    template <typename U>
+    static auto test(const U *p)
+        -> decltype(p->appendJson(std::declval<std::string &>()),
+                    std::true_type());
+    template <typename>
+    static std::false_type test(...);
+
+  public:
+    static constexpr bool value = decltype(test<T>(nullptr))::value;
+};
+
+template <typename T, typename Enable = void>
+struct JsonCodec
+{
+    static_assert(sizeof(T) == 0,
+                  "The type can't be converted to json, declare its fields "
+                  "with DROGON_JSON_FIELDS");
+};
+
+template <>
+struct JsonCodec<bool>
+{
+    static void write(bool value, std::string &output)
+    {
+        if (value)
+            output.append("true", 4);
+        else
+            output.append("false", 5);
+    }
+    static bool read(const JsonView &json, bool &value)
+    {
+        if (!json.isBool())
+            return false;
+        value = json.asBool();
+        return true;
+    }
+};
+
+template <typename T>
+struct JsonCodec<T,
+                 typename std::enable_if<std::is_integral<T>::value &&
+                                         std::is_signed<T>::value &&
+                                         !std::is_same<T, bool>::value>::type>
+{
+    static void write(T value, std::string &output)
+    {
+        appendJsonInt(value, output);
+    }
+    static bool read(const JsonView &json, T &value)
+    {
+        if (!json.isNumber())
+            return false;
+        auto number = json.asInt64();
+        if (number < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+            number > static_cast<int64_t>(std::numeric_limits<T>::max()))
+            return false;
+        value = static_cast<T>(number);
+        return true;
+    }
+};
+
+template <typename T>
+struct JsonCodec<T,
+                 typename std::enable_if<std::is_integral<T>::value &&
+                                         std::is_unsigned<T>::value &&
+                                         !std::is_same<T, bool>::value>::type>
+{
+    static void write(T value, std::string &output)
+    {
+        appendJsonUInt(value, output);
+    }
+    static bool read(const JsonView &json, T &value)
+    {
+        if (!json.isNumber() || json.raw()[0] == '-')
+            return false;
+        auto number = json.asUInt64();
+        if (number > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+            return false;
+        value = static_cast<T>(number);
+        return true;
+    }
+};
+
+template <typename T>
+struct JsonCodec<
+    T,
+    typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static void write(T value, std::string &output)
+    {
+        appendJsonDouble(static_cast<double>(value), output);
+    }
+    static bool read(const JsonView &json, T &value)
+    {
+        if (!json.isNumber())
+            return false;
+        value = static_cast<T>(json.asDouble());
+        return true;
+    }
+};
+
+template <>
+struct JsonCodec<std::string>
+{
+    static void write(const std::string &value, std::string &output)
+    {
+        appendJsonString(value.data(), value.length(), output);
+    }
+    static bool read(const JsonView &json, std::string &value)
+    {
+        if (!json.isString())
+            return false;
+        value = json.asString();
+        return true;
+    }
+};
+
+template <>
+struct JsonCodec<string_view>
+{
+    static void write(const string_view &value, std::string &output)
+    {
+        appendJsonString(value.data(), value.length(), output);
+    }
+};
+
+template <>
+struct JsonCodec<Json::Value>
+{
+    static void write(const Json::Value &value, std::string &output)
+    {
+        appendJsonValue(value, output);
+    }
+    static bool read(const JsonView &json, Json::Value &value)
+    {
+        value = json.toJsonValue();
+        return true;
+    }
+};
+
+template <typename T>
+struct JsonCodec<std::shared_ptr<T>>
+{
+    static void write(const std::shared_ptr<T> &value, std::string &output)
+    {
+        if (value)
+            JsonCodec<typename std::remove_cv<T>::type>::write(*value, output);
+        else
+            output.append("null", 4);
+    }
+    static bool read(const JsonView &json, std::shared_ptr<T> &value)
+    {
+        if (json.isNull())
+        {
+            value.reset();
+            return true;
+        }
+        auto object = std::make_shared<T>();
+        if (!JsonCodec<T>::read(json, *object))
+            return false;
+        value = std::move(object);
+        return true;
+    }
+};
+
+template <typename T, typename Alloc>
+struct JsonCodec<std::vector<T, Alloc>>
+{
+    static void write(const std::vector<T, Alloc> &value, std::string &output)
+    {
+        output.push_back('[');
+        bool first = true;
+        for (auto const &item : value)
+        {
+            if (!first)
+                output.push_back(',');
+            first = false;
+            JsonCodec<T>::write(item, output);
+        }
+        output.push_back(']');
+    }
+    static bool read(const JsonView &json, std::vector<T, Alloc> &value)
+    {
+        if (!json.isArray())
+            return false;
+        value.clear();
+        value.reserve(json.size());
+        bool ok = true;
+        json.forEachElement([&value, &ok](const JsonView &element) {
+            value.emplace_back();
+            if (ok && !JsonCodec<T>::read(element, value.back()))
+                ok = false;
+        });
+        return ok;
+    }
+};
+
+template <typename Map>
+struct JsonMapCodec
+{
+    static void write(const Map &value, std::string &output)
+    {
+        output.push_back('{');
+        bool first = true;
+        for (auto const &pair : value)
+        {
+            if (!first)
+                output.push_back(',');
+            first = false;
+            appendJsonString(pair.first.data(), pair.first.length(), output);
+            output.push_back(':');
+            JsonCodec<typename Map::mapped_type>::write(pair.second, output);
+        }
+        output.push_back('}');
+    }
+    static bool read(const JsonView &json, Map &value)
+    {
+        if (!json.isObject())
+            return false;
+        value.clear();
+        bool ok = true;
+        json.forEachMember(
+            [&value, &ok](const std::string &key, const JsonView &member) {
+                if (ok &&
+                    !JsonCodec<typename Map::mapped_type>::read(member,
+                                                                value[key]))
+                    ok = false;
+            });
+        return ok;
+    }
+};
+
+template <typename T, typename Compare, typename Alloc>
+struct JsonCodec<std::map<std::string, T, Compare, Alloc>>
+    : public JsonMapCodec<std::map<std::string, T, Compare, Alloc>>
+{
+};
+
+template <typename T, typename Hash, typename Equal, typename Alloc>
+struct JsonCodec<std::unordered_map<std::string, T, Hash, Equal, Alloc>>
+    : public JsonMapCodec<
+          std::unordered_map<std::string, T, Hash, Equal, Alloc>>
+{
+};
+
+struct JsonFieldWriter
+{
+    template <typename Field>
+    void operator()(const char *name, const Field &field)
+    {
+        output_.push_back(first_ ? '{' : ',');
+        first_ = false;
+        // The names of the fields are identifiers, which need no escaping.
+        output_.push_back('"');
+        output_.append(name);
+        output_.append("\":", 2);
+        JsonCodec<Field>::write(field, output_);
+    }
+    std::string &output_;
+    bool first_;
+};
+
+struct JsonFieldReader
+{
+    template <typename Field>
+    void operator()(const char *name, Field &field)
+    {
+        auto member = json_[name];
+        // Missing fields and null fields keep their default values.
+        if (!member.isValid() || member.isNull())
+            return;
+        if (ok_ && !JsonCodec<Field>::read(member, field))
+            ok_ = false;
+    }
+    const JsonView &json_;
+    bool ok_;
+};
+
+template <typename T>
+struct JsonCodec<T, typename std::enable_if<IsJsonReflected<T>::value>::type>
+{
+    static void write(const T &value, std::string &output)
+    {
+        JsonFieldWriter writer{output, true};
+        drogonVisitJsonFields(value, writer);
+        if (writer.first_)
+            output.append("{}", 2);
+        else
+            output.push_back('}');
+    }
+    static bool read(const JsonView &json, T &value)
+    {
+        if (!json.isObject())
+            return false;
+        JsonFieldReader reader{json, true};
+        drogonVisitJsonFields(value, reader);
+        return reader.ok_;
+    }
+};
+
+template <typename T>
+struct JsonCodec<T,
+                 typename std::enable_if<HasAppendJson<T>::value &&
+                                         !IsJsonReflected<T>::value>::type>
+{
+    static void write(const T &value, std::string &output)
+    {
+        value.appendJson(output);
+    }
+};
+
+}  // namespace internal
+
+/// Serialize the value and append it to the output.
+/**
+ * Supported types are bool, integers, floating point numbers, std::string,
+ * string_view, Json::Value, std::shared_ptr (a null pointer is written as
+ * null), std::vector, std::map and std::unordered_map with string keys, the
+ * structs declared by DROGON_JSON_FIELDS and the classes with an
+ * appendJson(std::string &) const method, such as the ORM models.
+ */
+template <typename T>
+void appendJson(const T &value, std::string &output)
+{
+    internal::JsonCodec<T>::write(value, output);
+}
+
+/// Serialize the value into a new string.
+template <typename T>
+std::string toJsonString(const T &value)
+{
+    std::string output;
+    appendJson(value, output);
+    return output;
+}
+
+/// Convert a json value to the value of type T.
+/**
+ * @return false if the json value doesn't match the type, in which case the
+ * value may be partially modified. The members of a struct which are missing
+ * or null in the json value keep their values. Numbers with a fraction are
+ * truncated when they are converted to integers, and integers which are out of
+ * range are mismatches.
+ */
+template <typename T>
+bool fromJson(const JsonView &json, T &value)
+{
+    return internal::JsonCodec<T>::read(json, value);
+}
+
+}  // namespace drogon
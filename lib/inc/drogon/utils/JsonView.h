@@ -0,0 +1,161 @@
+/**
+ *
+ *  JsonView.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/utils/string_view.h>
+#include <json/json.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <stdint.h>
+
+namespace drogon
+{
+namespace internal
+{
+struct JsonIndex;
+}
+
+/**
+ * @brief A read-only view of a json text, whose values are converted on demand.
+ *
+ * Parsing a text validates it and builds an index of the positions of its
+ * values in one pass, nothing is copied or allocated per value. Then a member
+ * of an object or an element of an array is found by skipping the other values
+ * via the index, and a value is converted to a string or a number only when
+ * it's read. For example:
+ * @code
+   auto json = req->jsonView();
+   if (json["user"]["id"].isNumber())
+       auto id = json["user"]["id"].asInt64();
+   @endcode
+ * Accessing a missing member or element returns an invalid view instead of
+ * throwing an exception, so it can be chained. All views of a text share the
+ * index, and the text must outlive them.
+ */
+class JsonView
+{
+  public:
+    enum Type
+    {
+        kInvalid = 0,
+        kNull,
+        kBool,
+        kNumber,
+        kString,
+        kArray,
+        kObject
+    };
+
+    /// Parse a json text.
+    /**
+     * @param text The json text, it must outlive the returned view.
+     * @param errorMessage If it isn't null, the reason of a failure is stored
+     * into it.
+     * @return The view of the root value, or an invalid view if the text is
+     * not valid json.
+     */
+    static JsonView parse(const string_view &text,
+                          std::string *errorMessage = nullptr);
+
+    JsonView() = default;
+
+    Type type() const;
+    bool isValid() const
+    {
+        return index_ != nullptr;
+    }
+    explicit operator bool() const
+    {
+        return isValid();
+    }
+    bool isNull() const
+    {
+        return type() == kNull;
+    }
+    bool isBool() const
+    {
+        return type() == kBool;
+    }
+    bool isNumber() const
+    {
+        return type() == kNumber;
+    }
+    bool isString() const
+    {
+        return type() == kString;
+    }
+    bool isArray() const
+    {
+        return type() == kArray;
+    }
+    bool isObject() const
+    {
+        return type() == kObject;
+    }
+
+    /// The number of the members of an object or the elements of an array, 0
+    /// for other values.
+    size_t size() const;
+
+    /// Get a member of an object, an invalid view is returned if the view is
+    /// not an object or the member doesn't exist.
+    JsonView operator[](const string_view &key) const;
+    JsonView operator[](const char *key) const
+    {
+        return (*this)[string_view(key)];
+    }
+    /// Get an element of an array, an invalid view is returned if the view is
+    /// not an array or the index is out of range.
+    JsonView operator[](size_t index) const;
+    JsonView operator[](int index) const
+    {
+        return index < 0 ? JsonView() : (*this)[static_cast<size_t>(index)];
+    }
+
+    /// Return true for the true literal and for non-zero numbers.
+    bool asBool() const;
+    /// Numbers with a fraction or an exponent are truncated, 0 is returned
+    /// for other values.
+    int64_t asInt64() const;
+    uint64_t asUInt64() const;
+    double asDouble() const;
+    /// Get the unescaped string, an empty string is returned for other values.
+    std::string asString() const;
+
+    /// Get the json text of the value.
+    string_view raw() const;
+
+    /// Convert the value to a Json::Value, the same as it's parsed by jsoncpp.
+    Json::Value toJsonValue() const;
+
+    /// Call the callback with every member of an object.
+    void forEachMember(
+        const std::function<void(const std::string &key, const JsonView &value)>
+            &callback) const;
+    /// Call the callback with every element of an array.
+    void forEachElement(
+        const std::function<void(const JsonView &value)> &callback) const;
+
+  private:
+    JsonView(std::shared_ptr<const internal::JsonIndex> index, uint32_t token)
+        : index_(std::move(index)), token_(token)
+    {
+    }
+    std::shared_ptr<const internal::JsonIndex> index_;
+    uint32_t token_{0};
+};
+
+}  // namespace drogon
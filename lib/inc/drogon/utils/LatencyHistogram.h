@@ -0,0 +1,112 @@
+/**
+ *
+ *  LatencyHistogram.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdint.h>
+
+namespace drogon
+{
+/// A summary of the values recorded by a LatencyHistogram, in seconds.
+struct LatencySummary
+{
+    uint64_t count_{0};
+    double sum_{0.0};
+    double max_{0.0};
+    double p50_{0.0};
+    double p90_{0.0};
+    double p99_{0.0};
+};
+
+/**
+ * @brief A lock-free histogram of latencies with logarithmic buckets.
+ *
+ * Values are recorded in microseconds, every power of two is divided into four
+ * buckets, so the relative error of a percentile is less than 25%. Recording
+ * a value costs a few relaxed atomic additions, aggregation is only done when
+ * a summary or the buckets are read.
+ */
+class LatencyHistogram : public trantor::NonCopyable
+{
+  public:
+    static constexpr size_t bucketsNumber = 160;
+
+    LatencyHistogram()
+    {
+        for (auto &bucket : buckets_)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+
+    void record(uint64_t microseconds)
+    {
+        buckets_[bucketIndex(microseconds)].fetch_add(
+            1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(microseconds, std::memory_order_relaxed);
+        auto max = max_.load(std::memory_order_relaxed);
+        while (microseconds > max &&
+               !max_.compare_exchange_weak(max,
+                                           microseconds,
+                                           std::memory_order_relaxed))
+            ;
+    }
+
+    template <typename Rep, typename Period>
+    void record(const std::chrono::duration<Rep, Period> &duration)
+    {
+        auto us =
+            std::chrono::duration_cast<std::chrono::microseconds>(duration)
+                .count();
+        record(us > 0 ? (uint64_t)us : 0);
+    }
+
+    uint64_t count() const
+    {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    /// Compute the summary of the recorded values.
+    LatencySummary summary() const;
+
+    /// Call the callback with the upper bound (in seconds) and the count of
+    /// every non-empty bucket, in ascending order.
+    void forEachBucket(
+        const std::function<void(double upperBound, uint64_t count)> &callback)
+        const;
+
+    /// Return the upper bound of a bucket in microseconds.
+    static uint64_t bucketUpperBound(size_t index);
+
+    /// Return the index of the bucket of a value in microseconds.
+    static size_t bucketIndex(uint64_t value)
+    {
+        if (value < 4)
+            return (size_t)value;
+        auto msb = 63 - __builtin_clzll(value);
+        size_t index = 4 * (msb - 1) + ((value >> (msb - 2)) & 3);
+        return index < bucketsNumber ? index : bucketsNumber - 1;
+    }
+
+  private:
+    std::atomic<uint64_t> buckets_[bucketsNumber];
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+}  // namespace drogon
@@ -0,0 +1,301 @@
+/**
+ *
+ *  Metrics.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/utils/LatencyHistogram.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace drogon
+{
+/// The labels of a metric, e.g. {{"method", "GET"}, {"code", "2xx"}}.
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+namespace internal
+{
+/// The number of the per-thread cells of a metric.
+constexpr size_t metricsSlotsNumber = 64;
+
+/// The slot of the current thread in the per-thread cells.
+/**
+ * Every thread owns a slot exclusively while it's alive, and updates its cells
+ * with plain loads and stores instead of read-modify-write instructions.
+ * Threads created after all slots are taken share the last slot, which is
+ * updated atomically.
+ */
+struct MetricsSlot
+{
+    size_t index_;
+    bool exclusive_;
+};
+const MetricsSlot &currentMetricsSlot();
+
+template <typename T>
+inline void addToCell(std::atomic<T> &cell, T value, bool exclusive)
+{
+    if (exclusive)
+        cell.store(cell.load(std::memory_order_relaxed) + value,
+                   std::memory_order_relaxed);
+    else
+        cell.fetch_add(value, std::memory_order_relaxed);
+}
+
+/// The cells of a metric, allocated when a thread updates it for the first
+/// time.
+template <typename Cell>
+class PerThreadCells : public trantor::NonCopyable
+{
+  public:
+    PerThreadCells()
+    {
+        for (auto &cell : cells_)
+            cell.store(nullptr, std::memory_order_relaxed);
+    }
+    ~PerThreadCells()
+    {
+        for (auto &cell : cells_)
+            delete cell.load(std::memory_order_relaxed);
+    }
+    Cell &get(size_t index)
+    {
+        auto cell = cells_[index].load(std::memory_order_acquire);
+        return cell ? *cell : allocate(index);
+    }
+    template <typename Function>
+    void forEach(Function &&function) const
+    {
+        for (auto &cell : cells_)
+        {
+            auto ptr = cell.load(std::memory_order_acquire);
+            if (ptr)
+                function(*ptr);
+        }
+    }
+
+  private:
+    Cell &allocate(size_t index)
+    {
+        auto cell = new Cell;
+        Cell *expected = nullptr;
+        if (cells_[index].compare_exchange_strong(expected,
+                                                  cell,
+                                                  std::memory_order_acq_rel))
+            return *cell;
+        delete cell;
+        return *expected;
+    }
+    std::atomic<Cell *> cells_[metricsSlotsNumber];
+};
+
+// Cells are padded to a cache line, so threads don't write the same line.
+struct CounterCell
+{
+    std::atomic<uint64_t> value_{0};
+    char padding_[64 - sizeof(std::atomic<uint64_t>)];
+};
+struct GaugeCell
+{
+    std::atomic<int64_t> value_{0};
+    char padding_[64 - sizeof(std::atomic<int64_t>)];
+};
+struct HistogramCell
+{
+    HistogramCell()
+    {
+        for (auto &bucket : buckets_)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+    std::atomic<uint64_t> buckets_[LatencyHistogram::bucketsNumber];
+    std::atomic<uint64_t> sum_{0};
+};
+}  // namespace internal
+
+/**
+ * @brief A monotonically increasing counter.
+ *
+ * The counter is split into per-thread cells, adding to it costs a few
+ * nanoseconds and never contends with other threads, the cells are summed
+ * when the value is read.
+ */
+class MetricCounter : public trantor::NonCopyable
+{
+  public:
+    void add(uint64_t value = 1)
+    {
+        auto &slot = internal::currentMetricsSlot();
+        internal::addToCell(cells_.get(slot.index_).value_,
+                            value,
+                            slot.exclusive_);
+    }
+    uint64_t value() const;
+
+  private:
+    internal::PerThreadCells<internal::CounterCell> cells_;
+};
+
+/// A value which goes up and down, e.g. the number of requests in flight. It
+/// may be increased in a thread and decreased in another.
+class MetricGauge : public trantor::NonCopyable
+{
+  public:
+    void add(int64_t value = 1)
+    {
+        auto &slot = internal::currentMetricsSlot();
+        internal::addToCell(cells_.get(slot.index_).value_,
+                            value,
+                            slot.exclusive_);
+    }
+    void sub(int64_t value = 1)
+    {
+        add(-value);
+    }
+    int64_t value() const;
+
+  private:
+    internal::PerThreadCells<internal::GaugeCell> cells_;
+};
+
+/**
+ * @brief A histogram of latencies with per-thread cells.
+ *
+ * It uses the logarithmic buckets of the LatencyHistogram (four buckets per
+ * power of two microseconds), recording a value updates a bucket and the sum
+ * of the current thread only. The buckets are merged when they're read, and
+ * may be folded into coarser buckets for the exposition.
+ */
+class MetricHistogram : public trantor::NonCopyable
+{
+  public:
+    void record(uint64_t microseconds)
+    {
+        auto &slot = internal::currentMetricsSlot();
+        auto &cell = cells_.get(slot.index_);
+        internal::addToCell(
+            cell.buckets_[LatencyHistogram::bucketIndex(microseconds)],
+            (uint64_t)1,
+            slot.exclusive_);
+        internal::addToCell(cell.sum_, microseconds, slot.exclusive_);
+    }
+    template <typename Rep, typename Period>
+    void record(const std::chrono::duration<Rep, Period> &duration)
+    {
+        auto us =
+            std::chrono::duration_cast<std::chrono::microseconds>(duration)
+                .count();
+        record(us > 0 ? (uint64_t)us : 0);
+    }
+
+    /// Count the recorded values by the upper bounds (in seconds, ascending),
+    /// the counts are cumulative as in Prometheus. A value is counted in the
+    /// first bound which is not less than the upper bound of its bucket.
+    /**
+     * @return The counts of the bounds followed by the total count.
+     */
+    std::vector<uint64_t> cumulativeCounts(
+        const std::vector<double> &upperBounds) const;
+    /// The sum of the recorded values in seconds.
+    double sum() const;
+    uint64_t count() const;
+
+  private:
+    internal::PerThreadCells<internal::HistogramCell> cells_;
+};
+
+/**
+ * @brief The registry of the metrics of an application.
+ *
+ * Metrics are registered by names and labels, registering an existing metric
+ * returns it, so a metric can be created where it's used. Callers keep the
+ * returned pointers and update them without any lookup, the values are only
+ * aggregated when they're exported. For example:
+ * @code
+   static auto orders = MetricsRegistry::instance().counter(
+       "shop_orders_total", "The number of orders", {{"type", "online"}});
+   orders->add();
+   @endcode
+ * The framework records the metrics of HTTP requests into the default
+ * instance, the PrometheusExporter plugin exposes them.
+ */
+class MetricsRegistry : public trantor::NonCopyable
+{
+  public:
+    /// The default registry.
+    static MetricsRegistry &instance();
+
+    std::shared_ptr<MetricCounter> counter(const std::string &name,
+                                           const std::string &help,
+                                           const MetricLabels &labels = {});
+    std::shared_ptr<MetricGauge> gauge(const std::string &name,
+                                       const std::string &help,
+                                       const MetricLabels &labels = {});
+    std::shared_ptr<MetricHistogram> histogram(
+        const std::string &name,
+        const std::string &help,
+        const MetricLabels &labels = {});
+
+    /// Register a gauge whose value is got by the callback when it's
+    /// exported, e.g. the size of a container. The callback may be called in
+    /// any thread.
+    void gaugeCallback(const std::string &name,
+                       const std::string &help,
+                       const MetricLabels &labels,
+                       std::function<double()> callback);
+
+    /// Render all metrics in the Prometheus text exposition format.
+    /**
+     * @param upperBounds The upper bounds of the buckets of histograms in
+     * seconds, in ascending order.
+     */
+    std::string toPrometheusText(const std::vector<double> &upperBounds) const;
+
+  private:
+    enum MetricType
+    {
+        kCounter,
+        kGauge,
+        kHistogram
+    };
+    struct Metric
+    {
+        std::shared_ptr<MetricCounter> counter_;
+        std::shared_ptr<MetricGauge> gauge_;
+        std::shared_ptr<MetricHistogram> histogram_;
+        std::function<double()> callback_;
+    };
+    struct Family
+    {
+        std::string help_;
+        MetricType type_;
+        std::map<MetricLabels, Metric> metrics_;
+    };
+    Metric &getMetric(const std::string &name,
+                      const std::string &help,
+                      MetricType type,
+                      const MetricLabels &labels);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;
+};
+
+}  // namespace drogon
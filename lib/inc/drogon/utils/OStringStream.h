@@ -0,0 +1,233 @@
+/**
+ *
+ *  OStringStream.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/utils/string_view.h>
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <ios>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace drogon
+{
+/**
+ * @brief An output stream which appends directly to a std::string.
+ *
+ * It's used by the source code generated from the csp files. Strings and
+ * characters are appended without any formatting and integers are converted
+ * with std::to_string() unless a manipulator (e.g. std::setw or std::hex)
+ * changes the format. Other types and manipulators are handled by a
+ * std::ostream writing to the same string, which is created when it's first
+ * used and keeps its state like a std::stringstream does, so the output is the
+ * same as the output of a std::stringstream. The stream converts to the
+ * std::ostream, so it can be passed to functions taking a std::ostream &.
+ *
+ * A stream constructed with a sink passes its content to the sink and clears it
+ * when flush() is called or when the content exceeds the flush threshold, so a
+ * large page can be sent while the rest of it is being rendered.
+ */
+class OStringStream : public trantor::NonCopyable
+{
+  public:
+    /// The function which receives the text flushed from a stream.
+    using Sink = std::function<void(const char *data, size_t length)>;
+
+    OStringStream() = default;
+    OStringStream(Sink sink, size_t flushThreshold)
+        : sink_(std::move(sink)), flushThreshold_(flushThreshold)
+    {
+        buffer_.reserve(flushThreshold);
+    }
+
+    /// Pass the content to the sink, it does nothing if the stream has no
+    /// sink.
+    void flush()
+    {
+        if (sink_ && !buffer_.empty())
+        {
+            sink_(buffer_.data(), buffer_.size());
+            buffer_.clear();
+        }
+    }
+
+    void reserve(size_t size)
+    {
+        buffer_.reserve(size);
+    }
+    void write(const char *data, size_t length)
+    {
+        buffer_.append(data, length);
+        checkFlush();
+    }
+    size_t size() const
+    {
+        return buffer_.size();
+    }
+    std::string &str()
+    {
+        return buffer_;
+    }
+    const std::string &str() const
+    {
+        return buffer_;
+    }
+
+    operator std::ostream &()
+    {
+        return formatter();
+    }
+
+    template <typename T>
+    OStringStream &operator<<(T &&value)
+    {
+        append(std::forward<T>(value));
+        checkFlush();
+        return *this;
+    }
+    OStringStream &operator<<(std::ostream &(*manipulator)(std::ostream &))
+    {
+        manipulator(formatter());
+        checkFlush();
+        return *this;
+    }
+
+  private:
+    // Appends the characters written by the formatter to the buffer.
+    class StringBuf : public std::streambuf
+    {
+      public:
+        explicit StringBuf(std::string &buffer) : buffer_(buffer)
+        {
+        }
+
+      protected:
+        int_type overflow(int_type ch) override
+        {
+            if (!traits_type::eq_int_type(ch, traits_type::eof()))
+                buffer_.push_back(traits_type::to_char_type(ch));
+            return traits_type::not_eof(ch);
+        }
+        std::streamsize xsputn(const char *data, std::streamsize n) override
+        {
+            buffer_.append(data, static_cast<size_t>(n));
+            return n;
+        }
+
+      private:
+        std::string &buffer_;
+    };
+    struct Formatter
+    {
+        explicit Formatter(std::string &buffer)
+            : buf_(buffer), stream_(&buf_)
+        {
+        }
+        StringBuf buf_;
+        std::ostream stream_;
+    };
+
+    std::ostream &formatter()
+    {
+        if (!formatter_)
+            formatter_.reset(new Formatter(buffer_));
+        return formatter_->stream_;
+    }
+    // Strings are padded if a width is set.
+    bool isPlain() const
+    {
+        return !formatter_ || formatter_->stream_.width() == 0;
+    }
+    // Integers are formatted in decimal without a sign or padding.
+    bool isPlainInteger() const
+    {
+        return !formatter_ ||
+               ((formatter_->stream_.flags() &
+                 (std::ios_base::basefield | std::ios_base::showpos)) ==
+                    std::ios_base::dec &&
+                formatter_->stream_.width() == 0);
+    }
+
+    void checkFlush()
+    {
+        if (buffer_.size() >= flushThreshold_)
+            flush();
+    }
+
+    template <typename T>
+    struct IsInteger
+    {
+        using Type = typename std::decay<T>::type;
+        static constexpr bool value =
+            std::is_integral<Type>::value && !std::is_same<Type, bool>::value &&
+            !std::is_same<Type, char>::value &&
+            !std::is_same<Type, signed char>::value &&
+            !std::is_same<Type, unsigned char>::value;
+    };
+
+    void append(const std::string &str)
+    {
+        if (isPlain())
+            buffer_.append(str);
+        else
+            formatter() << str;
+    }
+    void append(const char *str)
+    {
+        if (isPlain())
+            buffer_.append(str);
+        else
+            formatter() << str;
+    }
+    void append(char ch)
+    {
+        if (isPlain())
+            buffer_.push_back(ch);
+        else
+            formatter() << ch;
+    }
+    void append(const string_view &str)
+    {
+        if (isPlain())
+            buffer_.append(str.data(), str.length());
+        else
+            formatter() << std::string(str.data(), str.length());
+    }
+    template <typename T>
+    typename std::enable_if<IsInteger<T>::value>::type append(T value)
+    {
+        if (isPlainInteger())
+            buffer_.append(std::to_string(value));
+        else
+            formatter() << value;
+    }
+    template <typename T>
+    typename std::enable_if<!IsInteger<T>::value>::type append(const T &value)
+    {
+        formatter() << value;
+    }
+
+    std::string buffer_;
+    Sink sink_;
+    size_t flushThreshold_{std::numeric_limits<size_t>::max()};
+    std::unique_ptr<Formatter> formatter_;
+};
+
+}  // namespace drogon
@@ -0,0 +1,74 @@
+/**
+ *
+ *  ServerState.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+namespace drogon
+{
+/// A snapshot of the connections of an IO loop.
+struct IoLoopState
+{
+    /// "io:<index>".
+    std::string name_;
+    /// The HTTP connections of the loop, including the websocket ones.
+    size_t connections_{0};
+    size_t webSocketConnections_{0};
+    /// The requests in the pipelining queues of the connections, i.e. the
+    /// requests being handled and the ones whose responses wait for the
+    /// responses of the earlier requests.
+    size_t pipelinedRequests_{0};
+    /// The responses in the pipelining queues, ready but waiting for the
+    /// responses of the earlier requests.
+    size_t pipelinedResponses_{0};
+    /// The longest pipelining queue of a connection.
+    size_t maxPipelineDepth_{0};
+    /// The responses of the static files cached by the loop.
+    size_t cachedStaticFiles_{0};
+};
+
+/// A snapshot of the connections and the queues of a database client.
+struct DbClientState
+{
+    std::string name_;
+    /// The loop of a fast client, e.g. "io:0", fast clients have a state for
+    /// every loop. Empty for other clients.
+    std::string loop_;
+    size_t connections_{0};
+    /// The connections executing a command or held by a transaction.
+    size_t busyConnections_{0};
+    /// The commands waiting for a connection.
+    size_t waitingCommands_{0};
+    /// The transactions waiting for a connection.
+    size_t waitingTransactions_{0};
+};
+
+/// A snapshot of the runtime state of the framework, see
+/// HttpAppFramework::getServerState().
+struct ServerState
+{
+    /// The HTTP connections of all IO loops.
+    size_t connections_{0};
+    /// The sessions in the session table, 0 if the session is disabled.
+    size_t sessions_{0};
+    /// The IO loops in the order of their indexes.
+    std::vector<IoLoopState> ioLoops_;
+    /// The database clients in the order of their names and loops.
+    std::vector<DbClientState> dbClients_;
+};
+
+}  // namespace drogon
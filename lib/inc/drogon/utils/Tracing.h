@@ -0,0 +1,208 @@
+/**
+ *
+ *  Tracing.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace drogon
+{
+/// The trace context of the W3C Trace Context specification.
+struct TraceContext
+{
+    uint64_t traceIdHigh_{0};
+    uint64_t traceIdLow_{0};
+    uint64_t spanId_{0};
+    uint64_t parentSpanId_{0};
+    bool sampled_{false};
+
+    bool valid() const
+    {
+        return traceIdHigh_ != 0 || traceIdLow_ != 0;
+    }
+
+    /// Parse the value of a traceparent header, e.g.
+    /// "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01". The span ID
+    /// in it is stored as the parent span ID.
+    /**
+     * @return false if the value is malformed.
+     */
+    bool parseTraceparent(const std::string &value);
+
+    /// The value of the traceparent header of an outgoing request, whose
+    /// parent is the span of this context.
+    std::string toTraceparent() const;
+};
+
+/// A span finished, with the time in microseconds.
+struct SpanData
+{
+    uint64_t traceIdHigh_{0};
+    uint64_t traceIdLow_{0};
+    uint64_t spanId_{0};
+    uint64_t parentSpanId_{0};
+    /// "http.server", "routing", "filters", "handler", "http.client" or "sql".
+    const char *name_{""};
+    /// The request line of HTTP spans, the sql of sql spans.
+    std::string detail_;
+    /// Microseconds since the epoch.
+    int64_t start_{0};
+    int64_t duration_{0};
+    /// The status code of HTTP spans, -1 if a call fails without a response,
+    /// 0 or 1 (error) for sql spans.
+    int status_{0};
+};
+
+/**
+ * @brief The tracer samples requests and collects the spans of them.
+ *
+ * The framework starts a trace for a request with the traceparent header
+ * sampled by the parent service, or for a request sampled by the sample
+ * rate. The context of the request is the current context of the thread
+ * while the request is being handled in the IO loop, the HttpClient and
+ * DbClient calls made then are traced as children of the request (the
+ * HttpClient adds the traceparent header), and the context is the current
+ * context again when their callbacks are called.
+ *
+ * Spans are recorded into lock-free per-thread ring buffers, which are
+ * drained by an exporter, e.g. the TraceFileExporter plugin. A span is
+ * dropped if the ring buffer of its thread is full. Requests which are not
+ * sampled don't allocate anything.
+ */
+class Tracer : public trantor::NonCopyable
+{
+  public:
+    static Tracer &instance();
+
+    /// Set the fraction (0 to 1) of the requests without a traceparent
+    /// header which are sampled. The default value is 0.
+    void setSampleRate(double rate)
+    {
+        sampleRate_.store(rate, std::memory_order_relaxed);
+    }
+    double sampleRate() const
+    {
+        return sampleRate_.load(std::memory_order_relaxed);
+    }
+
+    /// Start the trace of an incoming request.
+    /**
+     * @param traceparent The traceparent header of the request.
+     * @param context The context of the request, whose span is the server
+     * span of the request. It's invalid if the request is not traced.
+     */
+    void startTrace(const std::string &traceparent, TraceContext &context);
+
+    /// The trace context of the current thread, invalid if there is none.
+    static const TraceContext &currentContext()
+    {
+        return currentContextRef();
+    }
+
+    /// Make a context the current context of this thread in a scope.
+    class ContextScope : public trantor::NonCopyable
+    {
+      public:
+        explicit ContextScope(const TraceContext &context)
+            : previous_(currentContextRef())
+        {
+            currentContextRef() = context;
+        }
+        ~ContextScope()
+        {
+            currentContextRef() = previous_;
+        }
+
+      private:
+        TraceContext previous_;
+    };
+
+    /// Record a finished span.
+    void record(SpanData &&span);
+
+    /// Move at most maxNumber spans in the ring buffers into the vector.
+    /**
+     * @return The number of spans moved.
+     */
+    size_t drain(std::vector<SpanData> &spans, size_t maxNumber);
+
+    /// The number of spans dropped because the ring buffers were full.
+    uint64_t droppedSpans() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    /// Generate a random non-zero ID.
+    static uint64_t newId();
+    /// Microseconds since the epoch.
+    static int64_t now();
+
+  private:
+    Tracer() = default;
+    class SpanRing;
+    static TraceContext &currentContextRef();
+    SpanRing &threadRing();
+
+    std::atomic<double> sampleRate_{0.0};
+    std::atomic<uint64_t> dropped_{0};
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<SpanRing>> rings_;
+};
+
+/**
+ * @brief An outgoing call traced as a child of the current context.
+ *
+ * It's created in the thread making the call, and finished before the
+ * callback of the call is called, e.g.
+ * @code
+   auto call = std::make_shared<TracedCall>("sql", sql);
+   auto callback = [call, rcb](const Result &r) {
+       Tracer::ContextScope scope(call->finish(0));
+       rcb(r);
+   };
+   @endcode
+ */
+class TracedCall : public trantor::NonCopyable
+{
+  public:
+    TracedCall(const char *name, std::string detail);
+
+    /// The context of the call, whose span is the span of the call.
+    const TraceContext &context() const
+    {
+        return context_;
+    }
+
+    /// Record the span if it's sampled.
+    /**
+     * @return The context of the caller, which should be the current
+     * context when the callback is called.
+     */
+    const TraceContext &finish(int status);
+
+  private:
+    TraceContext parent_;
+    TraceContext context_;
+    const char *name_;
+    std::string detail_;
+    int64_t start_;
+};
+
+}  // namespace drogon
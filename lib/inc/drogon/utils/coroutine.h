@@ -0,0 +1,371 @@
+/**
+ *
+ *  coroutine.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+/// Coroutine support for the asynchronous interfaces, only available when the
+/// application is compiled with C++20 coroutines enabled. The library itself
+/// doesn't depend on it, everything in this file is header-only.
+
+#pragma once
+
+#ifdef __cpp_impl_coroutine
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace drogon
+{
+template <typename T = void>
+class Task;
+
+namespace internal
+{
+struct TaskFinalAwaiter
+{
+    bool await_ready() noexcept
+    {
+        return false;
+    }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept
+    {
+        // Symmetric transfer to the awaiting coroutine, so that long chains of
+        // tasks don't grow the stack.
+        auto continuation = handle.promise().continuation_;
+        if (continuation)
+            return continuation;
+        return std::noop_coroutine();
+    }
+    void await_resume() noexcept
+    {
+    }
+};
+
+struct TaskPromiseBase
+{
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+    TaskFinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+    void unhandled_exception() noexcept
+    {
+        exception_ = std::current_exception();
+    }
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+};
+
+template <typename T>
+struct TaskPromise : public TaskPromiseBase
+{
+    Task<T> get_return_object() noexcept;
+    template <typename U>
+    void return_value(U &&value)
+    {
+        value_.emplace(std::forward<U>(value));
+    }
+    T result()
+    {
+        if (exception_)
+            std::rethrow_exception(exception_);
+        return std::move(*value_);
+    }
+    std::optional<T> value_;
+};
+
+template <>
+struct TaskPromise<void> : public TaskPromiseBase
+{
+    Task<void> get_return_object() noexcept;
+    void return_void() noexcept
+    {
+    }
+    void result()
+    {
+        if (exception_)
+            std::rethrow_exception(exception_);
+    }
+};
+
+}  // namespace internal
+
+/**
+ * @brief A lazily started coroutine which produces a value of the type T.
+ *
+ * The coroutine starts running when the task is awaited, and the awaiting
+ * coroutine is resumed when it finishes. Exceptions thrown in the coroutine are
+ * rethrown by co_await.
+ */
+template <typename T>
+class [[nodiscard]] Task
+{
+  public:
+    using promise_type = internal::TaskPromise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    explicit Task(handle_type handle) noexcept : handle_(handle)
+    {
+    }
+    Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr))
+    {
+    }
+    Task &operator=(Task &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle_)
+                handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+    ~Task()
+    {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    auto operator co_await() const noexcept
+    {
+        struct Awaiter
+        {
+            bool await_ready() noexcept
+            {
+                return !handle_ || handle_.done();
+            }
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<> continuation) noexcept
+            {
+                handle_.promise().continuation_ = continuation;
+                return handle_;
+            }
+            T await_resume()
+            {
+                return handle_.promise().result();
+            }
+            handle_type handle_;
+        };
+        return Awaiter{handle_};
+    }
+
+  private:
+    handle_type handle_;
+};
+
+namespace internal
+{
+template <typename T>
+inline Task<T> TaskPromise<T>::get_return_object() noexcept
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+    return Task<void>(
+        std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+}  // namespace internal
+
+/**
+ * @brief A coroutine which starts running immediately and is never awaited.
+ *
+ * Use it to start a coroutine from a callback based interface, for example:
+ * @code
+   [](std::function<void(const HttpResponsePtr &)> callback) -> AsyncTask {
+       auto result = co_await client->execSqlCoro("select 1");
+       callback(HttpResponse::newHttpResponse());
+   }(std::move(callback));
+   @endcode
+ * An exception escaping from the coroutine terminates the program.
+ */
+struct AsyncTask
+{
+    struct promise_type
+    {
+        AsyncTask get_return_object() noexcept
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void() noexcept
+        {
+        }
+        void unhandled_exception()
+        {
+            LOG_FATAL << "Exception escaping AsyncTask";
+            std::terminate();
+        }
+    };
+};
+
+namespace internal
+{
+class CallbackAwaiterBase
+{
+  public:
+    bool await_ready() noexcept
+    {
+        return false;
+    }
+    void setException(const std::exception_ptr &exception)
+    {
+        exception_ = exception;
+        resume();
+    }
+
+  protected:
+    void setHandle(std::coroutine_handle<> handle)
+    {
+        handle_ = handle;
+        loop_ = trantor::EventLoop::getEventLoopOfCurrentThread();
+    }
+    /// Return the value of this method from await_suspend() after starting
+    /// the operation, it's false if the result is set already, so the
+    /// coroutine continues without being suspended.
+    bool suspend() noexcept
+    {
+        return !ready_.exchange(true, std::memory_order_acq_rel);
+    }
+    void resume()
+    {
+        // The result is set before await_suspend() returns, the coroutine is
+        // not suspended yet and must not be resumed here.
+        if (!ready_.exchange(true, std::memory_order_acq_rel))
+            return;
+        if (loop_ && !loop_->isInLoopThread())
+        {
+            loop_->queueInLoop([handle = handle_]() { handle.resume(); });
+        }
+        else
+        {
+            handle_.resume();
+        }
+    }
+    void rethrowIfFailed()
+    {
+        if (exception_)
+            std::rethrow_exception(exception_);
+    }
+
+  private:
+    std::exception_ptr exception_;
+    std::coroutine_handle<> handle_;
+    trantor::EventLoop *loop_{nullptr};
+    // Set by the first one of await_suspend() and the result, the second one
+    // resumes the coroutine.
+    std::atomic<bool> ready_{false};
+};
+}  // namespace internal
+
+/**
+ * @brief The base class of the awaiters of callback based interfaces.
+ *
+ * A derived class starts the asynchronous operation in its await_suspend()
+ * method after calling setHandle() and returns the value of suspend(), and the
+ * callbacks of the operation call setValue() or setException(). The awaiting
+ * coroutine is resumed in the event loop of the thread which awaited it, or in
+ * the thread of the callback if the awaiting thread has no event loop. If the
+ * callbacks are called before await_suspend() returns, the coroutine isn't
+ * suspended at all.
+ */
+template <typename T>
+class CallbackAwaiter : public internal::CallbackAwaiterBase
+{
+  public:
+    T await_resume() noexcept(false)
+    {
+        rethrowIfFailed();
+        return std::move(*result_);
+    }
+    template <typename U>
+    void setValue(U &&value)
+    {
+        result_.emplace(std::forward<U>(value));
+        resume();
+    }
+
+  private:
+    std::optional<T> result_;
+};
+
+template <>
+class CallbackAwaiter<void> : public internal::CallbackAwaiterBase
+{
+  public:
+    void await_resume() noexcept(false)
+    {
+        rethrowIfFailed();
+    }
+    void setValue()
+    {
+        resume();
+    }
+};
+
+namespace internal
+{
+template <typename T, typename Launcher>
+class LauncherAwaiter : public CallbackAwaiter<T>
+{
+  public:
+    explicit LauncherAwaiter(Launcher &&launcher)
+        : launcher_(std::move(launcher))
+    {
+    }
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        this->setHandle(handle);
+        launcher_(static_cast<CallbackAwaiter<T> &>(*this));
+        return this->suspend();
+    }
+
+  private:
+    Launcher launcher_;
+};
+
+/// Make an awaiter which calls the launcher with itself when it's awaited,
+/// the launcher starts an asynchronous operation and sets the result of the
+/// awaiter in the callbacks of the operation.
+template <typename T, typename Launcher>
+LauncherAwaiter<T, std::decay_t<Launcher>> makeCallbackAwaiter(
+    Launcher &&launcher)
+{
+    return LauncherAwaiter<T, std::decay_t<Launcher>>(
+        std::forward<Launcher>(launcher));
+}
+}  // namespace internal
+
+}  // namespace drogon
+
+#endif
@@ -0,0 +1,439 @@
+/**
+ *
+ *  drogon_plugin_AccessLogger.cc
+ *
+ */
+#include <drogon/plugins/AccessLogger.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string.h>
+#include <time.h>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+std::atomic<AccessLogger *> AccessLogger::current_{nullptr};
+
+namespace
+{
+const char *fieldNames[] = {"time",
+                            "remote_addr",
+                            "method",
+                            "path",
+                            "route",
+                            "status",
+                            "bytes",
+                            "latency",
+                            "user_agent"};
+
+void appendNumber(std::string &buffer, int64_t number)
+{
+    char buf[24];
+    auto end = buf + sizeof(buf);
+    auto begin = end;
+    auto value = static_cast<uint64_t>(number < 0 ? -number : number);
+    do
+    {
+        *--begin = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    if (number < 0)
+        *--begin = '-';
+    buffer.append(begin, end - begin);
+}
+
+// Tabs, line breaks and other control characters are escaped, so a record
+// is always a line of tab-separated fields.
+void appendTextString(std::string &buffer, const char *data, size_t length)
+{
+    if (length == 0)
+    {
+        buffer.push_back('-');
+        return;
+    }
+    for (size_t i = 0; i < length; ++i)
+    {
+        auto ch = static_cast<unsigned char>(data[i]);
+        if (ch < 0x20 || ch == 0x7f || ch == '\\')
+        {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\x%02x", ch);
+            buffer.append(buf);
+        }
+        else
+        {
+            buffer.push_back(static_cast<char>(ch));
+        }
+    }
+}
+
+template <typename T>
+void appendBinaryValue(std::string &buffer, T value)
+{
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void appendBinaryString(std::string &buffer, const char *data, size_t length)
+{
+    auto size = static_cast<uint16_t>(length < 0xffff ? length : 0xffff);
+    appendBinaryValue(buffer, size);
+    buffer.append(data, size);
+}
+}  // namespace
+
+void AccessLogger::initAndStart(const Json::Value &config)
+{
+    path_ = config.get("path", path_).asString();
+    auto format = config.get("format", "text").asString();
+    if (format != "text" && format != "binary")
+        LOG_ERROR << "Unknown access log format " << format << ", use text";
+    binary_ = (format == "binary");
+    if (config.isMember("fields") && config["fields"].isArray())
+    {
+        for (auto &name : config["fields"])
+        {
+            auto field = name.asString();
+            auto iter = std::find_if(std::begin(fieldNames),
+                                     std::end(fieldNames),
+                                     [&field](const char *fieldName) {
+                                         return field == fieldName;
+                                     });
+            if (iter == std::end(fieldNames))
+            {
+                LOG_ERROR << "Unknown access log field " << field;
+                continue;
+            }
+            fields_.push_back(
+                static_cast<Field>(iter - std::begin(fieldNames)));
+        }
+    }
+    else
+    {
+        for (int i = kTime; i <= kUserAgent; ++i)
+            fields_.push_back(static_cast<Field>(i));
+    }
+    sampleRate_ = config.get("sample_rate", sampleRate_).asDouble();
+    alwaysLogErrors_ =
+        config.get("always_log_errors", alwaysLogErrors_).asBool();
+    bufferSize_ =
+        config.get("buffer_size", static_cast<Json::UInt64>(bufferSize_))
+            .asUInt64();
+    flushInterval_ = config.get("flush_interval", flushInterval_).asDouble();
+    maxFileSize_ =
+        config.get("max_file_size", static_cast<Json::UInt64>(maxFileSize_))
+            .asUInt64();
+    maxFiles_ =
+        config.get("max_files", static_cast<Json::UInt64>(maxFiles_))
+            .asUInt64();
+
+    openFile();
+    if (!file_)
+        return;
+    buffers_ =
+        std::make_unique<IOThreadStorage<std::unique_ptr<ThreadBuffer>>>();
+    buffers_->init([this](std::unique_ptr<ThreadBuffer> &buffer, size_t) {
+        buffer = std::make_unique<ThreadBuffer>();
+        buffer->buffer_.reserve(bufferSize_);
+        allBuffers_.push_back(buffer.get());
+    });
+    spare_.reserve(bufferSize_);
+    thread_ = std::thread([this]() { run(); });
+    current_.store(this, std::memory_order_release);
+}
+
+void AccessLogger::shutdown()
+{
+    current_.store(nullptr, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+    if (file_)
+    {
+        flush();
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void AccessLogger::log(const HttpRequestPtr &req,
+                       HttpStatusCode code,
+                       size_t bytes,
+                       int64_t latency)
+{
+    if (sampleRate_ < 1.0 && !(alwaysLogErrors_ && code >= 500))
+    {
+        thread_local std::minstd_rand generator(std::random_device{}());
+        if (std::uniform_real_distribution<double>(0, 1)(generator) >=
+            sampleRate_)
+            return;
+    }
+    auto &threadBuffer = *buffers_->getThreadData();
+    size_t size;
+    {
+        // Only contended when the background thread takes the buffer.
+        std::lock_guard<std::mutex> lock(threadBuffer.mutex_);
+        if (threadBuffer.buffer_.size() >= bufferSize_ * 16)
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (binary_)
+            appendBinary(threadBuffer.buffer_, req, code, bytes, latency);
+        else
+            appendText(threadBuffer, req, code, bytes, latency);
+        size = threadBuffer.buffer_.size();
+    }
+    if (size >= bufferSize_ &&
+        !flushRequested_.exchange(true, std::memory_order_acq_rel))
+        cond_.notify_one();
+}
+
+void AccessLogger::appendText(ThreadBuffer &threadBuffer,
+                              const HttpRequestPtr &req,
+                              HttpStatusCode code,
+                              size_t bytes,
+                              int64_t latency) const
+{
+    auto &buffer = threadBuffer.buffer_;
+    for (size_t i = 0; i < fields_.size(); ++i)
+    {
+        if (i > 0)
+            buffer.push_back('\t');
+        switch (fields_[i])
+        {
+            case kTime:
+            {
+                auto time = req->creationDate().microSecondsSinceEpoch();
+                auto second = time / 1000000;
+                // Format the date and time once a second.
+                if (second != threadBuffer.cachedSecond_)
+                {
+                    auto seconds = static_cast<time_t>(second);
+                    struct tm tmTime;
+                    gmtime_r(&seconds, &tmTime);
+                    strftime(threadBuffer.cachedTime_,
+                             sizeof(threadBuffer.cachedTime_),
+                             "%Y-%m-%dT%H:%M:%S.",
+                             &tmTime);
+                    threadBuffer.cachedSecond_ = second;
+                }
+                buffer.append(threadBuffer.cachedTime_);
+                char micros[8];
+                snprintf(micros,
+                         sizeof(micros),
+                         "%06dZ",
+                         static_cast<int>(time % 1000000));
+                buffer.append(micros);
+                break;
+            }
+            case kRemoteAddr:
+            {
+                auto ip = req->peerAddr().toIp();
+                appendTextString(buffer, ip.data(), ip.length());
+                break;
+            }
+            case kMethod:
+                buffer.append(req->methodString());
+                break;
+            case kPath:
+                appendTextString(buffer,
+                                 req->path().data(),
+                                 req->path().length());
+                break;
+            case kRoute:
+                appendTextString(buffer,
+                                 req->matchedPathPatternData(),
+                                 req->matchedPathPatternLength());
+                break;
+            case kStatus:
+                appendNumber(buffer, code);
+                break;
+            case kBytes:
+                appendNumber(buffer, static_cast<int64_t>(bytes));
+                break;
+            case kLatency:
+                appendNumber(buffer, latency / 1000);
+                break;
+            case kUserAgent:
+            {
+                auto &userAgent = req->getHeader("user-agent");
+                appendTextString(buffer,
+                                 userAgent.data(),
+                                 userAgent.length());
+                break;
+            }
+        }
+    }
+    buffer.push_back('\n');
+}
+
+void AccessLogger::appendBinary(std::string &buffer,
+                                const HttpRequestPtr &req,
+                                HttpStatusCode code,
+                                size_t bytes,
+                                int64_t latency) const
+{
+    auto start = buffer.size();
+    // The size of the record is filled in at the end.
+    appendBinaryValue(buffer, uint32_t(0));
+    for (auto field : fields_)
+    {
+        switch (field)
+        {
+            case kTime:
+                appendBinaryValue(
+                    buffer, req->creationDate().microSecondsSinceEpoch());
+                break;
+            case kRemoteAddr:
+            {
+                auto ip = req->peerAddr().toIp();
+                appendBinaryString(buffer, ip.data(), ip.length());
+                break;
+            }
+            case kMethod:
+            {
+                auto method = req->methodString();
+                appendBinaryString(buffer, method, strlen(method));
+                break;
+            }
+            case kPath:
+                appendBinaryString(buffer,
+                                   req->path().data(),
+                                   req->path().length());
+                break;
+            case kRoute:
+                appendBinaryString(buffer,
+                                   req->matchedPathPatternData(),
+                                   req->matchedPathPatternLength());
+                break;
+            case kStatus:
+                appendBinaryValue(buffer, static_cast<int64_t>(code));
+                break;
+            case kBytes:
+                appendBinaryValue(buffer, static_cast<int64_t>(bytes));
+                break;
+            case kLatency:
+                appendBinaryValue(buffer, latency / 1000);
+                break;
+            case kUserAgent:
+            {
+                auto &userAgent = req->getHeader("user-agent");
+                appendBinaryString(buffer,
+                                   userAgent.data(),
+                                   userAgent.length());
+                break;
+            }
+        }
+    }
+    auto size =
+        static_cast<uint32_t>(buffer.size() - start - sizeof(uint32_t));
+    memcpy(&buffer[start], &size, sizeof(size));
+}
+
+void AccessLogger::run()
+{
+    auto interval = std::chrono::microseconds(
+        static_cast<int64_t>(flushInterval_ * 1000000));
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        cond_.wait_for(lock, interval, [this]() {
+            return stopping_ ||
+                   flushRequested_.load(std::memory_order_acquire);
+        });
+        flushRequested_.store(false, std::memory_order_release);
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+void AccessLogger::flush()
+{
+    for (auto threadBuffer : allBuffers_)
+    {
+        {
+            // Swap the buffers, the IO thread keeps writing into the
+            // emptied one while this one is written.
+            std::lock_guard<std::mutex> lock(threadBuffer->mutex_);
+            spare_.swap(threadBuffer->buffer_);
+        }
+        if (!spare_.empty())
+        {
+            write(spare_);
+            spare_.clear();
+        }
+    }
+    if (file_)
+        fflush(file_);
+    auto dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reportedDrops_)
+    {
+        LOG_WARN << dropped - reportedDrops_
+                 << " access log records were dropped because the buffers "
+                    "were full";
+        reportedDrops_ = dropped;
+    }
+}
+
+void AccessLogger::write(const std::string &data)
+{
+    if (!file_)
+        return;
+    fwrite(data.data(), 1, data.length(), file_);
+    fileSize_ += data.length();
+    if (maxFileSize_ > 0 && fileSize_ >= maxFileSize_)
+        rotate();
+}
+
+void AccessLogger::openFile()
+{
+    file_ = fopen(path_.c_str(), binary_ ? "ab" : "a");
+    if (!file_)
+    {
+        LOG_SYSERR << "Can't open the access log file " << path_;
+        return;
+    }
+    fseek(file_, 0, SEEK_END);
+    fileSize_ = static_cast<size_t>(ftell(file_));
+    if (fileSize_ == 0 && !binary_)
+    {
+        std::string header("#fields:");
+        for (size_t i = 0; i < fields_.size(); ++i)
+        {
+            header.push_back(i == 0 ? ' ' : '\t');
+            header.append(fieldNames[fields_[i]]);
+        }
+        header.push_back('\n');
+        fwrite(header.data(), 1, header.length(), file_);
+        fileSize_ = header.length();
+    }
+}
+
+void AccessLogger::rotate()
+{
+    fclose(file_);
+    file_ = nullptr;
+    if (maxFiles_ == 0)
+    {
+        remove(path_.c_str());
+    }
+    else
+    {
+        // path.1 -> path.2, ..., the oldest one is overwritten.
+        for (auto i = maxFiles_ - 1; i > 0; --i)
+        {
+            auto from = path_ + "." + std::to_string(i);
+            auto to = path_ + "." + std::to_string(i + 1);
+            rename(from.c_str(), to.c_str());
+        }
+        rename(path_.c_str(), (path_ + ".1").c_str());
+    }
+    openFile();
+}
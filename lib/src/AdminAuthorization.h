@@ -0,0 +1,45 @@
+/**
+ *
+ *  AdminAuthorization.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpRequest.h>
+#include <string>
+
+namespace drogon
+{
+/// Check a request to an admin endpoint of the plugins, it must come from the
+/// localhost unless allowRemote is true, and carry the
+/// "Authorization: Bearer <token>" header.
+inline bool isAdminRequestAuthorized(const HttpRequestPtr &req,
+                                     const std::string &token,
+                                     bool allowRemote)
+{
+    if (token.empty())
+        return false;
+    if (!allowRemote && !req->peerAddr().isLoopbackIp())
+        return false;
+    auto &authorization = req->getHeader("authorization");
+    static const std::string bearer = "Bearer ";
+    if (authorization.length() != bearer.length() + token.length() ||
+        authorization.compare(0, bearer.length(), bearer) != 0)
+        return false;
+    // Compare in constant time.
+    unsigned char difference = 0;
+    for (size_t i = 0; i < token.length(); ++i)
+        difference |= authorization[bearer.length() + i] ^ token[i];
+    return difference == 0;
+}
+
+}  // namespace drogon
@@ -0,0 +1,178 @@
+/**
+ *
+ *  AllocationCounters.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "AllocationCounters.h"
+#include <drogon/config.h>
+#include <new>
+#include <stdlib.h>
+
+using namespace drogon;
+
+namespace
+{
+struct alignas(64) Slot
+{
+    std::atomic<uint64_t> allocations_{0};
+    std::atomic<uint64_t> deallocations_{0};
+    std::atomic<uint64_t> bytes_{0};
+};
+
+// Zero-initialized before any dynamic initialization, so operator new can be
+// called by static constructors.
+Slot slots[AllocationCounters::slotsNumber];
+std::atomic<size_t> nextSlot{0};
+
+// Without a constructor or destructor, so it needs no initialization guard
+// and operator new can use it in any thread at any time.
+thread_local size_t currentSlot = AllocationCounters::slotsNumber;
+}  // namespace
+
+size_t AllocationCounters::threadSlot()
+{
+    if (currentSlot == slotsNumber)
+    {
+        auto slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+        currentSlot = slot < slotsNumber - 1 ? slot : slotsNumber - 1;
+    }
+    return currentSlot;
+}
+
+AllocationCounters::Counts AllocationCounters::slot(size_t index)
+{
+    Counts counts;
+    counts.allocations_ =
+        slots[index].allocations_.load(std::memory_order_relaxed);
+    counts.deallocations_ =
+        slots[index].deallocations_.load(std::memory_order_relaxed);
+    counts.bytes_ = slots[index].bytes_.load(std::memory_order_relaxed);
+    return counts;
+}
+
+AllocationCounters::Counts AllocationCounters::total()
+{
+    Counts counts;
+    for (size_t i = 0; i < slotsNumber; ++i)
+    {
+        auto slotCounts = slot(i);
+        counts.allocations_ += slotCounts.allocations_;
+        counts.deallocations_ += slotCounts.deallocations_;
+        counts.bytes_ += slotCounts.bytes_;
+    }
+    return counts;
+}
+
+#if COUNT_ALLOCATIONS
+
+bool AllocationCounters::enabled()
+{
+    return true;
+}
+
+namespace
+{
+inline void add(std::atomic<uint64_t> &counter, uint64_t value, bool shared)
+{
+    // A slot is written by its thread only, except for the last one.
+    if (shared)
+        counter.fetch_add(value, std::memory_order_relaxed);
+    else
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+}
+
+inline void *allocate(size_t size) noexcept
+{
+    auto index = AllocationCounters::threadSlot();
+    auto shared = index == AllocationCounters::slotsNumber - 1;
+    add(slots[index].allocations_, 1, shared);
+    add(slots[index].bytes_, size, shared);
+    return malloc(size ? size : 1);
+}
+
+inline void deallocate(void *ptr) noexcept
+{
+    if (!ptr)
+        return;
+    auto index = AllocationCounters::threadSlot();
+    add(slots[index].deallocations_,
+        1,
+        index == AllocationCounters::slotsNumber - 1);
+    free(ptr);
+}
+}  // namespace
+
+void *operator new(size_t size)
+{
+    auto ptr = allocate(size);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    auto ptr = allocate(size);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    deallocate(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    deallocate(ptr);
+}
+
+#else
+
+bool AllocationCounters::enabled()
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,52 @@
+/**
+ *
+ *  AllocationCounters.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace drogon
+{
+/**
+ * @brief The counters of the allocations made by operator new.
+ *
+ * The global operator new and delete are replaced to count the allocations
+ * only when drogon is built with the COUNT_ALLOCATIONS option, otherwise the
+ * counters stay 0. Every thread counts into its own slot, the threads after
+ * the first (slotsNumber - 1) ones share the last slot.
+ */
+class AllocationCounters
+{
+  public:
+    struct Counts
+    {
+        uint64_t allocations_{0};
+        uint64_t deallocations_{0};
+        uint64_t bytes_{0};
+    };
+
+    static constexpr size_t slotsNumber = 256;
+
+    static bool enabled();
+
+    /// The slot of the current thread.
+    static size_t threadSlot();
+
+    static Counts slot(size_t index);
+    static Counts total();
+};
+
+}  // namespace drogon
@@ -0,0 +1,1045 @@
+/**
+ *
+ *  BinaryJson.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/BinaryJson.h>
+#include <drogon/utils/JsonBinding.h>
+#include <cmath>
+#include <vector>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+using namespace drogon;
+
+namespace
+{
+const size_t maxDepth = 1000;
+
+void appendBigEndian(std::string &output, uint64_t value, int bytes)
+{
+    char buf[8];
+    for (int i = bytes - 1; i >= 0; --i)
+    {
+        buf[i] = static_cast<char>(value & 0xff);
+        value >>= 8;
+    }
+    output.append(buf, bytes);
+}
+
+uint64_t doubleBits(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+class MsgPackWriter
+{
+  public:
+    explicit MsgPackWriter(std::string &output) : output_(output)
+    {
+    }
+    void writeNull()
+    {
+        output_.push_back('\xc0');
+    }
+    void writeBool(bool value)
+    {
+        output_.push_back(value ? '\xc3' : '\xc2');
+    }
+    void writeUInt(uint64_t value)
+    {
+        if (value < 0x80)
+        {
+            output_.push_back(static_cast<char>(value));
+        }
+        else if (value <= 0xff)
+        {
+            output_.push_back('\xcc');
+            appendBigEndian(output_, value, 1);
+        }
+        else if (value <= 0xffff)
+        {
+            output_.push_back('\xcd');
+            appendBigEndian(output_, value, 2);
+        }
+        else if (value <= 0xffffffff)
+        {
+            output_.push_back('\xce');
+            appendBigEndian(output_, value, 4);
+        }
+        else
+        {
+            output_.push_back('\xcf');
+            appendBigEndian(output_, value, 8);
+        }
+    }
+    void writeInt(int64_t value)
+    {
+        if (value >= 0)
+        {
+            writeUInt(static_cast<uint64_t>(value));
+        }
+        else if (value >= -32)
+        {
+            output_.push_back(static_cast<char>(value));
+        }
+        else if (value >= INT8_MIN)
+        {
+            output_.push_back('\xd0');
+            appendBigEndian(output_, static_cast<uint64_t>(value), 1);
+        }
+        else if (value >= INT16_MIN)
+        {
+            output_.push_back('\xd1');
+            appendBigEndian(output_, static_cast<uint64_t>(value), 2);
+        }
+        else if (value >= INT32_MIN)
+        {
+            output_.push_back('\xd2');
+            appendBigEndian(output_, static_cast<uint64_t>(value), 4);
+        }
+        else
+        {
+            output_.push_back('\xd3');
+            appendBigEndian(output_, static_cast<uint64_t>(value), 8);
+        }
+    }
+    void writeDouble(double value)
+    {
+        output_.push_back('\xcb');
+        appendBigEndian(output_, doubleBits(value), 8);
+    }
+    void writeString(const char *str, size_t length)
+    {
+        if (length < 32)
+        {
+            output_.push_back(static_cast<char>(0xa0 | length));
+        }
+        else if (length <= 0xff)
+        {
+            output_.push_back('\xd9');
+            appendBigEndian(output_, length, 1);
+        }
+        else if (length <= 0xffff)
+        {
+            output_.push_back('\xda');
+            appendBigEndian(output_, length, 2);
+        }
+        else
+        {
+            output_.push_back('\xdb');
+            appendBigEndian(output_, length, 4);
+        }
+        output_.append(str, length);
+    }
+    void beginArray(size_t size)
+    {
+        writeContainerHead(size, 0x90, '\xdc', '\xdd');
+    }
+    void beginObject(size_t size)
+    {
+        writeContainerHead(size, 0x80, '\xde', '\xdf');
+    }
+
+  private:
+    void writeContainerHead(size_t size, int fix, char head16, char head32)
+    {
+        if (size < 16)
+        {
+            output_.push_back(static_cast<char>(fix | size));
+        }
+        else if (size <= 0xffff)
+        {
+            output_.push_back(head16);
+            appendBigEndian(output_, size, 2);
+        }
+        else
+        {
+            output_.push_back(head32);
+            appendBigEndian(output_, size, 4);
+        }
+    }
+    std::string &output_;
+};
+
+class CborWriter
+{
+  public:
+    explicit CborWriter(std::string &output) : output_(output)
+    {
+    }
+    void writeNull()
+    {
+        output_.push_back('\xf6');
+    }
+    void writeBool(bool value)
+    {
+        output_.push_back(value ? '\xf5' : '\xf4');
+    }
+    void writeUInt(uint64_t value)
+    {
+        writeHead(0, value);
+    }
+    void writeInt(int64_t value)
+    {
+        if (value >= 0)
+            writeHead(0, static_cast<uint64_t>(value));
+        else
+            writeHead(1, ~static_cast<uint64_t>(value));
+    }
+    void writeDouble(double value)
+    {
+        output_.push_back('\xfb');
+        appendBigEndian(output_, doubleBits(value), 8);
+    }
+    void writeString(const char *str, size_t length)
+    {
+        writeHead(3, length);
+        output_.append(str, length);
+    }
+    void beginArray(size_t size)
+    {
+        writeHead(4, size);
+    }
+    void beginObject(size_t size)
+    {
+        writeHead(5, size);
+    }
+
+  private:
+    void writeHead(int major, uint64_t value)
+    {
+        auto type = static_cast<char>(major << 5);
+        if (value < 24)
+        {
+            output_.push_back(static_cast<char>(type | value));
+        }
+        else if (value <= 0xff)
+        {
+            output_.push_back(static_cast<char>(type | 24));
+            appendBigEndian(output_, value, 1);
+        }
+        else if (value <= 0xffff)
+        {
+            output_.push_back(static_cast<char>(type | 25));
+            appendBigEndian(output_, value, 2);
+        }
+        else if (value <= 0xffffffff)
+        {
+            output_.push_back(static_cast<char>(type | 26));
+            appendBigEndian(output_, value, 4);
+        }
+        else
+        {
+            output_.push_back(static_cast<char>(type | 27));
+            appendBigEndian(output_, value, 8);
+        }
+    }
+    std::string &output_;
+};
+
+template <typename Writer>
+void encodeValue(const Json::Value &value, Writer &writer)
+{
+    switch (value.type())
+    {
+        case Json::nullValue:
+            writer.writeNull();
+            break;
+        case Json::intValue:
+            writer.writeInt(value.asLargestInt());
+            break;
+        case Json::uintValue:
+            writer.writeUInt(value.asLargestUInt());
+            break;
+        case Json::realValue:
+            writer.writeDouble(value.asDouble());
+            break;
+        case Json::stringValue:
+        {
+            char const *begin;
+            char const *end;
+            if (value.getString(&begin, &end))
+                writer.writeString(begin, end - begin);
+            else
+                writer.writeString("", 0);
+            break;
+        }
+        case Json::booleanValue:
+            writer.writeBool(value.asBool());
+            break;
+        case Json::arrayValue:
+            writer.beginArray(value.size());
+            for (auto const &item : value)
+                encodeValue(item, writer);
+            break;
+        case Json::objectValue:
+            writer.beginObject(value.size());
+            for (auto iter = value.begin(); iter != value.end(); ++iter)
+            {
+                char const *end;
+                auto name = iter.memberName(&end);
+                writer.writeString(name, end - name);
+                encodeValue(*iter, writer);
+            }
+            break;
+    }
+}
+
+template <typename Writer>
+void encodeView(const JsonView &value, Writer &writer)
+{
+    switch (value.type())
+    {
+        case JsonView::kInvalid:
+        case JsonView::kNull:
+            writer.writeNull();
+            break;
+        case JsonView::kBool:
+            writer.writeBool(value.asBool());
+            break;
+        case JsonView::kNumber:
+            // Numbers are typed in the same way as they are by jsoncpp.
+            encodeValue(value.toJsonValue(), writer);
+            break;
+        case JsonView::kString:
+        {
+            auto str = value.asString();
+            writer.writeString(str.data(), str.length());
+            break;
+        }
+        case JsonView::kArray:
+            writer.beginArray(value.size());
+            value.forEachElement(
+                [&writer](const JsonView &item) { encodeView(item, writer); });
+            break;
+        case JsonView::kObject:
+            writer.beginObject(value.size());
+            value.forEachMember(
+                [&writer](const std::string &key, const JsonView &item) {
+                    writer.writeString(key.data(), key.length());
+                    encodeView(item, writer);
+                });
+            break;
+    }
+}
+
+/// Builds a Json::Value from the events of a decoder.
+class ValueBuilder
+{
+  public:
+    explicit ValueBuilder(Json::Value &root) : root_(root)
+    {
+    }
+    void null()
+    {
+        place(Json::Value());
+    }
+    void boolean(bool value)
+    {
+        place(Json::Value(value));
+    }
+    void int64(int64_t value)
+    {
+        place(Json::Value(static_cast<Json::Int64>(value)));
+    }
+    void uint64(uint64_t value)
+    {
+        // The same types as the ones chosen by the jsoncpp reader.
+        if (value <= static_cast<uint64_t>(INT64_MAX))
+            place(Json::Value(static_cast<Json::Int64>(value)));
+        else
+            place(Json::Value(static_cast<Json::UInt64>(value)));
+    }
+    void real(double value)
+    {
+        place(Json::Value(value));
+    }
+    void string(const char *str, size_t length)
+    {
+        place(Json::Value(str, str + length));
+    }
+    void beginArray()
+    {
+        containers_.push_back(&place(Json::Value(Json::arrayValue)));
+    }
+    void beginObject()
+    {
+        containers_.push_back(&place(Json::Value(Json::objectValue)));
+    }
+    void end()
+    {
+        containers_.pop_back();
+    }
+    void key(const char *str, size_t length)
+    {
+        key_.assign(str, length);
+    }
+
+  private:
+    Json::Value &place(Json::Value &&value)
+    {
+        if (containers_.empty())
+        {
+            root_ = std::move(value);
+            return root_;
+        }
+        auto &container = *containers_.back();
+        if (container.isArray())
+            return container.append(std::move(value));
+        auto &member = container[key_];
+        member = std::move(value);
+        return member;
+    }
+    Json::Value &root_;
+    std::vector<Json::Value *> containers_;
+    std::string key_;
+};
+
+/// Writes the json text from the events of a decoder.
+class TextBuilder
+{
+  public:
+    explicit TextBuilder(std::string &output) : output_(output)
+    {
+    }
+    void null()
+    {
+        separate();
+        output_.append("null", 4);
+    }
+    void boolean(bool value)
+    {
+        separate();
+        if (value)
+            output_.append("true", 4);
+        else
+            output_.append("false", 5);
+    }
+    void int64(int64_t value)
+    {
+        separate();
+        internal::appendJsonInt(value, output_);
+    }
+    void uint64(uint64_t value)
+    {
+        separate();
+        internal::appendJsonUInt(value, output_);
+    }
+    void real(double value)
+    {
+        separate();
+        internal::appendJsonDouble(value, output_);
+    }
+    void string(const char *str, size_t length)
+    {
+        separate();
+        internal::appendJsonString(str, length, output_);
+    }
+    void beginArray()
+    {
+        separate();
+        output_.push_back('[');
+        closers_.push_back(']');
+        first_ = true;
+    }
+    void beginObject()
+    {
+        separate();
+        output_.push_back('{');
+        closers_.push_back('}');
+        first_ = true;
+    }
+    void end()
+    {
+        output_.push_back(closers_.back());
+        closers_.pop_back();
+        first_ = false;
+    }
+    void key(const char *str, size_t length)
+    {
+        separate();
+        internal::appendJsonString(str, length, output_);
+        output_.push_back(':');
+        afterKey_ = true;
+    }
+
+  private:
+    void separate()
+    {
+        if (afterKey_)
+            afterKey_ = false;
+        else if (!first_)
+            output_.push_back(',');
+        first_ = false;
+    }
+    std::string &output_;
+    std::vector<char> closers_;
+    bool first_{true};
+    bool afterKey_{false};
+};
+
+class DecoderBase
+{
+  protected:
+    DecoderBase(const string_view &data, std::string *errorMessage)
+        : p_(reinterpret_cast<const unsigned char *>(data.data())),
+          end_(p_ + data.length()),
+          begin_(p_),
+          errorMessage_(errorMessage)
+    {
+    }
+    bool fail(const char *message)
+    {
+        if (errorMessage_)
+            *errorMessage_ = std::string(message) + " at position " +
+                             std::to_string(p_ - begin_);
+        return false;
+    }
+    bool readBigEndian(int bytes, uint64_t &value)
+    {
+        if (end_ - p_ < bytes)
+            return fail("Unexpected end");
+        value = 0;
+        for (int i = 0; i < bytes; ++i)
+            value = (value << 8) | *p_++;
+        return true;
+    }
+    bool readBytes(uint64_t length, const char *&data)
+    {
+        if (static_cast<uint64_t>(end_ - p_) < length)
+            return fail("Unexpected end");
+        data = reinterpret_cast<const char *>(p_);
+        p_ += length;
+        return true;
+    }
+    bool finish()
+    {
+        if (p_ != end_)
+            return fail("Extra bytes");
+        return true;
+    }
+    static double bitsToDouble(uint64_t bits)
+    {
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    static double bitsToFloat(uint64_t bits)
+    {
+        auto bits32 = static_cast<uint32_t>(bits);
+        float value;
+        memcpy(&value, &bits32, sizeof(value));
+        return value;
+    }
+
+    const unsigned char *p_;
+    const unsigned char *end_;
+    const unsigned char *begin_;
+    std::string *errorMessage_;
+};
+
+template <typename Builder>
+class MsgPackDecoder : public DecoderBase
+{
+  public:
+    MsgPackDecoder(const string_view &data,
+                   Builder &builder,
+                   std::string *errorMessage)
+        : DecoderBase(data, errorMessage), builder_(builder)
+    {
+    }
+    bool decode()
+    {
+        return decodeValue(0) && finish();
+    }
+
+  private:
+    bool decodeValue(size_t depth)
+    {
+        if (p_ == end_)
+            return fail("Unexpected end");
+        auto head = *p_++;
+        uint64_t value = 0;
+        if (head < 0x80)
+        {
+            builder_.uint64(head);
+            return true;
+        }
+        if (head >= 0xe0)
+        {
+            builder_.int64(static_cast<int8_t>(head));
+            return true;
+        }
+        if ((head & 0xe0) == 0xa0)
+            return decodeString(head & 0x1f, false);
+        if ((head & 0xf0) == 0x90)
+            return decodeArray(head & 0x0f, depth);
+        if ((head & 0xf0) == 0x80)
+            return decodeMap(head & 0x0f, depth);
+        switch (head)
+        {
+            case 0xc0:
+                builder_.null();
+                return true;
+            case 0xc2:
+            case 0xc3:
+                builder_.boolean(head == 0xc3);
+                return true;
+            case 0xc4:
+            case 0xd9:
+                return readBigEndian(1, value) && decodeString(value, false);
+            case 0xc5:
+            case 0xda:
+                return readBigEndian(2, value) && decodeString(value, false);
+            case 0xc6:
+            case 0xdb:
+                return readBigEndian(4, value) && decodeString(value, false);
+            case 0xca:
+                if (!readBigEndian(4, value))
+                    return false;
+                builder_.real(bitsToFloat(value));
+                return true;
+            case 0xcb:
+                if (!readBigEndian(8, value))
+                    return false;
+                builder_.real(bitsToDouble(value));
+                return true;
+            case 0xcc:
+            case 0xcd:
+            case 0xce:
+            case 0xcf:
+                if (!readBigEndian(1 << (head - 0xcc), value))
+                    return false;
+                builder_.uint64(value);
+                return true;
+            case 0xd0:
+                if (!readBigEndian(1, value))
+                    return false;
+                builder_.int64(static_cast<int8_t>(value));
+                return true;
+            case 0xd1:
+                if (!readBigEndian(2, value))
+                    return false;
+                builder_.int64(static_cast<int16_t>(value));
+                return true;
+            case 0xd2:
+                if (!readBigEndian(4, value))
+                    return false;
+                builder_.int64(static_cast<int32_t>(value));
+                return true;
+            case 0xd3:
+                if (!readBigEndian(8, value))
+                    return false;
+                builder_.int64(static_cast<int64_t>(value));
+                return true;
+            case 0xdc:
+                return readBigEndian(2, value) && decodeArray(value, depth);
+            case 0xdd:
+                return readBigEndian(4, value) && decodeArray(value, depth);
+            case 0xde:
+                return readBigEndian(2, value) && decodeMap(value, depth);
+            case 0xdf:
+                return readBigEndian(4, value) && decodeMap(value, depth);
+            default:
+                // 0xc1 is never used, and the extension types have no json
+                // representation.
+                --p_;
+                return fail("Unsupported type");
+        }
+    }
+    bool decodeString(uint64_t length, bool isKey)
+    {
+        const char *data = nullptr;
+        if (!readBytes(length, data))
+            return false;
+        if (isKey)
+            builder_.key(data, length);
+        else
+            builder_.string(data, length);
+        return true;
+    }
+    bool decodeArray(uint64_t size, size_t depth)
+    {
+        if (depth >= maxDepth)
+            return fail("Too deep nesting");
+        builder_.beginArray();
+        for (uint64_t i = 0; i < size; ++i)
+        {
+            if (!decodeValue(depth + 1))
+                return false;
+        }
+        builder_.end();
+        return true;
+    }
+    bool decodeMap(uint64_t size, size_t depth)
+    {
+        if (depth >= maxDepth)
+            return fail("Too deep nesting");
+        builder_.beginObject();
+        for (uint64_t i = 0; i < size; ++i)
+        {
+            if (!decodeKey() || !decodeValue(depth + 1))
+                return false;
+        }
+        builder_.end();
+        return true;
+    }
+    bool decodeKey()
+    {
+        if (p_ == end_)
+            return fail("Unexpected end");
+        auto head = *p_++;
+        uint64_t value = 0;
+        if ((head & 0xe0) == 0xa0)
+            return decodeString(head & 0x1f, true);
+        if (head < 0x80)
+            return integerKey(head);
+        switch (head)
+        {
+            case 0xc4:
+            case 0xd9:
+                return readBigEndian(1, value) && decodeString(value, true);
+            case 0xc5:
+            case 0xda:
+                return readBigEndian(2, value) && decodeString(value, true);
+            case 0xc6:
+            case 0xdb:
+                return readBigEndian(4, value) && decodeString(value, true);
+            case 0xcc:
+            case 0xcd:
+            case 0xce:
+            case 0xcf:
+                return readBigEndian(1 << (head - 0xcc), value) &&
+                       integerKey(value);
+            default:
+                --p_;
+                return fail("Unsupported map key");
+        }
+    }
+    bool integerKey(uint64_t value)
+    {
+        auto key = std::to_string(value);
+        builder_.key(key.data(), key.length());
+        return true;
+    }
+
+    Builder &builder_;
+};
+
+template <typename Builder>
+class CborDecoder : public DecoderBase
+{
+  public:
+    CborDecoder(const string_view &data,
+                Builder &builder,
+                std::string *errorMessage)
+        : DecoderBase(data, errorMessage), builder_(builder)
+    {
+    }
+    bool decode()
+    {
+        return decodeValue(0) && finish();
+    }
+
+  private:
+    static const uint64_t indefinite = ~uint64_t(0);
+
+    // Read the head of an item, the argument is set to indefinite for the
+    // items with indefinite lengths.
+    bool readHead(int &major, int &info, uint64_t &argument)
+    {
+        if (p_ == end_)
+            return fail("Unexpected end");
+        major = *p_ >> 5;
+        info = *p_ & 0x1f;
+        ++p_;
+        if (info < 24)
+        {
+            argument = info;
+            return true;
+        }
+        if (info <= 27)
+            return readBigEndian(1 << (info - 24), argument);
+        if (info == 31 && major >= 2 && major <= 5)
+        {
+            argument = indefinite;
+            return true;
+        }
+        if (info == 31 && major == 7)
+        {
+            // The "break" code, checked by the callers.
+            argument = indefinite;
+            return true;
+        }
+        --p_;
+        return fail("Invalid head");
+    }
+    bool isBreak()
+    {
+        if (p_ == end_)
+            return fail("Unexpected end");
+        if (*p_ == 0xff)
+        {
+            ++p_;
+            return true;
+        }
+        return false;
+    }
+    // Read a string, the chunks of an indefinite length string are joined.
+    bool readString(int major, uint64_t length, std::string &buffer,
+                    const char *&data, uint64_t &size)
+    {
+        if (length != indefinite)
+        {
+            size = length;
+            return readBytes(length, data);
+        }
+        buffer.clear();
+        while (!isBreak())
+        {
+            if (p_ == end_)
+                return false;
+            int chunkMajor = 0, info = 0;
+            uint64_t chunkLength = 0;
+            if (!readHead(chunkMajor, info, chunkLength))
+                return false;
+            if (chunkMajor != major || chunkLength == indefinite)
+                return fail("Invalid string chunk");
+            const char *chunk = nullptr;
+            if (!readBytes(chunkLength, chunk))
+                return false;
+            buffer.append(chunk, chunkLength);
+        }
+        data = buffer.data();
+        size = buffer.length();
+        return true;
+    }
+    bool decodeValue(size_t depth)
+    {
+        int major = 0, info = 0;
+        uint64_t argument = 0;
+        if (!readHead(major, info, argument))
+            return false;
+        switch (major)
+        {
+            case 0:
+                builder_.uint64(argument);
+                return true;
+            case 1:
+                if (argument > static_cast<uint64_t>(INT64_MAX))
+                    builder_.real(-1.0 - static_cast<double>(argument));
+                else
+                    builder_.int64(-1 - static_cast<int64_t>(argument));
+                return true;
+            case 2:
+            case 3:
+            {
+                std::string buffer;
+                const char *data = nullptr;
+                uint64_t size = 0;
+                if (!readString(major, argument, buffer, data, size))
+                    return false;
+                builder_.string(data, size);
+                return true;
+            }
+            case 4:
+            {
+                if (depth >= maxDepth)
+                    return fail("Too deep nesting");
+                builder_.beginArray();
+                for (uint64_t i = 0; argument == indefinite || i < argument;
+                     ++i)
+                {
+                    if (argument == indefinite)
+                    {
+                        if (isBreak())
+                            break;
+                        if (p_ == end_)
+                            return false;
+                    }
+                    if (!decodeValue(depth + 1))
+                        return false;
+                }
+                builder_.end();
+                return true;
+            }
+            case 5:
+            {
+                if (depth >= maxDepth)
+                    return fail("Too deep nesting");
+                builder_.beginObject();
+                for (uint64_t i = 0; argument == indefinite || i < argument;
+                     ++i)
+                {
+                    if (argument == indefinite)
+                    {
+                        if (isBreak())
+                            break;
+                        if (p_ == end_)
+                            return false;
+                    }
+                    if (!decodeKey() || !decodeValue(depth + 1))
+                        return false;
+                }
+                builder_.end();
+                return true;
+            }
+            case 6:
+                // Tags only add semantics to the tagged item.
+                if (depth >= maxDepth)
+                    return fail("Too deep nesting");
+                return decodeValue(depth + 1);
+            default:
+                return decodeSimple(info, argument);
+        }
+    }
+    bool decodeSimple(int info, uint64_t argument)
+    {
+        switch (info)
+        {
+            case 20:
+            case 21:
+                builder_.boolean(info == 21);
+                return true;
+            case 22:
+            case 23:
+                // null and undefined
+                builder_.null();
+                return true;
+            case 25:
+                builder_.real(halfToDouble(static_cast<uint16_t>(argument)));
+                return true;
+            case 26:
+                builder_.real(bitsToFloat(argument));
+                return true;
+            case 27:
+                builder_.real(bitsToDouble(argument));
+                return true;
+            default:
+                --p_;
+                return fail("Unsupported simple value");
+        }
+    }
+    bool decodeKey()
+    {
+        int major = 0, info = 0;
+        uint64_t argument = 0;
+        if (!readHead(major, info, argument))
+            return false;
+        if (major == 2 || major == 3)
+        {
+            std::string buffer;
+            const char *data = nullptr;
+            uint64_t size = 0;
+            if (!readString(major, argument, buffer, data, size))
+                return false;
+            builder_.key(data, size);
+            return true;
+        }
+        if (major == 0 || (major == 1 && argument < static_cast<uint64_t>(INT64_MAX)))
+        {
+            auto key = major == 0
+                           ? std::to_string(argument)
+                           : std::to_string(-1 - static_cast<int64_t>(argument));
+            builder_.key(key.data(), key.length());
+            return true;
+        }
+        return fail("Unsupported map key");
+    }
+    static double halfToDouble(uint16_t half)
+    {
+        int exponent = (half >> 10) & 0x1f;
+        int mantissa = half & 0x3ff;
+        double value;
+        if (exponent == 0)
+            value = ldexp(mantissa, -24);
+        else if (exponent != 31)
+            value = ldexp(mantissa + 1024, exponent - 25);
+        else
+            value = mantissa == 0 ? HUGE_VAL : NAN;
+        return (half & 0x8000) ? -value : value;
+    }
+
+    Builder &builder_;
+};
+
+template <typename Builder>
+bool decode(const string_view &data,
+            ContentType type,
+            Builder &builder,
+            std::string *errorMessage)
+{
+    if (type == CT_APPLICATION_MSGPACK)
+        return MsgPackDecoder<Builder>(data, builder, errorMessage).decode();
+    if (type == CT_APPLICATION_CBOR)
+        return CborDecoder<Builder>(data, builder, errorMessage).decode();
+    if (errorMessage)
+        *errorMessage = "Unsupported content type";
+    return false;
+}
+}  // namespace
+
+void drogon::encodeBinaryJson(const Json::Value &value,
+                              ContentType type,
+                              std::string &output)
+{
+    if (type == CT_APPLICATION_CBOR)
+    {
+        CborWriter writer(output);
+        encodeValue(value, writer);
+    }
+    else
+    {
+        assert(type == CT_APPLICATION_MSGPACK);
+        MsgPackWriter writer(output);
+        encodeValue(value, writer);
+    }
+}
+
+void drogon::encodeBinaryJson(const JsonView &value,
+                              ContentType type,
+                              std::string &output)
+{
+    if (type == CT_APPLICATION_CBOR)
+    {
+        CborWriter writer(output);
+        encodeView(value, writer);
+    }
+    else
+    {
+        assert(type == CT_APPLICATION_MSGPACK);
+        MsgPackWriter writer(output);
+        encodeView(value, writer);
+    }
+}
+
+bool drogon::decodeBinaryJson(const string_view &data,
+                              ContentType type,
+                              Json::Value &value,
+                              std::string *errorMessage)
+{
+    ValueBuilder builder(value);
+    return decode(data, type, builder, errorMessage);
+}
+
+bool drogon::binaryJsonToText(const string_view &data,
+                              ContentType type,
+                              std::string &output,
+                              std::string *errorMessage)
+{
+    TextBuilder builder(output);
+    return decode(data, type, builder, errorMessage);
+}
@@ -0,0 +1,68 @@
+/**
+ *
+ *  CancellationToken.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/CancellationToken.h>
+#include <algorithm>
+
+using namespace drogon;
+
+void CancellationToken::cancel()
+{
+    std::vector<std::pair<uint64_t, std::function<void()>>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_.exchange(true, std::memory_order_acq_rel))
+            return;
+        callbacks.swap(callbacks_);
+    }
+    for (auto &callback : callbacks)
+        callback.second();
+}
+
+uint64_t CancellationToken::onCancel(std::function<void()> &&callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cancelled_.load(std::memory_order_relaxed))
+        return 0;
+    auto id = ++nextCallbackId_;
+    callbacks_.emplace_back(id, std::move(callback));
+    return id;
+}
+
+void CancellationToken::removeCallback(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = std::find_if(callbacks_.begin(),
+                             callbacks_.end(),
+                             [id](const std::pair<uint64_t,
+                                                  std::function<void()>> &cb) {
+                                 return cb.first == id;
+                             });
+    if (iter != callbacks_.end())
+        callbacks_.erase(iter);
+}
+
+void CancellationToken::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_.store(false, std::memory_order_relaxed);
+    deadline_.store(0, std::memory_order_relaxed);
+    callbacks_.clear();
+}
+
+CancellationToken *&CancellationToken::currentRef()
+{
+    thread_local CancellationToken *token = nullptr;
+    return token;
+}
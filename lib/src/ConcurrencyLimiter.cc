@@ -0,0 +1,380 @@
+/**
+ *
+ *  drogon_plugin_ConcurrencyLimiter.cc
+ *
+ */
+#include <drogon/plugins/ConcurrencyLimiter.h>
+#include <drogon/utils/Metrics.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <mutex>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+std::atomic<ConcurrencyLimiter *> ConcurrencyLimiter::current_{nullptr};
+
+namespace
+{
+int64_t steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+}  // namespace
+
+class ConcurrencyLimiter::Limiter : public trantor::NonCopyable
+{
+  public:
+    Limiter(const std::string &name, const Json::Value &config)
+    {
+        auto algorithm = config.get("algorithm", "gradient").asString();
+        if (algorithm != "gradient" && algorithm != "aimd")
+            LOG_ERROR << "Unknown concurrency limit algorithm " << algorithm
+                      << ", use gradient";
+        gradient_ = (algorithm != "aimd");
+        minLimit_ = std::max(config.get("min_limit", 10).asUInt64(),
+                             static_cast<Json::UInt64>(1));
+        maxLimit_ = std::max(config.get("max_limit", 1000).asUInt64(),
+                             static_cast<Json::UInt64>(minLimit_));
+        auto initialLimit = config.get("initial_limit", 100).asUInt64();
+        initialLimit = std::min(std::max(initialLimit, minLimit_), maxLimit_);
+        estimatedLimit_ = static_cast<double>(initialLimit);
+        limit_.store(initialLimit, std::memory_order_relaxed);
+        window_ = static_cast<int64_t>(
+            config.get("window", 1.0).asDouble() * 1000000000.0);
+        minWindowSamples_ = std::max(
+            config.get("min_window_samples", 10).asUInt64(),
+            static_cast<Json::UInt64>(1));
+        rttTolerance_ = config.get("rtt_tolerance", 1.5).asDouble();
+        smoothing_ = config.get("smoothing", 0.2).asDouble();
+        longWindow_ = std::max(config.get("long_window", 100).asDouble(), 1.0);
+        latencyThreshold_ =
+            config.get("latency_threshold", 0.5).asDouble() * 1000000000.0;
+        backoffRatio_ = config.get("backoff_ratio", 0.9).asDouble();
+
+        auto &registry = MetricsRegistry::instance();
+        limitGauge_ = registry.gauge(
+            "drogon_concurrency_limit",
+            "The limit of the concurrent requests of a limiter",
+            {{"limiter", name}});
+        limitGauge_->add(static_cast<int64_t>(initialLimit));
+        inFlightGauge_ = registry.gauge(
+            "drogon_concurrency_in_flight",
+            "The requests being handled counted by a limiter",
+            {{"limiter", name}});
+        rejected_ = registry.counter(
+            "drogon_concurrency_rejected_requests_total",
+            "The requests rejected by a limiter",
+            {{"limiter", name}});
+        windowStart_ = steadyNanoseconds();
+    }
+    ~Limiter()
+    {
+        // The metrics outlive the limiter in the registry.
+        limitGauge_->sub(
+            static_cast<int64_t>(limit_.load(std::memory_order_relaxed)));
+    }
+
+    /// Take a slot if fewer requests than the ratio of the limit are being
+    /// handled.
+    bool tryAcquire(double ratio)
+    {
+        auto limit = static_cast<size_t>(
+            ratio * limit_.load(std::memory_order_relaxed));
+        auto inFlight = inFlight_.load(std::memory_order_relaxed);
+        do
+        {
+            if (inFlight >= limit)
+            {
+                rejected_->add();
+                return false;
+            }
+        } while (!inFlight_.compare_exchange_weak(inFlight,
+                                                  inFlight + 1,
+                                                  std::memory_order_relaxed));
+        acquired(inFlight + 1);
+        return true;
+    }
+    /// Take a slot regardless of the limit.
+    void acquire()
+    {
+        acquired(inFlight_.fetch_add(1, std::memory_order_relaxed) + 1);
+    }
+    /// Release a slot.
+    /**
+     * @param latency The nanoseconds the request took, negative if the
+     * request was not responded, it's not sampled then.
+     */
+    void release(int64_t latency)
+    {
+        inFlight_.fetch_sub(1, std::memory_order_relaxed);
+        inFlightGauge_->sub();
+        if (latency >= 0)
+            sample(latency);
+    }
+
+  private:
+    void acquired(size_t inFlight)
+    {
+        inFlightGauge_->add();
+        // A racy maximum is good enough for deciding whether the limit is
+        // used.
+        if (inFlight > maxInFlight_.load(std::memory_order_relaxed))
+            maxInFlight_.store(inFlight, std::memory_order_relaxed);
+    }
+    void sample(int64_t latency)
+    {
+        auto now = steadyNanoseconds();
+        std::lock_guard<std::mutex> lock(mutex_);
+        latencySum_ += latency;
+        ++samples_;
+        if (samples_ < minWindowSamples_ || now - windowStart_ < window_)
+            return;
+        auto shortRtt = static_cast<double>(latencySum_) / samples_;
+        auto maxInFlight =
+            maxInFlight_.exchange(inFlight_.load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+        latencySum_ = 0;
+        samples_ = 0;
+        windowStart_ = now;
+
+        auto limit = estimatedLimit_;
+        // The limit is not reached, the latency says nothing about it.
+        bool limited = maxInFlight * 2 >= limit;
+        if (gradient_)
+        {
+            if (longRtt_ <= 0.0)
+                longRtt_ = shortRtt;
+            else
+                longRtt_ += (shortRtt - longRtt_) / longWindow_;
+            // Recover quickly from a long period of high latencies.
+            if (longRtt_ / shortRtt > 2.0)
+                longRtt_ *= 0.95;
+            if (!limited)
+                return;
+            auto ratio = rttTolerance_ * longRtt_ / shortRtt;
+            auto gradient = std::max(0.5, std::min(1.0, ratio));
+            auto newLimit = limit * gradient + sqrt(limit);
+            limit = limit * (1.0 - smoothing_) + newLimit * smoothing_;
+        }
+        else if (shortRtt > latencyThreshold_)
+        {
+            limit *= backoffRatio_;
+        }
+        else if (limited)
+        {
+            limit += 1.0;
+        }
+        limit = std::max(limit, static_cast<double>(minLimit_));
+        estimatedLimit_ = std::min(limit, static_cast<double>(maxLimit_));
+        auto newLimit = static_cast<size_t>(estimatedLimit_);
+        auto oldLimit = limit_.exchange(newLimit, std::memory_order_relaxed);
+        if (newLimit != oldLimit)
+        {
+            limitGauge_->add(static_cast<int64_t>(newLimit) -
+                             static_cast<int64_t>(oldLimit));
+            LOG_TRACE << "Concurrency limit " << oldLimit << " -> "
+                      << newLimit << ", latency " << shortRtt / 1000000.0
+                      << "ms";
+        }
+    }
+
+    bool gradient_{true};
+    size_t minLimit_{10};
+    size_t maxLimit_{1000};
+    int64_t window_{1000000000};
+    size_t minWindowSamples_{10};
+    double rttTolerance_{1.5};
+    double smoothing_{0.2};
+    double longWindow_{100.0};
+    double latencyThreshold_{500000000.0};
+    double backoffRatio_{0.9};
+
+    std::atomic<size_t> limit_{0};
+    std::atomic<size_t> inFlight_{0};
+    std::atomic<size_t> maxInFlight_{0};
+
+    std::mutex mutex_;
+    // Guarded by the mutex.
+    double estimatedLimit_{0.0};
+    double longRtt_{0.0};
+    int64_t windowStart_{0};
+    int64_t latencySum_{0};
+    size_t samples_{0};
+
+    std::shared_ptr<MetricGauge> limitGauge_;
+    std::shared_ptr<MetricGauge> inFlightGauge_;
+    std::shared_ptr<MetricCounter> rejected_;
+};
+
+// The slots an admitted request takes in the limiters, released when the
+// response is produced or the callback is destroyed without a response.
+struct ConcurrencyLimiter::Permit : public trantor::NonCopyable
+{
+    ~Permit()
+    {
+        release(-1);
+    }
+    void release(int64_t latency)
+    {
+        if (released_)
+            return;
+        released_ = true;
+        global_->release(latency);
+        if (route_)
+            route_->release(latency);
+    }
+    std::shared_ptr<Limiter> global_;
+    std::shared_ptr<Limiter> route_;
+    int64_t start_{0};
+    bool released_{false};
+};
+
+ConcurrencyLimiter::ConcurrencyLimiter()
+{
+}
+
+ConcurrencyLimiter::~ConcurrencyLimiter()
+{
+}
+
+void ConcurrencyLimiter::initAndStart(const Json::Value &config)
+{
+    lowPriorityRatio_ =
+        config.get("low_priority_ratio", lowPriorityRatio_).asDouble();
+    auto retryAfter = config.get("retry_after", 1).asUInt();
+    retryAfter_ = retryAfter > 0 ? std::to_string(retryAfter) : "";
+
+    auto limiterConfig = config;
+    limiterConfig.removeMember("routes");
+    limiterConfig.removeMember("priorities");
+    global_ = std::make_shared<Limiter>("global", limiterConfig);
+    for (auto &route : config["routes"])
+    {
+        auto path = route.get("path", "").asString();
+        auto routeConfig = limiterConfig;
+        for (auto &name : route.getMemberNames())
+            routeConfig[name] = route[name];
+        try
+        {
+            std::regex regex(path);
+            auto limiter = std::make_shared<Limiter>(path, routeConfig);
+            routes_.push_back({std::move(regex), std::move(limiter)});
+        }
+        catch (const std::regex_error &e)
+        {
+            LOG_ERROR << "Invalid route path " << path
+                      << " of the concurrency limiter: " << e.what();
+        }
+    }
+    for (auto &rule : config["priorities"])
+    {
+        auto path = rule.get("path", "").asString();
+        auto name = rule.get("class", "normal").asString();
+        Priority priority;
+        if (name == "critical")
+            priority = kCritical;
+        else if (name == "low")
+            priority = kLow;
+        else
+        {
+            if (name != "normal")
+                LOG_ERROR << "Unknown priority class " << name
+                          << ", use normal";
+            priority = kNormal;
+        }
+        try
+        {
+            std::regex regex(path);
+            priorities_.push_back({std::move(regex),
+                                   rule.get("method", "").asString(),
+                                   priority});
+        }
+        catch (const std::regex_error &e)
+        {
+            LOG_ERROR << "Invalid priority path " << path
+                      << " of the concurrency limiter: " << e.what();
+        }
+    }
+    current_.store(this, std::memory_order_release);
+}
+
+void ConcurrencyLimiter::shutdown()
+{
+    current_.store(nullptr, std::memory_order_release);
+}
+
+bool ConcurrencyLimiter::admit(
+    const HttpRequestPtr &req,
+    std::function<void(const HttpResponsePtr &)> &callback)
+{
+    std::shared_ptr<Limiter> route;
+    for (auto &rule : routes_)
+    {
+        if (std::regex_search(req->path(), rule.regex_))
+        {
+            route = rule.limiter_;
+            break;
+        }
+    }
+    auto requestPriority = priority(req);
+    if (requestPriority == kCritical)
+    {
+        if (route)
+            route->acquire();
+        global_->acquire();
+    }
+    else
+    {
+        auto ratio = requestPriority == kLow ? lowPriorityRatio_ : 1.0;
+        if (route && !route->tryAcquire(ratio))
+        {
+            reject(callback);
+            return false;
+        }
+        if (!global_->tryAcquire(ratio))
+        {
+            if (route)
+                route->release(-1);
+            reject(callback);
+            return false;
+        }
+    }
+    auto permit = std::make_shared<Permit>();
+    permit->global_ = global_;
+    permit->route_ = std::move(route);
+    permit->start_ = steadyNanoseconds();
+    callback = [permit, callback = std::move(callback)](
+                   const HttpResponsePtr &resp) {
+        permit->release(steadyNanoseconds() - permit->start_);
+        callback(resp);
+    };
+    return true;
+}
+
+ConcurrencyLimiter::Priority ConcurrencyLimiter::priority(
+    const HttpRequestPtr &req) const
+{
+    for (auto &rule : priorities_)
+    {
+        if (!rule.method_.empty() && rule.method_ != req->methodString())
+            continue;
+        if (std::regex_search(req->path(), rule.regex_))
+            return rule.priority_;
+    }
+    return kNormal;
+}
+
+void ConcurrencyLimiter::reject(
+    const std::function<void(const HttpResponsePtr &)> &callback) const
+{
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setStatusCode(k503ServiceUnavailable);
+    if (!retryAfter_.empty())
+        resp->addHeader("Retry-After", retryAfter_);
+    callback(resp);
+}
@@ -327,6 +327,35 @@ static void loadApp(const Json::Value &app)
     drogon::app().setKeepaliveRequestsNumber(keepaliveReqs);
     auto pipeliningReqs = app.get("pipelining_requests", 0).asUInt64();
     drogon::app().setPipeliningRequestsNumber(pipeliningReqs);
+    auto serverTimingRate = app.get("server_timing_sample_rate", 0).asDouble();
+    drogon::app().setServerTimingSampleRate(serverTimingRate);
+    auto loopMonitorInterval = app.get("loop_monitor_interval", 0).asDouble();
+    if (loopMonitorInterval > 0)
+    {
+        drogon::app().enableEventLoopMonitor(
+            loopMonitorInterval,
+            app.get("loop_watchdog_threshold", 0).asDouble(),
+            app.get("loop_watchdog_dump_stacks", false).asBool());
+    }
+    auto gracefulShutdownTimeout =
+        app.get("graceful_shutdown_timeout", 0).asDouble();
+    drogon::app().setGracefulShutdownTimeout(gracefulShutdownTimeout);
+    auto hotRestartSocket = app.get("hot_restart_socket", "").asString();
+    if (!hotRestartSocket.empty())
+        drogon::app().enableHotRestart(hotRestartSocket);
+    auto requestTimeout = app.get("request_timeout", 0).asDouble();
+    drogon::app().setRequestTimeout(requestTimeout);
+    for (auto &route : app["route_timeouts"])
+    {
+        drogon::app().setRequestTimeout(route.get("timeout", 0).asDouble(),
+                                        route.get("path", "").asString());
+    }
+    auto requestTimeoutHeader =
+        app.get("request_timeout_header", "").asString();
+    if (!requestTimeoutHeader.empty())
+        drogon::app().setRequestTimeoutHeader(requestTimeoutHeader);
+    auto dbWarmUpTimeout = app.get("db_warm_up_timeout", 5.0).asDouble();
+    drogon::app().setDbWarmUpTimeout(dbWarmUpTimeout);
     auto useGzipStatic = app.get("gzip_static", true).asBool();
     drogon::app().setGzipStatic(useGzipStatic);
     auto maxBodySize = app.get("client_max_body_size", "1M").asString();
@@ -387,6 +416,9 @@ static void loadDbClients(const Json::Value &dbClients)
         auto name = client.get("name", "default").asString();
         auto filename = client.get("filename", "").asString();
         auto isFast = client.get("is_fast", false).asBool();
+        auto maxConnNum = client.get("max_connection_number", 0).asUInt();
+        auto keepaliveInterval =
+            client.get("keepalive_interval", 0.0).asDouble();
         drogon::app().createDbClient(type,
                                      host,
                                      (unsigned short)port,
@@ -396,7 +428,9 @@ static void loadDbClients(const Json::Value &dbClients)
                                      connNum,
                                      filename,
                                      name,
-                                     isFast);
+                                     isFast,
+                                     maxConnNum,
+                                     keepaliveInterval);
     }
 }
 static void loadListeners(const Json::Value &listeners)
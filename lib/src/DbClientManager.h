@@ -17,6 +17,7 @@
 #include <drogon/orm/DbClient.h>
 #include <drogon/HttpAppFramework.h>
 #include <drogon/IOThreadStorage.h>
+#include <drogon/utils/ServerState.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoop.h>
 #include <string>
@@ -51,7 +52,19 @@ class DbClientManager : public trantor::NonCopyable
                         const size_t connectionNum,
                         const std::string &filename,
                         const std::string &name,
-                        const bool isFast);
+                        const bool isFast,
+                        const size_t maxConnectionNum,
+                        const double keepaliveInterval);
+    void waitForConnections(double timeout);
+    /// Get the event loops owned by the clients, named as
+    /// "db:<client name>:<index>".
+    std::vector<std::pair<std::string, trantor::EventLoop *>> getLoops() const;
+    /// Append the states of the clients other than the fast ones.
+    void getStates(std::vector<DbClientState> &states) const;
+    /// Append the states of the fast clients of the current IO loop, it must
+    /// be called in the loop.
+    void getFastStates(std::vector<DbClientState> &states,
+                       const std::string &loopName) const;
 
   private:
     std::map<std::string, DbClientPtr> dbClientsMap_;
@@ -62,6 +75,8 @@ class DbClientManager : public trantor::NonCopyable
         ClientType dbType_;
         bool isFast_;
         size_t connectionNumber_;
+        size_t maxConnectionNumber_;
+        double keepaliveInterval_;
     };
     std::vector<DbInfo> dbInfos_;
     std::map<std::string, IOThreadStorage<orm::DbClientPtr>> dbFastClientsMap_;
@@ -27,6 +27,26 @@ void DbClientManager::createDbClients(
     return;
 }
 
+void DbClientManager::waitForConnections(double /*timeout*/)
+{
+    return;
+}
+
+std::vector<std::pair<std::string, trantor::EventLoop *>>
+DbClientManager::getLoops() const
+{
+    return {};
+}
+
+void DbClientManager::getStates(std::vector<DbClientState> &) const
+{
+}
+
+void DbClientManager::getFastStates(std::vector<DbClientState> &,
+                                    const std::string &) const
+{
+}
+
 void DbClientManager::createDbClient(const std::string &dbType,
                                      const std::string &host,
                                      const unsigned short port,
@@ -36,7 +56,9 @@ void DbClientManager::createDbClient(const std::string &dbType,
                                      const size_t connectionNum,
                                      const std::string &filename,
                                      const std::string &name,
-                                     const bool isFast)
+                                     const bool isFast,
+                                     const size_t /*maxConnectionNum*/,
+                                     const double /*keepaliveInterval*/)
 {
     LOG_FATAL << "No database is supported by drogon, please install the "
                  "database development library first.";
@@ -36,6 +36,12 @@ static std::mutex &getMapMutex()
     return mtx;
 }
 
+static std::mutex &getClassMapMutex()
+{
+    static std::mutex mtx;
+    return mtx;
+}
+
 }  // namespace internal
 }  // namespace drogon
 
@@ -43,21 +49,24 @@ void DrClassMap::registerClass(const std::string &className,
                                const DrAllocFunc &func)
 {
     LOG_TRACE << "Register class:" << className;
-    getMap().insert(std::make_pair(className, func));
+    std::lock_guard<std::mutex> lock(internal::getClassMapMutex());
+    getMap()[className] = func;
 }
 
 DrObjectBase *DrClassMap::newObject(const std::string &className)
 {
-    auto iter = getMap().find(className);
-    if (iter != getMap().end())
+    DrAllocFunc func;
     {
-        return iter->second();
+        std::lock_guard<std::mutex> lock(internal::getClassMapMutex());
+        auto iter = getMap().find(className);
+        if (iter == getMap().end())
+            return nullptr;
+        func = iter->second;
     }
-    else
-        return nullptr;
+    return func();
 }
 
-const std::shared_ptr<DrObjectBase> &DrClassMap::getSingleInstance(
+std::shared_ptr<DrObjectBase> DrClassMap::getSingleInstance(
     const std::string &className)
 {
     auto &mtx = internal::getMapMutex();
@@ -75,13 +84,20 @@ void DrClassMap::setSingleInstance(const std::shared_ptr<DrObjectBase> &ins)
 {
     auto &mtx = internal::getMapMutex();
     auto &singleInstanceMap = internal::getObjsMap();
-    std::lock_guard<std::mutex> lock(mtx);
-    singleInstanceMap[ins->className()] = ins;
+    std::shared_ptr<DrObjectBase> oldInstance;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto &instance = singleInstanceMap[ins->className()];
+        oldInstance = std::move(instance);
+        instance = ins;
+    }
+    // The old instance may be destroyed here, out of the lock.
 }
 
 std::vector<std::string> DrClassMap::getAllClassName()
 {
     std::vector<std::string> ret;
+    std::lock_guard<std::mutex> lock(internal::getClassMapMutex());
     for (auto const &iter : getMap())
     {
         ret.push_back(iter.first);
@@ -91,6 +107,8 @@ std::vector<std::string> DrClassMap::getAllClassName()
 
 std::unordered_map<std::string, DrAllocFunc> &DrClassMap::getMap()
 {
-    static std::unordered_map<std::string, DrAllocFunc> map;
+    // The map is never destroyed, the functions registered by the dynamic
+    // views may belong to libraries which are unloaded before the exit.
+    static auto &map = *new std::unordered_map<std::string, DrAllocFunc>;
     return map;
 }
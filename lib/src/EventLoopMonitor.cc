@@ -0,0 +1,280 @@
+/**
+ *
+ *  EventLoopMonitor.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "EventLoopMonitor.h"
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <chrono>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <execinfo.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+#ifdef __linux__
+void dumpStack(int)
+{
+    // Only async-signal-safe calls here.
+    static const char header[] = "Stack of the blocked event loop:\n";
+    auto ret = write(STDERR_FILENO, header, sizeof(header) - 1);
+    (void)ret;
+    void *frames[64];
+    auto size = backtrace(frames, 64);
+    backtrace_symbols_fd(frames, size, STDERR_FILENO);
+}
+#endif
+}  // namespace
+
+EventLoopMonitor::LoopState *&EventLoopMonitor::currentState()
+{
+    thread_local LoopState *state = nullptr;
+    return state;
+}
+
+int64_t EventLoopMonitor::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+EventLoopMonitor::Activity::Activity(Kind kind)
+    : state_(currentState()), kind_(kind)
+{
+    if (!state_)
+        return;
+    start_ = now();
+    if (state_->activityDepth_++ == 0)
+    {
+        describe(*state_, "", "");
+        state_->busySince_.store(start_, std::memory_order_relaxed);
+    }
+}
+
+EventLoopMonitor::Activity::~Activity()
+{
+    if (!state_)
+        return;
+    if (--state_->activityDepth_ > 0)
+        return;
+    auto elapsed = now() - start_;
+    auto &time = kind_ == kIo ? state_->ioTime_ : state_->functorTime_;
+    time.store(time.load(std::memory_order_relaxed) + elapsed,
+               std::memory_order_relaxed);
+    state_->busySince_.store(0, std::memory_order_relaxed);
+}
+
+void EventLoopMonitor::describe(LoopState &state,
+                                const char *method,
+                                const char *path)
+{
+    // The sequence is odd while the description is being written.
+    auto sequence = state.descriptionSequence_.load(std::memory_order_relaxed);
+    state.descriptionSequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if (*method)
+        snprintf(state.description_,
+                 sizeof(state.description_),
+                 "%s %s",
+                 method,
+                 path);
+    else
+        state.description_[0] = '\0';
+    state.descriptionSequence_.store(sequence + 2, std::memory_order_release);
+}
+
+void EventLoopMonitor::describeActivity(const char *method,
+                                        const std::string &path)
+{
+    auto state = currentState();
+    if (state)
+        describe(*state, method, path.c_str());
+}
+
+EventLoopMonitor::EventLoopMonitor(double interval,
+                                   double blockThreshold,
+                                   bool dumpStacks)
+    : interval_(interval),
+      intervalNs_(static_cast<int64_t>(interval * 1000000000)),
+      thresholdNs_(static_cast<int64_t>(blockThreshold * 1000000000)),
+      dumpStacks_(dumpStacks)
+{
+#ifdef __linux__
+    if (dumpStacks_ && thresholdNs_ > 0)
+    {
+        // The first call of backtrace() loads libgcc, which is not safe in a
+        // signal handler.
+        void *frames[1];
+        backtrace(frames, 1);
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = dumpStack;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGURG, &action, nullptr);
+    }
+#else
+    dumpStacks_ = false;
+#endif
+    if (thresholdNs_ > 0)
+        watchdog_ = std::thread([this]() { watch(); });
+}
+
+EventLoopMonitor::~EventLoopMonitor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    if (watchdog_.joinable())
+        watchdog_.join();
+}
+
+void EventLoopMonitor::monitor(trantor::EventLoop *loop,
+                               const std::string &name)
+{
+    auto state = std::make_shared<LoopState>();
+    state->name_ = name;
+    state->loop_ = loop;
+    state->intervalNs_ = intervalNs_;
+    state->started_ = now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        states_.push_back(state);
+    }
+    // The timer owns the state, so it lives as long as the loop.
+    auto interval = interval_;
+    loop->runInLoop([state, loop, interval]() {
+        currentState() = state.get();
+        state->thread_ = pthread_self();
+        state->lastTick_ = now();
+        state->heartbeat_.store(state->lastTick_, std::memory_order_release);
+        loop->runEvery(interval, [state]() { tick(state); });
+    });
+}
+
+void EventLoopMonitor::tick(const std::shared_ptr<LoopState> &statePtr)
+{
+    auto &state = *statePtr;
+    auto tickTime = now();
+    auto lag = tickTime - state.lastTick_ - state.intervalNs_;
+    state.lag_.record(std::chrono::nanoseconds(lag));
+    auto busyTime = state.ioTime_.load(std::memory_order_relaxed) +
+                    state.functorTime_.load(std::memory_order_relaxed);
+    auto elapsed = tickTime - state.lastTick_;
+    if (elapsed > 0)
+    {
+        state.busyRatio_.store(
+            std::min(1.0, double(busyTime - state.lastBusyTime_) / elapsed),
+            std::memory_order_relaxed);
+    }
+    state.lastBusyTime_ = busyTime;
+    state.lastTick_ = tickTime;
+    state.heartbeat_.store(tickTime, std::memory_order_release);
+    state.loop_->queueInLoop([statePtr, tickTime]() {
+        statePtr->queueDelay_.record(
+            std::chrono::nanoseconds(now() - tickTime));
+    });
+}
+
+std::vector<EventLoopStats> EventLoopMonitor::getStats() const
+{
+    std::vector<EventLoopStats> stats;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto current = now();
+    for (auto &state : states_)
+    {
+        EventLoopStats loopStats;
+        loopStats.name_ = state->name_;
+        loopStats.lag_ = state->lag_.summary();
+        loopStats.queueDelay_ = state->queueDelay_.summary();
+        loopStats.ioTime_ =
+            state->ioTime_.load(std::memory_order_relaxed) / 1000000000.0;
+        loopStats.functorTime_ =
+            state->functorTime_.load(std::memory_order_relaxed) /
+            1000000000.0;
+        loopStats.pollTime_ =
+            std::max(0.0,
+                     (current - state->started_) / 1000000000.0 -
+                         loopStats.ioTime_ - loopStats.functorTime_);
+        loopStats.busyRatio_ =
+            state->busyRatio_.load(std::memory_order_relaxed);
+        loopStats.blocks_ = state->blocks_.load(std::memory_order_relaxed);
+        stats.push_back(std::move(loopStats));
+    }
+    return stats;
+}
+
+void EventLoopMonitor::watch()
+{
+    // Check several times within the threshold, so a blocked loop is found
+    // soon after it exceeds the threshold.
+    auto period = std::chrono::nanoseconds(
+        std::max<int64_t>(thresholdNs_ / 4, 10000000));
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cond_.wait_for(lock, period, [this]() { return stopping_; }))
+    {
+        auto current = now();
+        for (auto &state : states_)
+            checkLoop(*state, current);
+    }
+}
+
+void EventLoopMonitor::checkLoop(LoopState &state, int64_t current)
+{
+    auto heartbeat = state.heartbeat_.load(std::memory_order_acquire);
+    if (heartbeat == 0)
+        return;
+    auto busySince = state.busySince_.load(std::memory_order_relaxed);
+    auto blocked = busySince ? current - busySince : 0;
+    // The timer may also be delayed by the callbacks of other modules.
+    blocked = std::max(blocked, current - heartbeat - intervalNs_);
+    if (blocked < thresholdNs_)
+    {
+        state.reported_ = false;
+        return;
+    }
+    if (state.reported_)
+        return;
+    state.reported_ = true;
+    state.blocks_.fetch_add(1, std::memory_order_relaxed);
+
+    std::string description;
+    if (busySince)
+    {
+        auto sequence =
+            state.descriptionSequence_.load(std::memory_order_acquire);
+        if ((sequence & 1) == 0)
+        {
+            description.assign(state.description_,
+                               strnlen(state.description_,
+                                       sizeof(state.description_)));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (state.descriptionSequence_.load(std::memory_order_relaxed) !=
+                sequence)
+                description.clear();
+        }
+    }
+    LOG_WARN << "The event loop " << state.name_ << " has been blocked for "
+             << blocked / 1000000 << " ms"
+             << (description.empty() ? "" : ", handling ") << description;
+    if (dumpStacks_)
+        pthread_kill(state.thread_, SIGURG);
+}
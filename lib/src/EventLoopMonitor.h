@@ -0,0 +1,134 @@
+/**
+ *
+ *  EventLoopMonitor.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/utils/EventLoopStats.h>
+#include <drogon/utils/LatencyHistogram.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+namespace drogon
+{
+/**
+ * @brief This class measures the health of event loops and watches for the
+ * callbacks blocking them.
+ *
+ * A timer on every loop fires every interval, it records how late it is and
+ * queues a probe functor which records how long it waits. The framework marks
+ * its I/O callbacks and functors with Activity objects, which account their
+ * time and tell the watchdog what a loop is doing.
+ *
+ * The watchdog thread logs a warning when a loop doesn't come back from a
+ * callback or doesn't fire its timer within the threshold, with the request
+ * being handled. It can also make the blocked thread print its stack to the
+ * standard error by the SIGURG signal.
+ */
+class EventLoopMonitor : public trantor::NonCopyable
+{
+    struct LoopState;
+
+  public:
+    EventLoopMonitor(double interval, double blockThreshold, bool dumpStacks);
+    ~EventLoopMonitor();
+
+    /// Start monitoring a loop, must be called before the loop runs or in
+    /// any thread after it runs.
+    void monitor(trantor::EventLoop *loop, const std::string &name);
+    std::vector<EventLoopStats> getStats() const;
+
+    /// A scope in which a monitored loop runs a callback of the framework.
+    /// It does nothing in the threads of the loops which are not monitored.
+    class Activity : public trantor::NonCopyable
+    {
+      public:
+        enum Kind
+        {
+            kIo,
+            kFunctor
+        };
+        explicit Activity(Kind kind);
+        ~Activity();
+
+      private:
+        LoopState *state_;
+        Kind kind_;
+        int64_t start_{0};
+    };
+
+    /// Describe what the current loop is doing, e.g. the request line of the
+    /// request being handled, for the watchdog.
+    static void describeActivity(const char *method, const std::string &path);
+
+  private:
+    struct LoopState
+    {
+        std::string name_;
+        trantor::EventLoop *loop_{nullptr};
+        int64_t intervalNs_{0};
+        LatencyHistogram lag_;
+        LatencyHistogram queueDelay_;
+        int64_t started_{0};
+        std::atomic<int64_t> heartbeat_{0};
+        std::atomic<int64_t> ioTime_{0};
+        std::atomic<int64_t> functorTime_{0};
+        std::atomic<double> busyRatio_{0.0};
+        std::atomic<uint64_t> blocks_{0};
+
+        // The start of the outermost activity, 0 when the loop is idle.
+        std::atomic<int64_t> busySince_{0};
+        // The description of the activity, guarded by the sequence lock.
+        std::atomic<uint32_t> descriptionSequence_{0};
+        char description_[128]{0};
+
+        // Accessed in the loop thread only.
+        int64_t lastTick_{0};
+        int64_t lastBusyTime_{0};
+        int activityDepth_{0};
+
+        // Set in the loop thread before the first tick.
+        pthread_t thread_;
+        // Accessed in the watchdog thread only.
+        bool reported_{false};
+    };
+    static LoopState *&currentState();
+    static int64_t now();
+    static void describe(LoopState &state,
+                         const char *method,
+                         const char *path);
+    static void tick(const std::shared_ptr<LoopState> &statePtr);
+    void watch();
+    void checkLoop(LoopState &state, int64_t now);
+
+    double interval_;
+    int64_t intervalNs_;
+    int64_t thresholdNs_;
+    bool dumpStacks_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<LoopState>> states_;
+    std::condition_variable cond_;
+    bool stopping_{false};
+    std::thread watchdog_;
+};
+
+}  // namespace drogon
@@ -32,6 +32,12 @@ static void doFilterChains(
         &callbackPtr,
     std::function<void()> &&missCallback)
 {
+    if (req->isCancelled())
+    {
+        HttpAppFrameworkImpl::instance().callCallback(
+            req, HttpAppFrameworkImpl::newCancelledResponse(), *callbackPtr);
+        return;
+    }
     if (index < filters.size())
     {
         auto &filter = filters[index];
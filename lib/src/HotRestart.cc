@@ -0,0 +1,372 @@
+/**
+ *
+ *  HotRestart.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HotRestart.h"
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace drogon;
+
+namespace
+{
+// The sockets sent by a message, below the limit of SCM_RIGHTS.
+constexpr size_t socketsPerMessage = 128;
+
+bool makeUnixAddress(const std::string &path, struct sockaddr_un &addr)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.length() >= sizeof(addr.sun_path))
+    {
+        LOG_ERROR << "The path of the hot restart socket is too long: "
+                  << path;
+        return false;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.length());
+    return true;
+}
+
+void setTimeout(int fd, int option, int seconds)
+{
+    struct timeval timeout;
+    timeout.tv_sec = seconds;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, option, &timeout, sizeof(timeout));
+}
+
+bool sendSockets(int fd, const std::vector<int> &sockets)
+{
+    uint32_t count = static_cast<uint32_t>(sockets.size());
+    if (send(fd, &count, sizeof(count), MSG_NOSIGNAL) != sizeof(count))
+        return false;
+    for (size_t offset = 0; offset < sockets.size();
+         offset += socketsPerMessage)
+    {
+        auto number = std::min(socketsPerMessage, sockets.size() - offset);
+        char data = 0;
+        struct iovec iov;
+        iov.iov_base = &data;
+        iov.iov_len = 1;
+        std::vector<char> control(CMSG_SPACE(sizeof(int) * number));
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+        auto cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * number);
+        memcpy(CMSG_DATA(cmsg), &sockets[offset], sizeof(int) * number);
+        if (sendmsg(fd, &msg, MSG_NOSIGNAL) != 1)
+            return false;
+    }
+    return true;
+}
+
+bool receiveSockets(int fd, std::vector<int> &sockets)
+{
+    uint32_t count = 0;
+    if (recv(fd, &count, sizeof(count), MSG_WAITALL) != sizeof(count))
+        return false;
+    while (sockets.size() < count)
+    {
+        char data;
+        struct iovec iov;
+        iov.iov_base = &data;
+        iov.iov_len = 1;
+        std::vector<char> control(CMSG_SPACE(sizeof(int) * socketsPerMessage));
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+        if (recvmsg(fd, &msg, MSG_CMSG_CLOEXEC) != 1)
+            return false;
+        for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+             cmsg = CMSG_NXTHDR(&msg, cmsg))
+        {
+            if (cmsg->cmsg_level != SOL_SOCKET ||
+                cmsg->cmsg_type != SCM_RIGHTS)
+                continue;
+            auto number = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            auto begin = sockets.size();
+            sockets.resize(begin + number);
+            memcpy(&sockets[begin], CMSG_DATA(cmsg), sizeof(int) * number);
+        }
+        if (msg.msg_flags & MSG_CTRUNC)
+            return false;
+    }
+    return true;
+}
+
+std::string formatAddress(const struct sockaddr_storage &addr)
+{
+    char ip[INET6_ADDRSTRLEN] = {0};
+    uint16_t port = 0;
+    if (addr.ss_family == AF_INET6)
+    {
+        auto addr6 = reinterpret_cast<const struct sockaddr_in6 *>(&addr);
+        inet_ntop(AF_INET6, &addr6->sin6_addr, ip, sizeof(ip));
+        port = ntohs(addr6->sin6_port);
+    }
+    else
+    {
+        auto addr4 = reinterpret_cast<const struct sockaddr_in *>(&addr);
+        inet_ntop(AF_INET, &addr4->sin_addr, ip, sizeof(ip));
+        port = ntohs(addr4->sin_port);
+    }
+    return std::string(ip) + ":" + std::to_string(port);
+}
+
+bool makeInetAddress(const std::string &ip,
+                     uint16_t port,
+                     struct sockaddr_storage &addr,
+                     socklen_t &length)
+{
+    memset(&addr, 0, sizeof(addr));
+    if (ip.find(':') != std::string::npos)
+    {
+        auto addr6 = reinterpret_cast<struct sockaddr_in6 *>(&addr);
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = htons(port);
+        length = sizeof(struct sockaddr_in6);
+        return inet_pton(AF_INET6, ip.c_str(), &addr6->sin6_addr) == 1;
+    }
+    auto addr4 = reinterpret_cast<struct sockaddr_in *>(&addr);
+    addr4->sin_family = AF_INET;
+    addr4->sin_port = htons(port);
+    length = sizeof(struct sockaddr_in);
+    return inet_pton(AF_INET, ip.c_str(), &addr4->sin_addr) == 1;
+}
+}  // namespace
+
+HotRestart::HotRestart(const std::string &socketPath) : socketPath_(socketPath)
+{
+}
+
+HotRestart::~HotRestart()
+{
+    if (previousFd_ >= 0)
+        close(previousFd_);
+    if (nextFd_ >= 0)
+        close(nextFd_);
+    if (listenFd_ >= 0)
+        close(listenFd_);
+}
+
+std::vector<int> HotRestart::takeOverSockets()
+{
+    std::vector<int> sockets;
+    struct sockaddr_un addr;
+    if (!makeUnixAddress(socketPath_, addr))
+        return sockets;
+    auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        LOG_SYSERR << "Failed to create the hot restart socket";
+        return sockets;
+    }
+    if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) <
+        0)
+    {
+        // No running process.
+        if (errno != ENOENT && errno != ECONNREFUSED)
+            LOG_SYSERR << "Failed to connect to " << socketPath_;
+        close(fd);
+        return sockets;
+    }
+    setTimeout(fd, SO_RCVTIMEO, 5);
+    if (!receiveSockets(fd, sockets))
+    {
+        LOG_ERROR << "Failed to take the listening sockets over from the "
+                     "running process";
+        for (auto socket : sockets)
+            close(socket);
+        sockets.clear();
+        close(fd);
+        return sockets;
+    }
+    LOG_INFO << "Took " << sockets.size()
+             << " listening sockets over from the running process";
+    previousFd_ = fd;
+    return sockets;
+}
+
+void HotRestart::notifyReady()
+{
+    if (previousFd_ < 0)
+        return;
+    char ready = 1;
+    if (send(previousFd_, &ready, 1, MSG_NOSIGNAL) != 1)
+        LOG_SYSERR << "Failed to notify the previous process";
+    close(previousFd_);
+    previousFd_ = -1;
+}
+
+void HotRestart::serve(trantor::EventLoop *loop,
+                       std::function<std::vector<int>()> &&getSockets,
+                       std::function<void()> &&onHandedOver)
+{
+    struct sockaddr_un addr;
+    if (!makeUnixAddress(socketPath_, addr))
+        return;
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0)
+    {
+        LOG_SYSERR << "Failed to create the hot restart socket";
+        return;
+    }
+    // The socket of the previous process is replaced.
+    unlink(socketPath_.c_str());
+    if (bind(listenFd_,
+             reinterpret_cast<struct sockaddr *>(&addr),
+             sizeof(addr)) < 0 ||
+        listen(listenFd_, 1) < 0)
+    {
+        LOG_SYSERR << "Failed to listen on " << socketPath_;
+        close(listenFd_);
+        listenFd_ = -1;
+        return;
+    }
+    loop_ = loop;
+    getSockets_ = std::move(getSockets);
+    onHandedOver_ = std::move(onHandedOver);
+    loop_->runInLoop([this]() {
+        listenChannel_ = std::unique_ptr<trantor::Channel>(
+            new trantor::Channel(loop_, listenFd_));
+        listenChannel_->setReadCallback([this]() { onNextProcess(); });
+        listenChannel_->enableReading();
+    });
+}
+
+void HotRestart::onNextProcess()
+{
+    auto fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0)
+        return;
+    if (nextFd_ >= 0)
+    {
+        // Another new process is taking the sockets over.
+        close(fd);
+        return;
+    }
+    auto sockets = getSockets_();
+    setTimeout(fd, SO_SNDTIMEO, 5);
+    if (!sendSockets(fd, sockets))
+    {
+        LOG_SYSERR << "Failed to hand the listening sockets over";
+        close(fd);
+        return;
+    }
+    LOG_INFO << "Handed " << sockets.size()
+             << " listening sockets over to a new process";
+    nextFd_ = fd;
+    nextChannel_ =
+        std::unique_ptr<trantor::Channel>(new trantor::Channel(loop_, fd));
+    nextChannel_->setReadCallback([this]() { onNextProcessReady(); });
+    nextChannel_->enableReading();
+}
+
+void HotRestart::onNextProcessReady()
+{
+    char ready = 0;
+    auto n = recv(nextFd_, &ready, 1, MSG_DONTWAIT);
+    if (n < 0 && (errno == EAGAIN || errno == EINTR))
+        return;
+    closeNextProcess();
+    if (n != 1)
+    {
+        LOG_WARN << "The new process quit before it accepted on the "
+                    "listening sockets, go on serving";
+        return;
+    }
+    LOG_INFO << "The new process accepts on the listening sockets";
+    // This process is replaced, the next one serves the later restarts.
+    listenChannel_->disableAll();
+    listenChannel_->remove();
+    close(listenFd_);
+    listenFd_ = -1;
+    onHandedOver_();
+}
+
+void HotRestart::closeNextProcess()
+{
+    nextChannel_->disableAll();
+    nextChannel_->remove();
+    close(nextFd_);
+    nextFd_ = -1;
+    // The channel is in its callback now.
+    std::shared_ptr<trantor::Channel> channel(std::move(nextChannel_));
+    loop_->queueInLoop([channel]() {});
+}
+
+int HotRestart::createListeningSocket(const std::string &ip, uint16_t port)
+{
+    struct sockaddr_storage addr;
+    socklen_t length;
+    if (!makeInetAddress(ip, port, addr, length))
+    {
+        LOG_ERROR << "Invalid listening address: " << ip;
+        return -1;
+    }
+    auto fd = socket(addr.ss_family,
+                     SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                     IPPROTO_TCP);
+    if (fd < 0)
+    {
+        LOG_SYSERR << "Failed to create a listening socket";
+        return -1;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), length) < 0 ||
+        listen(fd, SOMAXCONN) < 0)
+    {
+        LOG_SYSERR << "Failed to listen on " << ip << ":" << port;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+std::string HotRestart::socketAddress(int fd)
+{
+    struct sockaddr_storage addr;
+    socklen_t length = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    if (getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &length) <
+        0)
+        return "";
+    return formatAddress(addr);
+}
+
+std::string HotRestart::socketAddress(const std::string &ip, uint16_t port)
+{
+    struct sockaddr_storage addr;
+    socklen_t length;
+    if (!makeInetAddress(ip, port, addr, length))
+        return ip + ":" + std::to_string(port);
+    return formatAddress(addr);
+}
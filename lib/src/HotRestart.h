@@ -0,0 +1,97 @@
+/**
+ *
+ *  HotRestart.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/inner/Channel.h>
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+/**
+ * @brief Hand the listening sockets over from a running process to a new one
+ * through a unix domain socket, so the new process serves the connections
+ * queued on them and none is lost.
+ *
+ * The protocol on the unix socket:
+ * 1. The new process connects to it, the running one sends the number of the
+ * sockets, then the sockets by SCM_RIGHTS in batches.
+ * 2. The new process writes one byte when it has started to accept on the
+ * sockets, then the running one stops accepting, drains and quits. If the
+ * new process closes the connection without the byte, the running one goes
+ * on serving.
+ *
+ * The running process drains its connections whether the graceful shutdown
+ * timeout is set or not. To check it by hand, run an application with a
+ * handler which takes a few seconds to respond, send a request to the handler,
+ * and start another process with the same hot_restart_socket before the
+ * response arrives. The request must be answered by the old process, which
+ * quits after that, and the following requests by the new one.
+ */
+class HotRestart : public trantor::NonCopyable
+{
+  public:
+    explicit HotRestart(const std::string &socketPath);
+    ~HotRestart();
+
+    /// Take the listening sockets over from the running process, it's
+    /// empty if there's no running process.
+    std::vector<int> takeOverSockets();
+
+    /// Tell the previous process that this one accepts on the sockets.
+    void notifyReady();
+
+    /// Wait for the next process in the loop.
+    /**
+     * @param getSockets Returns the sockets handed over to the next process.
+     * @param onHandedOver Called when the next process accepts on them.
+     */
+    void serve(trantor::EventLoop *loop,
+               std::function<std::vector<int>()> &&getSockets,
+               std::function<void()> &&onHandedOver);
+
+    /// Create a non-blocking socket listening on the address with
+    /// SO_REUSEPORT, -1 on errors.
+    static int createListeningSocket(const std::string &ip, uint16_t port);
+
+    /// The address a socket is bound to, in the form of "ip:port", or the
+    /// address of the ip and port in the same form.
+    static std::string socketAddress(int fd);
+    static std::string socketAddress(const std::string &ip, uint16_t port);
+
+  private:
+    void onNextProcess();
+    void onNextProcessReady();
+    void closeNextProcess();
+
+    std::string socketPath_;
+    // The connection to the previous process.
+    int previousFd_{-1};
+
+    trantor::EventLoop *loop_{nullptr};
+    int listenFd_{-1};
+    std::unique_ptr<trantor::Channel> listenChannel_;
+    // The connection to the next process.
+    int nextFd_{-1};
+    std::unique_ptr<trantor::Channel> nextChannel_;
+    std::function<std::vector<int>()> getSockets_;
+    std::function<void()> onHandedOver_;
+};
+
+}  // namespace drogon
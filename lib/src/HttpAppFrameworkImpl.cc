@@ -30,6 +30,10 @@
 #include "SharedLibManager.h"
 #include "SessionManager.h"
 #include "DbClientManager.h"
+#include "EventLoopMonitor.h"
+#ifdef __linux__
+#include "HotRestart.h"
+#endif
 #include <drogon/config.h>
 #include <algorithm>
 #include <drogon/version.h>
@@ -39,6 +43,8 @@
 #include <drogon/HttpResponse.h>
 #include <drogon/HttpTypes.h>
 #include <drogon/Session.h>
+#include <drogon/plugins/ConcurrencyLimiter.h>
+#include <drogon/utils/Metrics.h>
 #include <drogon/utils/Utilities.h>
 #include <trantor/utils/AsyncFileLogger.h>
 #include <json/json.h>
@@ -61,6 +67,10 @@
 using namespace drogon;
 using namespace std::placeholders;
 
+// The time the connections are drained in after the hot restart if the
+// graceful shutdown timeout is not set.
+static const double handoverDrainTimeout = 30.0;
+
 HttpAppFrameworkImpl::HttpAppFrameworkImpl()
     : staticFileRouterPtr_(new StaticFileRouter(staticFileHeaders_)),
       httpCtrlsRouterPtr_(new HttpControllersRouter(*staticFileRouterPtr_,
@@ -137,6 +147,7 @@ static void godaemon(void)
 HttpAppFrameworkImpl::~HttpAppFrameworkImpl() noexcept
 {
     // Destroy the following objects before the loop destruction
+    loopMonitorPtr_.reset();
     sharedLibManagerPtr_.reset();
     sessionManagerPtr_.reset();
 }
@@ -145,6 +156,72 @@ HttpAppFramework &HttpAppFrameworkImpl::setStaticFilesCacheTime(int cacheTime)
     staticFileRouterPtr_->setStaticFilesCacheTime(cacheTime);
     return *this;
 }
+std::vector<EventLoopStats> HttpAppFrameworkImpl::getEventLoopStats() const
+{
+    if (!loopMonitorPtr_)
+        return {};
+    return loopMonitorPtr_->getStats();
+}
+namespace
+{
+// Collects the states of the loops, the callback is called when the last
+// loop releases it.
+struct ServerStateCollector
+{
+    ServerState state_;
+    std::mutex mutex_;
+    std::function<void(const ServerState &)> callback_;
+    ~ServerStateCollector()
+    {
+        std::sort(state_.dbClients_.begin(),
+                  state_.dbClients_.end(),
+                  [](const DbClientState &a, const DbClientState &b) {
+                      return a.name_ != b.name_ ? a.name_ < b.name_
+                                                : a.loop_ < b.loop_;
+                  });
+        callback_(state_);
+    }
+};
+}  // namespace
+
+void HttpAppFrameworkImpl::getServerState(
+    const std::function<void(const ServerState &)> &callback) const
+{
+    auto collector = std::make_shared<ServerStateCollector>();
+    collector->callback_ = callback;
+    collector->state_.connections_ =
+        (size_t)connectionNum_.load(std::memory_order_relaxed);
+    if (sessionManagerPtr_)
+        collector->state_.sessions_ = sessionManagerPtr_->sessionsNumber();
+    dbClientManagerPtr_->getStates(collector->state_.dbClients_);
+    if (namedLoops_.empty())
+        return;
+    // The main loop and the IO loops are the first ones, every loop takes
+    // the snapshot of its own connections and fast database clients.
+    collector->state_.ioLoops_.resize(threadNum_);
+    for (size_t i = 0; i <= threadNum_; ++i)
+    {
+        auto &namedLoop = namedLoops_[i];
+        namedLoop.second->runInLoop([this, collector, i, namedLoop]() {
+            IoLoopState loopState;
+            if (i > 0)
+            {
+                loopState.name_ = namedLoop.first;
+                HttpServer::getLoopState(loopState);
+                loopState.cachedStaticFiles_ =
+                    staticFileRouterPtr_->cachedFilesNumber();
+            }
+            std::vector<DbClientState> dbStates;
+            dbClientManagerPtr_->getFastStates(dbStates, namedLoop.first);
+            std::lock_guard<std::mutex> lock(collector->mutex_);
+            if (i > 0)
+                collector->state_.ioLoops_[i - 1] = std::move(loopState);
+            for (auto &dbState : dbStates)
+                collector->state_.dbClients_.push_back(std::move(dbState));
+        });
+    }
+}
+
 int HttpAppFrameworkImpl::staticFilesCacheTime() const
 {
     return staticFileRouterPtr_->staticFilesCacheTime();
@@ -386,6 +463,22 @@ void HttpAppFrameworkImpl::run()
         sharedLibManagerPtr_ = std::unique_ptr<SharedLibManager>(
             new SharedLibManager(getLoop(), libFilePaths_));
     }
+    MetricsRegistry::instance().gaugeCallback(
+        "drogon_http_connections",
+        "The number of HTTP connections",
+        {},
+        [this]() {
+            return (double)connectionNum_.load(std::memory_order_relaxed);
+        });
+#ifdef __linux__
+    if (!hotRestartSocket_.empty())
+    {
+        hotRestartPtr_ =
+            std::unique_ptr<HotRestart>(new HotRestart(hotRestartSocket_));
+        listenerManagerPtr_->enableSocketHandoff(
+            hotRestartPtr_->takeOverSockets());
+    }
+#endif
     // Create all listeners.
     auto ioLoops = listenerManagerPtr_->createListeners(
         std::bind(&HttpAppFrameworkImpl::onAsyncRequest, this, _1, _2),
@@ -406,7 +499,30 @@ void HttpAppFrameworkImpl::run()
     // loop, so put the main loop into ioLoops.
     ioLoops.push_back(getLoop());
     dbClientManagerPtr_->createDbClients(ioLoops);
+    // Warm up the connection pools before serving requests.
+    if (dbWarmUpTimeout_ > 0)
+        dbClientManagerPtr_->waitForConnections(dbWarmUpTimeout_);
     ioLoops.pop_back();
+    namedLoops_.emplace_back("main", getLoop());
+    for (size_t i = 0; i < threadNum_; ++i)
+    {
+        namedLoops_.emplace_back("io:" + std::to_string(i), ioLoops[i]);
+    }
+    for (auto &dbLoop : dbClientManagerPtr_->getLoops())
+    {
+        namedLoops_.push_back(dbLoop);
+    }
+    if (loopMonitorInterval_ > 0)
+    {
+        loopMonitorPtr_ = std::unique_ptr<EventLoopMonitor>(
+            new EventLoopMonitor(loopMonitorInterval_,
+                                 loopWatchdogThreshold_,
+                                 loopWatchdogDumpStacks_));
+        for (auto &namedLoop : namedLoops_)
+        {
+            loopMonitorPtr_->monitor(namedLoop.second, namedLoop.first);
+        }
+    }
     httpCtrlsRouterPtr_->init(ioLoops);
     httpSimpleCtrlsRouterPtr_->init(ioLoops);
     staticFileRouterPtr_->init(ioLoops);
@@ -434,6 +550,23 @@ void HttpAppFrameworkImpl::run()
     getLoop()->queueInLoop([this]() {
         // Let listener event loops run when everything is ready.
         listenerManagerPtr_->startListening();
+#ifdef __linux__
+        if (hotRestartPtr_)
+        {
+            // Let the previous process quit, and wait for the next one.
+            hotRestartPtr_->notifyReady();
+            hotRestartPtr_->serve(
+                getLoop(),
+                [this]() { return listenerManagerPtr_->listeningSockets(); },
+                [this]() {
+                    // The connections of this process are always drained,
+                    // the requests on them are not lost.
+                    drainAndQuit(gracefulShutdownTimeout_ > 0
+                                     ? gracefulShutdownTimeout_
+                                     : handoverDrainTimeout);
+                });
+        }
+#endif
         for (auto &adv : beginningAdvices_)
         {
             adv();
@@ -609,6 +742,15 @@ void HttpAppFrameworkImpl::onAsyncRequest(
         callback(resp);
         return;
     }
+    // Shed the load before the request takes any resource.
+    if (auto limiter = plugin::ConcurrencyLimiter::current())
+    {
+        if (!limiter->admit(req, callback))
+            return;
+    }
+    if (requestTimeout_ > 0 || !routeTimeouts_.empty() ||
+        !requestTimeoutHeader_.empty())
+        setRequestDeadline(req);
     if (useSession_)
     {
         std::string sessionId = req->getCookie("JSESSIONID");
@@ -745,7 +887,9 @@ HttpAppFramework &HttpAppFrameworkImpl::createDbClient(
     const size_t connectionNum,
     const std::string &filename,
     const std::string &name,
-    const bool isFast)
+    const bool isFast,
+    const size_t maxConnectionNum,
+    const double keepaliveInterval)
 {
     assert(!running_);
     dbClientManagerPtr_->createDbClient(dbType,
@@ -757,7 +901,9 @@ HttpAppFramework &HttpAppFrameworkImpl::createDbClient(
                                         connectionNum,
                                         filename,
                                         name,
-                                        isFast);
+                                        isFast,
+                                        maxConnectionNum,
+                                        keepaliveInterval);
     return *this;
 }
 
@@ -765,10 +911,116 @@ void HttpAppFrameworkImpl::quit()
 {
     if (getLoop()->isRunning())
     {
+        if (gracefulShutdownTimeout_ > 0)
+        {
+            getLoop()->runInLoop(
+                [this]() { drainAndQuit(gracefulShutdownTimeout_); });
+            return;
+        }
         getLoop()->queueInLoop([this]() { getLoop()->quit(); });
     }
 }
 
+void HttpAppFrameworkImpl::drainAndQuit(double timeout)
+{
+    if (draining_)
+        return;
+    draining_ = true;
+    LOG_INFO << "Draining " << connectionNum_.load() << " connections";
+    listenerManagerPtr_->stopAccepting();
+    HttpServer::startDraining();
+    // The IO loops follow the main loop.
+    for (size_t i = 1; i <= threadNum_ && i < namedLoops_.size(); ++i)
+    {
+        namedLoops_[i].second->runInLoop(
+            []() { HttpServer::closeIdleConnections(); });
+    }
+    auto deadline = trantor::Date::now().after(timeout);
+    getLoop()->runEvery(0.1, [this, deadline]() {
+        auto connections = connectionNum_.load(std::memory_order_relaxed);
+        if (connections > 0 && trantor::Date::now() < deadline)
+            return;
+        if (connections > 0)
+        {
+            LOG_WARN << "Quit with " << connections
+                     << " connections not drained";
+        }
+        getLoop()->quit();
+    });
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::enableHotRestart(
+    const std::string &socketPath)
+{
+    assert(!running_);
+#ifdef __linux__
+    hotRestartSocket_ = socketPath;
+#else
+    LOG_WARN << "The hot restart is only available on Linux";
+#endif
+    return *this;
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::setRequestTimeout(
+    double timeout,
+    const std::string &pathPattern)
+{
+    assert(!running_);
+    if (pathPattern.empty())
+        requestTimeout_ = timeout;
+    else
+        routeTimeouts_.emplace_back(std::regex(pathPattern), timeout);
+    return *this;
+}
+
+HttpAppFramework &HttpAppFrameworkImpl::setRequestTimeoutHeader(
+    const std::string &header)
+{
+    assert(!running_);
+    requestTimeoutHeader_ = header;
+    std::transform(requestTimeoutHeader_.begin(),
+                   requestTimeoutHeader_.end(),
+                   requestTimeoutHeader_.begin(),
+                   tolower);
+    return *this;
+}
+
+void HttpAppFrameworkImpl::setRequestDeadline(
+    const HttpRequestImplPtr &req) const
+{
+    auto timeout = requestTimeout_;
+    for (auto &route : routeTimeouts_)
+    {
+        if (std::regex_search(req->path(), route.first))
+        {
+            timeout = route.second;
+            break;
+        }
+    }
+    if (!requestTimeoutHeader_.empty())
+    {
+        auto &value = req->getHeaderBy(requestTimeoutHeader_);
+        if (!value.empty())
+        {
+            auto headerTimeout = atof(value.c_str());
+            if (headerTimeout > 0 && (timeout <= 0 || headerTimeout < timeout))
+                timeout = headerTimeout;
+        }
+    }
+    if (timeout > 0)
+        req->cancellationToken()->setDeadline(
+            req->creationDate().after(timeout));
+}
+
+HttpResponsePtr HttpAppFrameworkImpl::newCancelledResponse()
+{
+    // The response to a request cancelled by closing its connection is never
+    // sent, so it's for the requests whose deadlines have passed.
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setStatusCode(k504GatewayTimeout);
+    return resp;
+}
+
 const HttpResponsePtr &HttpAppFrameworkImpl::getCustom404Page()
 {
     if (!custom404_)
@@ -265,6 +265,26 @@ class HttpAppFrameworkImpl : public HttpAppFramework
         pipeliningRequestsNumber_ = number;
         return *this;
     }
+    virtual HttpAppFramework &setServerTimingSampleRate(double rate) override
+    {
+        serverTimingSampleRate_ = rate;
+        return *this;
+    }
+    virtual HttpAppFramework &enableEventLoopMonitor(
+        double interval,
+        double watchdogThreshold,
+        bool dumpStacks) override
+    {
+        assert(!running_);
+        loopMonitorInterval_ = interval;
+        loopWatchdogThreshold_ = watchdogThreshold;
+        loopWatchdogDumpStacks_ = dumpStacks;
+        return *this;
+    }
+    virtual std::vector<EventLoopStats> getEventLoopStats() const override;
+    virtual void getServerState(
+        const std::function<void(const ServerState &)> &callback)
+        const override;
     virtual HttpAppFramework &setGzipStatic(bool useGzipStatic) override;
     virtual HttpAppFramework &setClientMaxBodySize(size_t maxSize) override
     {
@@ -316,6 +336,10 @@ class HttpAppFrameworkImpl : public HttpAppFramework
     {
         return pipeliningRequestsNumber_;
     }
+    double serverTimingSampleRate() const
+    {
+        return serverTimingSampleRate_;
+    }
 
     virtual ~HttpAppFrameworkImpl() noexcept;
     virtual bool isRunning() override
@@ -326,6 +350,21 @@ class HttpAppFrameworkImpl : public HttpAppFramework
     virtual trantor::EventLoop *getLoop() const override;
 
     virtual void quit() override;
+    virtual HttpAppFramework &setGracefulShutdownTimeout(
+        double timeout) override
+    {
+        gracefulShutdownTimeout_ = timeout;
+        return *this;
+    }
+    virtual HttpAppFramework &enableHotRestart(
+        const std::string &socketPath) override;
+    virtual HttpAppFramework &setRequestTimeout(
+        double timeout,
+        const std::string &pathPattern) override;
+    virtual HttpAppFramework &setRequestTimeoutHeader(
+        const std::string &header) override;
+    /// The response to the requests cancelled before being handled.
+    static HttpResponsePtr newCancelledResponse();
 
     virtual HttpAppFramework &setServerHeaderField(
         const std::string &server) override
@@ -373,7 +412,14 @@ class HttpAppFrameworkImpl : public HttpAppFramework
         const size_t connectionNum = 1,
         const std::string &filename = "",
         const std::string &name = "default",
-        const bool isFast = false) override;
+        const bool isFast = false,
+        const size_t maxConnectionNum = 0,
+        const double keepaliveInterval = 0.0) override;
+    virtual HttpAppFramework &setDbWarmUpTimeout(double timeout) override
+    {
+        dbWarmUpTimeout_ = timeout;
+        return *this;
+    }
 
     inline static HttpAppFrameworkImpl &instance()
     {
@@ -384,6 +430,13 @@ class HttpAppFrameworkImpl : public HttpAppFramework
     {
         return useSendfile_;
     }
+    /// The loops of the framework named "main", "io:<index>" and
+    /// "db:<client name>:<index>", available after the framework runs.
+    const std::vector<std::pair<std::string, trantor::EventLoop *>>
+        &getNamedLoops() const
+    {
+        return namedLoops_;
+    }
     void callCallback(
         const HttpRequestImplPtr &req,
         const HttpResponsePtr &resp,
@@ -472,6 +525,24 @@ class HttpAppFrameworkImpl : public HttpAppFramework
     size_t logfileSize_{100000000};
     size_t keepaliveRequestsNumber_{0};
     size_t pipeliningRequestsNumber_{0};
+    double serverTimingSampleRate_{0};
+    double loopMonitorInterval_{0};
+    double dbWarmUpTimeout_{5.0};
+    double loopWatchdogThreshold_{0};
+    bool loopWatchdogDumpStacks_{false};
+    std::unique_ptr<EventLoopMonitor> loopMonitorPtr_;
+    std::vector<std::pair<std::string, trantor::EventLoop *>> namedLoops_;
+    double gracefulShutdownTimeout_{0};
+    bool draining_{false};
+    // Stop accepting and quit after the connections are drained or the
+    // timeout expires.
+    void drainAndQuit(double timeout);
+    std::string hotRestartSocket_;
+    std::unique_ptr<HotRestart> hotRestartPtr_;
+    double requestTimeout_{0};
+    std::vector<std::pair<std::regex, double>> routeTimeouts_;
+    std::string requestTimeoutHeader_;
+    void setRequestDeadline(const HttpRequestImplPtr &req) const;
     bool useSendfile_{true};
     bool useGzip_{true};
     size_t clientMaxBodySize_{1024 * 1024};
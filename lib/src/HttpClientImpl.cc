@@ -18,6 +18,7 @@
 #include "HttpResponseParser.h"
 #include "HttpAppFrameworkImpl.h"
 #include <drogon/config.h>
+#include <drogon/utils/Tracing.h>
 #include <algorithm>
 #include <stdlib.h>
 
@@ -25,6 +26,40 @@ using namespace trantor;
 using namespace drogon;
 using namespace std::placeholders;
 
+// Propagate the current trace context by the traceparent header, and trace
+// the request if the context is sampled.
+static void traceRequest(const HttpRequestPtr &req, HttpReqCallback &callback)
+{
+    auto &context = Tracer::currentContext();
+    if (!context.valid())
+        return;
+    if (!context.sampled_)
+    {
+        req->addHeader("traceparent", context.toTraceparent());
+        return;
+    }
+    auto call = std::make_shared<TracedCall>(
+        "http.client", std::string(req->methodString()) + " " + req->path());
+    req->addHeader("traceparent", call->context().toTraceparent());
+    callback = [call, callback = std::move(callback)](
+                   ReqResult result, const HttpResponsePtr &response) {
+        Tracer::ContextScope scope(
+            call->finish(response ? response->statusCode() : -1));
+        callback(result, response);
+    };
+}
+
+// The result of the calls of a request which is cancelled or whose deadline
+// has passed.
+static ReqResult cancelledResult(const CancellationToken &token)
+{
+    auto deadline = token.deadline().microSecondsSinceEpoch();
+    if (deadline > 0 &&
+        trantor::Date::now().microSecondsSinceEpoch() >= deadline)
+        return ReqResult::Timeout;
+    return ReqResult::Cancelled;
+}
+
 void HttpClientImpl::createTcpClient()
 {
     LOG_TRACE << "New TcpClient," << serverAddr_.toIpPort();
@@ -56,9 +91,9 @@ void HttpClientImpl::createTcpClient()
                 {
                     thisPtr->sendReq(connPtr,
                                      thisPtr->requestsBuffer_.front().first);
-                    thisPtr->pipeliningCallbacks_.push(
+                    thisPtr->pipeliningCallbacks_.push_back(
                         std::move(thisPtr->requestsBuffer_.front()));
-                    thisPtr->requestsBuffer_.pop();
+                    thisPtr->requestsBuffer_.pop_front();
                 }
             }
             else
@@ -194,21 +229,111 @@ HttpClientImpl::~HttpClientImpl()
 void HttpClientImpl::sendRequest(const drogon::HttpRequestPtr &req,
                                  const drogon::HttpReqCallback &callback)
 {
-    auto thisPtr = shared_from_this();
-    loop_->runInLoop([thisPtr, req, callback]() {
-        thisPtr->sendRequestInLoop(req, callback);
-    });
+    sendRequest(req, HttpReqCallback(callback));
 }
 
 void HttpClientImpl::sendRequest(const drogon::HttpRequestPtr &req,
                                  drogon::HttpReqCallback &&callback)
 {
     auto thisPtr = shared_from_this();
-    loop_->runInLoop([thisPtr, req, callback = std::move(callback)]() {
+    traceRequest(req, callback);
+    CancellationTokenPtr token;
+    if (!bindToCancellation(req, callback, token))
+        return;
+    loop_->runInLoop([thisPtr, req, token, callback = std::move(callback)]() {
+        // The token may be cancelled before the request is queued.
+        if (token && token->isCancelled())
+        {
+            callback(cancelledResult(*token), nullptr);
+            return;
+        }
         thisPtr->sendRequestInLoop(req, callback);
     });
 }
 
+bool HttpClientImpl::bindToCancellation(const HttpRequestPtr &req,
+                                        HttpReqCallback &callback,
+                                        CancellationTokenPtr &token)
+{
+    auto current = CancellationToken::current();
+    if (!current)
+        return true;
+    if (current->isCancelled())
+    {
+        callback(cancelledResult(*current), nullptr);
+        return false;
+    }
+    token = current->shared_from_this();
+    std::weak_ptr<HttpClientImpl> weakPtr = shared_from_this();
+    auto callbackId = token->onCancel([weakPtr, req]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->loop_->runInLoop([thisPtr, req]() {
+            thisPtr->abortRequest(req, ReqResult::Cancelled);
+        });
+    });
+    trantor::TimerId timerId = trantor::InvalidTimerId;
+    auto deadline = token->deadline().microSecondsSinceEpoch();
+    if (deadline > 0)
+    {
+        auto delay =
+            deadline - trantor::Date::now().microSecondsSinceEpoch();
+        timerId = loop_->runAfter(delay / 1000000.0, [weakPtr, req]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->abortRequest(req, ReqResult::Timeout);
+        });
+    }
+    callback = [token,
+                callbackId,
+                timerId,
+                loop = loop_,
+                callback = std::move(callback)](
+                   ReqResult result, const HttpResponsePtr &response) {
+        token->removeCallback(callbackId);
+        if (timerId != trantor::InvalidTimerId)
+            loop->invalidateTimer(timerId);
+        CancellationToken::Scope scope(token.get());
+        callback(result, response);
+    };
+    return true;
+}
+
+void HttpClientImpl::abortRequest(const HttpRequestPtr &req,
+                                  ReqResult result)
+{
+    loop_->assertInLoopThread();
+    auto isRequest =
+        [&req](const std::pair<HttpRequestPtr, HttpReqCallback> &item) {
+            return item.first == req;
+        };
+    auto iter =
+        std::find_if(requestsBuffer_.begin(), requestsBuffer_.end(), isRequest);
+    if (iter != requestsBuffer_.end())
+    {
+        auto callback = std::move(iter->second);
+        requestsBuffer_.erase(iter);
+        callback(result, nullptr);
+        return;
+    }
+    iter = std::find_if(pipeliningCallbacks_.begin(),
+                        pipeliningCallbacks_.end(),
+                        isRequest);
+    if (iter == pipeliningCallbacks_.end() || !iter->second)
+        return;
+    auto callback = std::move(iter->second);
+    iter->second = nullptr;
+    if (pipeliningCallbacks_.size() == 1 && requestsBuffer_.empty())
+    {
+        // Nothing else waits for the connection, close it to tell the server
+        // the request is abandoned.
+        pipeliningCallbacks_.clear();
+        tcpClientPtr_.reset();
+    }
+    callback(result, nullptr);
+}
+
 void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
                                        const drogon::HttpReqCallback &callback)
 {
@@ -233,7 +358,7 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
 
     if (!tcpClientPtr_)
     {
-        requestsBuffer_.push(
+        requestsBuffer_.push_back(
             {req,
              [thisPtr = shared_from_this(),
               callback](ReqResult result, const HttpResponsePtr &response) {
@@ -290,7 +415,7 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
                                         (thisPtr->requestsBuffer_).front();
                                     reqAndCb.second(ReqResult::BadServerAddress,
                                                     nullptr);
-                                    (thisPtr->requestsBuffer_).pop();
+                                    (thisPtr->requestsBuffer_).pop_front();
                                 }
                                 return;
                             }
@@ -306,7 +431,7 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
             }
             else
             {
-                requestsBuffer_.pop();
+                requestsBuffer_.pop_front();
                 callback(ReqResult::BadServerAddress, nullptr);
                 assert(requestsBuffer_.empty());
                 return;
@@ -324,7 +449,7 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
                 requestsBuffer_.empty())
             {
                 sendReq(connPtr, req);
-                pipeliningCallbacks_.push(
+                pipeliningCallbacks_.push_back(
                     {req,
                      [thisPtr, callback](ReqResult result,
                                          const HttpResponsePtr &response) {
@@ -333,7 +458,7 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
             }
             else
             {
-                requestsBuffer_.push(
+                requestsBuffer_.push_back(
                     {req,
                      [thisPtr, callback](ReqResult result,
                                          const HttpResponsePtr &response) {
@@ -343,7 +468,7 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
         }
         else
         {
-            requestsBuffer_.push(
+            requestsBuffer_.push_back(
                 {req,
                  [thisPtr, callback](ReqResult result,
                                      const HttpResponsePtr &response) {
@@ -402,11 +527,12 @@ void HttpClientImpl::onRecvMessage(const trantor::TcpConnectionPtr &connPtr,
                 resp->parseJson();
             }
             auto cb = std::move(firstReq);
-            pipeliningCallbacks_.pop();
+            pipeliningCallbacks_.pop_front();
             handleCookies(resp);
             bytesReceived_ += (msgSize - msg->readableBytes());
             msgSize = msg->readableBytes();
-            cb.second(ReqResult::Ok, resp);
+            if (cb.second)
+                cb.second(ReqResult::Ok, resp);
 
             // LOG_TRACE << "pipelining buffer size=" <<
             // pipeliningCallbacks_.size(); LOG_TRACE << "requests buffer size="
@@ -416,8 +542,8 @@ void HttpClientImpl::onRecvMessage(const trantor::TcpConnectionPtr &connPtr,
             {
                 auto &reqAndCb = requestsBuffer_.front();
                 sendReq(connPtr, reqAndCb.first);
-                pipeliningCallbacks_.push(std::move(reqAndCb));
-                requestsBuffer_.pop();
+                pipeliningCallbacks_.push_back(std::move(reqAndCb));
+                requestsBuffer_.pop_front();
             }
             else
             {
@@ -459,13 +585,14 @@ void HttpClientImpl::onError(ReqResult result)
     while (!pipeliningCallbacks_.empty())
     {
         auto cb = std::move(pipeliningCallbacks_.front());
-        pipeliningCallbacks_.pop();
-        cb.second(result, nullptr);
+        pipeliningCallbacks_.pop_front();
+        if (cb.second)
+            cb.second(result, nullptr);
     }
     while (!requestsBuffer_.empty())
     {
         auto cb = std::move(requestsBuffer_.front().second);
-        requestsBuffer_.pop();
+        requestsBuffer_.pop_front();
         cb(result, nullptr);
     }
     tcpClientPtr_.reset();
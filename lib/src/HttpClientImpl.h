@@ -20,8 +20,8 @@
 #include <trantor/net/EventLoop.h>
 #include <trantor/net/TcpClient.h>
 #include <trantor/net/Resolver.h>
+#include <deque>
 #include <mutex>
-#include <queue>
 #include <vector>
 
 namespace drogon
@@ -84,8 +84,14 @@ class HttpClientImpl : public HttpClient,
                            const HttpReqCallback &callback);
     void handleCookies(const HttpResponseImplPtr &resp);
     void createTcpClient();
-    std::queue<std::pair<HttpRequestPtr, HttpReqCallback>> pipeliningCallbacks_;
-    std::queue<std::pair<HttpRequestPtr, HttpReqCallback>> requestsBuffer_;
+    bool bindToCancellation(const HttpRequestPtr &req,
+                            HttpReqCallback &callback,
+                            CancellationTokenPtr &token);
+    void abortRequest(const HttpRequestPtr &req, ReqResult result);
+    // The callback of a request in the pipeline is empty if the request is
+    // aborted, its response is discarded.
+    std::deque<std::pair<HttpRequestPtr, HttpReqCallback>> pipeliningCallbacks_;
+    std::deque<std::pair<HttpRequestPtr, HttpReqCallback>> requestsBuffer_;
     void onRecvMessage(const trantor::TcpConnectionPtr &, trantor::MsgBuffer *);
     void onError(ReqResult result);
     std::string domain_;
@@ -18,6 +18,7 @@
 #include "HttpResponseImpl.h"
 #include "StaticFileRouter.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpMetrics.h"
 #include "FiltersFunction.h"
 #include <algorithm>
 
@@ -49,6 +50,8 @@ void HttpControllersRouter::init(
         router.regex_ = std::regex(router.pathParameterPattern_,
                                    std::regex_constants::icase);
         regString.append("(").append(tmp).append(")|");
+        router.stageMetrics_ =
+            std::make_shared<RouteStageMetrics>(router.pathPattern_);
         for (auto &binder : router.binders_)
         {
             if (binder)
@@ -381,6 +384,10 @@ void HttpControllersRouter::route(
                     size_t ctlIndex = i - 1;
                     auto &routerItem = ctrlVector_[ctlIndex];
                     assert(Invalid > req->method());
+                    HttpMetrics::instance().onRouted(
+                        HttpMetrics::kHttpController,
+                        req->timings(),
+                        routerItem.stageMetrics_.get());
                     req->setMatchedPathPattern(routerItem.pathPattern_);
                     auto &binder = routerItem.binders_[req->method()];
                     if (!binder)
@@ -495,6 +502,14 @@ void HttpControllersRouter::doControllerHandler(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
+    if (req->isCancelled())
+    {
+        invokeCallback(callback,
+                       req,
+                       HttpAppFrameworkImpl::newCancelledResponse());
+        return;
+    }
+    req->timings().handlerStart_ = RequestTimings::now();
     auto &responsePtr = *(ctrlBinderPtr->responseCache_);
     if (responsePtr)
     {
@@ -90,6 +90,7 @@ class HttpControllersRouter : public trantor::NonCopyable
         std::regex regex_;
         CtrlBinderPtr binders_[Invalid]{
             nullptr};  // The enum value of Invalid is the http methods number
+        std::shared_ptr<RouteStageMetrics> stageMetrics_;
     };
     std::vector<HttpControllerRouterItem> ctrlVector_;
     std::mutex ctrlMutex_;
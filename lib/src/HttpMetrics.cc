@@ -0,0 +1,80 @@
+/**
+ *
+ *  HttpMetrics.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpMetrics.h"
+
+using namespace drogon;
+
+RouteStageMetrics::RouteStageMetrics(const std::string &route)
+{
+    const char *stages[] = {
+        "parse", "queue", "filters", "handler", "serialize", "write"};
+    for (int i = 0; i < RequestTimings::kStagesNumber; ++i)
+    {
+        stages_[i] = MetricsRegistry::instance().histogram(
+            "drogon_http_stage_duration_seconds",
+            "The durations of the stages of HTTP requests by routes",
+            {{"route", route}, {"stage", stages[i]}});
+    }
+}
+
+void RouteStageMetrics::record(const RequestTimings &timings, int64_t sent)
+{
+    int64_t durations[RequestTimings::kStagesNumber];
+    timings.stageDurations(sent, durations);
+    for (int i = 0; i < RequestTimings::kStagesNumber; ++i)
+        stages_[i]->record(std::chrono::nanoseconds(durations[i]));
+}
+
+HttpMetrics &HttpMetrics::instance()
+{
+    static HttpMetrics metrics;
+    return metrics;
+}
+
+HttpMetrics::HttpMetrics()
+    : unmatched_("unmatched"), staticFiles_("static_files")
+{
+    auto &registry = MetricsRegistry::instance();
+    const char *methods[] = {
+        "GET", "POST", "HEAD", "PUT", "DELETE", "OPTIONS", "INVALID"};
+    for (int i = Get; i <= Invalid; ++i)
+    {
+        requests_[i] = registry.counter("drogon_http_requests_total",
+                                        "The number of HTTP requests received",
+                                        {{"method", methods[i]}});
+    }
+    inFlight_ = registry.gauge(
+        "drogon_http_requests_in_flight",
+        "The number of HTTP requests whose responses are not produced yet");
+    duration_ = registry.histogram(
+        "drogon_http_request_duration_seconds",
+        "The time from receiving an HTTP request to producing its response");
+    const char *routers[] = {
+        "simple_controller", "http_controller", "static_file", "not_found"};
+    for (int i = 0; i < kRoutersNumber; ++i)
+    {
+        routed_[i] =
+            registry.counter("drogon_http_routed_requests_total",
+                             "The number of HTTP requests dispatched by routers",
+                             {{"router", routers[i]}});
+    }
+    const char *codes[] = {"other", "1xx", "2xx", "3xx", "4xx", "5xx"};
+    for (int i = 0; i < 6; ++i)
+    {
+        responses_[i] = registry.counter("drogon_http_responses_total",
+                                         "The number of HTTP responses sent",
+                                         {{"code", codes[i]}});
+    }
+}
@@ -0,0 +1,122 @@
+/**
+ *
+ *  HttpMetrics.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "RequestTimings.h"
+#include <drogon/HttpTypes.h>
+#include <drogon/utils/Metrics.h>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+/**
+ * @brief The durations of the stages of the requests accepted by a route,
+ * recorded into drogon_http_stage_duration_seconds{route, stage}.
+ *
+ * The routers create one for each path pattern when they're initialized, the
+ * requests which are not routed are recorded with the route "unmatched".
+ */
+class RouteStageMetrics
+{
+  public:
+    explicit RouteStageMetrics(const std::string &route);
+    void record(const RequestTimings &timings, int64_t sent);
+
+  private:
+    std::shared_ptr<MetricHistogram> stages_[RequestTimings::kStagesNumber];
+};
+
+/**
+ * @brief The metrics of HTTP requests, which are recorded by the framework
+ * into the default MetricsRegistry.
+ *
+ * - drogon_http_requests_total{method}: Requests received, counted in
+ * HttpServer::onRequests().
+ * - drogon_http_requests_in_flight: Requests whose responses are not produced
+ * yet.
+ * - drogon_http_request_duration_seconds: The time from receiving a request
+ * to producing its response.
+ * - drogon_http_routed_requests_total{router}: Requests dispatched by each
+ * router, "not_found" for those no router accepts.
+ * - drogon_http_responses_total{code}: Responses sent, by the class of their
+ * status codes.
+ * - drogon_http_stage_duration_seconds{route, stage}: See RouteStageMetrics.
+ */
+class HttpMetrics
+{
+  public:
+    enum Router
+    {
+        kSimpleController = 0,
+        kHttpController,
+        kStaticFile,
+        kNotFound,
+        kRoutersNumber
+    };
+
+    static HttpMetrics &instance();
+
+    void onRequest(HttpMethod method)
+    {
+        requests_[method < Invalid ? method : Invalid]->add();
+        inFlight_->add();
+    }
+    void onResponse(RequestTimings &timings)
+    {
+        inFlight_->sub();
+        timings.responded_ = RequestTimings::now();
+        duration_->record(
+            std::chrono::nanoseconds(timings.responded_ - timings.parsed_));
+    }
+    /// Called when a router accepts a request, or rejects it with kNotFound.
+    /**
+     * @param route The stage metrics of the matched route, the requests
+     * without it are recorded as unmatched.
+     */
+    void onRouted(Router router,
+                  RequestTimings &timings,
+                  RouteStageMetrics *route = nullptr)
+    {
+        routed_[router]->add();
+        timings.routed_ = RequestTimings::now();
+        timings.route_ = route;
+    }
+    RouteStageMetrics &staticFileStages()
+    {
+        return staticFiles_;
+    }
+    void onSent(HttpStatusCode code,
+                const RequestTimings &timings,
+                int64_t sent)
+    {
+        auto index = static_cast<size_t>(code) / 100;
+        responses_[index < 6 ? index : 0]->add();
+        (timings.route_ ? timings.route_ : &unmatched_)->record(timings, sent);
+    }
+
+  private:
+    HttpMetrics();
+
+    std::shared_ptr<MetricCounter> requests_[Invalid + 1];
+    std::shared_ptr<MetricGauge> inFlight_;
+    std::shared_ptr<MetricHistogram> duration_;
+    std::shared_ptr<MetricCounter> routed_[kRoutersNumber];
+    std::shared_ptr<MetricCounter> responses_[6];
+    RouteStageMetrics unmatched_;
+    RouteStageMetrics staticFiles_;
+};
+
+}  // namespace drogon
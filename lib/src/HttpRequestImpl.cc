@@ -15,7 +15,9 @@
 #include "HttpRequestImpl.h"
 #include "HttpFileUploadRequest.h"
 #include "HttpAppFrameworkImpl.h"
+#include "JsonWriter.h"
 
+#include <drogon/utils/BinaryJson.h>
 #include <drogon/utils/Utilities.h>
 #include <fstream>
 #include <iostream>
@@ -46,6 +48,46 @@ void HttpRequestImpl::parseJson() const
             jsonPtr_.reset();
         }
     }
+    else if (auto binaryType = getBinaryJsonType(type))
+    {
+        jsonPtr_ = std::make_shared<Json::Value>();
+        std::string errs;
+        if (!decodeBinaryJson(input, binaryType, *jsonPtr_, &errs))
+        {
+            LOG_ERROR << errs;
+            jsonPtr_.reset();
+        }
+    }
+}
+void HttpRequestImpl::parseJsonView() const
+{
+    auto input = contentView();
+    if (input.empty())
+        return;
+    std::string type = getHeaderBy("content-type");
+    std::transform(type.begin(), type.end(), type.begin(), tolower);
+    std::string errs;
+    if (type.find("application/json") != std::string::npos)
+    {
+        jsonView_ = JsonView::parse(input, &errs);
+        if (!jsonView_)
+        {
+            LOG_ERROR << errs;
+        }
+    }
+    else if (auto binaryType = getBinaryJsonType(type))
+    {
+        // The view needs a json text, so the document is transcoded into one,
+        // which is still cheaper than building a Json::Value tree.
+        auto text = std::make_shared<std::string>();
+        if (!binaryJsonToText(input, binaryType, *text, &errs))
+        {
+            LOG_ERROR << errs;
+            return;
+        }
+        jsonTextPtr_ = std::move(text);
+        jsonView_ = JsonView::parse(*jsonTextPtr_);
+    }
 }
 void HttpRequestImpl::parseParameters() const
 {
@@ -214,7 +256,9 @@ void HttpRequestImpl::appendToBuffer(trantor::MsgBuffer *output) const
             output->append(content);
             content.clear();
         }
-        else if (contentType_ == CT_APPLICATION_JSON)
+        else if (contentType_ == CT_APPLICATION_JSON ||
+                 contentType_ == CT_APPLICATION_MSGPACK ||
+                 contentType_ == CT_APPLICATION_CBOR)
         {
             /// Can't set parameters in content in this case
             LOG_ERROR
@@ -450,19 +494,28 @@ HttpRequestPtr HttpRequest::newHttpFormPostRequest()
     return req;
 }
 
-HttpRequestPtr HttpRequest::newHttpJsonRequest(const Json::Value &data)
+HttpRequestPtr HttpRequest::newHttpJsonRequest(const Json::Value &data,
+                                               ContentType type)
 {
-    static std::once_flag once;
-    static Json::StreamWriterBuilder builder;
-    std::call_once(once, []() {
-        builder["commentStyle"] = "None";
-        builder["indentation"] = "";
-    });
     auto req = std::make_shared<HttpRequestImpl>(nullptr);
     req->setMethod(drogon::Get);
     req->setVersion(drogon::HttpRequest::kHttp11);
-    req->contentType_ = CT_APPLICATION_JSON;
-    req->setContent(writeString(builder, data));
+    if (type == CT_APPLICATION_MSGPACK || type == CT_APPLICATION_CBOR)
+    {
+        req->contentType_ = type;
+        std::string content;
+        encodeBinaryJson(data, type, content);
+        req->setContent(content);
+        // Ask for a response in the same format.
+        req->addHeader("accept",
+                       type == CT_APPLICATION_MSGPACK ? "application/msgpack"
+                                                      : "application/cbor");
+    }
+    else
+    {
+        req->contentType_ = CT_APPLICATION_JSON;
+        req->setContent(writeJson(data));
+    }
     return req;
 }
 
@@ -478,6 +531,7 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     swap(method_, that.method_);
     swap(version_, that.version_);
     swap(flagForParsingJson_, that.flagForParsingJson_);
+    swap(flagForParsingJsonView_, that.flagForParsingJsonView_);
     swap(flagForParsingParameters_, that.flagForParsingParameters_);
     swap(matchedPathPattern_, that.matchedPathPattern_);
     swap(path_, that.path_);
@@ -486,12 +540,16 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     swap(cookies_, that.cookies_);
     swap(parameters_, that.parameters_);
     swap(jsonPtr_, that.jsonPtr_);
+    swap(jsonView_, that.jsonView_);
+    swap(jsonTextPtr_, that.jsonTextPtr_);
     swap(sessionPtr_, that.sessionPtr_);
     swap(attributesPtr_, that.attributesPtr_);
     swap(cacheFilePtr_, that.cacheFilePtr_);
     swap(peer_, that.peer_);
     swap(local_, that.local_);
     swap(creationDate_, that.creationDate_);
+    swap(timings_, that.timings_);
+    swap(traceContext_, that.traceContext_);
     swap(content_, that.content_);
     swap(contentLen_, that.contentLen_);
     swap(expect_, that.expect_);
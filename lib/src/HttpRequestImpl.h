@@ -16,6 +16,8 @@
 
 #include "HttpUtils.h"
 #include "CacheFile.h"
+#include "RequestTimings.h"
+#include <drogon/utils/Tracing.h>
 #include <drogon/utils/Utilities.h>
 #include <drogon/HttpRequest.h>
 #include <drogon/utils/Utilities.h>
@@ -48,6 +50,7 @@ class HttpRequestImpl : public HttpRequest
         version_ = kUnknown;
         contentLen_ = 0;
         flagForParsingJson_ = false;
+        flagForParsingJsonView_ = false;
         headers_.clear();
         cookies_.clear();
         flagForParsingParameters_ = false;
@@ -56,6 +59,8 @@ class HttpRequestImpl : public HttpRequest
         query_.clear();
         parameters_.clear();
         jsonPtr_.reset();
+        jsonView_ = JsonView();
+        jsonTextPtr_.reset();
         sessionPtr_.reset();
         attributesPtr_.reset();
         cacheFilePtr_.reset();
@@ -64,6 +69,8 @@ class HttpRequestImpl : public HttpRequest
         contentType_ = CT_TEXT_PLAIN;
         contentTypeString_.clear();
         keepAlive_ = true;
+        timings_ = RequestTimings();
+        traceContext_ = TraceContext();
     }
     trantor::EventLoop *getLoop()
     {
@@ -229,6 +236,31 @@ class HttpRequestImpl : public HttpRequest
         creationDate_ = date;
     }
 
+    virtual const CancellationTokenPtr &cancellationToken() const override
+    {
+        return cancellationToken_;
+    }
+
+    /// Give the request a token of its own, the token of the last request
+    /// handled by this object is reused if nothing holds it any more.
+    void renewCancellationToken()
+    {
+        if (cancellationToken_ && cancellationToken_.use_count() == 1)
+            cancellationToken_->reset();
+        else
+            cancellationToken_ = std::make_shared<CancellationToken>();
+    }
+
+    RequestTimings &timings()
+    {
+        return timings_;
+    }
+
+    TraceContext &traceContext()
+    {
+        return traceContext_;
+    }
+
     void setPeerAddr(const trantor::InetAddress &peer)
     {
         peer_ = peer;
@@ -363,6 +395,16 @@ class HttpRequestImpl : public HttpRequest
         return jsonPtr_;
     }
 
+    virtual JsonView jsonView() const override
+    {
+        if (!flagForParsingJsonView_)
+        {
+            flagForParsingJsonView_ = true;
+            parseJsonView();
+        }
+        return jsonView_;
+    }
+
     virtual void setCustomContentTypeString(const std::string &type) override
     {
         contentType_ = CT_NONE;
@@ -440,8 +482,10 @@ class HttpRequestImpl : public HttpRequest
     }
 
     void parseJson() const;
+    void parseJsonView() const;
     mutable bool flagForParsingParameters_{false};
     mutable bool flagForParsingJson_{false};
+    mutable bool flagForParsingJsonView_{false};
     HttpMethod method_{Invalid};
     Version version_{kUnknown};
     std::string path_;
@@ -451,11 +495,17 @@ class HttpRequestImpl : public HttpRequest
     std::unordered_map<std::string, std::string> cookies_;
     mutable std::unordered_map<std::string, std::string> parameters_;
     mutable std::shared_ptr<Json::Value> jsonPtr_;
+    mutable JsonView jsonView_;
+    // The json text transcoded from a binary body for the view.
+    mutable std::shared_ptr<std::string> jsonTextPtr_;
     SessionPtr sessionPtr_;
     mutable AttributesPtr attributesPtr_;
     trantor::InetAddress peer_;
     trantor::InetAddress local_;
     trantor::Date creationDate_;
+    RequestTimings timings_;
+    TraceContext traceContext_;
+    CancellationTokenPtr cancellationToken_;
     std::unique_ptr<CacheFile> cacheFilePtr_;
     std::string expect_;
     bool keepAlive_{true};
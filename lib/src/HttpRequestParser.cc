@@ -125,6 +125,7 @@ void HttpRequestParser::reset()
         request_ = std::move(req);
         request_->setCreationDate(trantor::Date::now());
     }
+    request_->renewCancellationToken();
 }
 // Return false if any error
 bool HttpRequestParser::parseRequest(MsgBuffer *buf)
@@ -136,6 +137,9 @@ bool HttpRequestParser::parseRequest(MsgBuffer *buf)
     {
         if (status_ == HttpRequestParseStatus::ExpectMethod)
         {
+            auto &timings = request_->timings();
+            if (timings.parseStart_ == 0)
+                timings.parseStart_ = RequestTimings::now();
             auto *space =
                 std::find(buf->peek(), (const char *)buf->beginWrite(), ' ');
             if (space != buf->beginWrite())
@@ -329,7 +333,7 @@ bool HttpRequestParser::parseRequest(MsgBuffer *buf)
     return ok;
 }
 
-void HttpRequestParser::pushRquestToPipelining(const HttpRequestPtr &req)
+void HttpRequestParser::pushRquestToPipelining(const HttpRequestImplPtr &req)
 {
 #ifndef NDEBUG
     auto conn = conn_.lock();
@@ -338,10 +342,19 @@ void HttpRequestParser::pushRquestToPipelining(const HttpRequestPtr &req)
         conn->getLoop()->assertInLoopThread();
     }
 #endif
-    requestPipelining_.push_back({req, {nullptr, false}});
+    requestPipelining_.push_back({req, nullptr, false});
 }
 
-HttpRequestPtr HttpRequestParser::getFirstRequest() const
+void HttpRequestParser::cancelPendingRequests()
+{
+    for (auto &pending : requestPipelining_)
+    {
+        if (!pending.response_)
+            pending.request_->cancellationToken()->cancel();
+    }
+}
+
+HttpRequestImplPtr HttpRequestParser::getFirstRequest() const
 {
 #ifndef NDEBUG
     auto conn = conn_.lock();
@@ -352,12 +365,12 @@ HttpRequestPtr HttpRequestParser::getFirstRequest() const
 #endif
     if (!requestPipelining_.empty())
     {
-        return requestPipelining_.front().first;
+        return requestPipelining_.front().request_;
     }
     return nullptr;
 }
 
-std::pair<HttpResponsePtr, bool> HttpRequestParser::getFirstResponse() const
+PendingResponse HttpRequestParser::getFirstResponse() const
 {
 #ifndef NDEBUG
     auto conn = conn_.lock();
@@ -368,9 +381,9 @@ std::pair<HttpResponsePtr, bool> HttpRequestParser::getFirstResponse() const
 #endif
     if (!requestPipelining_.empty())
     {
-        return requestPipelining_.front().second;
+        return requestPipelining_.front();
     }
-    return {nullptr, false};
+    return {nullptr, nullptr, false};
 }
 
 void HttpRequestParser::popFirstRequest()
@@ -385,9 +398,10 @@ void HttpRequestParser::popFirstRequest()
     requestPipelining_.pop_front();
 }
 
-void HttpRequestParser::pushResponseToPipelining(const HttpRequestPtr &req,
-                                                 const HttpResponsePtr &resp,
-                                                 bool isHeadMethod)
+void HttpRequestParser::pushResponseToPipelining(
+    const HttpRequestImplPtr &req,
+    const HttpResponsePtr &resp,
+    bool isHeadMethod)
 {
 #ifndef NDEBUG
     auto conn = conn_.lock();
@@ -398,9 +412,10 @@ void HttpRequestParser::pushResponseToPipelining(const HttpRequestPtr &req,
 #endif
     for (auto &iter : requestPipelining_)
     {
-        if (iter.first == req)
+        if (iter.request_ == req)
         {
-            iter.second = {resp, isHeadMethod};
+            iter.response_ = resp;
+            iter.isHeadMethod_ = isHeadMethod;
             return;
         }
     }
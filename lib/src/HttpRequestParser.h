@@ -24,6 +24,14 @@
 
 namespace drogon
 {
+/// A response waiting to be sent, with the request it answers.
+struct PendingResponse
+{
+    HttpRequestImplPtr request_;
+    HttpResponsePtr response_;
+    bool isHeadMethod_{false};
+};
+
 class HttpRequestParser : public trantor::NonCopyable,
                           public std::enable_shared_from_this<HttpRequestParser>
 {
@@ -72,17 +80,43 @@ class HttpRequestParser : public trantor::NonCopyable,
         websockConnPtr_ = conn;
     }
     // to support request pipelining(rfc2616-8.1.2.2)
-    void pushRquestToPipelining(const HttpRequestPtr &req);
-    HttpRequestPtr getFirstRequest() const;
-    std::pair<HttpResponsePtr, bool> getFirstResponse() const;
+    void pushRquestToPipelining(const HttpRequestImplPtr &req);
+    HttpRequestImplPtr getFirstRequest() const;
+    PendingResponse getFirstResponse() const;
     void popFirstRequest();
-    void pushResponseToPipelining(const HttpRequestPtr &req,
+    void pushResponseToPipelining(const HttpRequestImplPtr &req,
                                   const HttpResponsePtr &resp,
                                   bool isHeadMethod);
     size_t numberOfRequestsInPipelining() const
     {
         return requestPipelining_.size();
     }
+    /// The number of the responses in the pipelining queue waiting for the
+    /// responses of the earlier requests.
+    size_t numberOfResponsesInPipelining() const
+    {
+        size_t number = 0;
+        for (auto &pending : requestPipelining_)
+        {
+            if (pending.response_)
+                ++number;
+        }
+        return number;
+    }
+    /// Whether the connection waits for the next request, i.e. no request is
+    /// being received or handled.
+    bool isIdle() const
+    {
+        return requestPipelining_.empty() &&
+               status_ == HttpRequestParseStatus::ExpectMethod;
+    }
+    trantor::TcpConnectionPtr connection() const
+    {
+        return conn_.lock();
+    }
+    /// Cancel the requests whose responses are not produced yet, called when
+    /// the connection is closed.
+    void cancelPendingRequests();
     bool emptyPipelining()
     {
         return requestPipelining_.empty();
@@ -103,14 +137,13 @@ class HttpRequestParser : public trantor::NonCopyable,
     {
         return sendBuffer_;
     }
-    std::vector<std::pair<HttpResponsePtr, bool>> &getResponseBuffer()
+    std::vector<PendingResponse> &getResponseBuffer()
     {
         assert(loop_->isInLoopThread());
         if (!responseBuffer_)
         {
-            responseBuffer_ =
-                std::unique_ptr<std::vector<std::pair<HttpResponsePtr, bool>>>(
-                    new std::vector<std::pair<HttpResponsePtr, bool>>);
+            responseBuffer_ = std::unique_ptr<std::vector<PendingResponse>>(
+                new std::vector<PendingResponse>);
         }
         return *responseBuffer_;
     }
@@ -134,14 +167,12 @@ class HttpRequestParser : public trantor::NonCopyable,
     HttpRequestImplPtr request_;
     bool firstRequest_{true};
     WebSocketConnectionImplPtr websockConnPtr_;
-    std::deque<std::pair<HttpRequestPtr, std::pair<HttpResponsePtr, bool>>>
-        requestPipelining_;
+    std::deque<PendingResponse> requestPipelining_;
     size_t requestsCounter_{0};
     std::weak_ptr<trantor::TcpConnection> conn_;
     bool stopWorking_{false};
     trantor::MsgBuffer sendBuffer_;
-    std::unique_ptr<std::vector<std::pair<HttpResponsePtr, bool>>>
-        responseBuffer_;
+    std::unique_ptr<std::vector<PendingResponse>> responseBuffer_;
     std::unique_ptr<std::vector<HttpRequestImplPtr>> requestBuffer_;
     std::vector<HttpRequestImplPtr> requestsPool_;
 };
@@ -15,8 +15,10 @@
 #include "HttpResponseImpl.h"
 #include "HttpAppFrameworkImpl.h"
 #include "HttpUtils.h"
+#include "JsonWriter.h"
 #include <drogon/HttpViewData.h>
 #include <drogon/IOThreadStorage.h>
+#include <drogon/utils/BinaryJson.h>
 #include <fstream>
 #include <memory>
 #include <stdio.h>
@@ -72,13 +74,7 @@ void HttpResponseImpl::generateBodyFromJson()
     {
         return;
     }
-    static std::once_flag once;
-    static Json::StreamWriterBuilder builder;
-    std::call_once(once, []() {
-        builder["commentStyle"] = "None";
-        builder["indentation"] = "";
-    });
-    setBody(writeString(builder, *jsonPtr_));
+    setBody(writeJson(*jsonPtr_));
 }
 
 HttpResponsePtr HttpResponse::newNotFoundResponse()
@@ -145,6 +141,29 @@ HttpResponsePtr HttpResponse::newHttpViewResponse(const std::string &viewName,
     return genHttpResponse(viewName, data);
 }
 
+HttpResponsePtr HttpResponse::newStreamViewResponse(
+    const std::string &viewName,
+    const HttpViewData &data)
+{
+    auto templ = DrTemplateBase::newTemplate(viewName);
+    if (!templ)
+        return drogon::HttpResponse::newNotFoundResponse();
+    return newStreamResponse([templ, data](const StreamWriter &writer) {
+        OStringStream stream(writer, 16 * 1024);
+        templ->renderTo(data, stream);
+        stream.flush();
+    });
+}
+
+HttpResponsePtr HttpResponse::newStreamResponse(
+    const std::function<void(const StreamWriter &)> &producer,
+    ContentType type)
+{
+    auto res = std::make_shared<HttpResponseImpl>(k200OK, type);
+    res->setStreamProducer(producer);
+    return res;
+}
+
 HttpResponsePtr HttpResponse::newFileResponse(
     const std::string &fullPath,
     const std::string &attachmentFileName,
@@ -214,7 +233,11 @@ void HttpResponseImpl::makeHeaderString(
         headerStringPtr->append(statusMessage_.data(), statusMessage_.length());
     headerStringPtr->append("\r\n");
     generateBodyFromJson();
-    if (sendfileName_.empty())
+    if (streamProducer_)
+    {
+        len = snprintf(buf, sizeof buf, "Transfer-Encoding: chunked\r\n");
+    }
+    else if (sendfileName_.empty())
     {
         long unsigned int bodyLength =
             bodyPtr_ ? bodyPtr_->length()
@@ -229,6 +252,7 @@ void HttpResponseImpl::makeHeaderString(
             LOG_SYSERR << sendfileName_ << " stat error";
             return;
         }
+        sendfileLength_ = static_cast<size_t>(filestat.st_size);
         len = snprintf(buf,
                        sizeof buf,
                        "Content-Length: %llu\r\n",
@@ -280,7 +304,11 @@ void HttpResponseImpl::renderToBuffer(trantor::MsgBuffer &buffer)
             buffer.append(statusMessage_.data(), statusMessage_.length());
         buffer.append("\r\n");
         generateBodyFromJson();
-        if (sendfileName_.empty())
+        if (streamProducer_)
+        {
+            len = snprintf(buf, sizeof buf, "Transfer-Encoding: chunked\r\n");
+        }
+        else if (sendfileName_.empty())
         {
             long unsigned int bodyLength =
                 bodyPtr_ ? bodyPtr_->length()
@@ -298,6 +326,7 @@ void HttpResponseImpl::renderToBuffer(trantor::MsgBuffer &buffer)
                 LOG_SYSERR << sendfileName_ << " stat error";
                 return;
             }
+            sendfileLength_ = static_cast<size_t>(filestat.st_size);
             len =
                 snprintf(buf,
                          sizeof buf,
@@ -591,6 +620,7 @@ void HttpResponseImpl::swap(HttpResponseImpl &that) noexcept
     swap(currentChunkLength_, that.currentChunkLength_);
     swap(contentType_, that.contentType_);
     jsonPtr_.swap(that.jsonPtr_);
+    streamProducer_.swap(that.streamProducer_);
     fullHeaderString_.swap(that.fullHeaderString_);
     httpString_.swap(that.httpString_);
     swap(datePos_, that.datePos_);
@@ -606,6 +636,7 @@ void HttpResponseImpl::clear()
     cookies_.clear();
     bodyPtr_.reset();
     bodyViewPtr_.reset();
+    streamProducer_ = nullptr;
     leftBodyLength_ = 0;
     currentChunkLength_ = 0;
     jsonPtr_.reset();
@@ -613,8 +644,49 @@ void HttpResponseImpl::clear()
     datePos_ = std::string::npos;
 }
 
+bool HttpResponseImpl::encodeJsonBody(ContentType type)
+{
+    std::string encoded;
+    if (jsonPtr_)
+    {
+        encodeBinaryJson(*jsonPtr_, type, encoded);
+    }
+    else
+    {
+        auto &text = body();
+        auto view = JsonView::parse(text);
+        if (!view)
+            return false;
+        encodeBinaryJson(view, type, encoded);
+    }
+    jsonPtr_.reset();
+    flagForParsingJson_ = false;
+    setBody(std::move(encoded));
+    setContentTypeCode(type);
+    return true;
+}
+
 void HttpResponseImpl::parseJson() const
 {
+    auto binaryType = getBinaryJsonType(contentType_);
+    if (binaryType == CT_NONE)
+        binaryType = getBinaryJsonType(getHeaderBy("content-type"));
+    if (binaryType != CT_NONE)
+    {
+        jsonPtr_ = std::make_shared<Json::Value>();
+        std::string errs;
+        string_view data;
+        if (bodyPtr_)
+            data = string_view(bodyPtr_->data(), bodyPtr_->length());
+        else if (bodyViewPtr_)
+            data = *bodyViewPtr_;
+        if (!decodeBinaryJson(data, binaryType, *jsonPtr_, &errs))
+        {
+            LOG_ERROR << errs;
+            jsonPtr_.reset();
+        }
+        return;
+    }
     static std::once_flag once;
     static Json::CharReaderBuilder builder;
     std::call_once(once, []() { builder["collectComments"] = false; });
@@ -287,13 +287,18 @@ class HttpResponseImpl : public HttpResponse
     }
     void setJsonObject(const Json::Value &pJson)
     {
+        flagForParsingJson_ = true;
         jsonPtr_ = std::make_shared<Json::Value>(pJson);
     }
     void setJsonObject(Json::Value &&pJson)
     {
+        flagForParsingJson_ = true;
         jsonPtr_ = std::make_shared<Json::Value>(std::move(pJson));
     }
     void generateBodyFromJson();
+    /// Replace the json body with its encoding in a binary format, false is
+    /// returned if the body is not valid json.
+    bool encodeJsonBody(ContentType type);
     const std::string &sendfileName() const
     {
         return sendfileName_;
@@ -302,6 +307,34 @@ class HttpResponseImpl : public HttpResponse
     {
         sendfileName_ = filename;
     }
+    /// The length of the file to send, known after the header is rendered.
+    size_t sendfileLength() const
+    {
+        return sendfileLength_;
+    }
+    const std::function<void(const StreamWriter &)> &streamProducer() const
+    {
+        return streamProducer_;
+    }
+    void setStreamProducer(
+        const std::function<void(const StreamWriter &)> &producer)
+    {
+        streamProducer_ = producer;
+    }
+    /// Produce the whole body of a streaming response, it's used when the
+    /// client doesn't support the chunked transfer coding.
+    void bufferStream()
+    {
+        if (!streamProducer_)
+            return;
+        auto body = std::make_shared<std::string>();
+        streamProducer_([&body](const char *data, size_t length) {
+            body->append(data, length);
+        });
+        streamProducer_ = nullptr;
+        bodyPtr_ = std::move(body);
+        bodyViewPtr_.reset();
+    }
     void makeHeaderString()
     {
         fullHeaderString_ = std::make_shared<std::string>();
@@ -352,6 +385,8 @@ class HttpResponseImpl : public HttpResponse
     std::shared_ptr<string_view> bodyViewPtr_;
     ssize_t expriedTime_{-1};
     std::string sendfileName_;
+    size_t sendfileLength_{0};
+    std::function<void(const StreamWriter &)> streamProducer_;
     mutable std::shared_ptr<Json::Value> jsonPtr_;
 
     std::shared_ptr<std::string> fullHeaderString_;
@@ -13,26 +13,76 @@
  */
 
 #include "HttpServer.h"
+#include "EventLoopMonitor.h"
 #include "HttpRequestImpl.h"
 #include "HttpRequestParser.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpMetrics.h"
 #include "HttpResponseImpl.h"
 #include "WebSocketConnectionImpl.h"
 #include <drogon/HttpRequest.h>
 #include <drogon/HttpResponse.h>
+#include <drogon/plugins/AccessLogger.h>
+#include <drogon/plugins/Profiler.h>
+#include <drogon/utils/Tracing.h>
 #include <drogon/utils/Utilities.h>
+#include <algorithm>
 #include <functional>
+#include <random>
+#include <unordered_set>
+#include <trantor/net/inner/TcpConnectionImpl.h>
 #include <trantor/utils/Logger.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 using namespace std::placeholders;
 using namespace drogon;
 using namespace trantor;
 namespace drogon
 {
-static HttpResponsePtr getCompressedResponse(const HttpRequestImplPtr &req,
-                                             const HttpResponsePtr &response,
-                                             bool isHeadMethod)
-{  // use gzip
+// Encode a json response in MessagePack or CBOR if the client prefers it.
+static HttpResponsePtr getNegotiatedResponse(const HttpRequestImplPtr &req,
+                                             const HttpResponsePtr &response)
+{
+    if (response->contentType() != CT_APPLICATION_JSON)
+        return response;
+    auto type = negotiateJsonType(req->getHeaderBy("accept"));
+    if (type == CT_APPLICATION_JSON)
+        return response;
+    auto newResp = response;
+    if (response->expiredTime() >= 0)
+    {
+        // cached response,we need to make a clone
+        newResp = std::make_shared<HttpResponseImpl>(
+            *static_cast<HttpResponseImpl *>(response.get()));
+        newResp->setExpiredTime(-1);
+    }
+    if (!static_cast<HttpResponseImpl *>(newResp.get())->encodeJsonBody(type))
+        return response;
+    newResp->addHeader("Vary", "Accept");
+    return newResp;
+}
+
+static HttpResponsePtr getCompressedResponse(
+    const HttpRequestImplPtr &req,
+    const HttpResponsePtr &originalResponse,
+    bool isHeadMethod)
+{
+    auto response = getNegotiatedResponse(req, originalResponse);
+    auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
+    if (respImplPtr->streamProducer())
+    {
+        // HTTP/1.0 clients don't support the chunked transfer coding.
+        if (req->version() == HttpRequest::kHttp10)
+            respImplPtr->bufferStream();
+        return response;
+    }
+    // use gzip
     LOG_TRACE << "Use gzip to compress the body";
     auto &sendfileName =
         static_cast<HttpResponseImpl *>(response.get())->sendfileName();
@@ -67,6 +117,165 @@ static HttpResponsePtr getCompressedResponse(const HttpRequestImplPtr &req,
     }
     return response;
 }
+
+static bool isServerTimingSampled()
+{
+    auto rate = HttpAppFrameworkImpl::instance().serverTimingSampleRate();
+    if (rate <= 0)
+        return false;
+    if (rate >= 1)
+        return true;
+    thread_local std::minstd_rand generator(std::random_device{}());
+    return std::uniform_real_distribution<double>(0, 1)(generator) < rate;
+}
+
+// Add the Server-Timing header with the durations (in milliseconds) of the
+// stages before the response is produced.
+static HttpResponsePtr addServerTiming(const HttpRequestImplPtr &req,
+                                       const HttpResponsePtr &response)
+{
+    auto newResp = response;
+    if (response->expiredTime() >= 0)
+    {
+        // cached response,we need to make a clone
+        newResp = std::make_shared<HttpResponseImpl>(
+            *static_cast<HttpResponseImpl *>(response.get()));
+        newResp->setExpiredTime(-1);
+    }
+    auto &timings = req->timings();
+    int64_t durations[RequestTimings::kStagesNumber];
+    timings.stageDurations(timings.responded_, durations);
+    const char *stages[] = {"parse", "queue", "filters", "handler"};
+    std::string header;
+    char buf[64];
+    for (int i = RequestTimings::kParse; i <= RequestTimings::kHandler; ++i)
+    {
+        auto len = snprintf(buf,
+                            sizeof(buf),
+                            "%s%s;dur=%.3f",
+                            header.empty() ? "" : ", ",
+                            stages[i],
+                            durations[i] / 1000000.0);
+        header.append(buf, len);
+    }
+    newResp->addHeader("Server-Timing", header);
+    return newResp;
+}
+
+// Prepare the response of a request to be sent, the time it takes is counted
+// in the serialize stage of the request.
+static HttpResponsePtr getResponseToSend(const HttpRequestImplPtr &req,
+                                         const HttpResponsePtr &response,
+                                         bool isHeadMethod)
+{
+    auto start = RequestTimings::now();
+    auto newResp = getCompressedResponse(req, response, isHeadMethod);
+    if (isServerTimingSampled())
+        newResp = addServerTiming(req, newResp);
+    req->timings().serialize_ += RequestTimings::now() - start;
+    return newResp;
+}
+
+// Record the spans of a sampled request when its response is sent, the stages
+// before the response are the children of the server span.
+static void recordServerSpans(const HttpRequestImplPtr &req,
+                              HttpStatusCode code,
+                              int64_t sent)
+{
+    auto &context = req->traceContext();
+    auto &timings = req->timings();
+    auto &tracer = Tracer::instance();
+    // The offset from the steady clock to the wall clock in nanoseconds.
+    auto offset = Tracer::now() * 1000 - RequestTimings::now();
+    auto record = [&](const char *name,
+                      int64_t start,
+                      int64_t end,
+                      uint64_t spanId,
+                      uint64_t parentSpanId) {
+        SpanData span;
+        span.traceIdHigh_ = context.traceIdHigh_;
+        span.traceIdLow_ = context.traceIdLow_;
+        span.spanId_ = spanId;
+        span.parentSpanId_ = parentSpanId;
+        span.name_ = name;
+        span.start_ = (start + offset) / 1000;
+        span.duration_ = (end - start) / 1000;
+        span.status_ = code;
+        if (spanId == context.spanId_)
+        {
+            span.detail_.append(req->methodString()).push_back(' ');
+            if (req->matchedPathPatternLength() > 0)
+                span.detail_.append(req->matchedPathPatternData(),
+                                    req->matchedPathPatternLength());
+            else
+                span.detail_.append(req->path());
+        }
+        tracer.record(std::move(span));
+    };
+    auto start = timings.parseStart_ ? timings.parseStart_ : timings.parsed_;
+    record("http.server", start, sent, context.spanId_, context.parentSpanId_);
+    if (timings.routed_)
+    {
+        record("routing",
+               timings.parsed_,
+               timings.routed_,
+               Tracer::newId(),
+               context.spanId_);
+    }
+    if (timings.routed_ && timings.handlerStart_)
+    {
+        record("filters",
+               timings.routed_,
+               timings.handlerStart_,
+               Tracer::newId(),
+               context.spanId_);
+    }
+    if (timings.handlerStart_ && timings.responded_)
+    {
+        record("handler",
+               timings.handlerStart_,
+               timings.responded_,
+               Tracer::newId(),
+               context.spanId_);
+    }
+}
+
+static void logAccess(const HttpRequestImplPtr &req,
+                      HttpStatusCode code,
+                      size_t bytes,
+                      int64_t sent)
+{
+    auto accessLogger = plugin::AccessLogger::current();
+    if (!accessLogger)
+        return;
+    auto &timings = req->timings();
+    auto start = timings.parseStart_ ? timings.parseStart_ : timings.parsed_;
+    accessLogger->log(req, code, bytes, sent - start);
+}
+
+// Return the number of the bytes of the chunks.
+static size_t sendStream(const TcpConnectionPtr &conn,
+                         const HttpResponseImpl &response)
+{
+    // Every part written by the producer is sent as a chunk at once.
+    trantor::MsgBuffer buffer;
+    size_t bytes = 5;
+    response.streamProducer()(
+        [&conn, &buffer, &bytes](const char *data, size_t length) {
+            if (length == 0 || !conn->connected())
+                return;
+            char header[32];
+            auto len = snprintf(header, sizeof header, "%zx\r\n", length);
+            buffer.append(header, len);
+            buffer.append(data, length);
+            buffer.append("\r\n", 2);
+            bytes += buffer.readableBytes();
+            conn->send(buffer);
+            buffer.retrieveAll();
+        });
+    conn->send("0\r\n\r\n", 5);
+    return bytes;
+}
 static bool isWebSocket(const HttpRequestImplPtr &req)
 {
     auto &headers = req->headers();
@@ -106,7 +315,20 @@ static void defaultConnectionCallback(const trantor::TcpConnectionPtr &)
 {
     return;
 }
+
+// The parsers of the connections of the current IO loop, for the snapshots of
+// the loop. The servers of all listeners share the IO loops.
+static thread_local std::unordered_set<HttpRequestParser *> loopParsers;
+
+static void closeIfDrained(const TcpConnectionPtr &conn)
+{
+    auto requestParser = conn->getContext<HttpRequestParser>();
+    if (requestParser && requestParser->isIdle())
+        conn->shutdown();
+}
 }  // namespace drogon
+
+std::atomic<bool> HttpServer::draining_{false};
 HttpServer::HttpServer(
     EventLoop *loop,
     const InetAddress &listenAddr,
@@ -131,23 +353,185 @@ HttpServer::HttpServer(
 
 HttpServer::~HttpServer()
 {
+    for (auto &channel : acceptChannels_)
+    {
+        channel->disableAll();
+        channel->remove();
+    }
+    if (idleFd_ >= 0)
+        close(idleFd_);
 }
 
 void HttpServer::start()
 {
     LOG_TRACE << "HttpServer[" << server_.name() << "] starts listenning on "
               << server_.ipPort();
-    server_.start();
+    if (listeningSockets_.empty())
+    {
+        server_.start();
+        return;
+    }
+    auto loop = server_.getLoop();
+    loop->runInLoop([this, loop]() {
+        if (idleTimeout_ > 0)
+        {
+            timingWheel_ = std::make_shared<trantor::TimingWheel>(
+                loop,
+                idleTimeout_,
+                1.0F,
+                idleTimeout_ < 500 ? idleTimeout_ + 1 : 100);
+        }
+        idleFd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        for (auto fd : listeningSockets_)
+        {
+            auto channel = std::unique_ptr<trantor::Channel>(
+                new trantor::Channel(loop, fd));
+            channel->setReadCallback([this, fd]() { onAccept(fd); });
+            channel->enableReading();
+            acceptChannels_.push_back(std::move(channel));
+        }
+    });
+}
+
+void HttpServer::stopAccepting()
+{
+    getLoop()->assertInLoopThread();
+    acceptingStopped_ = true;
+    for (auto &channel : acceptChannels_)
+    {
+        channel->disableAll();
+        channel->remove();
+    }
+    acceptChannels_.clear();
+    for (auto fd : listeningSockets_)
+    {
+        close(fd);
+    }
+    listeningSockets_.clear();
+    if (idleFd_ >= 0)
+    {
+        close(idleFd_);
+        idleFd_ = -1;
+    }
+}
+
+void HttpServer::onAccept(int listeningSocket)
+{
+    // The sockets are level triggered, accept until the queue is empty.
+    while (true)
+    {
+        struct sockaddr_in6 addr;
+        socklen_t length = sizeof(addr);
+#ifdef __linux__
+        auto fd = accept4(listeningSocket,
+                          reinterpret_cast<struct sockaddr *>(&addr),
+                          &length,
+                          SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+        auto fd = accept(listeningSocket,
+                         reinterpret_cast<struct sockaddr *>(&addr),
+                         &length);
+        if (fd >= 0)
+        {
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+#endif
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return;
+            LOG_SYSERR << "Failed to accept a connection";
+            if ((errno == EMFILE || errno == ENFILE) && idleFd_ >= 0)
+            {
+                // Free the reserved descriptor to accept the connection and
+                // close it at once, so it doesn't stay in the queue.
+                close(idleFd_);
+                idleFd_ = accept(listeningSocket, nullptr, nullptr);
+                if (idleFd_ >= 0)
+                    close(idleFd_);
+                idleFd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+            }
+            return;
+        }
+        if (addr.sin6_family == AF_INET6)
+            newConnection(fd, InetAddress(addr));
+        else
+            newConnection(
+                fd,
+                InetAddress(*reinterpret_cast<struct sockaddr_in *>(&addr)));
+    }
+}
+
+void HttpServer::newConnection(int fd, const InetAddress &peerAddr)
+{
+    struct sockaddr_in6 addr;
+    socklen_t length = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &length);
+    auto localAddr =
+        addr.sin6_family == AF_INET6
+            ? InetAddress(addr)
+            : InetAddress(*reinterpret_cast<struct sockaddr_in *>(&addr));
+    // Done the way trantor::TcpServer does it.
+    auto conn = std::make_shared<TcpConnectionImpl>(getLoop(),
+                                                    fd,
+                                                    localAddr,
+                                                    peerAddr);
+    if (timingWheel_)
+    {
+        conn->enableKickingOff(idleTimeout_, timingWheel_);
+    }
+    conn->setRecvMsgCallback(std::bind(&HttpServer::onMessage, this, _1, _2));
+    conn->setConnectionCallback(
+        std::bind(&HttpServer::onConnection, this, _1));
+    conn->setCloseCallback([this](const TcpConnectionPtr &connPtr) {
+        connections_.erase(connPtr);
+        static_cast<TcpConnectionImpl *>(connPtr.get())->connectDestroyed();
+    });
+    connections_.insert(conn);
+    conn->connectEstablished();
+}
+
+void HttpServer::startDraining()
+{
+    draining_ = true;
+}
+
+void HttpServer::closeIdleConnections()
+{
+    std::vector<HttpRequestParser *> parsers(loopParsers.begin(),
+                                             loopParsers.end());
+    for (auto parser : parsers)
+    {
+        if (parser->webSocketConn())
+        {
+            parser->webSocketConn()->shutdown();
+            continue;
+        }
+        auto conn = parser->connection();
+        if (conn && parser->isIdle())
+            conn->shutdown();
+    }
 }
 
 void HttpServer::onConnection(const TcpConnectionPtr &conn)
 {
+    EventLoopMonitor::Activity activity(EventLoopMonitor::Activity::kIo);
     if (conn->connected())
     {
         auto parser = std::make_shared<HttpRequestParser>(conn);
         parser->reset();
         conn->setContext(parser);
+        loopParsers.insert(parser.get());
         connectionCallback_(conn);
+        if (acceptingStopped_)
+        {
+            // Accepted by trantor after the server stopped accepting.
+            conn->forceClose();
+        }
     }
     else if (conn->disconnected())
     {
@@ -160,11 +544,30 @@ void HttpServer::onConnection(const TcpConnectionPtr &conn)
             {
                 requestParser->webSocketConn()->onClose();
             }
+            requestParser->cancelPendingRequests();
+            loopParsers.erase(requestParser.get());
             conn->clearContext();
         }
     }
 }
 
+void HttpServer::getLoopState(IoLoopState &state)
+{
+    state.connections_ = loopParsers.size();
+    for (auto parser : loopParsers)
+    {
+        if (parser->webSocketConn())
+        {
+            ++state.webSocketConnections_;
+            continue;
+        }
+        auto depth = parser->numberOfRequestsInPipelining();
+        state.pipelinedRequests_ += depth;
+        state.pipelinedResponses_ += parser->numberOfResponsesInPipelining();
+        state.maxPipelineDepth_ = std::max(state.maxPipelineDepth_, depth);
+    }
+}
+
 void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
 {
     if (!conn->hasContext())
@@ -172,6 +575,7 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
     auto requestParser = conn->getContext<HttpRequestParser>();
     if (!requestParser)
         return;
+    EventLoopMonitor::Activity activity(EventLoopMonitor::Activity::kIo);
     // With the pipelining feature or web socket, it is possible to receice
     // multiple messages at once, so
     // the while loop is necessary
@@ -203,6 +607,8 @@ void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
                 requestParser->requestImpl()->setLocalAddr(conn->localAddr());
                 requestParser->requestImpl()->setCreationDate(
                     trantor::Date::date());
+                requestParser->requestImpl()->timings().parsed_ =
+                    RequestTimings::now();
                 requestParser->requestImpl()->setSecure(
                     conn->isSSLConnection());
                 if (requestParser->firstReq() &&
@@ -272,8 +678,19 @@ void HttpServer::onRequests(
     }
     auto loopFlagPtr = std::make_shared<bool>(true);
 
+    auto &metrics = HttpMetrics::instance();
     for (auto &req : requests)
     {
+        metrics.onRequest(req->method());
+        EventLoopMonitor::describeActivity(req->methodString(), req->path());
+        // The calls made while the request is being handled in this loop are
+        // traced in the context of the request.
+        Tracer::instance().startTrace(req->getHeaderBy("traceparent"),
+                                      req->traceContext());
+        Tracer::ContextScope traceScope(req->traceContext());
+        CancellationToken::Scope cancellationScope(
+            req->cancellationToken().get());
+        plugin::Profiler::RouteCpuScope cpuScope(*req);
         bool close_ = (!req->keepAlive());
         bool isHeadMethod = (req->method() == Head);
         if (isHeadMethod)
@@ -294,18 +711,18 @@ void HttpServer::onRequests(
                 auto resp = advice(req);
                 if (resp)
                 {
+                    metrics.onResponse(req->timings());
+                    auto newResp = getResponseToSend(req, resp, isHeadMethod);
                     if (!syncFlag)
                     {
-                        requestParser->getResponseBuffer().emplace_back(
-                            getCompressedResponse(req, resp, isHeadMethod),
-                            isHeadMethod);
+                        requestParser->getResponseBuffer().push_back(
+                            {req, std::move(newResp), isHeadMethod});
                     }
                     else
                     {
-                        requestParser->pushResponseToPipelining(
-                            req,
-                            getCompressedResponse(req, resp, isHeadMethod),
-                            isHeadMethod);
+                        requestParser->pushResponseToPipelining(req,
+                                                                newResp,
+                                                                isHeadMethod);
                     }
 
                     adviceFlag = true;
@@ -327,11 +744,11 @@ void HttpServer::onRequests(
              requestParser](const HttpResponsePtr &response) {
                 if (!response)
                     return;
+                HttpMetrics::instance().onResponse(req->timings());
                 if (!conn->connected())
                     return;
                 response->setCloseConnection(close_);
-                auto newResp =
-                    getCompressedResponse(req, response, isHeadMethod);
+                auto newResp = getResponseToSend(req, response, isHeadMethod);
                 if (conn->getLoop()->isInLoopThread())
                 {
                     /*
@@ -348,8 +765,8 @@ void HttpServer::onRequests(
                         syncFlag = true;
                         if (requestParser->emptyPipelining())
                         {
-                            requestParser->getResponseBuffer().emplace_back(
-                                newResp, isHeadMethod);
+                            requestParser->getResponseBuffer().push_back(
+                                {req, newResp, isHeadMethod});
                         }
                         else
                         {
@@ -362,12 +779,12 @@ void HttpServer::onRequests(
                     {
                         requestParser->popFirstRequest();
 
-                        std::vector<std::pair<HttpResponsePtr, bool>> resps;
-                        resps.emplace_back(newResp, isHeadMethod);
+                        std::vector<PendingResponse> resps;
+                        resps.push_back({req, newResp, isHeadMethod});
                         while (!requestParser->emptyPipelining())
                         {
                             auto resp = requestParser->getFirstResponse();
-                            if (resp.first)
+                            if (resp.response_)
                             {
                                 requestParser->popFirstRequest();
                                 resps.push_back(std::move(resp));
@@ -393,19 +810,20 @@ void HttpServer::onRequests(
                                                   this,
                                                   isHeadMethod,
                                                   requestParser]() {
+                        EventLoopMonitor::Activity activity(
+                            EventLoopMonitor::Activity::kFunctor);
                         if (conn->connected())
                         {
                             if (requestParser->getFirstRequest() == req)
                             {
                                 requestParser->popFirstRequest();
-                                std::vector<std::pair<HttpResponsePtr, bool>>
-                                    resps;
-                                resps.emplace_back(newResp, isHeadMethod);
+                                std::vector<PendingResponse> resps;
+                                resps.push_back({req, newResp, isHeadMethod});
                                 while (!requestParser->emptyPipelining())
                                 {
                                     auto resp =
                                         requestParser->getFirstResponse();
-                                    if (resp.first)
+                                    if (resp.response_)
                                     {
                                         requestParser->popFirstRequest();
                                         resps.push_back(std::move(resp));
@@ -444,26 +862,43 @@ void HttpServer::onRequests(
 }
 
 void HttpServer::sendResponse(const TcpConnectionPtr &conn,
-                              const HttpResponsePtr &response,
-                              bool isHeadMethod)
+                              const PendingResponse &pending)
 {
     conn->getLoop()->assertInLoopThread();
+    auto &response = pending.response_;
+    auto &timings = pending.request_->timings();
     auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
-    if (!isHeadMethod)
+    auto start = RequestTimings::now();
+    size_t bytes;
+    if (!pending.isHeadMethod_)
     {
         auto httpString = respImplPtr->renderToString();
+        timings.serialize_ += RequestTimings::now() - start;
+        bytes = httpString->length();
         conn->send(httpString);
         auto &sendfileName = respImplPtr->sendfileName();
         if (!sendfileName.empty())
         {
             conn->sendFile(sendfileName.c_str());
+            bytes += respImplPtr->sendfileLength();
+        }
+        else if (respImplPtr->streamProducer())
+        {
+            bytes += sendStream(conn, *respImplPtr);
         }
     }
     else
     {
         auto httpString = respImplPtr->renderHeaderForHeadMethod();
+        timings.serialize_ += RequestTimings::now() - start;
+        bytes = httpString->length();
         conn->send(httpString);
     }
+    auto sent = RequestTimings::now();
+    HttpMetrics::instance().onSent(response->statusCode(), timings, sent);
+    if (pending.request_->traceContext().sampled_)
+        recordServerSpans(pending.request_, response->statusCode(), sent);
+    logAccess(pending.request_, response->statusCode(), bytes, sent);
 
     if (response->ifCloseConnection())
     {
@@ -471,39 +906,63 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
     }
 }
 
-void HttpServer::sendResponses(
-    const TcpConnectionPtr &conn,
-    const std::vector<std::pair<HttpResponsePtr, bool>> &responses,
-    trantor::MsgBuffer &buffer)
+void HttpServer::sendResponses(const TcpConnectionPtr &conn,
+                               const std::vector<PendingResponse> &responses,
+                               trantor::MsgBuffer &buffer)
 {
     conn->getLoop()->assertInLoopThread();
     if (responses.empty())
         return;
     if (responses.size() == 1)
     {
-        sendResponse(conn, responses[0].first, responses[0].second);
+        sendResponse(conn, responses[0]);
+        if (draining_)
+            closeIfDrained(conn);
         return;
     }
+    auto &metrics = HttpMetrics::instance();
     for (auto const &resp : responses)
     {
-        auto respImplPtr = static_cast<HttpResponseImpl *>(resp.first.get());
-        if (!resp.second)
+        auto &timings = resp.request_->timings();
+        auto respImplPtr =
+            static_cast<HttpResponseImpl *>(resp.response_.get());
+        auto start = RequestTimings::now();
+        auto bytes = buffer.readableBytes();
+        if (!resp.isHeadMethod_)
         {
             // Not HEAD method
             respImplPtr->renderToBuffer(buffer);
+            timings.serialize_ += RequestTimings::now() - start;
+            bytes = buffer.readableBytes() - bytes;
             auto &sendfileName = respImplPtr->sendfileName();
             if (!sendfileName.empty())
             {
                 conn->send(buffer);
                 buffer.retrieveAll();
                 conn->sendFile(sendfileName.c_str());
+                bytes += respImplPtr->sendfileLength();
+            }
+            else if (respImplPtr->streamProducer())
+            {
+                conn->send(buffer);
+                buffer.retrieveAll();
+                bytes += sendStream(conn, *respImplPtr);
             }
         }
         else
         {
             auto httpString = respImplPtr->renderHeaderForHeadMethod();
+            timings.serialize_ += RequestTimings::now() - start;
+            bytes = httpString->length();
             buffer.append(httpString->data(), httpString->length());
         }
+        // The responses in the buffer are sent together, a response is
+        // considered written when it's in the buffer.
+        auto sent = RequestTimings::now();
+        metrics.onSent(respImplPtr->statusCode(), timings, sent);
+        if (resp.request_->traceContext().sampled_)
+            recordServerSpans(resp.request_, respImplPtr->statusCode(), sent);
+        logAccess(resp.request_, respImplPtr->statusCode(), bytes, sent);
         if (respImplPtr->ifCloseConnection())
         {
             if (buffer.readableBytes() > 0)
@@ -520,4 +979,6 @@ void HttpServer::sendResponses(
         conn->send(buffer);
     }
     buffer.retrieveAll();
+    if (draining_)
+        closeIfDrained(conn);
 }
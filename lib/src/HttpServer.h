@@ -15,11 +15,17 @@
 #pragma once
 
 #include "impl_forwards.h"
+#include <drogon/utils/ServerState.h>
 #include <trantor/net/TcpServer.h>
 #include <trantor/net/callbacks.h>
+#include <trantor/net/inner/Channel.h>
 #include <trantor/utils/NonCopyable.h>
+#include <trantor/utils/TimingWheel.h>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace drogon
@@ -65,6 +71,7 @@ class HttpServer : trantor::NonCopyable
     void kickoffIdleConnections(size_t timeout)
     {
         server_.kickoffIdleConnections(timeout);
+        idleTimeout_ = timeout;
     }
     trantor::EventLoop *getLoop()
     {
@@ -81,25 +88,60 @@ class HttpServer : trantor::NonCopyable
         server_.enableSSL(certPath, keyPath);
     }
 
+    /// Fill the connection numbers of the state of the current IO loop, it
+    /// must be called in the loop.
+    static void getLoopState(IoLoopState &state);
+
+    /// Accept on the listening sockets instead of the one of trantor, it must
+    /// be called before start(). The sockets are closed when the server stops
+    /// accepting.
+    void setListeningSockets(std::vector<int> &&sockets)
+    {
+        listeningSockets_ = std::move(sockets);
+    }
+    /// Stop accepting new connections, it must be called in the loop of the
+    /// server. Without the listening sockets set, the connections accepted by
+    /// trantor later are closed at once.
+    void stopAccepting();
+
+    /// Drain the connections of all servers, the connections are closed
+    /// after their responses are sent.
+    static void startDraining();
+    /// Close the idle connections and the websocket connections of the
+    /// current IO loop, it must be called in the loop.
+    static void closeIdleConnections();
+
   private:
+    void onAccept(int listeningSocket);
+    void newConnection(int fd, const trantor::InetAddress &peerAddr);
     void onConnection(const trantor::TcpConnectionPtr &conn);
     void onMessage(const trantor::TcpConnectionPtr &, trantor::MsgBuffer *);
     void onRequests(const trantor::TcpConnectionPtr &,
                     const std::vector<HttpRequestImplPtr> &,
                     const std::shared_ptr<HttpRequestParser> &);
     void sendResponse(const trantor::TcpConnectionPtr &,
-                      const HttpResponsePtr &,
-                      bool isHeadMethod);
-    void sendResponses(
-        const trantor::TcpConnectionPtr &conn,
-        const std::vector<std::pair<HttpResponsePtr, bool>> &responses,
-        trantor::MsgBuffer &buffer);
+                      const PendingResponse &);
+    void sendResponses(const trantor::TcpConnectionPtr &conn,
+                       const std::vector<PendingResponse> &responses,
+                       trantor::MsgBuffer &buffer);
     trantor::TcpServer server_;
     HttpAsyncCallback httpAsyncCallback_;
     WebSocketNewAsyncCallback newWebsocketCallback_;
     trantor::ConnectionCallback connectionCallback_;
     const std::vector<std::function<HttpResponsePtr(const HttpRequestPtr &)>>
         &syncAdvices_;
+    size_t idleTimeout_{0};
+    std::atomic<bool> acceptingStopped_{false};
+    std::vector<int> listeningSockets_;
+    std::vector<std::unique_ptr<trantor::Channel>> acceptChannels_;
+    // Reserved for accepting and closing a connection when the process runs
+    // out of file descriptors, as trantor::Acceptor does, otherwise the level
+    // triggered listening sockets keep the loop busy.
+    int idleFd_{-1};
+    // The connections accepted on the listening sockets.
+    std::unordered_set<trantor::TcpConnectionPtr> connections_;
+    std::shared_ptr<trantor::TimingWheel> timingWheel_;
+    static std::atomic<bool> draining_;
 };
 
 }  // namespace drogon
@@ -19,6 +19,7 @@
 #include "HttpControllersRouter.h"
 #include "FiltersFunction.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpMetrics.h"
 #include <drogon/HttpSimpleController.h>
 #include <drogon/utils/HttpConstraint.h>
 
@@ -57,7 +58,7 @@ void HttpSimpleControllersRouter::registerHttpSimpleController(
     binder->controllerName_ = ctrlName;
     binder->filterNames_ = filters;
     drogon::app().getLoop()->queueInLoop([binder, ctrlName]() {
-        auto &object_ = DrClassMap::getSingleInstance(ctrlName);
+        auto object_ = DrClassMap::getSingleInstance(ctrlName);
         auto controller =
             std::dynamic_pointer_cast<HttpSimpleControllerBase>(object_);
         binder->controller_ = controller;
@@ -100,6 +101,9 @@ void HttpSimpleControllersRouter::route(
     if (iter != simpleCtrlMap_.end())
     {
         auto &ctrlInfo = iter->second;
+        HttpMetrics::instance().onRouted(HttpMetrics::kSimpleController,
+                                         req->timings(),
+                                         ctrlInfo.stageMetrics_.get());
         req->setMatchedPathPattern(iter->first);
         auto &binder = ctrlInfo.binders_[req->method()];
         if (!binder)
@@ -195,6 +199,14 @@ void HttpSimpleControllersRouter::doControllerHandler(
     const HttpRequestImplPtr &req,
     std::function<void(const HttpResponsePtr &)> &&callback)
 {
+    if (req->isCancelled())
+    {
+        invokeCallback(callback,
+                       req,
+                       HttpAppFrameworkImpl::newCancelledResponse());
+        return;
+    }
+    req->timings().handlerStart_ = RequestTimings::now();
     auto &controller = ctrlBinderPtr->controller_;
     if (controller)
     {
@@ -282,6 +294,7 @@ void HttpSimpleControllersRouter::init(
     for (auto &iter : simpleCtrlMap_)
     {
         auto &item = iter.second;
+        item.stageMetrics_ = std::make_shared<RouteStageMetrics>(iter.first);
         for (size_t i = 0; i < Invalid; ++i)
         {
             auto &binder = item.binders_[i];
@@ -104,6 +104,7 @@ class HttpSimpleControllersRouter : public trantor::NonCopyable
     struct SimpleControllerRouterItem
     {
         CtrlBinderPtr binders_[Invalid];
+        std::shared_ptr<RouteStageMetrics> stageMetrics_;
     };
     std::unordered_map<std::string, SimpleControllerRouterItem> simpleCtrlMap_;
     std::mutex simpleCtrlMutex_;
@@ -15,6 +15,9 @@
 #include "HttpUtils.h"
 #include <drogon/utils/Utilities.h>
 #include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
 
 namespace drogon
 {
@@ -141,6 +144,16 @@ const string_view &webContentTypeToString(ContentType contenttype)
             static string_view sv = "Content-Type: application/wasm\r\n";
             return sv;
         }
+        case CT_APPLICATION_MSGPACK:
+        {
+            static string_view sv = "Content-Type: application/msgpack\r\n";
+            return sv;
+        }
+        case CT_APPLICATION_CBOR:
+        {
+            static string_view sv = "Content-Type: application/cbor\r\n";
+            return sv;
+        }
         default:
         case CT_TEXT_PLAIN:
         {
@@ -488,4 +501,83 @@ ContentType getContentType(const std::string &fileName)
     }
 }
 
+static string_view trimMediaType(string_view mediaType)
+{
+    auto pos = mediaType.find(';');
+    if (pos != string_view::npos)
+        mediaType = mediaType.substr(0, pos);
+    while (!mediaType.empty() && isspace(mediaType.front()))
+        mediaType.remove_prefix(1);
+    while (!mediaType.empty() && isspace(mediaType.back()))
+        mediaType.remove_suffix(1);
+    return mediaType;
+}
+
+static bool equalsIgnoreCase(const string_view &str, const char *lowered)
+{
+    auto len = strlen(lowered);
+    if (str.length() != len)
+        return false;
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (tolower(str[i]) != lowered[i])
+            return false;
+    }
+    return true;
+}
+
+ContentType getBinaryJsonType(const string_view &contentType)
+{
+    auto mediaType = trimMediaType(contentType);
+    if (equalsIgnoreCase(mediaType, "application/msgpack") ||
+        equalsIgnoreCase(mediaType, "application/x-msgpack") ||
+        equalsIgnoreCase(mediaType, "application/vnd.msgpack"))
+        return CT_APPLICATION_MSGPACK;
+    if (equalsIgnoreCase(mediaType, "application/cbor"))
+        return CT_APPLICATION_CBOR;
+    return CT_NONE;
+}
+
+ContentType negotiateJsonType(const std::string &accept)
+{
+    // Most clients don't know the binary formats.
+    if (accept.find("msgpack") == std::string::npos &&
+        accept.find("cbor") == std::string::npos &&
+        accept.find("MSGPACK") == std::string::npos &&
+        accept.find("CBOR") == std::string::npos)
+        return CT_APPLICATION_JSON;
+    ContentType binaryType = CT_NONE;
+    double binaryQuality = 0;
+    double jsonQuality = 0;
+    string_view ranges(accept);
+    while (!ranges.empty())
+    {
+        auto pos = ranges.find(',');
+        auto range = ranges.substr(0, pos);
+        ranges = pos == string_view::npos ? string_view()
+                                          : ranges.substr(pos + 1);
+        double quality = 1;
+        auto qPos = range.find("q=");
+        if (qPos != string_view::npos && range.find(';') < qPos)
+            quality = atof(std::string(range.substr(qPos + 2)).c_str());
+        auto type = getBinaryJsonType(range);
+        if (type != CT_NONE)
+        {
+            if (quality > binaryQuality)
+            {
+                binaryType = type;
+                binaryQuality = quality;
+            }
+        }
+        else if (equalsIgnoreCase(trimMediaType(range), "application/json"))
+        {
+            jsonQuality = std::max(jsonQuality, quality);
+        }
+    }
+    if (binaryType != CT_NONE && binaryQuality > 0 &&
+        binaryQuality >= jsonQuality)
+        return binaryType;
+    return CT_APPLICATION_JSON;
+}
+
 }  // namespace drogon
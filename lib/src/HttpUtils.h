@@ -25,4 +25,18 @@ const string_view &webContentTypeToString(ContentType contenttype);
 const string_view &statusCodeToString(int code);
 ContentType getContentType(const std::string &fileName);
 
+/// Get the binary format (CT_APPLICATION_MSGPACK or CT_APPLICATION_CBOR) of
+/// a content type header, CT_NONE is returned for other types.
+ContentType getBinaryJsonType(const string_view &contentType);
+inline ContentType getBinaryJsonType(ContentType type)
+{
+    return (type == CT_APPLICATION_MSGPACK || type == CT_APPLICATION_CBOR)
+               ? type
+               : CT_NONE;
+}
+
+/// Choose the format of a json body by an accept header, CT_APPLICATION_JSON
+/// is returned unless the client prefers a binary format.
+ContentType negotiateJsonType(const std::string &accept);
+
 }  // namespace drogon
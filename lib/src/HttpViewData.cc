@@ -13,35 +13,107 @@
  */
 
 #include <drogon/HttpViewData.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace drogon;
 
-std::string HttpViewData::htmlTranslate(const char *str, size_t length)
+const char *HttpViewData::findSpecialChar(const char *str, const char *end)
+{
+#ifdef __SSE2__
+    // Compare 16 bytes with the special characters at a time.
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i apos = _mm_set1_epi8('\'');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    while (end - str >= 16)
+    {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(str));
+        auto matches =
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quot),
+                                      _mm_cmpeq_epi8(chunk, amp)),
+                         _mm_or_si128(_mm_cmpeq_epi8(chunk, apos),
+                                      _mm_or_si128(_mm_cmpeq_epi8(chunk, lt),
+                                                   _mm_cmpeq_epi8(chunk, gt))));
+        auto mask = _mm_movemask_epi8(matches);
+        if (mask != 0)
+            return str + __builtin_ctz(mask);
+        str += 16;
+    }
+#endif
+    for (; str < end; ++str)
+    {
+        switch (*str)
+        {
+            case '"':
+            case '&':
+            case '\'':
+            case '<':
+            case '>':
+                return str;
+            default:
+                break;
+        }
+    }
+    return end;
+}
+
+void HttpViewData::htmlTranslate(const char *str,
+                                 size_t length,
+                                 std::string &output)
 {
-    std::string ret;
-    ret.reserve(length + 64);
     auto end = str + length;
     while (str != end)
     {
-        switch (*str)
+        // Append the span without special characters at once.
+        auto special = findSpecialChar(str, end);
+        output.append(str, special - str);
+        if (special == end)
+            break;
+        switch (*special)
         {
             case '"':
-                ret.append("&quot;", 6);
+                output.append("&quot;", 6);
                 break;
             case '&':
-                ret.append("&amp;", 5);
+                output.append("&amp;", 5);
+                break;
+            case '\'':
+                output.append("&#39;", 5);
                 break;
             case '<':
-                ret.append("&lt;", 4);
+                output.append("&lt;", 4);
                 break;
             case '>':
-                ret.append("&gt;", 4);
+                output.append("&gt;", 4);
                 break;
             default:
-                ret.push_back(*str);
                 break;
         }
-        ++str;
+        str = special + 1;
     }
+}
+
+std::string HttpViewData::htmlTranslate(const char *str, size_t length)
+{
+    std::string ret;
+    ret.reserve(length + 64);
+    htmlTranslate(str, length, ret);
     return ret;
-}
\ No newline at end of file
+}
+
+string_view HttpViewData::htmlTranslate(const string_view &str,
+                                        std::string &buffer)
+{
+    auto end = str.data() + str.length();
+    auto special = findSpecialChar(str.data(), end);
+    if (special == end)
+        return str;
+    buffer.clear();
+    buffer.reserve(str.length() + 64);
+    buffer.append(str.data(), special - str.data());
+    htmlTranslate(special, end - special, buffer);
+    return string_view(buffer.data(), buffer.length());
+}
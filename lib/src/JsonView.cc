@@ -0,0 +1,731 @@
+/**
+ *
+ *  JsonView.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/JsonView.h>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string.h>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
+
+namespace drogon
+{
+namespace internal
+{
+/// The index of a json text, every value (including the keys of objects) has
+/// a token in the order of the text.
+struct JsonIndex
+{
+    struct Token
+    {
+        // The position of the first character of the value.
+        uint32_t begin_;
+        // The position after the last character of the value.
+        uint32_t end_;
+        // The index of the token after the value, i.e. after all the tokens
+        // of the members or the elements of an object or an array.
+        uint32_t next_;
+    };
+    string_view text_;
+    std::vector<Token> tokens_;
+};
+}  // namespace internal
+}  // namespace drogon
+
+using namespace drogon;
+using internal::JsonIndex;
+
+namespace
+{
+const size_t maxDepth = 1000;
+
+inline bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Find the first '"', '\\' or control character in [p, end).
+const char *findStringSpecial(const char *p, const char *end)
+{
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    while (end - p >= 16)
+    {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        auto matches = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                         _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+        auto mask = _mm_movemask_epi8(matches);
+        if (mask != 0)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p)
+    {
+        auto c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\' || c < 0x20)
+            return p;
+    }
+    return end;
+}
+
+// Return the position after the closing quote, or nullptr if the string is
+// invalid.
+const char *scanString(const char *p, const char *end)
+{
+    ++p;
+    while (true)
+    {
+        p = findStringSpecial(p, end);
+        if (p == end || static_cast<unsigned char>(*p) < 0x20)
+            return nullptr;
+        if (*p == '"')
+            return p + 1;
+        // An escape sequence
+        if (end - p < 2)
+            return nullptr;
+        switch (p[1])
+        {
+            case '"':
+            case '\\':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                p += 2;
+                break;
+            case 'u':
+                if (end - p < 6)
+                    return nullptr;
+                for (int i = 2; i < 6; ++i)
+                {
+                    if (hexValue(p[i]) < 0)
+                        return nullptr;
+                }
+                p += 6;
+                break;
+            default:
+                return nullptr;
+        }
+    }
+}
+
+const char *scanNumber(const char *p, const char *end)
+{
+    if (p < end && *p == '-')
+        ++p;
+    if (p == end)
+        return nullptr;
+    if (*p == '0')
+    {
+        ++p;
+    }
+    else if (isDigit(*p))
+    {
+        while (p < end && isDigit(*p))
+            ++p;
+    }
+    else
+    {
+        return nullptr;
+    }
+    if (p < end && *p == '.')
+    {
+        ++p;
+        if (p == end || !isDigit(*p))
+            return nullptr;
+        while (p < end && isDigit(*p))
+            ++p;
+    }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        if (p < end && (*p == '+' || *p == '-'))
+            ++p;
+        if (p == end || !isDigit(*p))
+            return nullptr;
+        while (p < end && isDigit(*p))
+            ++p;
+    }
+    return p;
+}
+
+const char *scanLiteral(const char *p, const char *end, const char *literal)
+{
+    auto len = strlen(literal);
+    if (static_cast<size_t>(end - p) < len || memcmp(p, literal, len) != 0)
+        return nullptr;
+    return p + len;
+}
+
+// Return the position after a scalar value, or nullptr if it's invalid.
+const char *scanScalar(const char *p, const char *end)
+{
+    switch (*p)
+    {
+        case '"':
+            return scanString(p, end);
+        case 't':
+            return scanLiteral(p, end, "true");
+        case 'f':
+            return scanLiteral(p, end, "false");
+        case 'n':
+            return scanLiteral(p, end, "null");
+        default:
+            return scanNumber(p, end);
+    }
+}
+
+void appendUtf8(std::string &output, unsigned int codepoint)
+{
+    if (codepoint < 0x80)
+    {
+        output.push_back(static_cast<char>(codepoint));
+    }
+    else if (codepoint < 0x800)
+    {
+        output.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+        output.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+    else if (codepoint < 0x10000)
+    {
+        output.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+        output.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        output.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+    else
+    {
+        output.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+        output.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+        output.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        output.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+unsigned int decodeHex4(const char *p)
+{
+    return (hexValue(p[0]) << 12) | (hexValue(p[1]) << 8) |
+           (hexValue(p[2]) << 4) | hexValue(p[3]);
+}
+
+// Unescape the content of a validated string (without the quotes).
+std::string unescape(const char *p, const char *end)
+{
+    std::string result;
+    result.reserve(end - p);
+    while (p < end)
+    {
+        auto escape = static_cast<const char *>(memchr(p, '\\', end - p));
+        if (!escape)
+        {
+            result.append(p, end - p);
+            break;
+        }
+        result.append(p, escape - p);
+        p = escape + 1;
+        switch (*p)
+        {
+            case 'b':
+                result.push_back('\b');
+                break;
+            case 'f':
+                result.push_back('\f');
+                break;
+            case 'n':
+                result.push_back('\n');
+                break;
+            case 'r':
+                result.push_back('\r');
+                break;
+            case 't':
+                result.push_back('\t');
+                break;
+            case 'u':
+            {
+                auto codepoint = decodeHex4(p + 1);
+                p += 4;
+                // A surrogate pair
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF &&
+                    end - p >= 7 && p[1] == '\\' && p[2] == 'u')
+                {
+                    auto low = decodeHex4(p + 3);
+                    if (low >= 0xDC00 && low <= 0xDFFF)
+                    {
+                        codepoint = 0x10000 + ((codepoint & 0x3FF) << 10) +
+                                    (low & 0x3FF);
+                        p += 6;
+                    }
+                }
+                appendUtf8(result, codepoint);
+                break;
+            }
+            default:
+                // '"', '\\' and '/'
+                result.push_back(*p);
+                break;
+        }
+        ++p;
+    }
+    return result;
+}
+
+bool buildIndex(JsonIndex &index, std::string *errorMessage)
+{
+    auto setError = [errorMessage](const char *message, size_t pos) {
+        if (errorMessage)
+            *errorMessage =
+                std::string(message) + " at position " + std::to_string(pos);
+        return false;
+    };
+    auto &text = index.text_;
+    if (text.length() >= std::numeric_limits<uint32_t>::max())
+        return setError("Too large json text", 0);
+    const char *begin = text.data();
+    const char *end = begin + text.length();
+    const char *p = begin;
+    auto &tokens = index.tokens_;
+    tokens.reserve(text.length() / 8 + 4);
+
+    enum Expect
+    {
+        kValue,
+        kValueOrEnd,
+        kKey,
+        kKeyOrEnd,
+        kColon,
+        kCommaOrEnd,
+        kDone
+    };
+    struct Frame
+    {
+        uint32_t token_;
+        bool isObject_;
+    };
+    std::vector<Frame> stack;
+    Expect expect = kValue;
+    while (true)
+    {
+        while (p < end && isWhitespace(*p))
+            ++p;
+        if (p == end)
+            break;
+        auto pos = static_cast<uint32_t>(p - begin);
+        auto closeContainer = [&]() {
+            auto &token = tokens[stack.back().token_];
+            token.end_ = pos + 1;
+            token.next_ = static_cast<uint32_t>(tokens.size());
+            stack.pop_back();
+            ++p;
+            expect = stack.empty() ? kDone : kCommaOrEnd;
+        };
+        switch (expect)
+        {
+            case kValueOrEnd:
+                if (*p == ']')
+                {
+                    closeContainer();
+                    continue;
+                }
+                // Fall through
+            case kValue:
+                if (*p == '{' || *p == '[')
+                {
+                    if (stack.size() >= maxDepth)
+                        return setError("Too deep nesting", pos);
+                    stack.push_back(
+                        {static_cast<uint32_t>(tokens.size()), *p == '{'});
+                    tokens.push_back({pos, 0, 0});
+                    expect = *p == '{' ? kKeyOrEnd : kValueOrEnd;
+                    ++p;
+                }
+                else
+                {
+                    auto valueEnd = scanScalar(p, end);
+                    if (!valueEnd)
+                        return setError("Invalid value", pos);
+                    tokens.push_back(
+                        {pos,
+                         static_cast<uint32_t>(valueEnd - begin),
+                         static_cast<uint32_t>(tokens.size() + 1)});
+                    p = valueEnd;
+                    expect = stack.empty() ? kDone : kCommaOrEnd;
+                }
+                break;
+            case kKeyOrEnd:
+                if (*p == '}')
+                {
+                    closeContainer();
+                    continue;
+                }
+                // Fall through
+            case kKey:
+            {
+                if (*p != '"')
+                    return setError("Missing '\"'", pos);
+                auto keyEnd = scanString(p, end);
+                if (!keyEnd)
+                    return setError("Invalid string", pos);
+                tokens.push_back({pos,
+                                  static_cast<uint32_t>(keyEnd - begin),
+                                  static_cast<uint32_t>(tokens.size() + 1)});
+                p = keyEnd;
+                expect = kColon;
+                break;
+            }
+            case kColon:
+                if (*p != ':')
+                    return setError("Missing ':'", pos);
+                ++p;
+                expect = kValue;
+                break;
+            case kCommaOrEnd:
+                if (*p == ',')
+                {
+                    ++p;
+                    expect = stack.back().isObject_ ? kKey : kValue;
+                }
+                else if (*p == (stack.back().isObject_ ? '}' : ']'))
+                {
+                    closeContainer();
+                }
+                else
+                {
+                    return setError("Missing ',' or the end of a container",
+                                    pos);
+                }
+                break;
+            case kDone:
+                return setError("Extra characters", pos);
+        }
+    }
+    if (expect != kDone)
+        return setError("Unexpected end", text.length());
+    return true;
+}
+
+bool isInteger(const string_view &raw)
+{
+    for (auto c : raw)
+    {
+        if (c == '.' || c == 'e' || c == 'E')
+            return false;
+    }
+    return true;
+}
+
+// Parse the digits of an integer, false is returned on overflow.
+bool parseUInt(const char *p, const char *end, uint64_t &value)
+{
+    value = 0;
+    for (; p < end; ++p)
+    {
+        auto digit = static_cast<uint64_t>(*p - '0');
+        if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+            return false;
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+double parseDouble(const string_view &raw)
+{
+    double value = 0;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    std::from_chars(raw.data(), raw.data() + raw.length(), value);
+#else
+    std::istringstream stream(std::string(raw.data(), raw.length()));
+    stream.imbue(std::locale::classic());
+    stream >> value;
+#endif
+    return value;
+}
+}  // namespace
+
+JsonView JsonView::parse(const string_view &text, std::string *errorMessage)
+{
+    auto index = std::make_shared<JsonIndex>();
+    index->text_ = text;
+    if (!buildIndex(*index, errorMessage))
+        return JsonView();
+    return JsonView(std::move(index), 0);
+}
+
+JsonView::Type JsonView::type() const
+{
+    if (!index_)
+        return kInvalid;
+    switch (index_->text_[index_->tokens_[token_].begin_])
+    {
+        case '{':
+            return kObject;
+        case '[':
+            return kArray;
+        case '"':
+            return kString;
+        case 't':
+        case 'f':
+            return kBool;
+        case 'n':
+            return kNull;
+        default:
+            return kNumber;
+    }
+}
+
+string_view JsonView::raw() const
+{
+    if (!index_)
+        return string_view();
+    auto &token = index_->tokens_[token_];
+    return index_->text_.substr(token.begin_, token.end_ - token.begin_);
+}
+
+size_t JsonView::size() const
+{
+    auto type = this->type();
+    if (type != kArray && type != kObject)
+        return 0;
+    auto &tokens = index_->tokens_;
+    size_t size = 0;
+    for (auto i = token_ + 1; i < tokens[token_].next_; ++size)
+    {
+        if (type == kObject)
+            ++i;
+        i = tokens[i].next_;
+    }
+    return size;
+}
+
+JsonView JsonView::operator[](const string_view &key) const
+{
+    if (type() != kObject)
+        return JsonView();
+    auto &tokens = index_->tokens_;
+    auto &text = index_->text_;
+    for (auto i = token_ + 1; i < tokens[token_].next_;)
+    {
+        auto &keyToken = tokens[i];
+        auto rawKey =
+            text.substr(keyToken.begin_ + 1, keyToken.end_ - keyToken.begin_ - 2);
+        if (rawKey.find('\\') == string_view::npos)
+        {
+            if (rawKey == key)
+                return JsonView(index_, i + 1);
+        }
+        else
+        {
+            auto unescaped =
+                unescape(rawKey.data(), rawKey.data() + rawKey.length());
+            if (string_view(unescaped.data(), unescaped.length()) == key)
+                return JsonView(index_, i + 1);
+        }
+        i = tokens[i + 1].next_;
+    }
+    return JsonView();
+}
+
+JsonView JsonView::operator[](size_t index) const
+{
+    if (type() != kArray)
+        return JsonView();
+    auto &tokens = index_->tokens_;
+    for (auto i = token_ + 1; i < tokens[token_].next_; i = tokens[i].next_)
+    {
+        if (index-- == 0)
+            return JsonView(index_, i);
+    }
+    return JsonView();
+}
+
+bool JsonView::asBool() const
+{
+    switch (type())
+    {
+        case kBool:
+            return raw()[0] == 't';
+        case kNumber:
+            return asDouble() != 0.0;
+        default:
+            return false;
+    }
+}
+
+int64_t JsonView::asInt64() const
+{
+    if (type() != kNumber)
+        return 0;
+    auto raw = this->raw();
+    if (isInteger(raw))
+    {
+        bool negative = raw[0] == '-';
+        uint64_t value;
+        if (parseUInt(raw.data() + (negative ? 1 : 0),
+                      raw.data() + raw.length(),
+                      value))
+        {
+            if (negative && value <= static_cast<uint64_t>(
+                                         std::numeric_limits<int64_t>::max()) +
+                                         1)
+                return static_cast<int64_t>(0 - value);
+            if (!negative &&
+                value <= static_cast<uint64_t>(
+                             std::numeric_limits<int64_t>::max()))
+                return static_cast<int64_t>(value);
+        }
+    }
+    return static_cast<int64_t>(asDouble());
+}
+
+uint64_t JsonView::asUInt64() const
+{
+    if (type() != kNumber)
+        return 0;
+    auto raw = this->raw();
+    if (isInteger(raw) && raw[0] != '-')
+    {
+        uint64_t value;
+        if (parseUInt(raw.data(), raw.data() + raw.length(), value))
+            return value;
+    }
+    auto value = asDouble();
+    return value > 0 ? static_cast<uint64_t>(value) : 0;
+}
+
+double JsonView::asDouble() const
+{
+    if (type() != kNumber)
+        return 0.0;
+    return parseDouble(raw());
+}
+
+std::string JsonView::asString() const
+{
+    if (type() != kString)
+        return std::string();
+    auto raw = this->raw();
+    return unescape(raw.data() + 1, raw.data() + raw.length() - 1);
+}
+
+Json::Value JsonView::toJsonValue() const
+{
+    switch (type())
+    {
+        case kInvalid:
+        case kNull:
+            return Json::Value();
+        case kBool:
+            return Json::Value(asBool());
+        case kString:
+            return Json::Value(asString());
+        case kNumber:
+        {
+            // The same types as the ones chosen by the jsoncpp reader.
+            auto raw = this->raw();
+            if (isInteger(raw))
+            {
+                bool negative = raw[0] == '-';
+                uint64_t value;
+                if (parseUInt(raw.data() + (negative ? 1 : 0),
+                              raw.data() + raw.length(),
+                              value))
+                {
+                    auto maxInt = static_cast<uint64_t>(
+                        std::numeric_limits<Json::Int64>::max());
+                    if (negative && value <= maxInt + 1)
+                        return Json::Value(
+                            static_cast<Json::Int64>(0 - value));
+                    if (!negative && value <= maxInt)
+                        return Json::Value(static_cast<Json::Int64>(value));
+                    if (!negative)
+                        return Json::Value(static_cast<Json::UInt64>(value));
+                }
+            }
+            return Json::Value(parseDouble(raw));
+        }
+        case kArray:
+        {
+            Json::Value array(Json::arrayValue);
+            forEachElement(
+                [&array](const JsonView &value) {
+                    array.append(value.toJsonValue());
+                });
+            return array;
+        }
+        case kObject:
+        {
+            Json::Value object(Json::objectValue);
+            forEachMember([&object](const std::string &key,
+                                    const JsonView &value) {
+                object[key] = value.toJsonValue();
+            });
+            return object;
+        }
+    }
+    return Json::Value();
+}
+
+void JsonView::forEachMember(
+    const std::function<void(const std::string &key, const JsonView &value)>
+        &callback) const
+{
+    if (type() != kObject)
+        return;
+    auto &tokens = index_->tokens_;
+    for (auto i = token_ + 1; i < tokens[token_].next_;)
+    {
+        JsonView key(index_, i);
+        callback(key.asString(), JsonView(index_, i + 1));
+        i = tokens[i + 1].next_;
+    }
+}
+
+void JsonView::forEachElement(
+    const std::function<void(const JsonView &value)> &callback) const
+{
+    if (type() != kArray)
+        return;
+    auto &tokens = index_->tokens_;
+    for (auto i = token_ + 1; i < tokens[token_].next_; i = tokens[i].next_)
+    {
+        callback(JsonView(index_, i));
+    }
+}
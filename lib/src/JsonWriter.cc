@@ -0,0 +1,343 @@
+/**
+ *
+ *  JsonWriter.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "JsonWriter.h"
+#include <drogon/utils/JsonBinding.h>
+#include <cmath>
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
+#include <stdio.h>
+#include <string.h>
+
+namespace drogon
+{
+// 1 for the characters which are escaped by jsoncpp: control characters,
+// '"', '\\' and the non-ASCII characters (which are escaped to \uXXXX).
+static const char needEscaping[256] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+
+static void appendHex(std::string &output, unsigned int ch)
+{
+    static const char hex[] = "0123456789abcdef";
+    char buf[6] = {'\\',
+                   'u',
+                   hex[(ch >> 12) & 0xf],
+                   hex[(ch >> 8) & 0xf],
+                   hex[(ch >> 4) & 0xf],
+                   hex[ch & 0xf]};
+    output.append(buf, 6);
+}
+
+// The same as the decoding of jsoncpp, invalid sequences are replaced by
+// U+FFFD.
+static unsigned int utf8ToCodepoint(const char *&s, const char *e)
+{
+    const unsigned int replacement = 0xFFFD;
+    unsigned int firstByte = static_cast<unsigned char>(*s);
+    if (firstByte < 0x80)
+        return firstByte;
+    if (firstByte < 0xE0)
+    {
+        if (e - s < 2)
+            return replacement;
+        unsigned int calculated =
+            ((firstByte & 0x1F) << 6) | (static_cast<unsigned int>(s[1]) & 0x3F);
+        s += 1;
+        return calculated < 0x80 ? replacement : calculated;
+    }
+    if (firstByte < 0xF0)
+    {
+        if (e - s < 3)
+            return replacement;
+        unsigned int calculated = ((firstByte & 0x0F) << 12) |
+                                  ((static_cast<unsigned int>(s[1]) & 0x3F)
+                                   << 6) |
+                                  (static_cast<unsigned int>(s[2]) & 0x3F);
+        s += 2;
+        if (calculated >= 0xD800 && calculated <= 0xDFFF)
+            return replacement;
+        return calculated < 0x800 ? replacement : calculated;
+    }
+    if (firstByte < 0xF8)
+    {
+        if (e - s < 4)
+            return replacement;
+        unsigned int calculated = ((firstByte & 0x07) << 18) |
+                                  ((static_cast<unsigned int>(s[1]) & 0x3F)
+                                   << 12) |
+                                  ((static_cast<unsigned int>(s[2]) & 0x3F)
+                                   << 6) |
+                                  (static_cast<unsigned int>(s[3]) & 0x3F);
+        s += 3;
+        return calculated < 0x10000 ? replacement : calculated;
+    }
+    return replacement;
+}
+
+static void writeString(const char *str, const char *end, std::string &output)
+{
+    output.push_back('"');
+    while (str < end)
+    {
+        auto span = str;
+        while (span < end && !needEscaping[static_cast<unsigned char>(*span)])
+            ++span;
+        output.append(str, span - str);
+        if (span == end)
+            break;
+        str = span;
+        switch (*str)
+        {
+            case '"':
+                output.append("\\\"", 2);
+                break;
+            case '\\':
+                output.append("\\\\", 2);
+                break;
+            case '\b':
+                output.append("\\b", 2);
+                break;
+            case '\f':
+                output.append("\\f", 2);
+                break;
+            case '\n':
+                output.append("\\n", 2);
+                break;
+            case '\r':
+                output.append("\\r", 2);
+                break;
+            case '\t':
+                output.append("\\t", 2);
+                break;
+            default:
+            {
+                auto codepoint = utf8ToCodepoint(str, end);
+                if (codepoint < 0x10000)
+                {
+                    appendHex(output, codepoint);
+                }
+                else
+                {
+                    // Encode 20 bits as a surrogate pair.
+                    codepoint -= 0x10000;
+                    appendHex(output, 0xd800 + ((codepoint >> 10) & 0x3ff));
+                    appendHex(output, 0xdc00 + (codepoint & 0x3ff));
+                }
+                break;
+            }
+        }
+        ++str;
+    }
+    output.push_back('"');
+}
+
+static void writeUInt(uint64_t value, std::string &output)
+{
+    static const char digitPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233"
+        "34353637383940414243444546474849505152535455565758596061626364656667"
+        "6869707172737475767778798081828384858687888990919293949596979899";
+    char buf[20];
+    char *p = buf + sizeof(buf);
+    while (value >= 100)
+    {
+        auto index = (value % 100) * 2;
+        value /= 100;
+        *--p = digitPairs[index + 1];
+        *--p = digitPairs[index];
+    }
+    if (value >= 10)
+    {
+        *--p = digitPairs[value * 2 + 1];
+        *--p = digitPairs[value * 2];
+    }
+    else
+    {
+        *--p = static_cast<char>('0' + value);
+    }
+    output.append(p, buf + sizeof(buf) - p);
+}
+
+static void writeReal(double value, std::string &output)
+{
+    if (!std::isfinite(value))
+    {
+        if (std::isnan(value))
+            output.append("null", 4);
+        else if (value < 0)
+            output.append("-1e+9999", 8);
+        else
+            output.append("1e+9999", 7);
+        return;
+    }
+    // The same format as jsoncpp with the default precision, to_chars() is
+    // specified to produce the same text as printf() in the "C" locale.
+    char buf[36];
+#ifdef __cpp_lib_to_chars
+    int len = static_cast<int>(
+        std::to_chars(
+            buf, buf + sizeof(buf), value, std::chars_format::general, 17)
+            .ptr -
+        buf);
+#else
+    auto len = snprintf(buf, sizeof(buf), "%.17g", value);
+#endif
+    bool hasPoint = false;
+    for (int i = 0; i < len; ++i)
+    {
+        if (buf[i] == ',')
+            buf[i] = '.';
+        if (buf[i] == '.' || buf[i] == 'e')
+            hasPoint = true;
+    }
+    output.append(buf, len);
+    if (!hasPoint)
+        output.append(".0", 2);
+}
+
+static void writeValue(const Json::Value &value, std::string &output)
+{
+    switch (value.type())
+    {
+        case Json::nullValue:
+            output.append("null", 4);
+            break;
+        case Json::intValue:
+            internal::appendJsonInt(value.asLargestInt(), output);
+            break;
+        case Json::uintValue:
+            writeUInt(value.asLargestUInt(), output);
+            break;
+        case Json::realValue:
+            writeReal(value.asDouble(), output);
+            break;
+        case Json::stringValue:
+        {
+            char const *begin;
+            char const *end;
+            if (value.getString(&begin, &end))
+                writeString(begin, end, output);
+            else
+                output.append("\"\"", 2);
+            break;
+        }
+        case Json::booleanValue:
+            if (value.asBool())
+                output.append("true", 4);
+            else
+                output.append("false", 5);
+            break;
+        case Json::arrayValue:
+        {
+            output.push_back('[');
+            bool first = true;
+            for (auto const &item : value)
+            {
+                if (!first)
+                    output.push_back(',');
+                first = false;
+                writeValue(item, output);
+            }
+            output.push_back(']');
+            break;
+        }
+        case Json::objectValue:
+        {
+            output.push_back('{');
+            bool first = true;
+            for (auto iter = value.begin(); iter != value.end(); ++iter)
+            {
+                if (!first)
+                    output.push_back(',');
+                first = false;
+                char const *end;
+                auto name = iter.memberName(&end);
+                writeString(name, end, output);
+                output.push_back(':');
+                writeValue(*iter, output);
+            }
+            output.push_back('}');
+            break;
+        }
+    }
+}
+
+void writeJson(const Json::Value &value, std::string &output)
+{
+    // Walking the tree of a Json::Value to compute the length beforehand costs
+    // more than the reallocations of the string, so only the small values are
+    // guaranteed to be written without reallocations.
+    output.reserve(output.length() + 256);
+    writeValue(value, output);
+}
+
+std::string writeJson(const Json::Value &value)
+{
+    std::string output;
+    writeJson(value, output);
+    return output;
+}
+
+void internal::appendJsonString(const char *str,
+                                size_t length,
+                                std::string &output)
+{
+    writeString(str, str + length, output);
+}
+
+void internal::appendJsonInt(int64_t value, std::string &output)
+{
+    if (value < 0)
+    {
+        output.push_back('-');
+        writeUInt(0 - static_cast<uint64_t>(value), output);
+    }
+    else
+    {
+        writeUInt(static_cast<uint64_t>(value), output);
+    }
+}
+
+void internal::appendJsonUInt(uint64_t value, std::string &output)
+{
+    writeUInt(value, output);
+}
+
+void internal::appendJsonDouble(double value, std::string &output)
+{
+    writeReal(value, output);
+}
+
+void internal::appendJsonValue(const Json::Value &value, std::string &output)
+{
+    writeValue(value, output);
+}
+
+}  // namespace drogon
@@ -0,0 +1,34 @@
+/**
+ *
+ *  JsonWriter.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <json/json.h>
+#include <string>
+
+namespace drogon
+{
+/// Serialize the json value and append it to the output.
+/**
+ * The output is the same as the output of a Json::StreamWriter with empty
+ * indentation and no comments, but the value is written directly into the
+ * string instead of through a std::ostream, and numbers are formatted without
+ * any stream.
+ */
+void writeJson(const Json::Value &value, std::string &output);
+
+/// Serialize the json value into a new string.
+std::string writeJson(const Json::Value &value);
+
+}  // namespace drogon
@@ -0,0 +1,78 @@
+/**
+ *
+ *  LatencyHistogram.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/LatencyHistogram.h>
+
+using namespace drogon;
+
+constexpr size_t LatencyHistogram::bucketsNumber;
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index)
+{
+    if (index < 4)
+        return index;
+    auto msb = index / 4 + 1;
+    auto sub = index % 4;
+    return ((5 + sub) << (msb - 2)) - 1;
+}
+
+LatencySummary LatencyHistogram::summary() const
+{
+    LatencySummary summary;
+    uint64_t counts[bucketsNumber];
+    uint64_t total = 0;
+    for (size_t i = 0; i < bucketsNumber; ++i)
+    {
+        counts[i] = buckets_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    auto max = max_.load(std::memory_order_relaxed);
+    summary.count_ = total;
+    summary.sum_ = sum_.load(std::memory_order_relaxed) / 1000000.0;
+    summary.max_ = max / 1000000.0;
+    if (total == 0)
+        return summary;
+    auto percentile = [&](double q) {
+        auto rank = (uint64_t)(q * total);
+        if (rank == 0)
+            rank = 1;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < bucketsNumber; ++i)
+        {
+            sum += counts[i];
+            if (sum >= rank)
+            {
+                auto upper = bucketUpperBound(i);
+                return (upper < max ? upper : max) / 1000000.0;
+            }
+        }
+        return max / 1000000.0;
+    };
+    summary.p50_ = percentile(0.5);
+    summary.p90_ = percentile(0.9);
+    summary.p99_ = percentile(0.99);
+    return summary;
+}
+
+void LatencyHistogram::forEachBucket(
+    const std::function<void(double upperBound, uint64_t count)> &callback)
+    const
+{
+    for (size_t i = 0; i < bucketsNumber; ++i)
+    {
+        auto count = buckets_[i].load(std::memory_order_relaxed);
+        if (count > 0)
+            callback(bucketUpperBound(i) / 1000000.0, count);
+    }
+}
@@ -15,8 +15,12 @@
 #include "ListenerManager.h"
 #include "HttpServer.h"
 #include "HttpAppFrameworkImpl.h"
+#ifdef __linux__
+#include "HotRestart.h"
+#endif
 #include <drogon/config.h>
 #include <trantor/utils/Logger.h>
+#include <set>
 #include <fcntl.h>
 #include <sys/file.h>
 #include <sys/stat.h>
@@ -76,6 +80,7 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
 {
 #ifdef __linux__
     std::vector<trantor::EventLoop *> ioLoops;
+    std::set<std::string> inheritedAddresses;
     for (size_t i = 0; i < threadNum; ++i)
     {
         LOG_TRACE << "thread num=" << threadNum;
@@ -87,7 +92,8 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
             auto const &ip = listener.ip_;
             bool isIpv6 = ip.find(':') == std::string::npos ? false : true;
             std::shared_ptr<HttpServer> serverPtr;
-            if (i == 0)
+            // The ports are in use by the previous process in hot restarts.
+            if (i == 0 && inheritedSockets_.empty())
             {
                 DrogonFileLocker lock;
                 // Check whether the port is in use.
@@ -130,6 +136,34 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
                 serverPtr->enableSSL(cert, key);
 #endif
             }
+            else if (socketHandoff_)
+            {
+                // The sockets of the previous process are shared by the IO
+                // loops, the loops without one create new sockets.
+                auto address = HotRestart::socketAddress(ip, listener.port_);
+                std::vector<int> sockets;
+                auto iter = inheritedSockets_.find(address);
+                if (iter != inheritedSockets_.end())
+                {
+                    inheritedAddresses.insert(address);
+                    for (size_t j = i; j < iter->second.size(); j += threadNum)
+                    {
+                        sockets.push_back(iter->second[j]);
+                    }
+                }
+                if (sockets.empty())
+                {
+                    auto fd =
+                        HotRestart::createListeningSocket(ip, listener.port_);
+                    if (fd < 0)
+                        exit(1);
+                    sockets.push_back(fd);
+                }
+                listeningSockets_.insert(listeningSockets_.end(),
+                                         sockets.begin(),
+                                         sockets.end());
+                serverPtr->setListeningSockets(std::move(sockets));
+            }
             serverPtr->setHttpAsyncCallback(httpCallback);
             serverPtr->setNewWebsocketCallback(webSocketCallback);
             serverPtr->setConnectionCallback(connectionCallback);
@@ -138,6 +172,19 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
             servers_.push_back(serverPtr);
         }
     }
+    for (auto &inherited : inheritedSockets_)
+    {
+        if (inheritedAddresses.find(inherited.first) !=
+            inheritedAddresses.end())
+            continue;
+        LOG_WARN << "No listener on " << inherited.first
+                 << " any more, its sockets are closed";
+        for (auto fd : inherited.second)
+        {
+            close(fd);
+        }
+    }
+    inheritedSockets_.clear();
 #else
     auto loopThreadPtr =
         std::make_shared<EventLoopThread>("DrogonListeningLoop");
@@ -194,6 +241,33 @@ void ListenerManager::startListening()
     }
 }
 
+void ListenerManager::enableSocketHandoff(std::vector<int> &&inheritedSockets)
+{
+    socketHandoff_ = true;
+#ifdef __linux__
+    for (auto fd : inheritedSockets)
+    {
+        inheritedSockets_[HotRestart::socketAddress(fd)].push_back(fd);
+    }
+#endif
+}
+
+std::vector<int> ListenerManager::listeningSockets() const
+{
+    if (acceptingStopped_)
+        return {};
+    return listeningSockets_;
+}
+
+void ListenerManager::stopAccepting()
+{
+    acceptingStopped_ = true;
+    for (auto &server : servers_)
+    {
+        server->getLoop()->runInLoop([server]() { server->stopAccepting(); });
+    }
+}
+
 ListenerManager::~ListenerManager()
 {
     for (size_t i = 0; i < servers_.size(); ++i)
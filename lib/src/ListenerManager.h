@@ -18,6 +18,7 @@
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoopThreadPool.h>
 #include <trantor/net/callbacks.h>
+#include <map>
 #include <string>
 #include <vector>
 #include <memory>
@@ -44,6 +45,16 @@ class ListenerManager : public trantor::NonCopyable
             std::function<HttpResponsePtr(const HttpRequestPtr &)>>
             &syncAdvices);
     void startListening();
+    /// Let drogon create the listening sockets of the listeners without SSL
+    /// for the hot restarts, the sockets taken over from the previous process
+    /// are used for the listeners on their addresses. It must be called
+    /// before the listeners are created and is available on Linux only.
+    void enableSocketHandoff(std::vector<int> &&inheritedSockets);
+    /// The listening sockets created by drogon, empty after the listeners
+    /// stop accepting.
+    std::vector<int> listeningSockets() const;
+    /// Stop accepting new connections on all listeners.
+    void stopAccepting();
     ~ListenerManager();
 
   private:
@@ -68,6 +79,11 @@ class ListenerManager : public trantor::NonCopyable
         std::string keyFile_;
     };
     std::vector<ListenerInfo> listeners_;
+    bool socketHandoff_{false};
+    // The sockets taken over, by their addresses.
+    std::map<std::string, std::vector<int>> inheritedSockets_;
+    std::vector<int> listeningSockets_;
+    bool acceptingStopped_{false};
     std::vector<std::shared_ptr<HttpServer>> servers_;
     std::vector<std::shared_ptr<trantor::EventLoopThread>>
         listeningloopThreads_;
@@ -0,0 +1,366 @@
+/**
+ *
+ *  Metrics.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/Metrics.h>
+#include <algorithm>
+#include <stdexcept>
+#include <stdio.h>
+
+using namespace drogon;
+
+namespace
+{
+class SlotAllocator
+{
+  public:
+    static SlotAllocator &instance()
+    {
+        // Never destroyed, threads may exit after the static objects are
+        // destroyed.
+        static auto &allocator = *new SlotAllocator;
+        return allocator;
+    }
+    size_t acquire()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!freeSlots_.empty())
+        {
+            auto index = freeSlots_.back();
+            freeSlots_.pop_back();
+            return index;
+        }
+        if (nextSlot_ < sharedSlot)
+            return nextSlot_++;
+        return sharedSlot;
+    }
+    void release(size_t index)
+    {
+        if (index == sharedSlot)
+            return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        freeSlots_.push_back(index);
+    }
+
+    static constexpr size_t sharedSlot = internal::metricsSlotsNumber - 1;
+
+  private:
+    std::mutex mutex_;
+    size_t nextSlot_{0};
+    std::vector<size_t> freeSlots_;
+};
+constexpr size_t SlotAllocator::sharedSlot;
+
+class ThreadSlot
+{
+  public:
+    ThreadSlot()
+    {
+        slot_.index_ = SlotAllocator::instance().acquire();
+        slot_.exclusive_ = slot_.index_ != SlotAllocator::sharedSlot;
+    }
+    ~ThreadSlot()
+    {
+        // The mutex of the allocator makes the values written by this thread
+        // visible to the next owner of the slot.
+        SlotAllocator::instance().release(slot_.index_);
+    }
+    const internal::MetricsSlot &slot() const
+    {
+        return slot_;
+    }
+
+  private:
+    internal::MetricsSlot slot_;
+};
+
+void appendDouble(std::string &output, double value)
+{
+    char buf[32];
+    auto len = snprintf(buf, sizeof(buf), "%.15g", value);
+    output.append(buf, len);
+}
+
+void appendEscaped(std::string &output, const std::string &text, bool quote)
+{
+    for (auto ch : text)
+    {
+        if (ch == '\\')
+            output.append("\\\\");
+        else if (ch == '\n')
+            output.append("\\n");
+        else if (ch == '"' && quote)
+            output.append("\\\"");
+        else
+            output.push_back(ch);
+    }
+}
+
+void appendSample(std::string &output,
+                  const std::string &name,
+                  const char *suffix,
+                  const MetricLabels &labels,
+                  const char *le,
+                  const std::string &value)
+{
+    output.append(name).append(suffix);
+    if (!labels.empty() || le)
+    {
+        output.push_back('{');
+        bool first = true;
+        for (auto &label : labels)
+        {
+            if (!first)
+                output.push_back(',');
+            first = false;
+            output.append(label.first).append("=\"");
+            appendEscaped(output, label.second, true);
+            output.push_back('"');
+        }
+        if (le)
+        {
+            if (!first)
+                output.push_back(',');
+            output.append("le=\"").append(le).push_back('"');
+        }
+        output.push_back('}');
+    }
+    output.push_back(' ');
+    output.append(value).push_back('\n');
+}
+}  // namespace
+
+const internal::MetricsSlot &internal::currentMetricsSlot()
+{
+    thread_local ThreadSlot threadSlot;
+    return threadSlot.slot();
+}
+
+uint64_t MetricCounter::value() const
+{
+    uint64_t sum = 0;
+    cells_.forEach([&sum](const internal::CounterCell &cell) {
+        sum += cell.value_.load(std::memory_order_relaxed);
+    });
+    return sum;
+}
+
+int64_t MetricGauge::value() const
+{
+    int64_t sum = 0;
+    cells_.forEach([&sum](const internal::GaugeCell &cell) {
+        sum += cell.value_.load(std::memory_order_relaxed);
+    });
+    return sum;
+}
+
+std::vector<uint64_t> MetricHistogram::cumulativeCounts(
+    const std::vector<double> &upperBounds) const
+{
+    uint64_t buckets[LatencyHistogram::bucketsNumber] = {0};
+    cells_.forEach([&buckets](const internal::HistogramCell &cell) {
+        for (size_t i = 0; i < LatencyHistogram::bucketsNumber; ++i)
+            buckets[i] += cell.buckets_[i].load(std::memory_order_relaxed);
+    });
+    std::vector<uint64_t> counts(upperBounds.size() + 1, 0);
+    for (size_t i = 0; i < LatencyHistogram::bucketsNumber; ++i)
+    {
+        if (buckets[i] == 0)
+            continue;
+        auto upper = LatencyHistogram::bucketUpperBound(i) / 1000000.0;
+        auto iter =
+            std::lower_bound(upperBounds.begin(), upperBounds.end(), upper);
+        counts[iter - upperBounds.begin()] += buckets[i];
+    }
+    for (size_t i = 1; i < counts.size(); ++i)
+        counts[i] += counts[i - 1];
+    return counts;
+}
+
+double MetricHistogram::sum() const
+{
+    uint64_t sum = 0;
+    cells_.forEach([&sum](const internal::HistogramCell &cell) {
+        sum += cell.sum_.load(std::memory_order_relaxed);
+    });
+    return sum / 1000000.0;
+}
+
+uint64_t MetricHistogram::count() const
+{
+    uint64_t count = 0;
+    cells_.forEach([&count](const internal::HistogramCell &cell) {
+        for (auto &bucket : cell.buckets_)
+            count += bucket.load(std::memory_order_relaxed);
+    });
+    return count;
+}
+
+MetricsRegistry &MetricsRegistry::instance()
+{
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Metric &MetricsRegistry::getMetric(const std::string &name,
+                                                    const std::string &help,
+                                                    MetricType type,
+                                                    const MetricLabels &labels)
+{
+    auto iter = families_.find(name);
+    if (iter == families_.end())
+    {
+        iter = families_.emplace(name, Family()).first;
+        iter->second.help_ = help;
+        iter->second.type_ = type;
+    }
+    else if (iter->second.type_ != type)
+    {
+        throw std::invalid_argument("The metric " + name +
+                                    " is registered with another type");
+    }
+    return iter->second.metrics_[labels];
+}
+
+std::shared_ptr<MetricCounter> MetricsRegistry::counter(
+    const std::string &name,
+    const std::string &help,
+    const MetricLabels &labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &metric = getMetric(name, help, kCounter, labels);
+    if (!metric.counter_)
+        metric.counter_ = std::make_shared<MetricCounter>();
+    return metric.counter_;
+}
+
+std::shared_ptr<MetricGauge> MetricsRegistry::gauge(const std::string &name,
+                                                    const std::string &help,
+                                                    const MetricLabels &labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &metric = getMetric(name, help, kGauge, labels);
+    if (!metric.gauge_ && !metric.callback_)
+        metric.gauge_ = std::make_shared<MetricGauge>();
+    if (!metric.gauge_)
+        throw std::invalid_argument("The gauge " + name +
+                                    " is registered with a callback");
+    return metric.gauge_;
+}
+
+std::shared_ptr<MetricHistogram> MetricsRegistry::histogram(
+    const std::string &name,
+    const std::string &help,
+    const MetricLabels &labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &metric = getMetric(name, help, kHistogram, labels);
+    if (!metric.histogram_)
+        metric.histogram_ = std::make_shared<MetricHistogram>();
+    return metric.histogram_;
+}
+
+void MetricsRegistry::gaugeCallback(const std::string &name,
+                                    const std::string &help,
+                                    const MetricLabels &labels,
+                                    std::function<double()> callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &metric = getMetric(name, help, kGauge, labels);
+    metric.gauge_.reset();
+    metric.callback_ = std::move(callback);
+}
+
+std::string MetricsRegistry::toPrometheusText(
+    const std::vector<double> &upperBounds) const
+{
+    std::vector<std::string> les;
+    les.reserve(upperBounds.size());
+    for (auto bound : upperBounds)
+    {
+        std::string le;
+        appendDouble(le, bound);
+        les.push_back(std::move(le));
+    }
+    std::string output;
+    std::string value;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &family : families_)
+    {
+        auto &name = family.first;
+        output.append("# HELP ").append(name).push_back(' ');
+        appendEscaped(output, family.second.help_, false);
+        output.append("\n# TYPE ").append(name);
+        switch (family.second.type_)
+        {
+            case kCounter:
+                output.append(" counter\n");
+                break;
+            case kGauge:
+                output.append(" gauge\n");
+                break;
+            case kHistogram:
+                output.append(" histogram\n");
+                break;
+        }
+        for (auto &item : family.second.metrics_)
+        {
+            auto &labels = item.first;
+            auto &metric = item.second;
+            if (metric.counter_)
+            {
+                appendSample(output,
+                             name,
+                             "",
+                             labels,
+                             nullptr,
+                             std::to_string(metric.counter_->value()));
+            }
+            else if (metric.gauge_)
+            {
+                appendSample(output,
+                             name,
+                             "",
+                             labels,
+                             nullptr,
+                             std::to_string(metric.gauge_->value()));
+            }
+            else if (metric.callback_)
+            {
+                value.clear();
+                appendDouble(value, metric.callback_());
+                appendSample(output, name, "", labels, nullptr, value);
+            }
+            else if (metric.histogram_)
+            {
+                auto counts = metric.histogram_->cumulativeCounts(upperBounds);
+                for (size_t i = 0; i < les.size(); ++i)
+                {
+                    appendSample(output,
+                                 name,
+                                 "_bucket",
+                                 labels,
+                                 les[i].c_str(),
+                                 std::to_string(counts[i]));
+                }
+                auto total = std::to_string(counts.back());
+                appendSample(output, name, "_bucket", labels, "+Inf", total);
+                value.clear();
+                appendDouble(value, metric.histogram_->sum());
+                appendSample(output, name, "_sum", labels, nullptr, value);
+                appendSample(output, name, "_count", labels, nullptr, total);
+            }
+        }
+    }
+    return output;
+}
@@ -15,37 +15,34 @@
  */
 
 #include <drogon/NotFound.h>
-#include <map>
-#include <set>
-#include <sstream>
+#include <drogon/utils/OStringStream.h>
 #include <string>
-#include <vector>
 
 using namespace drogon;
 
 std::string NotFound::genText(const HttpViewData &NotFound_view_data)
 {
-    std::stringstream NotFound_tmp_stream;
-    NotFound_tmp_stream << "<html>\n";
-    NotFound_tmp_stream << "<head><title>404 Not Found</title></head>\n";
-    NotFound_tmp_stream << "<body bgcolor=\"white\">\n";
-    NotFound_tmp_stream << "<center><h1>404 Not Found</h1></center>\n";
-    NotFound_tmp_stream << "<hr><center>drogon/";
+    drogon::OStringStream NotFound_tmp_stream;
+    NotFound_tmp_stream.reserve(capacityHint());
+    NotFound_tmp_stream.write(
+        "<html>\n"
+        "<head><title>404 Not Found</title></head>\n"
+        "<body bgcolor=\"white\">\n"
+        "<center><h1>404 Not Found</h1></center>\n"
+        "<hr><center>drogon/",
+        131);
     NotFound_tmp_stream << NotFound_view_data.get<std::string>("version");
-    NotFound_tmp_stream << "</center>\n";
-    NotFound_tmp_stream << "</body>\n";
-    NotFound_tmp_stream << "</html>\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    return NotFound_tmp_stream.str();
+    NotFound_tmp_stream.write(
+        "</center>\n"
+        "</body>\n"
+        "</html>\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n",
+        422);
+    updateCapacityHint(NotFound_tmp_stream.size());
+    return std::move(NotFound_tmp_stream.str());
 }
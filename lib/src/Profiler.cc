@@ -0,0 +1,575 @@
+/**
+ *
+ *  drogon_plugin_Profiler.cc
+ *
+ */
+#include "AdminAuthorization.h"
+#include "AllocationCounters.h"
+#include "HttpAppFrameworkImpl.h"
+#include <drogon/drogon.h>
+#include <drogon/plugins/Profiler.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#endif
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+std::atomic<Profiler *> Profiler::routesProfiler_{nullptr};
+
+struct Profiler::ThreadInfo
+{
+    std::string name_;
+    // Set in the thread by a functor queued when the plugin starts.
+    pthread_t thread_;
+    long tid_{0};
+    size_t allocationSlot_{0};
+    std::atomic<bool> ready_{false};
+};
+
+struct Profiler::RouteTimes
+{
+    struct Times
+    {
+        int64_t cpuTime_{0};
+        uint64_t requests_{0};
+    };
+    // Only contended when the times are collected.
+    std::mutex mutex_;
+    std::unordered_map<std::string, Times> routes_;
+    std::string key_;
+};
+
+#ifdef __linux__
+
+namespace
+{
+constexpr int kMaxDepth = 64;
+// The frames of the signal handler and the signal trampoline.
+constexpr int kSkippedFrames = 2;
+}  // namespace
+
+/**
+ * The samples of the threads in a cpu profiling session. A thread records
+ * its samples in its signal handler, they're read after the session stops
+ * and no handler is running.
+ */
+class Profiler::CpuSession : public trantor::NonCopyable
+{
+  public:
+    struct SampledThread
+    {
+        const ThreadInfo *info_{nullptr};
+        timer_t timer_;
+        bool hasTimer_{false};
+        size_t maxSamples_{0};
+        std::unique_ptr<void *[]> frames_;
+        std::unique_ptr<int[]> depths_;
+        std::atomic<size_t> count_{0};
+        std::atomic<uint64_t> lost_{0};
+
+        /// The frames of the next sample, nullptr if the buffer is full.
+        void **nextSample()
+        {
+            auto count = count_.load(std::memory_order_relaxed);
+            if (count >= maxSamples_)
+            {
+                lost_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            return frames_.get() + count * kMaxDepth;
+        }
+        void commitSample(int depth)
+        {
+            auto count = count_.load(std::memory_order_relaxed);
+            depths_[count] = depth;
+            count_.store(count + 1, std::memory_order_release);
+        }
+    };
+
+    CpuSession(const std::vector<std::shared_ptr<ThreadInfo>> &threads,
+               double seconds,
+               int frequency);
+    ~CpuSession();
+
+    static void installSignalHandler();
+    void start();
+    void stop();
+    std::string foldedStacks() const;
+
+  private:
+    static void onSignal(int, siginfo_t *info, void *);
+    bool owns(const SampledThread *thread) const
+    {
+        return thread >= threads_.get() && thread < threads_.get() + size_;
+    }
+
+    static std::atomic<CpuSession *> current_;
+    static std::atomic<int> handlersRunning_;
+
+    std::unique_ptr<SampledThread[]> threads_;
+    size_t size_;
+    int frequency_;
+};
+
+std::atomic<Profiler::CpuSession *> Profiler::CpuSession::current_{nullptr};
+std::atomic<int> Profiler::CpuSession::handlersRunning_{0};
+
+Profiler::CpuSession::CpuSession(
+    const std::vector<std::shared_ptr<ThreadInfo>> &threads,
+    double seconds,
+    int frequency)
+    : threads_(new SampledThread[threads.size()]),
+      size_(threads.size()),
+      frequency_(frequency)
+{
+    // A thread is sampled at most at the frequency of the wall time.
+    auto maxSamples = static_cast<size_t>(seconds * frequency) + 16;
+    for (size_t i = 0; i < size_; ++i)
+    {
+        auto &thread = threads_[i];
+        thread.info_ = threads[i].get();
+        if (!thread.info_->ready_.load(std::memory_order_acquire))
+            continue;
+        thread.maxSamples_ = maxSamples;
+        thread.frames_.reset(new void *[maxSamples * kMaxDepth]);
+        thread.depths_.reset(new int[maxSamples]);
+    }
+}
+
+Profiler::CpuSession::~CpuSession()
+{
+    stop();
+}
+
+void Profiler::CpuSession::installSignalHandler()
+{
+    // The first call of backtrace() loads libgcc, which is not safe in a
+    // signal handler.
+    void *frames[1];
+    backtrace(frames, 1);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = onSignal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+}
+
+void Profiler::CpuSession::onSignal(int, siginfo_t *info, void *)
+{
+    auto savedErrno = errno;
+    handlersRunning_.fetch_add(1);
+    auto session = current_.load();
+    if (session && info->si_code == SI_TIMER)
+    {
+        // The signal may be left over from an earlier session.
+        auto thread = static_cast<SampledThread *>(info->si_value.sival_ptr);
+        void **frames;
+        if (session->owns(thread) && (frames = thread->nextSample()))
+        {
+            // Called here, so the frames of the stack start from this
+            // handler.
+            thread->commitSample(backtrace(frames, kMaxDepth));
+        }
+    }
+    handlersRunning_.fetch_sub(1);
+    errno = savedErrno;
+}
+
+void Profiler::CpuSession::start()
+{
+    current_.store(this);
+    auto interval = 1000000000L / frequency_;
+    for (size_t i = 0; i < size_; ++i)
+    {
+        auto &thread = threads_[i];
+        if (thread.maxSamples_ == 0)
+            continue;
+        // The timer fires at the CPU time of the thread, so the idle threads
+        // are not sampled.
+        clockid_t clock;
+        if (pthread_getcpuclockid(thread.info_->thread_, &clock) != 0)
+            continue;
+        struct sigevent event;
+        memset(&event, 0, sizeof(event));
+        event.sigev_notify = SIGEV_THREAD_ID;
+        event.sigev_signo = SIGPROF;
+        event.sigev_value.sival_ptr = &thread;
+        event.sigev_notify_thread_id = thread.info_->tid_;
+        if (timer_create(clock, &event, &thread.timer_) != 0)
+        {
+            LOG_SYSERR << "Can't create the profiling timer of "
+                       << thread.info_->name_;
+            continue;
+        }
+        thread.hasTimer_ = true;
+        struct itimerspec spec;
+        spec.it_interval.tv_sec = interval / 1000000000L;
+        spec.it_interval.tv_nsec = interval % 1000000000L;
+        spec.it_value = spec.it_interval;
+        timer_settime(thread.timer_, 0, &spec, nullptr);
+    }
+}
+
+void Profiler::CpuSession::stop()
+{
+    for (size_t i = 0; i < size_; ++i)
+    {
+        if (threads_[i].hasTimer_)
+        {
+            timer_delete(threads_[i].timer_);
+            threads_[i].hasTimer_ = false;
+        }
+    }
+    auto expected = this;
+    current_.compare_exchange_strong(expected, nullptr);
+    // Wait for the handlers which may still be recording into this session.
+    while (handlersRunning_.load() > 0)
+        sched_yield();
+}
+
+namespace
+{
+std::string symbolize(void *address, bool isReturnAddress)
+{
+    // A return address points after the call instruction, which may be the
+    // start of the next function.
+    auto lookup = static_cast<char *>(address) - (isReturnAddress ? 1 : 0);
+    Dl_info info;
+    if (dladdr(lookup, &info) && info.dli_sname)
+    {
+        int status = 0;
+        auto demangled =
+            abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        std::string name(status == 0 && demangled ? demangled
+                                                  : info.dli_sname);
+        free(demangled);
+        // Semicolons separate the frames in the folded format.
+        std::replace(name.begin(), name.end(), ';', ':');
+        return name;
+    }
+    char buf[64];
+    if (info.dli_fname)
+    {
+        auto module = strrchr(info.dli_fname, '/');
+        snprintf(buf,
+                 sizeof(buf),
+                 "%s+0x%lx",
+                 module ? module + 1 : info.dli_fname,
+                 (unsigned long)(lookup - static_cast<char *>(info.dli_fbase)));
+    }
+    else
+    {
+        snprintf(buf, sizeof(buf), "0x%lx", (unsigned long)address);
+    }
+    return buf;
+}
+}  // namespace
+
+std::string Profiler::CpuSession::foldedStacks() const
+{
+    std::unordered_map<void *, std::string> symbols;
+    auto symbol = [&symbols](void *address, bool isReturnAddress)
+        -> const std::string & {
+        auto iter = symbols.find(address);
+        if (iter == symbols.end())
+            iter = symbols
+                       .emplace(address, symbolize(address, isReturnAddress))
+                       .first;
+        return iter->second;
+    };
+    std::map<std::string, size_t> stacks;
+    for (size_t i = 0; i < size_; ++i)
+    {
+        auto &thread = threads_[i];
+        auto count = thread.count_.load(std::memory_order_acquire);
+        // Count the identical stacks before symbolizing them.
+        std::map<std::vector<void *>, size_t> rawStacks;
+        for (size_t j = 0; j < count; ++j)
+        {
+            auto frames = thread.frames_.get() + j * kMaxDepth;
+            auto depth = thread.depths_[j];
+            if (depth <= kSkippedFrames)
+                continue;
+            ++rawStacks[std::vector<void *>(frames + kSkippedFrames,
+                                            frames + depth)];
+        }
+        for (auto &rawStack : rawStacks)
+        {
+            auto &frames = rawStack.first;
+            std::string stack = thread.info_->name_;
+            // The folded format starts from the outermost frame, the
+            // innermost one is the interrupted instruction.
+            for (size_t j = frames.size(); j-- > 0;)
+            {
+                stack.push_back(';');
+                stack.append(symbol(frames[j], j > 0));
+            }
+            stacks[stack] += rawStack.second;
+        }
+        auto lost = thread.lost_.load(std::memory_order_relaxed);
+        if (lost > 0)
+            stacks[thread.info_->name_ + ";[lost samples]"] += lost;
+    }
+    std::string output;
+    for (auto &stack : stacks)
+    {
+        output.append(stack.first);
+        output.push_back(' ');
+        output.append(std::to_string(stack.second));
+        output.push_back('\n');
+    }
+    return output;
+}
+
+#else
+
+class Profiler::CpuSession
+{
+};
+
+#endif
+
+Profiler::Profiler()
+{
+}
+
+Profiler::~Profiler()
+{
+}
+
+int64_t Profiler::threadCpuTime()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+void Profiler::initAndStart(const Json::Value &config)
+{
+    path_ = config.get("path", path_).asString();
+    token_ = config.get("token", "").asString();
+    allowRemote_ = config.get("allow_remote", allowRemote_).asBool();
+    maxSeconds_ = config.get("max_seconds", maxSeconds_).asDouble();
+    if (token_.empty())
+    {
+        LOG_ERROR << "The Profiler plugin is disabled without a token";
+        return;
+    }
+    for (auto &namedLoop : HttpAppFrameworkImpl::instance().getNamedLoops())
+    {
+        auto info = std::make_shared<ThreadInfo>();
+        info->name_ = namedLoop.first;
+        namedLoop.second->runInLoop([info]() {
+            info->thread_ = pthread_self();
+#ifdef __linux__
+            info->tid_ = syscall(SYS_gettid);
+#endif
+            info->allocationSlot_ = AllocationCounters::threadSlot();
+            info->ready_.store(true, std::memory_order_release);
+        });
+        threads_.push_back(std::move(info));
+    }
+    routeTimes_ =
+        std::make_unique<IOThreadStorage<std::unique_ptr<RouteTimes>>>();
+    routeTimes_->init([this](std::unique_ptr<RouteTimes> &times, size_t) {
+        times = std::make_unique<RouteTimes>();
+        allRouteTimes_.push_back(times.get());
+    });
+#ifdef __linux__
+    CpuSession::installSignalHandler();
+#endif
+    app().registerPreRoutingAdvice(
+        [this](const HttpRequestPtr &req,
+               AdviceCallback &&callback,
+               AdviceChainCallback &&chainCallback) {
+            handleRequest(req, std::move(callback), std::move(chainCallback));
+        });
+}
+
+void Profiler::shutdown()
+{
+    routesProfiler_.store(nullptr, std::memory_order_release);
+}
+
+void Profiler::handleRequest(const HttpRequestPtr &req,
+                             AdviceCallback &&callback,
+                             AdviceChainCallback &&chainCallback)
+{
+    auto &path = req->path();
+    if (req->method() != Get || path.compare(0, path_.length(), path_) != 0)
+    {
+        chainCallback();
+        return;
+    }
+    auto endpoint = path.substr(path_.length());
+    if (endpoint != "/cpu" && endpoint != "/routes" &&
+        endpoint != "/allocations")
+    {
+        chainCallback();
+        return;
+    }
+    if (!isAdminRequestAuthorized(req, token_, allowRemote_))
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setStatusCode(k401Unauthorized);
+        callback(resp);
+        return;
+    }
+    if (endpoint == "/allocations")
+    {
+        callback(allocations());
+        return;
+    }
+    auto seconds = 10.0;
+    auto &secondsParameter = req->getParameter("seconds");
+    if (!secondsParameter.empty())
+        seconds = atof(secondsParameter.c_str());
+    seconds = std::max(0.1, std::min(seconds, maxSeconds_));
+    if (busy_.exchange(true))
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setStatusCode(k409Conflict);
+        resp->setBody("A profiling session is running");
+        callback(resp);
+        return;
+    }
+    if (endpoint == "/routes")
+    {
+        profileRoutes(seconds, std::move(callback));
+        return;
+    }
+    auto frequency = 99;
+    auto &frequencyParameter = req->getParameter("frequency");
+    if (!frequencyParameter.empty())
+        frequency = atoi(frequencyParameter.c_str());
+    frequency = std::max(1, std::min(frequency, 1000));
+    profileCpu(seconds, frequency, std::move(callback));
+}
+
+void Profiler::profileCpu(double seconds,
+                          int frequency,
+                          AdviceCallback &&callback)
+{
+#ifdef __linux__
+    auto session = std::make_shared<CpuSession>(threads_, seconds, frequency);
+    session->start();
+    app().getLoop()->runAfter(
+        seconds, [this, session, callback = std::move(callback)]() {
+            session->stop();
+            auto resp = HttpResponse::newHttpResponse();
+            resp->setContentTypeCode(CT_TEXT_PLAIN);
+            resp->setBody(session->foldedStacks());
+            busy_.store(false);
+            callback(resp);
+        });
+#else
+    (void)seconds;
+    (void)frequency;
+    busy_.store(false);
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setStatusCode(k501NotImplemented);
+    resp->setBody("CPU profiling is only supported on Linux");
+    callback(resp);
+#endif
+}
+
+void Profiler::addRouteCpuTime(const HttpRequest &req, int64_t cpuTime)
+{
+    auto &times = *routeTimes_->getThreadData();
+    std::lock_guard<std::mutex> lock(times.mutex_);
+    // Reuse the key string to find the route without allocations.
+    times.key_.assign(req.matchedPathPatternData(),
+                      req.matchedPathPatternLength());
+    if (times.key_.empty())
+        times.key_ = "unmatched";
+    auto &routeTimes = times.routes_[times.key_];
+    routeTimes.cpuTime_ += cpuTime;
+    ++routeTimes.requests_;
+}
+
+void Profiler::profileRoutes(double seconds, AdviceCallback &&callback)
+{
+    routesProfiler_.store(this, std::memory_order_release);
+    app().getLoop()->runAfter(
+        seconds, [this, seconds, callback = std::move(callback)]() {
+            routesProfiler_.store(nullptr, std::memory_order_release);
+            std::unordered_map<std::string, RouteTimes::Times> routes;
+            for (auto times : allRouteTimes_)
+            {
+                std::lock_guard<std::mutex> lock(times->mutex_);
+                for (auto &route : times->routes_)
+                {
+                    auto &total = routes[route.first];
+                    total.cpuTime_ += route.second.cpuTime_;
+                    total.requests_ += route.second.requests_;
+                }
+                times->routes_.clear();
+            }
+            std::vector<std::pair<std::string, RouteTimes::Times>> sorted(
+                routes.begin(), routes.end());
+            std::sort(sorted.begin(),
+                      sorted.end(),
+                      [](const std::pair<std::string, RouteTimes::Times> &a,
+                         const std::pair<std::string, RouteTimes::Times> &b) {
+                          return a.second.cpuTime_ > b.second.cpuTime_;
+                      });
+            Json::Value json;
+            json["seconds"] = seconds;
+            json["routes"] = Json::Value(Json::arrayValue);
+            for (auto &route : sorted)
+            {
+                Json::Value item;
+                item["route"] = route.first;
+                item["requests"] =
+                    static_cast<Json::UInt64>(route.second.requests_);
+                item["cpu_time"] = route.second.cpuTime_ / 1000000000.0;
+                json["routes"].append(item);
+            }
+            busy_.store(false);
+            callback(HttpResponse::newHttpJsonResponse(json));
+        });
+}
+
+HttpResponsePtr Profiler::allocations() const
+{
+    auto toJson = [](const AllocationCounters::Counts &counts) {
+        Json::Value json;
+        json["allocations"] = static_cast<Json::UInt64>(counts.allocations_);
+        json["deallocations"] =
+            static_cast<Json::UInt64>(counts.deallocations_);
+        json["bytes"] = static_cast<Json::UInt64>(counts.bytes_);
+        return json;
+    };
+    Json::Value json;
+    json["enabled"] = AllocationCounters::enabled();
+    json["total"] = toJson(AllocationCounters::total());
+    json["threads"] = Json::Value(Json::arrayValue);
+    for (auto &thread : threads_)
+    {
+        if (!thread->ready_.load(std::memory_order_acquire))
+            continue;
+        auto item = toJson(AllocationCounters::slot(thread->allocationSlot_));
+        item["name"] = thread->name_;
+        json["threads"].append(item);
+    }
+    return HttpResponse::newHttpJsonResponse(json);
+}
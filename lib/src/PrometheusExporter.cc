@@ -0,0 +1,47 @@
+/**
+ *
+ *  drogon_plugin_PrometheusExporter.cc
+ *
+ */
+#include <drogon/drogon.h>
+#include <drogon/plugins/PrometheusExporter.h>
+#include <drogon/utils/Metrics.h>
+#include <algorithm>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+void PrometheusExporter::initAndStart(const Json::Value &config)
+{
+    path_ = config.get("path", path_).asString();
+    if (config.isMember("buckets") && config["buckets"].isArray())
+    {
+        buckets_.clear();
+        for (auto &bound : config["buckets"])
+        {
+            assert(bound.isNumeric());
+            buckets_.push_back(bound.asDouble());
+        }
+        std::sort(buckets_.begin(), buckets_.end());
+    }
+    app().registerSyncAdvice([this](const HttpRequestPtr &req) {
+        return this->exportingAdvice(req);
+    });
+}
+
+void PrometheusExporter::shutdown()
+{
+    /// Shutdown the plugin
+}
+
+HttpResponsePtr PrometheusExporter::exportingAdvice(
+    const HttpRequestPtr &req) const
+{
+    if (req->method() != Get || req->path() != path_)
+        return HttpResponsePtr{};
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setContentTypeCodeAndCustomString(
+        CT_TEXT_PLAIN, "content-type: text/plain; version=0.0.4\r\n");
+    resp->setBody(MetricsRegistry::instance().toPrometheusText(buckets_));
+    return resp;
+}
@@ -0,0 +1,95 @@
+/**
+ *
+ *  RequestTimings.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+
+namespace drogon
+{
+class RouteStageMetrics;
+
+/**
+ * @brief The time marks of a request on its way through the server, in
+ * nanoseconds of the steady clock.
+ *
+ * The stages between the marks are:
+ * - parse: From the first byte of the request to the end of its parsing.
+ * - queue: Until a router accepts it (the pre-routing advices, the hop to
+ * the IO loop and the routing).
+ * - filters: Until its handler is called (the post-routing advices, the
+ * filters and the pre-handling advices).
+ * - handler: Until its response is produced.
+ * - serialize: Encoding, compressing and rendering the response.
+ * - write: The rest of the time until the response is handed to the
+ * connection, including the time it waits for the earlier pipelined
+ * responses.
+ *
+ * A mark is 0 if the request skips it, e.g. a request answered by a
+ * synchronous advice is never routed, its skipped stages last 0.
+ */
+struct RequestTimings
+{
+    enum Stage
+    {
+        kParse = 0,
+        kQueue,
+        kFilters,
+        kHandler,
+        kSerialize,
+        kWrite,
+        kStagesNumber
+    };
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /// Compute the duration of each stage in nanoseconds when the response is
+    /// sent at the given time.
+    void stageDurations(int64_t sent, int64_t (&durations)[kStagesNumber]) const
+    {
+        // An unset mark takes the value of the next mark which is set.
+        int64_t marks[5] = {
+            parseStart_, parsed_, routed_, handlerStart_, responded_};
+        int64_t next = sent;
+        for (int i = 4; i >= 0; --i)
+        {
+            if (marks[i] == 0 || marks[i] > next)
+                marks[i] = next;
+            next = marks[i];
+        }
+        for (int i = 0; i < 4; ++i)
+            durations[i] = marks[i + 1] - marks[i];
+        auto write = sent - marks[4];
+        durations[kSerialize] = serialize_ < write ? serialize_ : write;
+        durations[kWrite] = write - durations[kSerialize];
+    }
+
+    int64_t parseStart_{0};
+    int64_t parsed_{0};
+    int64_t routed_{0};
+    int64_t handlerStart_{0};
+    int64_t responded_{0};
+    /// The accumulated time of the serialization.
+    int64_t serialize_{0};
+    /// The metrics of the route which accepts the request.
+    RouteStageMetrics *route_{nullptr};
+};
+
+}  // namespace drogon
@@ -0,0 +1,99 @@
+/**
+ *
+ *  drogon_plugin_ServerStateExporter.cc
+ *
+ */
+#include "AdminAuthorization.h"
+#include <drogon/drogon.h>
+#include <drogon/plugins/ServerStateExporter.h>
+#include <trantor/utils/Logger.h>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+void ServerStateExporter::initAndStart(const Json::Value &config)
+{
+    path_ = config.get("path", path_).asString();
+    token_ = config.get("token", "").asString();
+    allowRemote_ = config.get("allow_remote", allowRemote_).asBool();
+    if (token_.empty())
+    {
+        LOG_ERROR << "The ServerStateExporter plugin is disabled without a "
+                     "token";
+        return;
+    }
+    app().registerPreRoutingAdvice(
+        [this](const HttpRequestPtr &req,
+               AdviceCallback &&callback,
+               AdviceChainCallback &&chainCallback) {
+            handleRequest(req, std::move(callback), std::move(chainCallback));
+        });
+}
+
+void ServerStateExporter::shutdown()
+{
+}
+
+void ServerStateExporter::handleRequest(const HttpRequestPtr &req,
+                                        AdviceCallback &&callback,
+                                        AdviceChainCallback &&chainCallback)
+{
+    if (req->method() != Get || req->path() != path_)
+    {
+        chainCallback();
+        return;
+    }
+    if (!isAdminRequestAuthorized(req, token_, allowRemote_))
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setStatusCode(k401Unauthorized);
+        callback(resp);
+        return;
+    }
+    app().getServerState(
+        [callback = std::move(callback)](const ServerState &state) {
+            callback(HttpResponse::newHttpJsonResponse(toJson(state)));
+        });
+}
+
+Json::Value ServerStateExporter::toJson(const ServerState &state)
+{
+    Json::Value json;
+    json["connections"] = static_cast<Json::UInt64>(state.connections_);
+    json["sessions"] = static_cast<Json::UInt64>(state.sessions_);
+    json["io_loops"] = Json::Value(Json::arrayValue);
+    for (auto &loop : state.ioLoops_)
+    {
+        Json::Value item;
+        item["name"] = loop.name_;
+        item["connections"] = static_cast<Json::UInt64>(loop.connections_);
+        item["websocket_connections"] =
+            static_cast<Json::UInt64>(loop.webSocketConnections_);
+        item["pipelined_requests"] =
+            static_cast<Json::UInt64>(loop.pipelinedRequests_);
+        item["pipelined_responses"] =
+            static_cast<Json::UInt64>(loop.pipelinedResponses_);
+        item["max_pipeline_depth"] =
+            static_cast<Json::UInt64>(loop.maxPipelineDepth_);
+        item["cached_static_files"] =
+            static_cast<Json::UInt64>(loop.cachedStaticFiles_);
+        json["io_loops"].append(item);
+    }
+    json["db_clients"] = Json::Value(Json::arrayValue);
+    for (auto &client : state.dbClients_)
+    {
+        Json::Value item;
+        item["name"] = client.name_;
+        if (!client.loop_.empty())
+            item["loop"] = client.loop_;
+        item["connections"] = static_cast<Json::UInt64>(client.connections_);
+        item["busy_connections"] =
+            static_cast<Json::UInt64>(client.busyConnections_);
+        item["waiting_commands"] =
+            static_cast<Json::UInt64>(client.waitingCommands_);
+        item["waiting_transactions"] =
+            static_cast<Json::UInt64>(client.waitingTransactions_);
+        json["db_clients"].append(item);
+    }
+    return json;
+}
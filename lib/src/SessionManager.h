@@ -33,6 +33,10 @@ class SessionManager : public trantor::NonCopyable
         sessionMapPtr_.reset();
     }
     SessionPtr getSession(const std::string &sessionID, bool needToSet);
+    size_t sessionsNumber()
+    {
+        return sessionMapPtr_->size();
+    }
 
   private:
     std::unique_ptr<CacheMap<std::string, SessionPtr>> sessionMapPtr_;
@@ -14,13 +14,30 @@
 
 #include "SharedLibManager.h"
 #include <drogon/config.h>
+#include <drogon/DrClassMap.h>
+#include <drogon/DrTemplateBase.h>
+#include <trantor/net/inner/Channel.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <atomic>
 #include <dirent.h>
 #include <dlfcn.h>
-#include <fstream>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
-#include <trantor/utils/Logger.h>
+#include <sys/wait.h>
+#include <thread>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+extern char **environ;
+
 static void forEachFileIn(
     const std::string &path,
     const std::function<void(const std::string &, const struct stat &)> &cb)
@@ -65,95 +82,89 @@ static void forEachFileIn(
     return;
 }
 
-using namespace drogon;
-SharedLibManager::SharedLibManager(trantor::EventLoop *loop,
-                                   const std::vector<std::string> &libPaths)
-    : loop_(loop), libPaths_(libPaths)
+static bool isCspFile(const std::string &filename)
 {
-    timeId_ = loop_->runEvery(5.0, [=]() { managerLibs(); });
+    // Hidden files are usually temporary files of editors.
+    auto pos = filename.rfind('/');
+    auto namePos = pos == std::string::npos ? 0 : pos + 1;
+    return filename.length() > namePos + 4 && filename[namePos] != '.' &&
+           filename.compare(filename.length() - 4, 4, ".csp") == 0;
 }
-SharedLibManager::~SharedLibManager()
+
+/// Run a command by the shell, return true if it exits with 0.
+/**
+ * The system() function is not used because it changes the dispositions of
+ * signals of the whole process, which is not safe when several commands are
+ * run in parallel.
+ */
+static bool runCommand(const std::string &cmd)
 {
-    loop_->invalidateTimer(timeId_);
+    LOG_TRACE << cmd;
+    const char *argv[] = {"sh", "-c", cmd.c_str(), nullptr};
+    pid_t pid;
+    auto err = posix_spawn(
+        &pid, "/bin/sh", nullptr, nullptr, const_cast<char **>(argv), environ);
+    if (err != 0)
+    {
+        LOG_ERROR << "Can't run the command '" << cmd << "': " << strerror(err);
+        return false;
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) == -1)
+    {
+        if (errno != EINTR)
+        {
+            LOG_SYSERR << "waitpid";
+            return false;
+        }
+    }
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        return true;
+    LOG_ERROR << "The command '" << cmd << "' failed with status " << status;
+    return false;
 }
-void SharedLibManager::managerLibs()
+
+namespace
 {
-    for (auto const &libPath : libPaths_)
+/// The lock file prevents processes sharing a view directory from generating
+/// the source files of a view at the same time.
+class CompilationLock
+{
+  public:
+    explicit CompilationLock(std::string path) : path_(std::move(path))
     {
-        forEachFileIn(
-            libPath, [=](const std::string &filename, const struct stat &st) {
-                auto pos = filename.rfind('.');
-                if (pos != std::string::npos)
-                {
-                    auto exName = filename.substr(pos + 1);
-                    if (exName == "csp")
-                    {
-                        // compile
-                        auto lockFile = filename + ".lock";
-                        std::ifstream fin(lockFile);
-                        if (fin)
-                        {
-                            return;
-                        }
-
-                        void *oldHandle = nullptr;
-                        if (dlMap_.find(filename) != dlMap_.end())
-                        {
-#ifdef __linux__
-                            if (st.st_mtim.tv_sec >
-                                dlMap_[filename].mTime.tv_sec)
-#else
-                          if (st.st_mtimespec.tv_sec >
-                              dlMap_[filename].mTime.tv_sec)
-#endif
-                            {
-                                LOG_TRACE << "new csp file:" << filename;
-                                oldHandle = dlMap_[filename].handle;
-                            }
-                            else
-                                return;
-                        }
-
-                        {
-                            std::ofstream fout(lockFile);
-                        }
-                        std::string cmd = "drogon_ctl create view ";
-                        cmd.append(filename).append(" -o ").append(libPath);
-                        LOG_TRACE << cmd;
-                        auto r = system(cmd.c_str());
-                        // TODO: handle r
-                        (void)(r);
-                        auto srcFile = filename.substr(0, pos);
-                        srcFile.append(".cc");
-                        DLStat dlStat;
-                        dlStat.handle = loadLibs(srcFile, oldHandle);
-#ifdef __linux__
-                        dlStat.mTime = st.st_mtim;
-#else
-                        dlStat.mTime = st.st_mtimespec;
-#endif
-                        if (dlStat.handle)
-                        {
-                            dlMap_[filename] = dlStat;
-                        }
-                        else
-                        {
-                            dlStat.handle = dlMap_[filename].handle;
-                            dlMap_[filename] = dlStat;
-                        }
-                        loop_->runAfter(3.5, [=]() {
-                            LOG_TRACE << "remove file " << lockFile;
-                            if (unlink(lockFile.c_str()) == -1)
-                                perror("");
-                        });
-                    }
-                }
-            });
+        // Wait for at most 60 seconds, then the lock file is regarded as
+        // being left by a crashed process.
+        for (int i = 0; i < 600; ++i)
+        {
+            auto fd = open(path_.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0644);
+            if (fd >= 0)
+            {
+                close(fd);
+                return;
+            }
+            if (errno != EEXIST)
+            {
+                LOG_SYSERR << "Can't create the lock file " << path_;
+                return;
+            }
+            usleep(100 * 1000);
+        }
+        LOG_WARN << "Ignore the stale lock file " << path_;
     }
-}
-void *SharedLibManager::loadLibs(const std::string &sourceFile, void *oldHld)
+    ~CompilationLock()
+    {
+        unlink(path_.c_str());
+    }
+
+  private:
+    std::string path_;
+};
+}  // namespace
+
+static std::string compilationCommand(const std::string &sourceFile,
+                                      const std::string &soFile)
 {
-    LOG_TRACE << "src:" << sourceFile;
     std::string cmd = COMPILER_COMMAND;
     auto pos = cmd.rfind('/');
     if (pos != std::string::npos)
@@ -170,38 +181,240 @@ void *SharedLibManager::loadLibs(const std::string &sourceFile, void *oldHld)
         cmd.append(" -shared -fPIC -undefined dynamic_lookup -o ");
     else
         cmd.append(" -shared -fPIC --no-gnu-unique -o ");
-    pos = sourceFile.rfind('.');
-    auto soFile = sourceFile.substr(0, pos);
-    soFile.append(".so");
     cmd.append(soFile);
-    void *Handle = nullptr;
-    LOG_TRACE << cmd;
-    if (system(cmd.c_str()) == 0)
+    return cmd;
+}
+
+using namespace drogon;
+
+// The interval for the modifications of a file to settle before it's
+// compiled, editors often write a file several times when saving it.
+static const double debounceDelay = 0.2;
+
+SharedLibManager::SharedLibManager(trantor::EventLoop *loop,
+                                   const std::vector<std::string> &libPaths)
+    : loop_(loop),
+      libPaths_(libPaths),
+      compilers_(std::max(std::thread::hardware_concurrency(), 1u),
+                 "ViewCompiler")
+{
+    loop_->runInLoop([this]() {
+        // Watch the directories before the first scan, so no modification
+        // is missed between them.
+        auto watching = watchLibPaths();
+        scanLibPaths();
+        if (!watching)
+            timeId_ = loop_->runEvery(5.0, [this]() { scanLibPaths(); });
+    });
+}
+
+SharedLibManager::~SharedLibManager()
+{
+    if (timeId_)
+        loop_->invalidateTimer(timeId_);
+    for (auto &timer : debounceTimers_)
+        loop_->invalidateTimer(timer.second);
+    if (inotifyChannelPtr_)
     {
-        LOG_TRACE << "Compiled successfully";
-        if (oldHld)
+        inotifyChannelPtr_->disableAll();
+        inotifyChannelPtr_->remove();
+    }
+    if (inotifyFd_ >= 0)
+        close(inotifyFd_);
+}
+
+void SharedLibManager::scanLibPaths()
+{
+    for (auto const &libPath : libPaths_)
+    {
+        forEachFileIn(libPath,
+                      [this](const std::string &filename,
+                             const struct stat &st) {
+                          if (!isCspFile(filename))
+                              return;
+#ifdef __linux__
+                          auto mTime = st.st_mtim;
+#else
+                          auto mTime = st.st_mtimespec;
+#endif
+                          auto iter = mTimes_.find(filename);
+                          if (iter != mTimes_.end() &&
+                              iter->second.tv_sec == mTime.tv_sec &&
+                              iter->second.tv_nsec == mTime.tv_nsec)
+                              return;
+                          mTimes_[filename] = mTime;
+                          compileView(filename);
+                      });
+    }
+}
+
+bool SharedLibManager::watchLibPaths()
+{
+#ifdef __linux__
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0)
+    {
+        LOG_SYSERR << "inotify_init1, poll the view directories instead";
+        return false;
+    }
+    for (auto const &libPath : libPaths_)
+    {
+        auto wd = inotify_add_watch(inotifyFd_,
+                                    libPath.c_str(),
+                                    IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0)
         {
-            if (dlclose(oldHld) == 0)
-            {
-                LOG_TRACE << "close dynamic lib successfully:" << oldHld;
-            }
-            else
+            LOG_SYSERR << "Can't watch " << libPath
+                       << ", poll the view directories instead";
+            close(inotifyFd_);
+            inotifyFd_ = -1;
+            watchedPaths_.clear();
+            return false;
+        }
+        watchedPaths_[wd] = libPath;
+    }
+    inotifyChannelPtr_ = std::unique_ptr<trantor::Channel>(
+        new trantor::Channel(loop_, inotifyFd_));
+    inotifyChannelPtr_->setReadCallback([this]() { onInotifyEvents(); });
+    inotifyChannelPtr_->enableReading();
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SharedLibManager::onInotifyEvents()
+{
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;)
+    {
+        auto n = read(inotifyFd_, buffer, sizeof(buffer));
+        if (n <= 0)
+            return;
+        for (char *ptr = buffer; ptr < buffer + n;)
+        {
+            auto event = reinterpret_cast<const struct inotify_event *>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW)
             {
-                LOG_TRACE << dlerror();
+                LOG_WARN << "The inotify queue overflowed, rescan the view "
+                            "directories";
+                scanLibPaths();
+                continue;
             }
+            if (event->len == 0)
+                continue;
+            auto iter = watchedPaths_.find(event->wd);
+            if (iter == watchedPaths_.end())
+                continue;
+            std::string filename = iter->second;
+            filename.append("/").append(event->name);
+            if (isCspFile(filename))
+                scheduleCompilation(filename);
         }
+    }
+#endif
+}
 
-        // loading so file;
-        Handle = dlopen(soFile.c_str(), RTLD_LAZY);
-        if (!Handle)
+void SharedLibManager::scheduleCompilation(const std::string &cspFile)
+{
+    auto iter = debounceTimers_.find(cspFile);
+    if (iter != debounceTimers_.end())
+        loop_->invalidateTimer(iter->second);
+    debounceTimers_[cspFile] =
+        loop_->runAfter(debounceDelay, [this, cspFile]() {
+            debounceTimers_.erase(cspFile);
+            compileView(cspFile);
+        });
+}
+
+void SharedLibManager::compileView(const std::string &cspFile)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &status = viewStatus_[cspFile];
+        if (status.compiling)
         {
-            LOG_ERROR << "load " << soFile << " error!";
-            LOG_ERROR << dlerror();
+            // Compile it again when the current compilation is finished.
+            status.modified = true;
+            return;
+        }
+        status.compiling = true;
+    }
+    compilers_.runTaskInQueue([this, cspFile]() {
+        for (;;)
+        {
+            loadView(cspFile);
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto &status = viewStatus_[cspFile];
+            if (!status.modified)
+            {
+                status.compiling = false;
+                return;
+            }
+            status.modified = false;
         }
-        else
+    });
+}
+
+void SharedLibManager::loadView(const std::string &cspFile)
+{
+    LOG_TRACE << "new csp file:" << cspFile;
+    static std::atomic<uint64_t> sequence{0};
+    auto pos = cspFile.rfind('/');
+    auto libPath = cspFile.substr(0, pos);
+    auto className = cspFile.substr(pos + 1, cspFile.length() - pos - 5);
+    auto baseName = cspFile.substr(0, cspFile.length() - 4);
+    // Every library is compiled to a new file, otherwise dlopen() returns the
+    // old library which is still loaded.
+    auto soFile = baseName;
+    soFile.append(".")
+        .append(std::to_string(getpid()))
+        .append(".")
+        .append(std::to_string(++sequence))
+        .append(".so");
+    {
+        CompilationLock lock(cspFile + ".lock");
+        std::string cmd = "drogon_ctl create view ";
+        cmd.append(cspFile).append(" -o ").append(libPath);
+        if (!runCommand(cmd) ||
+            !runCommand(compilationCommand(baseName + ".cc", soFile)))
         {
-            LOG_TRACE << "Successfully loaded library file " << soFile;
+            unlink(soFile.c_str());
+            return;
         }
     }
-    return Handle;
+    LOG_TRACE << "Compiled successfully";
+
+    // The view registers its class when the library is loaded.
+    auto handle = dlopen(soFile.c_str(), RTLD_LAZY);
+    if (!handle)
+    {
+        LOG_ERROR << "load " << soFile << " error!";
+        LOG_ERROR << dlerror();
+        unlink(soFile.c_str());
+        return;
+    }
+    if (rename(soFile.c_str(), (baseName + ".so").c_str()) != 0)
+        unlink(soFile.c_str());
+    LOG_TRACE << "Successfully loaded library file " << soFile;
+
+    auto object = DrClassMap::newObject(className);
+    if (!dynamic_cast<DrTemplateBase *>(object))
+    {
+        // The library can't be unloaded, the class map may refer to it.
+        LOG_ERROR << "The library of " << cspFile << " has no view named "
+                  << className;
+        delete object;
+        return;
+    }
+    // The instance keeps the library loaded, so the renderings which got the
+    // old instance finish before its library is unloaded.
+    std::shared_ptr<void> library(handle, [](void *ptr) {
+        if (dlclose(ptr) != 0)
+            LOG_ERROR << dlerror();
+    });
+    DrClassMap::setSingleInstance(std::shared_ptr<DrObjectBase>(
+        object, [library](DrObjectBase *ptr) { delete ptr; }));
 }
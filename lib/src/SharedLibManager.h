@@ -15,11 +15,32 @@
 #pragma once
 
 #include <trantor/net/EventLoop.h>
+#include <trantor/utils/ConcurrentTaskQueue.h>
 #include <trantor/utils/NonCopyable.h>
+#include <sys/stat.h>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 #include <vector>
+
+namespace trantor
+{
+class Channel;
+}
 namespace drogon
 {
+/**
+ * @brief This class recompiles and reloads the views in the library paths
+ * when their csp files are modified.
+ *
+ * The modifications are watched by inotify on Linux (the directories are
+ * polled every 5 seconds on other systems). The modifications of a file are
+ * debounced, and the views are compiled in parallel in background threads.
+ * A new library is loaded beside the old one, and its view replaces the old
+ * view atomically, the old library is unloaded after the renderings using it
+ * are finished.
+ */
 class SharedLibManager : public trantor::NonCopyable
 {
   public:
@@ -28,16 +49,34 @@ class SharedLibManager : public trantor::NonCopyable
     ~SharedLibManager();
 
   private:
-    void managerLibs();
+    void scanLibPaths();
+    bool watchLibPaths();
+    void onInotifyEvents();
+    void scheduleCompilation(const std::string &cspFile);
+    void compileView(const std::string &cspFile);
+    void loadView(const std::string &cspFile);
+
     trantor::EventLoop *loop_;
     std::vector<std::string> libPaths_;
-    struct DLStat
+
+    // Accessed in the loop thread only.
+    std::unordered_map<std::string, struct timespec> mTimes_;
+    std::unordered_map<std::string, trantor::TimerId> debounceTimers_;
+    trantor::TimerId timeId_{0};
+    int inotifyFd_{-1};
+    std::unordered_map<int, std::string> watchedPaths_;
+    std::unique_ptr<trantor::Channel> inotifyChannelPtr_;
+
+    struct ViewStatus
     {
-        void *handle{nullptr};
-        struct timespec mTime = {0};
+        bool compiling{false};
+        bool modified{false};
     };
-    std::unordered_map<std::string, DLStat> dlMap_;
-    void *loadLibs(const std::string &sourceFile, void *oldHld);
-    trantor::TimerId timeId_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, ViewStatus> viewStatus_;
+
+    // Declared last so the compilations are finished before the other
+    // members are destroyed.
+    trantor::ConcurrentTaskQueue compilers_;
 };
 }  // namespace drogon
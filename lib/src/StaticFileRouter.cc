@@ -14,6 +14,7 @@
 
 #include "StaticFileRouter.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpMetrics.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
 
@@ -55,6 +56,12 @@ void StaticFileRouter::route(
         transform(filetype.begin(), filetype.end(), filetype.begin(), tolower);
         if (fileTypeSet_.find(filetype) != fileTypeSet_.end())
         {
+            auto &metrics = HttpMetrics::instance();
+            metrics.onRouted(HttpMetrics::kStaticFile,
+                             req->timings(),
+                             &metrics.staticFileStages());
+            // No filters for static files.
+            req->timings().handlerStart_ = req->timings().routed_;
             // LOG_INFO << "file query!" << path;
             std::string filePath =
                 HttpAppFrameworkImpl::instance().getDocumentRoot() + path;
@@ -192,6 +199,7 @@ void StaticFileRouter::route(
         }
     }
 
+    HttpMetrics::instance().onRouted(HttpMetrics::kNotFound, req->timings());
     callback(HttpResponse::newNotFoundResponse());
 }
 
@@ -43,6 +43,13 @@ class StaticFileRouter
         gzipStaticFlag_ = useGzipStatic;
     }
     void init(const std::vector<trantor::EventLoop *> &ioloops);
+    /// The number of the responses cached by the current IO loop, it must be
+    /// called in the loop.
+    size_t cachedFilesNumber() const
+    {
+        return staticFilesCache_ ? staticFilesCache_->getThreadData().size()
+                                 : 0;
+    }
     StaticFileRouter(
         const std::vector<std::pair<std::string, std::string>> &headers)
         : headers_(headers)
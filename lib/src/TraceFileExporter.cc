@@ -0,0 +1,139 @@
+/**
+ *
+ *  drogon_plugin_TraceFileExporter.cc
+ *
+ */
+#include <drogon/plugins/TraceFileExporter.h>
+#include <trantor/utils/Logger.h>
+#include <chrono>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+namespace
+{
+void appendEscaped(std::string &output, const std::string &text)
+{
+    for (auto ch : text)
+    {
+        switch (ch)
+        {
+            case '"':
+                output.append("\\\"");
+                break;
+            case '\\':
+                output.append("\\\\");
+                break;
+            case '\n':
+                output.append("\\n");
+                break;
+            case '\r':
+                output.append("\\r");
+                break;
+            case '\t':
+                output.append("\\t");
+                break;
+            default:
+                if ((unsigned char)ch < 0x20)
+                {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", ch);
+                    output.append(buf);
+                }
+                else
+                {
+                    output.push_back(ch);
+                }
+                break;
+        }
+    }
+}
+}  // namespace
+
+void TraceFileExporter::initAndStart(const Json::Value &config)
+{
+    path_ = config.get("path", path_).asString();
+    flushInterval_ = config.get("flush_interval", flushInterval_).asDouble();
+    Tracer::instance().setSampleRate(
+        config.get("sample_rate", 0.01).asDouble());
+    file_ = fopen(path_.c_str(), "a");
+    if (!file_)
+    {
+        LOG_ERROR << "Can't open the trace file " << path_;
+        return;
+    }
+    thread_ = std::thread([this]() { run(); });
+}
+
+void TraceFileExporter::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+    if (file_)
+    {
+        // Write the spans recorded while the thread was stopping.
+        writeSpans();
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void TraceFileExporter::run()
+{
+    auto interval = std::chrono::microseconds(
+        static_cast<int64_t>(flushInterval_ * 1000000));
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cond_.wait_for(lock, interval, [this]() { return stopping_; }))
+    {
+        lock.unlock();
+        writeSpans();
+        lock.lock();
+    }
+}
+
+void TraceFileExporter::writeSpans()
+{
+    auto &tracer = Tracer::instance();
+    std::string line;
+    // Drain in batches, so a burst of spans doesn't hold a huge vector.
+    while (tracer.drain(spans_, 4096) > 0)
+    {
+        for (auto &span : spans_)
+        {
+            char buf[192];
+            snprintf(buf,
+                     sizeof(buf),
+                     "{\"trace_id\":\"%016llx%016llx\",\"span_id\":\"%016llx\","
+                     "\"parent_id\":\"%016llx\",\"name\":\"%s\",\"detail\":\"",
+                     (unsigned long long)span.traceIdHigh_,
+                     (unsigned long long)span.traceIdLow_,
+                     (unsigned long long)span.spanId_,
+                     (unsigned long long)span.parentSpanId_,
+                     span.name_);
+            line.assign(buf);
+            appendEscaped(line, span.detail_);
+            snprintf(buf,
+                     sizeof(buf),
+                     "\",\"start\":%lld,\"duration\":%lld,\"status\":%d}\n",
+                     (long long)span.start_,
+                     (long long)span.duration_,
+                     span.status_);
+            line.append(buf);
+            fwrite(line.data(), 1, line.length(), file_);
+        }
+        spans_.clear();
+    }
+    fflush(file_);
+    auto dropped = tracer.droppedSpans();
+    if (dropped != reportedDrops_)
+    {
+        LOG_WARN << dropped - reportedDrops_
+                 << " spans were dropped because the ring buffers were full";
+        reportedDrops_ = dropped;
+    }
+}
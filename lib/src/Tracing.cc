@@ -0,0 +1,261 @@
+/**
+ *
+ *  Tracing.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/Tracing.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+
+using namespace drogon;
+
+namespace
+{
+bool parseHex(const char *text, size_t length, uint64_t &value)
+{
+    value = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        auto ch = text[i];
+        value <<= 4;
+        if (ch >= '0' && ch <= '9')
+            value |= ch - '0';
+        else if (ch >= 'a' && ch <= 'f')
+            value |= ch - 'a' + 10;
+        else
+            return false;
+    }
+    return true;
+}
+
+std::minstd_rand &generator()
+{
+    thread_local std::minstd_rand generator(std::random_device{}());
+    return generator;
+}
+}  // namespace
+
+bool TraceContext::parseTraceparent(const std::string &value)
+{
+    // version "-" trace-id "-" parent-id "-" trace-flags, the versions after
+    // 00 may append fields.
+    if (value.length() < 55 || value[2] != '-' || value[35] != '-' ||
+        value[52] != '-' || (value.length() > 55 && value[55] != '-'))
+        return false;
+    uint64_t version, flags;
+    TraceContext context;
+    if (!parseHex(value.data(), 2, version) || version == 0xff ||
+        (version == 0 && value.length() != 55) ||
+        !parseHex(value.data() + 3, 16, context.traceIdHigh_) ||
+        !parseHex(value.data() + 19, 16, context.traceIdLow_) ||
+        !parseHex(value.data() + 36, 16, context.parentSpanId_) ||
+        !parseHex(value.data() + 53, 2, flags) || !context.valid() ||
+        context.parentSpanId_ == 0)
+        return false;
+    context.sampled_ = (flags & 1) != 0;
+    *this = context;
+    return true;
+}
+
+std::string TraceContext::toTraceparent() const
+{
+    char buf[64];
+    auto len = snprintf(buf,
+                        sizeof(buf),
+                        "00-%016llx%016llx-%016llx-%s",
+                        (unsigned long long)traceIdHigh_,
+                        (unsigned long long)traceIdLow_,
+                        (unsigned long long)(spanId_ ? spanId_
+                                                     : parentSpanId_),
+                        sampled_ ? "01" : "00");
+    return std::string(buf, len);
+}
+
+/// A single-producer single-consumer ring buffer of the spans of a thread,
+/// the consumers are serialized by the mutex of the tracer.
+class Tracer::SpanRing : public trantor::NonCopyable
+{
+  public:
+    static constexpr size_t capacity = 1024;
+
+    bool push(SpanData &&span)
+    {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == capacity)
+            return false;
+        slots_[tail % capacity] = std::move(span);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    size_t pop(std::vector<SpanData> &spans, size_t maxNumber)
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+        auto tail = tail_.load(std::memory_order_acquire);
+        auto number = std::min<size_t>(tail - head, maxNumber);
+        for (size_t i = 0; i < number; ++i)
+            spans.push_back(std::move(slots_[(head + i) % capacity]));
+        head_.store(head + number, std::memory_order_release);
+        return number;
+    }
+    bool empty() const
+    {
+        return head_.load(std::memory_order_acquire) ==
+               tail_.load(std::memory_order_acquire);
+    }
+
+    // Set when the thread exits, the ring is removed after it's drained.
+    std::atomic<bool> orphaned_{false};
+
+  private:
+    SpanData slots_[capacity];
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+};
+
+Tracer &Tracer::instance()
+{
+    // Never destroyed, threads may record spans after the static objects are
+    // destroyed.
+    static auto &tracer = *new Tracer;
+    return tracer;
+}
+
+TraceContext &Tracer::currentContextRef()
+{
+    thread_local TraceContext context;
+    return context;
+}
+
+uint64_t Tracer::newId()
+{
+    uint64_t id;
+    do
+    {
+        id = ((uint64_t)generator()() << 33) ^ ((uint64_t)generator()() << 11) ^
+             generator()();
+    } while (id == 0);
+    return id;
+}
+
+int64_t Tracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+void Tracer::startTrace(const std::string &traceparent, TraceContext &context)
+{
+    if (!traceparent.empty() && context.parseTraceparent(traceparent))
+    {
+        // Follow the decision of the parent service, the context is
+        // propagated even if it's not sampled.
+        if (context.sampled_)
+            context.spanId_ = newId();
+        return;
+    }
+    context = TraceContext();
+    auto rate = sampleRate();
+    if (rate <= 0 ||
+        (rate < 1 &&
+         std::uniform_real_distribution<double>(0, 1)(generator()) >= rate))
+        return;
+    context.traceIdHigh_ = newId();
+    context.traceIdLow_ = newId();
+    context.spanId_ = newId();
+    context.sampled_ = true;
+}
+
+Tracer::SpanRing &Tracer::threadRing()
+{
+    struct ThreadRing
+    {
+        std::shared_ptr<SpanRing> ring_;
+        ~ThreadRing()
+        {
+            if (ring_)
+                ring_->orphaned_.store(true, std::memory_order_release);
+        }
+    };
+    thread_local ThreadRing threadRing;
+    if (!threadRing.ring_)
+    {
+        threadRing.ring_ = std::make_shared<SpanRing>();
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings_.push_back(threadRing.ring_);
+    }
+    return *threadRing.ring_;
+}
+
+void Tracer::record(SpanData &&span)
+{
+    if (!threadRing().push(std::move(span)))
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t Tracer::drain(std::vector<SpanData> &spans, size_t maxNumber)
+{
+    size_t number = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto iter = rings_.begin(); iter != rings_.end();)
+    {
+        auto &ring = **iter;
+        // Check it before draining, so the spans pushed before the thread
+        // exits are not lost.
+        auto orphaned = ring.orphaned_.load(std::memory_order_acquire);
+        number += ring.pop(spans, maxNumber - number);
+        if (orphaned && ring.empty())
+            iter = rings_.erase(iter);
+        else
+            ++iter;
+        if (number == maxNumber)
+            break;
+    }
+    return number;
+}
+
+TracedCall::TracedCall(const char *name, std::string detail)
+    : parent_(Tracer::currentContext()),
+      context_(parent_),
+      name_(name),
+      detail_(std::move(detail)),
+      start_(Tracer::now())
+{
+    if (context_.sampled_)
+    {
+        context_.parentSpanId_ = parent_.spanId_;
+        context_.spanId_ = Tracer::newId();
+    }
+}
+
+const TraceContext &TracedCall::finish(int status)
+{
+    if (context_.sampled_)
+    {
+        SpanData span;
+        span.traceIdHigh_ = context_.traceIdHigh_;
+        span.traceIdLow_ = context_.traceIdLow_;
+        span.spanId_ = context_.spanId_;
+        span.parentSpanId_ = context_.parentSpanId_;
+        span.name_ = name_;
+        span.detail_ = std::move(detail_);
+        span.start_ = start_;
+        span.duration_ = Tracer::now() - start_;
+        span.status_ = status;
+        Tracer::instance().record(std::move(span));
+        // Record once.
+        context_.sampled_ = false;
+    }
+    return parent_;
+}
@@ -0,0 +1,136 @@
+/**
+ *
+ *  ViewFragmentCache.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/ViewFragmentCache.h>
+
+using namespace drogon;
+
+constexpr size_t ViewFragmentCache::shardsNumber;
+
+ViewFragmentCache &ViewFragmentCache::instance()
+{
+    static ViewFragmentCache cache;
+    return cache;
+}
+
+void ViewFragmentCache::erase(Shard &shard, std::list<Entry>::iterator iter)
+{
+    shard.size_ -= iter->cost();
+    shard.index_.erase(iter->key_);
+    shard.entries_.erase(iter);
+}
+
+std::shared_ptr<const std::string> ViewFragmentCache::get(
+    const std::string &key)
+{
+    auto &shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    auto iter = shard.index_.find(key);
+    if (iter == shard.index_.end())
+        return nullptr;
+    auto entry = iter->second;
+    if (entry->expires_ && entry->expiry_ <= Clock::now())
+    {
+        erase(shard, entry);
+        return nullptr;
+    }
+    shard.entries_.splice(shard.entries_.begin(), shard.entries_, entry);
+    return entry->fragment_;
+}
+
+std::shared_ptr<const std::string> ViewFragmentCache::put(
+    const std::string &key,
+    std::string &&fragment,
+    double timeout)
+{
+    auto fragmentPtr = std::make_shared<const std::string>(std::move(fragment));
+    Entry entry{key, fragmentPtr, Clock::time_point(), timeout > 0};
+    if (entry.expires_)
+        entry.expiry_ =
+            Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                               std::chrono::duration<double>(timeout));
+    auto cost = entry.cost();
+    auto capacity = shardCapacity_.load(std::memory_order_relaxed);
+    auto &shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    auto iter = shard.index_.find(key);
+    if (iter != shard.index_.end())
+        erase(shard, iter->second);
+    if (cost > capacity)
+        return fragmentPtr;
+    while (shard.size_ + cost > capacity)
+        erase(shard, std::prev(shard.entries_.end()));
+    shard.entries_.push_front(std::move(entry));
+    shard.index_.emplace(key, shard.entries_.begin());
+    shard.size_ += cost;
+    return fragmentPtr;
+}
+
+void ViewFragmentCache::invalidate(const std::string &key)
+{
+    auto &shard = shardOf(key);
+    std::lock_guard<std::mutex> lock(shard.mutex_);
+    auto iter = shard.index_.find(key);
+    if (iter != shard.index_.end())
+        erase(shard, iter->second);
+}
+
+void ViewFragmentCache::invalidatePrefix(const std::string &prefix)
+{
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        for (auto iter = shard.entries_.begin(); iter != shard.entries_.end();)
+        {
+            auto next = std::next(iter);
+            if (iter->key_.compare(0, prefix.length(), prefix) == 0)
+                erase(shard, iter);
+            iter = next;
+        }
+    }
+}
+
+void ViewFragmentCache::clear()
+{
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        shard.entries_.clear();
+        shard.index_.clear();
+        shard.size_ = 0;
+    }
+}
+
+void ViewFragmentCache::setCapacity(size_t capacity)
+{
+    auto shardCapacity = capacity / shardsNumber;
+    shardCapacity_.store(shardCapacity, std::memory_order_relaxed);
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        while (shard.size_ > shardCapacity)
+            erase(shard, std::prev(shard.entries_.end()));
+    }
+}
+
+size_t ViewFragmentCache::size() const
+{
+    size_t size = 0;
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        size += shard.size_;
+    }
+    return size;
+}
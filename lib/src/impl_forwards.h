@@ -26,6 +26,8 @@ using HttpResponseImplPtr = std::shared_ptr<HttpResponseImpl>;
 class WebSocketConnectionImpl;
 using WebSocketConnectionImplPtr = std::shared_ptr<WebSocketConnectionImpl>;
 class HttpRequestParser;
+struct PendingResponse;
+class RouteStageMetrics;
 class StaticFileRouter;
 class HttpControllersRouter;
 class WebsocketControllersRouter;
@@ -33,6 +35,8 @@ class HttpSimpleControllersRouter;
 class PluginsManager;
 class ListenerManager;
 class SharedLibManager;
+class EventLoopMonitor;
+class HotRestart;
 class SessionManager;
 class HttpServer;
 
@@ -1,5 +1,56 @@
 #include <drogon/HttpViewData.h>
+#include <chrono>
 #include <iostream>
+
+// The per-character implementation, which is used as a baseline of the
+// benchmark.
+static std::string htmlTranslateByChar(const char *str, size_t length)
+{
+    std::string ret;
+    ret.reserve(length + 64);
+    auto end = str + length;
+    while (str != end)
+    {
+        switch (*str)
+        {
+            case '"':
+                ret.append("&quot;", 6);
+                break;
+            case '&':
+                ret.append("&amp;", 5);
+                break;
+            case '\'':
+                ret.append("&#39;", 5);
+                break;
+            case '<':
+                ret.append("&lt;", 4);
+                break;
+            case '>':
+                ret.append("&gt;", 4);
+                break;
+            default:
+                ret.push_back(*str);
+                break;
+        }
+        ++str;
+    }
+    return ret;
+}
+
+template <typename Function>
+static double benchmark(Function &&function)
+{
+    const int times = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < times; ++i)
+        function();
+    auto end = std::chrono::steady_clock::now();
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               end - start)
+               .count() /
+           times;
+}
+
 int main()
 {
     drogon::HttpViewData data;
@@ -11,4 +62,48 @@ int main()
               << std::endl;
     std::cout << (data.insertAsString("4", "4"), data.get<std::string>("4"))
               << std::endl;
+
+    std::string clean;
+    std::string dirty;
+    for (int i = 0; i < 64; ++i)
+    {
+        clean.append("The quick brown fox jumps over the lazy dog. ");
+        dirty.append("<a href=\"/fox?q=1&r=2\">It's a fox</a> and a dog. ");
+    }
+    for (auto const &str : {clean, dirty})
+    {
+        if (drogon::HttpViewData::htmlTranslate(str) !=
+            htmlTranslateByChar(str.data(), str.length()))
+        {
+            std::cout << "Bad translation!" << std::endl;
+            return 1;
+        }
+    }
+    std::string buffer;
+    drogon::string_view view(clean.data(), clean.length());
+    if (drogon::HttpViewData::htmlTranslate(view, buffer).data() !=
+        clean.data())
+    {
+        std::cout << "A clean string is copied!" << std::endl;
+        return 1;
+    }
+    for (auto const *str : {&clean, &dirty})
+    {
+        size_t total = 0;
+        std::cout << (str == &clean ? "clean" : "dirty") << " string ("
+                  << str->length() << " bytes):" << std::endl;
+        std::cout << "  per character: " << benchmark([&]() {
+            total += htmlTranslateByChar(str->data(), str->length()).length();
+        }) << "ns" << std::endl;
+        std::cout << "  htmlTranslate: " << benchmark([&]() {
+            total += drogon::HttpViewData::htmlTranslate(*str).length();
+        }) << "ns" << std::endl;
+        std::cout << "  no copy:       " << benchmark([&]() {
+            drogon::string_view view(str->data(), str->length());
+            total +=
+                drogon::HttpViewData::htmlTranslate(view, buffer).length();
+        }) << "ns" << std::endl;
+        if (total == 0)
+            return 1;
+    }
 }
@@ -20,6 +20,8 @@
 #include <drogon/orm/Row.h>
 #include <drogon/orm/RowIterator.h>
 #include <drogon/orm/SqlBinder.h>
+#include <drogon/orm/SqlMetrics.h>
+#include <drogon/utils/coroutine.h>
 #include <exception>
 #include <functional>
 #include <future>
@@ -35,6 +37,8 @@ using ResultCallback = std::function<void(const Result &)>;
 using ExceptionCallback = std::function<void(const DrogonDbException &)>;
 
 class Transaction;
+class QueryResultCache;
+class SqlMetricsCollector;
 
 /// Database client abstract class
 class DbClient : public trantor::NonCopyable
@@ -148,6 +152,35 @@ class DbClient : public trantor::NonCopyable
         return r;
     }
 
+#ifdef __cpp_impl_coroutine
+    /// Coroutine interface, co_await the returned object to get the result.
+    /**
+     * The arguments are copied into the returned object and the sql is sent
+     * when the object is awaited. An exception of the query is rethrown by
+     * co_await, and the awaiting coroutine is resumed in the event loop of the
+     * thread which awaited it. For example:
+     * @code
+       auto users =
+           co_await client->execSqlCoro("select * from users where id=$1", id);
+       @endcode
+     */
+    template <typename... Arguments>
+    auto execSqlCoro(const std::string &sql, Arguments &&... args) noexcept
+    {
+        return drogon::internal::makeCallbackAwaiter<Result>(
+            [this, sql, ... args = std::forward<Arguments>(args)](
+                CallbackAwaiter<Result> &awaiter) mutable {
+                execSqlAsync(
+                    sql,
+                    [&awaiter](const Result &r) { awaiter.setValue(r); },
+                    [&awaiter](const std::exception_ptr &e) {
+                        awaiter.setException(e);
+                    },
+                    std::move(args)...);
+            });
+    }
+#endif
+
     /// Streaming-like method for sql execution. For more information, see the
     /// wiki page.
     internal::SqlBinder operator<<(const std::string &sql);
@@ -173,6 +206,89 @@ class DbClient : public trantor::NonCopyable
         const std::function<void(const std::shared_ptr<Transaction> &)>
             &callback) = 0;
 
+#ifdef __cpp_impl_coroutine
+    /// Create a transaction object in a coroutine.
+    auto newTransactionCoro()
+    {
+        return drogon::internal::makeCallbackAwaiter<
+            std::shared_ptr<Transaction>>(
+            [this](CallbackAwaiter<std::shared_ptr<Transaction>> &awaiter) {
+                newTransactionAsync(
+                    [&awaiter](const std::shared_ptr<Transaction> &trans) {
+                        awaiter.setValue(trans);
+                    });
+            });
+    }
+#endif
+
+    /// Let the connection pool of the client grow and shrink with the load.
+    /**
+     * @param maxConnNum: The maximum number of connections. The number of
+     * connections given when the client is created is the minimum number.
+     * @param maxQueueWaitTime: A new connection is opened when the oldest
+     * pending command has waited in the queue longer than this number of
+     * seconds.
+     * @param idleTimeout: Connections above the minimum number are closed after
+     * staying idle for this number of seconds.
+     *
+     * @note Only the PostgreSQL and Mysql clients which are not in the fast
+     * mode support this feature.
+     */
+    virtual void enablePoolAutoScaling(size_t maxConnNum,
+                                       double maxQueueWaitTime = 0.1,
+                                       double idleTimeout = 60.0);
+
+    /// Ping idle connections every interval seconds, so that broken
+    /// connections are found and replaced before queries are sent to them.
+    /**
+     * @note Only the PostgreSQL and Mysql clients which are not in the fast
+     * mode support this feature.
+     */
+    virtual void enableKeepalive(double interval);
+
+    /// Block the current thread until all initial connections of the client
+    /// are established or the timeout (in seconds) expires.
+    /**
+     * @return false if the timeout expires.
+     */
+    virtual bool waitForConnections(double timeout);
+
+    /// Enable the result cache of the client.
+    /**
+     * @param maxMemorySize: The maximum memory size in bytes used by the cached
+     * results, the least recently used results are dropped when it's exceeded.
+     *
+     * @note Only the queries marked with the CacheQuery object are cached, and
+     * the results are shared by all threads using this client. This method
+     * should be called before any query is executed by the client.
+     */
+    void enableResultCache(size_t maxMemorySize = 64 * 1024 * 1024);
+
+    /// Drop all cached results that are tagged with any of the tables.
+    /**
+     * This method is called automatically when a query marked with the
+     * InvalidateCache object is executed.
+     */
+    virtual void invalidateResultCache(const std::vector<std::string> &tables);
+
+    /// Drop all cached results.
+    void clearResultCache();
+
+    /// Enable the collection of the latencies of sql commands.
+    /**
+     * @param slowQueryThreshold: If it's greater than 0, the sql commands which
+     * take longer than this number of seconds to execute are logged with the
+     * WARN level.
+     *
+     * @note This method should be called before any query is executed by the
+     * client. The commands executed in transactions are not counted.
+     */
+    void enableMetrics(double slowQueryThreshold = 0.0);
+
+    /// Get a snapshot of the metrics, all values are zero if the metrics are
+    /// not enabled.
+    DbClientMetrics getMetrics() const;
+
     ClientType type() const
     {
         return type_;
@@ -192,10 +308,15 @@ class DbClient : public trantor::NonCopyable
         std::vector<int> &&format,
         ResultCallback &&rcb,
         std::function<void(const std::exception_ptr &)> &&exceptCallback) = 0;
+    /// Run a task in a loop of the client, the callbacks of the cached results
+    /// are called in it like the ones of the queries.
+    virtual void queueInLoop(std::function<void()> &&task);
 
   protected:
     ClientType type_;
     std::string connectionInfo_;
+    std::shared_ptr<QueryResultCache> resultCache_;
+    std::shared_ptr<SqlMetricsCollector> metrics_;
 };
 using DbClientPtr = std::shared_ptr<DbClient>;
 
@@ -123,6 +123,16 @@ class BrokenConnection : public Failure
     explicit BrokenConnection(const std::string &);
 };
 
+/// The command is dropped without being executed because the request it's
+/// issued for is cancelled, see drogon::CancellationToken.
+class CommandCancelled : public Failure
+{
+  public:
+    explicit CommandCancelled(const std::string &err) : Failure(err)
+    {
+    }
+};
+
 /// Exception class for failed queries.
 /** Carries, in addition to a regular error message, a copy of the failed query
  * and (if available) the SQLSTATE value accompanying the error.
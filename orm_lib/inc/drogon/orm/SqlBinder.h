@@ -60,6 +60,40 @@ enum class Mode
     NonBlocking,
     Blocking
 };
+
+/// Mark a query as cacheable by the result cache of the client.
+/**
+ * The result is kept for ttl seconds and is dropped when any of the tables is
+ * invalidated. This marker has no effect if the result cache of the client is
+ * not enabled or the query is executed in a transaction. For example:
+ * @code
+ *   *clientPtr << "select * from countries where region=$1"
+ *              << CacheQuery({"countries"}, 300) << region
+ *              >> [](const Result &r) {...}
+ *              >> [](const DrogonDbException &e) {...};
+ * @endcode
+ */
+struct CacheQuery
+{
+    CacheQuery(std::vector<std::string> tables, double ttl = 60.0)
+        : tables_(std::move(tables)), ttl_(ttl)
+    {
+    }
+    std::vector<std::string> tables_;
+    double ttl_;
+};
+
+/// Mark a query as a write to the tables, all cached results tagged with the
+/// tables are dropped after the query succeeds. If the query is executed in a
+/// transaction, they are dropped again after the transaction is committed.
+struct InvalidateCache
+{
+    InvalidateCache(std::vector<std::string> tables)
+        : tables_(std::move(tables))
+    {
+    }
+    std::vector<std::string> tables_;
+};
 namespace internal
 {
 template <typename T>
@@ -380,11 +414,45 @@ class SqlBinder
         mode_ = mode;
         return *this;
     }
+    self &operator<<(const CacheQuery &cache)
+    {
+        cacheTables_ = cache.tables_;
+        cacheTtl_ = cache.ttl_;
+        return *this;
+    }
+    self &operator<<(CacheQuery &cache)
+    {
+        return operator<<((const CacheQuery &)cache);
+    }
+    self &operator<<(CacheQuery &&cache)
+    {
+        cacheTables_ = std::move(cache.tables_);
+        cacheTtl_ = cache.ttl_;
+        return *this;
+    }
+    self &operator<<(const InvalidateCache &invalidation)
+    {
+        invalidatedTables_ = invalidation.tables_;
+        return *this;
+    }
+    self &operator<<(InvalidateCache &invalidation)
+    {
+        return operator<<((const InvalidateCache &)invalidation);
+    }
+    self &operator<<(InvalidateCache &&invalidation)
+    {
+        invalidatedTables_ = std::move(invalidation.tables_);
+        return *this;
+    }
 
     void exec() noexcept(false);
 
   private:
     int getMysqlTypeBySize(size_t size);
+    size_t getFixedParameterLength(int format) const;
+    std::string resultCacheKey() const;
+    bool findCachedResult(Result &result);
+    QueryCallback wrapResultCacheCallback(QueryCallback &&callback);
     std::string sql_;
     DbClient &client_;
     size_t parametersNumber_{0};
@@ -400,6 +468,11 @@ class SqlBinder
     bool destructed_{false};
     bool isExceptionPtr_{false};
     ClientType type_;
+    std::vector<std::string> cacheTables_;
+    double cacheTtl_{0.0};
+    std::string cacheKey_;
+    uint64_t cacheEpoch_{0};
+    std::vector<std::string> invalidatedTables_;
 };
 
 }  // namespace internal
@@ -0,0 +1,55 @@
+/**
+ *
+ *  SqlMetrics.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/utils/LatencyHistogram.h>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+namespace orm
+{
+/// Latencies of sql commands, all in seconds.
+/**
+ * - queueTime_: The time a command waits for a free connection.
+ * - executionTime_: The time from sending a command to the database server to
+ * receiving its result.
+ * - callbackTime_: The time spent in the result callback, including the
+ * conversion of rows to the types of the callback parameters.
+ */
+struct SqlLatencies
+{
+    LatencySummary queueTime_;
+    LatencySummary executionTime_;
+    LatencySummary callbackTime_;
+    uint64_t errors_{0};
+};
+
+/// A snapshot of the metrics of a database client.
+struct DbClientMetrics
+{
+    /// The number of commands being executed on connections.
+    size_t inFlight_{0};
+    /// The number of commands waiting for a free connection.
+    size_t pending_{0};
+    /// Latencies of all commands.
+    SqlLatencies total_;
+    /// Latencies of each sql statement, i.e. sql text with placeholders.
+    std::vector<std::pair<std::string, SqlLatencies>> statements_;
+};
+
+}  // namespace orm
+}  // namespace drogon
@@ -13,6 +13,8 @@
  */
 
 #include "DbClientImpl.h"
+#include "QueryResultCache.h"
+#include "SqlMetricsCollector.h"
 #include <drogon/config.h>
 #include <drogon/orm/DbClient.h>
 using namespace drogon::orm;
@@ -65,3 +67,53 @@ std::shared_ptr<DbClient> DbClient::newSqlite3Client(
     exit(1);
 #endif
 }
+
+void DbClient::enableResultCache(size_t maxMemorySize)
+{
+    resultCache_ = std::make_shared<QueryResultCache>(maxMemorySize);
+}
+
+void DbClient::invalidateResultCache(const std::vector<std::string> &tables)
+{
+    if (resultCache_)
+        resultCache_->invalidate(tables);
+}
+
+void DbClient::clearResultCache()
+{
+    if (resultCache_)
+        resultCache_->clear();
+}
+
+void DbClient::enableMetrics(double slowQueryThreshold)
+{
+    metrics_ = std::make_shared<SqlMetricsCollector>(slowQueryThreshold);
+}
+
+DbClientMetrics DbClient::getMetrics() const
+{
+    if (metrics_)
+        return metrics_->metrics();
+    return DbClientMetrics();
+}
+
+void DbClient::enablePoolAutoScaling(size_t, double, double)
+{
+    LOG_WARN << "The connection pool auto-scaling is not supported by this "
+                "client";
+}
+
+void DbClient::enableKeepalive(double)
+{
+    LOG_WARN << "The keepalive is not supported by this client";
+}
+
+void DbClient::queueInLoop(std::function<void()> &&task)
+{
+    task();
+}
+
+bool DbClient::waitForConnections(double)
+{
+    return true;
+}
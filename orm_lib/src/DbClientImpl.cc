@@ -14,6 +14,9 @@
 
 #include "DbClientImpl.h"
 #include "DbConnection.h"
+#include "SqlCancellation.h"
+#include "SqlMetricsCollector.h"
+#include "SqlTracing.h"
 #include <drogon/config.h>
 #if USE_POSTGRESQL
 #include "postgresql_impl/PgConnection.h"
@@ -51,7 +54,8 @@ DbClientImpl::DbClientImpl(const std::string &connInfo,
                  : (connNum < std::thread::hardware_concurrency()
                         ? connNum
                         : std::thread::hardware_concurrency()),
-             "DbLoop")
+             "DbLoop"),
+      maxConnectionsNumber_(connNum)
 {
     type_ = type;
     connectionInfo_ = connInfo;
@@ -102,6 +106,10 @@ DbClientImpl::DbClientImpl(const std::string &connInfo,
 
 DbClientImpl::~DbClientImpl() noexcept
 {
+    if (poolTimerLoop_)
+    {
+        poolTimerLoop_->invalidateTimer(poolTimerId_);
+    }
     std::lock_guard<std::mutex> lock(connectionsMutex_);
     for (auto const &conn : connections_)
     {
@@ -155,6 +163,10 @@ void DbClientImpl::execSql(
     assert(paraNum == length.size());
     assert(paraNum == format.size());
     assert(rcb);
+    traceSqlCommand(sql, rcb, exceptCallback);
+    CancellationTokenPtr cancellationToken;
+    if (!bindSqlCommand(cancellationToken, rcb, exceptCallback))
+        return;
     DbConnectionPtr conn;
     bool busy = false;
     {
@@ -190,19 +202,28 @@ void DbClientImpl::execSql(
                                              std::move(format),
                                              std::move(rcb),
                                              std::move(exceptCallback));
+                cmd->cancellationToken_ = std::move(cancellationToken);
                 sqlCmdBuffer_.push_back(std::move(cmd));
+                if (metrics_)
+                    metrics_->commandQueued();
             }
         }
         else
         {
             auto iter = readyConnections_.begin();
-            busyConnections_.insert(*iter);
-            conn = *iter;
+            busyConnections_.insert(iter->first);
+            conn = iter->first;
             readyConnections_.erase(iter);
         }
     }
     if (conn)
     {
+        if (metrics_)
+            metrics_->instrument(sql,
+                                 SqlMetricsCollector::Clock::now(),
+                                 false,
+                                 rcb,
+                                 exceptCallback);
         execSql(conn,
                 std::move(sql),
                 paraNum,
@@ -235,8 +256,8 @@ void DbClientImpl::newTransactionAsync(
         if (!readyConnections_.empty())
         {
             auto iter = readyConnections_.begin();
-            busyConnections_.insert(*iter);
-            conn = *iter;
+            busyConnections_.insert(iter->first);
+            conn = iter->first;
             readyConnections_.erase(iter);
         }
         else
@@ -293,6 +314,7 @@ void DbClientImpl::makeTrans(
                 thisPtr->handleNewTask(conn);
             });
         }));
+    trans->clientResultCache_ = resultCache_;
     trans->doBegin();
     conn->loop()->queueInLoop(
         [callback = std::move(callback), trans]() { callback(trans); });
@@ -314,6 +336,7 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
 {
     std::function<void(const std::shared_ptr<Transaction> &)> transCallback;
     std::shared_ptr<SqlCmd> cmd;
+    std::vector<std::shared_ptr<SqlCmd>> cancelledCmds;
     {
         std::lock_guard<std::mutex> guard(connectionsMutex_);
         if (!transCallbacks_.empty())
@@ -321,18 +344,35 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
             transCallback = std::move(transCallbacks_.front());
             transCallbacks_.pop();
         }
-        else if (!sqlCmdBuffer_.empty())
-        {
-            cmd = std::move(sqlCmdBuffer_.front());
-            sqlCmdBuffer_.pop_front();
-        }
         else
         {
-            // Connection is idle, put it into the readyConnections_ set;
-            busyConnections_.erase(connPtr);
-            readyConnections_.insert(connPtr);
+            // Drop the commands of the cancelled requests.
+            while (!sqlCmdBuffer_.empty() &&
+                   sqlCmdBuffer_.front()->cancellationToken_ &&
+                   sqlCmdBuffer_.front()->cancellationToken_->isCancelled())
+            {
+                cancelledCmds.push_back(std::move(sqlCmdBuffer_.front()));
+                sqlCmdBuffer_.pop_front();
+            }
+            if (!sqlCmdBuffer_.empty())
+            {
+                cmd = std::move(sqlCmdBuffer_.front());
+                sqlCmdBuffer_.pop_front();
+            }
+            else
+            {
+                // Connection is idle, put it into the readyConnections_ set;
+                busyConnections_.erase(connPtr);
+                readyConnections_[connPtr] = Clock::now();
+            }
         }
     }
+    for (auto &cancelledCmd : cancelledCmds)
+    {
+        if (metrics_)
+            metrics_->commandDropped();
+        cancelSqlCommand(cancelledCmd->exceptionCallback_);
+    }
     if (transCallback)
     {
         makeTrans(connPtr, std::move(transCallback));
@@ -340,6 +380,12 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
     }
     if (cmd)
     {
+        if (metrics_)
+            metrics_->instrument(cmd->sql_,
+                                 cmd->enqueueTime_,
+                                 true,
+                                 cmd->callback_,
+                                 cmd->exceptionCallback_);
         execSql(connPtr,
                 std::move(cmd->sql_),
                 cmd->parametersNumber_,
@@ -420,6 +466,7 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
             thisPtr->busyConnections_.insert(
                 okConnPtr);  // For new connections, this sentence is necessary
         }
+        thisPtr->connectionsCond_.notify_all();
         thisPtr->handleNewTask(okConnPtr);
     });
     std::weak_ptr<DbConnection> weakConn = connPtr;
@@ -435,3 +482,173 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
     // std::cout<<"newConn end"<<connPtr<<std::endl;
     return connPtr;
 }
+
+void DbClientImpl::enablePoolAutoScaling(size_t maxConnNum,
+                                         double maxQueueWaitTime,
+                                         double idleTimeout)
+{
+    if (type_ == ClientType::Sqlite3)
+    {
+        DbClient::enablePoolAutoScaling(maxConnNum,
+                                        maxQueueWaitTime,
+                                        idleTimeout);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        maxConnectionsNumber_ =
+            maxConnNum > connectionsNumber_ ? maxConnNum : connectionsNumber_;
+        maxQueueWaitTime_ = maxQueueWaitTime;
+        idleTimeout_ = idleTimeout;
+    }
+    startPoolTimer();
+}
+
+void DbClientImpl::enableKeepalive(double interval)
+{
+    if (type_ == ClientType::Sqlite3)
+    {
+        DbClient::enableKeepalive(interval);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        keepaliveInterval_ = interval;
+    }
+    startPoolTimer();
+}
+
+bool DbClientImpl::waitForConnections(double timeout)
+{
+    std::unique_lock<std::mutex> lock(connectionsMutex_);
+    return connectionsCond_.wait_for(
+        lock, std::chrono::duration<double>(timeout), [this]() {
+            return readyConnections_.size() + busyConnections_.size() >=
+                   connectionsNumber_;
+        });
+}
+
+drogon::DbClientState DbClientImpl::state()
+{
+    DbClientState state;
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    state.connections_ = connections_.size();
+    state.busyConnections_ = busyConnections_.size();
+    state.waitingCommands_ = sqlCmdBuffer_.size();
+    state.waitingTransactions_ = transCallbacks_.size();
+    return state;
+}
+
+void DbClientImpl::startPoolTimer()
+{
+    // The timer runs at least once a second, more frequently if the queue
+    // wait limit or the keepalive interval is shorter.
+    double interval = 1.0;
+    {
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        if (maxConnectionsNumber_ > connectionsNumber_ &&
+            maxQueueWaitTime_ / 2 < interval)
+            interval = maxQueueWaitTime_ / 2;
+        if (keepaliveInterval_ > 0 && keepaliveInterval_ / 2 < interval)
+            interval = keepaliveInterval_ / 2;
+    }
+    if (interval < 0.01)
+        interval = 0.01;
+    if (poolTimerLoop_)
+    {
+        poolTimerLoop_->invalidateTimer(poolTimerId_);
+    }
+    else
+    {
+        poolTimerLoop_ = loops_.getNextLoop();
+    }
+    std::weak_ptr<DbClientImpl> weakPtr = shared_from_this();
+    poolTimerId_ = poolTimerLoop_->runEvery(interval, [weakPtr]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        thisPtr->maintainPool();
+    });
+}
+
+void DbClientImpl::maintainPool()
+{
+    auto now = Clock::now();
+    std::vector<DbConnectionPtr> idleConnections;
+    std::vector<DbConnectionPtr> pingConnections;
+    bool needNewConnection = false;
+    {
+        std::lock_guard<std::mutex> guard(connectionsMutex_);
+        // Grow the pool when commands have waited too long and no connection
+        // is being established.
+        if (connections_.size() < maxConnectionsNumber_ &&
+            connections_.size() ==
+                readyConnections_.size() + busyConnections_.size())
+        {
+            if (!transCallbacks_.empty() ||
+                (!sqlCmdBuffer_.empty() &&
+                 std::chrono::duration<double>(
+                     now - sqlCmdBuffer_.front()->enqueueTime_)
+                         .count() > maxQueueWaitTime_))
+            {
+                needNewConnection = true;
+            }
+        }
+        for (auto iter = readyConnections_.begin();
+             iter != readyConnections_.end();)
+        {
+            auto idleTime =
+                std::chrono::duration<double>(now - iter->second).count();
+            if (connections_.size() > connectionsNumber_ &&
+                idleTime > idleTimeout_)
+            {
+                // Shrink the pool.
+                idleConnections.push_back(iter->first);
+                connections_.erase(iter->first);
+                iter = readyConnections_.erase(iter);
+            }
+            else if (keepaliveInterval_ > 0 && idleTime > keepaliveInterval_)
+            {
+                busyConnections_.insert(iter->first);
+                pingConnections.push_back(iter->first);
+                iter = readyConnections_.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+    for (auto &conn : idleConnections)
+    {
+        LOG_TRACE << "Close an idle connection";
+        conn->loop()->queueInLoop([conn]() {
+            conn->setCloseCallback([](const DbConnectionPtr &) {});
+            conn->disconnect();
+        });
+    }
+    for (auto &conn : pingConnections)
+    {
+        // A broken connection is closed and reconnected by its close callback,
+        // a live one becomes idle again after the ping.
+        execSql(conn,
+                "select 1",
+                0,
+                std::vector<const char *>(),
+                std::vector<int>(),
+                std::vector<int>(),
+                [](const Result &) {},
+                [](const std::exception_ptr &) {
+                    LOG_WARN << "Database connection keepalive failed";
+                });
+    }
+    if (needNewConnection)
+    {
+        LOG_TRACE << "Open a new connection for pending commands";
+        auto loop = loops_.getNextLoop();
+        loop->runInLoop([thisPtr = shared_from_this(), loop]() {
+            std::lock_guard<std::mutex> lock(thisPtr->connectionsMutex_);
+            thisPtr->connections_.insert(thisPtr->newConnection(loop));
+        });
+    }
+}
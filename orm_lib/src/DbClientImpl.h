@@ -16,12 +16,16 @@
 
 #include "DbConnection.h"
 #include <drogon/orm/DbClient.h>
+#include <drogon/utils/ServerState.h>
 #include <trantor/net/EventLoopThreadPool.h>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <list>
 #include <memory>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace drogon
@@ -49,12 +53,41 @@ class DbClientImpl : public DbClient,
     virtual void newTransactionAsync(
         const std::function<void(const std::shared_ptr<Transaction> &)>
             &callback) override;
+    virtual void enablePoolAutoScaling(size_t maxConnNum,
+                                       double maxQueueWaitTime,
+                                       double idleTimeout) override;
+    virtual void enableKeepalive(double interval) override;
+    virtual bool waitForConnections(double timeout) override;
+    std::vector<trantor::EventLoop *> getLoops() const
+    {
+        return loops_.getLoops();
+    }
+    /// Get the numbers of the connections and the waiting commands, the name
+    /// of the state is left empty.
+    DbClientState state();
 
   private:
+    using Clock = std::chrono::steady_clock;
     size_t connectionsNumber_;
     trantor::EventLoopThreadPool loops_;
     std::shared_ptr<SharedMutex> sharedMutexPtr_;
 
+    // Pool sizing and health, all guarded by connectionsMutex_
+    size_t maxConnectionsNumber_;
+    double maxQueueWaitTime_{0.1};
+    double idleTimeout_{60.0};
+    double keepaliveInterval_{0.0};
+    trantor::EventLoop *poolTimerLoop_{nullptr};
+    trantor::TimerId poolTimerId_{trantor::InvalidTimerId};
+    std::condition_variable connectionsCond_;
+    void startPoolTimer();
+    void maintainPool();
+
+    virtual void queueInLoop(std::function<void()> &&task) override
+    {
+        loops_.getNextLoop()->queueInLoop(std::move(task));
+    }
+
     void execSql(
         const DbConnectionPtr &conn,
         std::string &&sql,
@@ -73,7 +106,8 @@ class DbClientImpl : public DbClient,
 
     std::mutex connectionsMutex_;
     std::unordered_set<DbConnectionPtr> connections_;
-    std::unordered_set<DbConnectionPtr> readyConnections_;
+    // Idle connections and the time when they became idle
+    std::unordered_map<DbConnectionPtr, Clock::time_point> readyConnections_;
     std::unordered_set<DbConnectionPtr> busyConnections_;
 
     std::queue<std::function<void(const std::shared_ptr<Transaction> &)>>
@@ -14,6 +14,9 @@
 
 #include "DbClientLockFree.h"
 #include "DbConnection.h"
+#include "SqlCancellation.h"
+#include "SqlMetricsCollector.h"
+#include "SqlTracing.h"
 #include "TransactionImpl.h"
 #include <drogon/config.h>
 #if USE_POSTGRESQL
@@ -26,6 +29,7 @@
 #include <drogon/drogon.h>
 #include <drogon/orm/DbClient.h>
 #include <drogon/orm/Exception.h>
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -92,6 +96,10 @@ void DbClientLockFree::execSql(
     assert(paraNum == format.size());
     assert(rcb);
     loop_->assertInLoopThread();
+    traceSqlCommand(sql, rcb, exceptCallback);
+    CancellationTokenPtr cancellationToken;
+    if (!bindSqlCommand(cancellationToken, rcb, exceptCallback))
+        return;
     if (connections_.empty())
     {
         try
@@ -112,6 +120,12 @@ void DbClientLockFree::execSql(
             if (!conn->isWorking() &&
                 (transSet_.empty() || transSet_.find(conn) == transSet_.end()))
             {
+                if (metrics_)
+                    metrics_->instrument(sql,
+                                         SqlMetricsCollector::Clock::now(),
+                                         false,
+                                         rcb,
+                                         exceptCallback);
                 conn->execSql(
                     std::move(sql),
                     paraNum,
@@ -142,6 +156,12 @@ void DbClientLockFree::execSql(
                     (transSet_.empty() ||
                      transSet_.find(conn) == transSet_.end()))
                 {
+                    if (metrics_)
+                        metrics_->instrument(sql,
+                                             SqlMetricsCollector::Clock::now(),
+                                             false,
+                                             rcb,
+                                             exceptCallback);
                     conn->execSql(
                         std::move(sql),
                         paraNum,
@@ -175,6 +195,12 @@ void DbClientLockFree::execSql(
                 if (transSet_.empty() ||
                     transSet_.find(conn) == transSet_.end())
                 {
+                    if (metrics_)
+                        metrics_->instrument(sql,
+                                             SqlMetricsCollector::Clock::now(),
+                                             false,
+                                             rcb,
+                                             exceptCallback);
                     conn->execSql(std::move(sql),
                                   paraNum,
                                   std::move(parameters),
@@ -222,6 +248,9 @@ void DbClientLockFree::execSql(
             }
         },
         std::move(exceptCallback)));
+    sqlCmdBuffer_.back()->cancellationToken_ = std::move(cancellationToken);
+    if (metrics_)
+        metrics_->commandQueued();
 }
 
 std::shared_ptr<Transaction> DbClientLockFree::newTransaction(
@@ -232,6 +261,21 @@ std::shared_ptr<Transaction> DbClientLockFree::newTransaction(
     return nullptr;
 }
 
+drogon::DbClientState DbClientLockFree::state() const
+{
+    loop_->assertInLoopThread();
+    DbClientState state;
+    state.connections_ = connections_.size();
+    for (auto &conn : connections_)
+    {
+        if (conn->isWorking() || transSet_.find(conn) != transSet_.end())
+            ++state.busyConnections_;
+    }
+    state.waitingCommands_ = sqlCmdBuffer_.size();
+    state.waitingTransactions_ = transCallbacks_.size();
+    return state;
+}
+
 void DbClientLockFree::newTransactionAsync(
     const std::function<void(const std::shared_ptr<Transaction> &)> &callback)
 {
@@ -298,6 +342,7 @@ void DbClientLockFree::makeTrans(
             }
         }));
     transSet_.insert(conn);
+    trans->clientResultCache_ = resultCache_;
     trans->doBegin();
     conn->loop()->queueInLoop(
         [callback = std::move(callback), trans] { callback(trans); });
@@ -316,12 +361,20 @@ void DbClientLockFree::handleNewTask(const DbConnectionPtr &conn)
         return;
     }
 
+    while (!sqlCmdBuffer_.empty() && dropIfCancelled(sqlCmdBuffer_.front()))
+        sqlCmdBuffer_.pop_front();
     if (!sqlCmdBuffer_.empty())
     {
 #if LIBPQ_SUPPORTS_BATCH_MODE
         if (type_ != ClientType::PostgreSQL)
         {
             auto &cmd = sqlCmdBuffer_.front();
+            if (metrics_)
+                metrics_->instrument(cmd->sql_,
+                                     cmd->enqueueTime_,
+                                     true,
+                                     cmd->callback_,
+                                     cmd->exceptionCallback_);
             conn->execSql(std::move(cmd->sql_),
                           cmd->parametersNumber_,
                           std::move(cmd->parameters_),
@@ -336,10 +389,35 @@ void DbClientLockFree::handleNewTask(const DbConnectionPtr &conn)
             std::deque<std::shared_ptr<SqlCmd>> cmds;
             using std::swap;
             swap(cmds, sqlCmdBuffer_);
+            cmds.erase(std::remove_if(cmds.begin(),
+                                      cmds.end(),
+                                      [this](const std::shared_ptr<SqlCmd> &c) {
+                                          return dropIfCancelled(c);
+                                      }),
+                       cmds.end());
+            if (cmds.empty())
+                return;
+            if (metrics_)
+            {
+                for (auto &cmd : cmds)
+                {
+                    metrics_->instrument(cmd->sql_,
+                                         cmd->enqueueTime_,
+                                         true,
+                                         cmd->callback_,
+                                         cmd->exceptionCallback_);
+                }
+            }
             conn->batchSql(std::move(cmds));
         }
 #else
         auto &cmd = sqlCmdBuffer_.front();
+        if (metrics_)
+            metrics_->instrument(cmd->sql_,
+                                 cmd->enqueueTime_,
+                                 true,
+                                 cmd->callback_,
+                                 cmd->exceptionCallback_);
         conn->execSql(std::move(cmd->sql_),
                       cmd->parametersNumber_,
                       std::move(cmd->parameters_),
@@ -353,6 +431,19 @@ void DbClientLockFree::handleNewTask(const DbConnectionPtr &conn)
     }
 }
 
+bool DbClientLockFree::dropIfCancelled(const std::shared_ptr<SqlCmd> &cmd)
+{
+    if (!cmd->cancellationToken_ || !cmd->cancellationToken_->isCancelled())
+        return false;
+    if (metrics_)
+        metrics_->commandDropped();
+    // The callback may execute new commands, so it's not called while the
+    // buffer is being handled.
+    loop_->queueInLoop(
+        [cmd]() { cancelSqlCommand(cmd->exceptionCallback_); });
+    return true;
+}
+
 DbConnectionPtr DbClientLockFree::newConnection()
 {
     DbConnectionPtr connPtr;
@@ -16,6 +16,7 @@
 
 #include "DbConnection.h"
 #include <drogon/orm/DbClient.h>
+#include <drogon/utils/ServerState.h>
 #include <trantor/net/EventLoopThreadPool.h>
 #include <functional>
 #include <memory>
@@ -50,11 +51,19 @@ class DbClientLockFree : public DbClient,
     virtual void newTransactionAsync(
         const std::function<void(const std::shared_ptr<Transaction> &)>
             &callback) override;
+    /// Get the numbers of the connections and the waiting commands, it must
+    /// be called in the loop of the client. The name of the state is left
+    /// empty.
+    DbClientState state() const;
 
   private:
     std::string connectionInfo_;
     trantor::EventLoop *loop_;
     DbConnectionPtr newConnection();
+    virtual void queueInLoop(std::function<void()> &&task) override
+    {
+        loop_->queueInLoop(std::move(task));
+    }
     const size_t connectionsNumber_;
     std::vector<DbConnectionPtr> connections_;
     std::vector<DbConnectionPtr> connectionHolders_;
@@ -69,6 +78,8 @@ class DbClientLockFree : public DbClient,
         std::function<void(const std::shared_ptr<Transaction> &)> &&callback);
 
     void handleNewTask(const DbConnectionPtr &conn);
+    // Fail a queued command if its request is cancelled.
+    bool dropIfCancelled(const std::shared_ptr<SqlCmd> &cmd);
 #if LIBPQ_SUPPORTS_BATCH_MODE
     size_t connectionPos_{0};  // Used for pg batch mode.
 #endif
@@ -13,11 +13,13 @@
  */
 
 #include "../../lib/src/DbClientManager.h"
+#include "DbClientImpl.h"
 #include "DbClientLockFree.h"
 #include <drogon/config.h>
 #include <drogon/HttpAppFramework.h>
 #include <drogon/utils/Utilities.h>
 #include <algorithm>
+#include <chrono>
 
 using namespace drogon::orm;
 using namespace drogon;
@@ -80,9 +82,87 @@ void DbClientManager::createDbClients(
                     drogon::orm::DbClient::newSqlite3Client(
                         dbInfo.connectionInfo_, dbInfo.connectionNumber_);
 #endif
+                continue;
             }
+            auto iter = dbClientsMap_.find(dbInfo.name_);
+            if (iter == dbClientsMap_.end())
+                continue;
+            if (dbInfo.maxConnectionNumber_ > dbInfo.connectionNumber_)
+            {
+                iter->second->enablePoolAutoScaling(
+                    dbInfo.maxConnectionNumber_);
+            }
+            if (dbInfo.keepaliveInterval_ > 0)
+            {
+                iter->second->enableKeepalive(dbInfo.keepaliveInterval_);
+            }
+        }
+    }
+}
+
+void DbClientManager::waitForConnections(double timeout)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (auto &client : dbClientsMap_)
+    {
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (!client.second->waitForConnections(timeout - elapsed.count()))
+        {
+            LOG_WARN << "The database client '" << client.first
+                     << "' is not fully connected after " << timeout
+                     << " seconds, start serving anyway";
+        }
+    }
+}
+
+std::vector<std::pair<std::string, trantor::EventLoop *>>
+DbClientManager::getLoops() const
+{
+    // The fast clients run in the IO loops.
+    std::vector<std::pair<std::string, trantor::EventLoop *>> loops;
+    for (auto &client : dbClientsMap_)
+    {
+        auto clientImpl =
+            std::dynamic_pointer_cast<DbClientImpl>(client.second);
+        if (!clientImpl)
+            continue;
+        auto clientLoops = clientImpl->getLoops();
+        for (size_t i = 0; i < clientLoops.size(); ++i)
+        {
+            loops.emplace_back("db:" + client.first + ":" + std::to_string(i),
+                               clientLoops[i]);
         }
     }
+    return loops;
+}
+
+void DbClientManager::getStates(std::vector<DbClientState> &states) const
+{
+    for (auto &client : dbClientsMap_)
+    {
+        auto clientImpl =
+            std::dynamic_pointer_cast<DbClientImpl>(client.second);
+        if (!clientImpl)
+            continue;
+        states.push_back(clientImpl->state());
+        states.back().name_ = client.first;
+    }
+}
+
+void DbClientManager::getFastStates(std::vector<DbClientState> &states,
+                                    const std::string &loopName) const
+{
+    for (auto &client : dbFastClientsMap_)
+    {
+        auto clientImpl = std::dynamic_pointer_cast<DbClientLockFree>(
+            client.second.getThreadData());
+        if (!clientImpl)
+            continue;
+        states.push_back(clientImpl->state());
+        states.back().name_ = client.first;
+        states.back().loop_ = loopName;
+    }
 }
 
 void DbClientManager::createDbClient(const std::string &dbType,
@@ -94,7 +174,9 @@ void DbClientManager::createDbClient(const std::string &dbType,
                                      const size_t connectionNum,
                                      const std::string &filename,
                                      const std::string &name,
-                                     const bool isFast)
+                                     const bool isFast,
+                                     const size_t maxConnectionNum,
+                                     const double keepaliveInterval)
 {
     auto connStr = utils::formattedString("host=%s port=%u dbname=%s user=%s",
                                           host.c_str(),
@@ -113,6 +195,8 @@ void DbClientManager::createDbClient(const std::string &dbType,
     info.connectionNumber_ = connectionNum;
     info.isFast_ = isFast;
     info.name_ = name;
+    info.maxConnectionNumber_ = maxConnectionNum;
+    info.keepaliveInterval_ = keepaliveInterval;
 
     if (type == "postgresql")
     {
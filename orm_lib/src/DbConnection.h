@@ -16,9 +16,11 @@
 
 #include <drogon/config.h>
 #include <drogon/orm/DbClient.h>
+#include <drogon/utils/CancellationToken.h>
 #include <trantor/net/EventLoop.h>
 #include <trantor/net/inner/Channel.h>
 #include <trantor/utils/NonCopyable.h>
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -54,6 +56,10 @@ struct SqlCmd
     QueryCallback callback_;
     ExceptPtrCallback exceptionCallback_;
     std::string preparingStatement_;
+    std::chrono::steady_clock::time_point enqueueTime_;
+    // The token of the request the command is issued for, a queued command
+    // is dropped if it's cancelled.
+    CancellationTokenPtr cancellationToken_;
     SqlCmd(std::string &&sql,
            const size_t paraNum,
            std::vector<const char *> &&parameters,
@@ -67,7 +73,8 @@ struct SqlCmd
           lengths_(std::move(length)),
           formats_(std::move(format)),
           callback_(std::move(cb)),
-          exceptionCallback_(std::move(exceptCb))
+          exceptionCallback_(std::move(exceptCb)),
+          enqueueTime_(std::chrono::steady_clock::now())
     {
     }
 };
@@ -120,6 +127,12 @@ class DbConnection : public trantor::NonCopyable
     {
         return isWorking_;
     }
+    /// Return true if commands can be sent to the connection before the
+    /// results of the previous commands are received.
+    virtual bool supportsPipelining() const
+    {
+        return false;
+    }
 
   protected:
     QueryCallback callback_;
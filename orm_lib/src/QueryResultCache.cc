@@ -0,0 +1,158 @@
+/**
+ *
+ *  QueryResultCache.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "QueryResultCache.h"
+#include <drogon/orm/Field.h>
+#include <drogon/orm/ResultIterator.h>
+#include <drogon/orm/Row.h>
+#include <drogon/orm/RowIterator.h>
+#include <string.h>
+
+using namespace drogon::orm;
+
+static size_t resultMemorySize(const Result &result)
+{
+    // An estimate which includes the per-field overhead of the result
+    // implementations.
+    size_t size = sizeof(Result) + result.sql().length();
+    auto columns = result.columns();
+    for (Result::RowSizeType j = 0; j < columns; ++j)
+    {
+        size += strlen(result.columnName(j)) + sizeof(void *);
+    }
+    for (auto const &row : result)
+    {
+        for (auto const &field : row)
+        {
+            size += field.length() + 2 * sizeof(void *);
+        }
+    }
+    return size;
+}
+
+QueryResultCache::QueryResultCache(size_t maxMemorySize)
+    : maxMemorySize_(maxMemorySize)
+{
+}
+
+bool QueryResultCache::find(const std::string &key, Result &result)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = entries_.find(key);
+    if (iter == entries_.end())
+        return false;
+    if (iter->second.expiry_ <= Clock::now())
+    {
+        eraseEntry(iter);
+        return false;
+    }
+    lruList_.splice(lruList_.begin(), lruList_, iter->second.lruPos_);
+    result = iter->second.result_;
+    return true;
+}
+
+void QueryResultCache::insert(const std::string &key,
+                              const std::vector<std::string> &tables,
+                              double ttl,
+                              const Result &result,
+                              uint64_t epochBeforeQuery)
+{
+    auto size = resultMemorySize(result) + key.length();
+    for (auto const &table : tables)
+        size += table.length();
+    // Never let a single result take more than a quarter of the cache
+    if (size > maxMemorySize_ / 4)
+        return;
+    auto expiry =
+        Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double>(ttl));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (epochBeforeQuery < clearedEpoch_)
+        return;
+    for (auto const &table : tables)
+    {
+        auto iter = tableEpochs_.find(table);
+        if (iter != tableEpochs_.end() && iter->second > epochBeforeQuery)
+        {
+            // The table was written while the query was running.
+            return;
+        }
+    }
+    auto iter = entries_.find(key);
+    if (iter != entries_.end())
+        eraseEntry(iter);
+    while (memorySize_ + size > maxMemorySize_ && !lruList_.empty())
+    {
+        eraseEntry(entries_.find(lruList_.back()));
+    }
+    lruList_.push_front(key);
+    entries_.emplace(key,
+                     Entry{result, expiry, tables, size, lruList_.begin()});
+    memorySize_ += size;
+    for (auto const &table : tables)
+    {
+        tableIndex_[table].insert(key);
+    }
+}
+
+void QueryResultCache::invalidate(const std::vector<std::string> &tables)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++epoch_;
+    for (auto const &table : tables)
+    {
+        tableEpochs_[table] = epoch_;
+        auto indexIter = tableIndex_.find(table);
+        if (indexIter == tableIndex_.end())
+            continue;
+        auto keys = std::move(indexIter->second);
+        tableIndex_.erase(indexIter);
+        for (auto const &key : keys)
+        {
+            auto iter = entries_.find(key);
+            if (iter != entries_.end())
+                eraseEntry(iter);
+        }
+    }
+}
+
+void QueryResultCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    clearedEpoch_ = ++epoch_;
+    entries_.clear();
+    lruList_.clear();
+    tableIndex_.clear();
+    tableEpochs_.clear();
+    memorySize_ = 0;
+}
+
+void QueryResultCache::eraseEntry(EntryMap::iterator iter)
+{
+    auto &entry = iter->second;
+    for (auto const &table : entry.tables_)
+    {
+        auto indexIter = tableIndex_.find(table);
+        if (indexIter != tableIndex_.end())
+        {
+            indexIter->second.erase(iter->first);
+            if (indexIter->second.empty())
+                tableIndex_.erase(indexIter);
+        }
+    }
+    memorySize_ -= entry.memorySize_;
+    lruList_.erase(entry.lruPos_);
+    entries_.erase(iter);
+}
@@ -0,0 +1,107 @@
+/**
+ *
+ *  QueryResultCache.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/orm/Result.h>
+#include <trantor/utils/NonCopyable.h>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace drogon
+{
+namespace orm
+{
+/**
+ * @brief A memory-bounded LRU cache of query results shared by all threads
+ * using a database client.
+ *
+ * Entries are keyed by the sql statement and its bound parameters, and are
+ * tagged with the names of the tables they read from, so that a write to one
+ * of these tables can drop all of them at once.
+ */
+class QueryResultCache : public trantor::NonCopyable
+{
+  public:
+    explicit QueryResultCache(size_t maxMemorySize);
+
+    /// Find a live entry, return false if there is no entry or it has expired.
+    bool find(const std::string &key, Result &result);
+
+    /// Get the current invalidation epoch. It must be read before the query
+    /// is sent to the database and passed to the insert() method, so that a
+    /// result read before a concurrent write is never cached.
+    uint64_t epoch() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return epoch_;
+    }
+
+    void insert(const std::string &key,
+                const std::vector<std::string> &tables,
+                double ttl,
+                const Result &result,
+                uint64_t epochBeforeQuery);
+
+    /// Drop all entries tagged with any of the tables.
+    void invalidate(const std::vector<std::string> &tables);
+
+    /// Drop all entries.
+    void clear();
+
+    size_t memorySize() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return memorySize_;
+    }
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    struct Entry
+    {
+        Result result_;
+        Clock::time_point expiry_;
+        std::vector<std::string> tables_;
+        size_t memorySize_;
+        std::list<std::string>::iterator lruPos_;
+    };
+    using EntryMap = std::unordered_map<std::string, Entry>;
+
+    void eraseEntry(EntryMap::iterator iter);
+
+    const size_t maxMemorySize_;
+    size_t memorySize_{0};
+    uint64_t epoch_{0};
+    uint64_t clearedEpoch_{0};
+    EntryMap entries_;
+    // The most recently used key is at the front of the list.
+    std::list<std::string> lruList_;
+    std::unordered_map<std::string, std::unordered_set<std::string>>
+        tableIndex_;
+    std::unordered_map<std::string, uint64_t> tableEpochs_;
+    mutable std::mutex mutex_;
+};
+
+}  // namespace orm
+}  // namespace drogon
@@ -12,6 +12,8 @@
  *
  */
 
+#include "QueryResultCache.h"
+#include "SqlCancellation.h"
 #include <drogon/config.h>
 #include <drogon/orm/DbClient.h>
 #include <drogon/orm/SqlBinder.h>
@@ -26,16 +28,19 @@ using namespace drogon::orm::internal;
 void SqlBinder::exec()
 {
     execed_ = true;
+    Result cachedResult(nullptr);
+    bool cached = findCachedResult(cachedResult);
+    if (!cached && !invalidatedTables_.empty())
+    {
+        // Drop the cached results before the query is sent, so that no
+        // result read concurrently with the write is cached.
+        client_.invalidateResultCache(invalidatedTables_);
+    }
     if (mode_ == Mode::NonBlocking)
     {
         // nonblocking mode,default mode
         // Retain shared_ptrs of parameters until we get the result;
-        client_.execSql(
-            std::move(sql_),
-            parametersNumber_,
-            std::move(parameters_),
-            std::move(lengths_),
-            std::move(formats_),
+        QueryCallback resultCallback =
             [holder = std::move(callbackHolder_),
              objs = std::move(objs_)](const Result &r) mutable {
                 objs.clear();
@@ -43,7 +48,8 @@ void SqlBinder::exec()
                 {
                     holder->execCallback(r);
                 }
-            },
+            };
+        ExceptPtrCallback exceptCallback =
             [exceptCb = std::move(exceptionCallback_),
              exceptPtrCb = std::move(exceptionPtrCallback_),
              isExceptPtr =
@@ -68,7 +74,36 @@ void SqlBinder::exec()
                     if (exceptPtrCb)
                         exceptPtrCb(exception);
                 }
-            });
+            };
+        if (cached)
+        {
+            // The callbacks of a cached result are called in a loop of the
+            // client like the ones of a query, never in this thread.
+            CancellationTokenPtr token;
+            if (!bindSqlCommand(token, resultCallback, exceptCallback))
+                return;
+            client_.queueInLoop(
+                [resultCallback = std::move(resultCallback),
+                 exceptCallback = std::move(exceptCallback),
+                 cachedResult]() {
+                    try
+                    {
+                        resultCallback(cachedResult);
+                    }
+                    catch (const DrogonDbException &)
+                    {
+                        exceptCallback(std::current_exception());
+                    }
+                });
+            return;
+        }
+        client_.execSql(std::move(sql_),
+                        parametersNumber_,
+                        std::move(parameters_),
+                        std::move(lengths_),
+                        std::move(formats_),
+                        wrapResultCacheCallback(std::move(resultCallback)),
+                        std::move(exceptCallback));
     }
     else
     {
@@ -76,23 +111,32 @@ void SqlBinder::exec()
         std::shared_ptr<std::promise<Result>> pro(new std::promise<Result>);
         auto f = pro->get_future();
 
-        client_.execSql(
-            std::move(sql_),
-            parametersNumber_,
-            std::move(parameters_),
-            std::move(lengths_),
-            std::move(formats_),
-            [pro](const Result &r) { pro->set_value(r); },
-            [pro](const std::exception_ptr &exception) {
-                try
-                {
-                    pro->set_exception(exception);
-                }
-                catch (...)
-                {
-                    assert(0);
-                }
-            });
+        if (cached)
+        {
+            objs_.clear();
+            pro->set_value(cachedResult);
+        }
+        else
+        {
+            client_.execSql(
+                std::move(sql_),
+                parametersNumber_,
+                std::move(parameters_),
+                std::move(lengths_),
+                std::move(formats_),
+                wrapResultCacheCallback(
+                    [pro](const Result &r) { pro->set_value(r); }),
+                [pro](const std::exception_ptr &exception) {
+                    try
+                    {
+                        pro->set_exception(exception);
+                    }
+                    catch (...)
+                    {
+                        assert(0);
+                    }
+                });
+        }
         if (callbackHolder_ || exceptionCallback_)
         {
             try
@@ -121,6 +165,116 @@ void SqlBinder::exec()
         }
     }
 }
+bool SqlBinder::findCachedResult(Result &result)
+{
+    auto &cache = client_.resultCache_;
+    if (cacheTtl_ <= 0.0 || !cache || !invalidatedTables_.empty())
+        return false;
+    cacheKey_ = resultCacheKey();
+    if (cache->find(cacheKey_, result))
+    {
+        LOG_TRACE << "Result cache hit:" << sql_;
+        return true;
+    }
+    cacheEpoch_ = cache->epoch();
+    return false;
+}
+
+QueryCallback SqlBinder::wrapResultCacheCallback(QueryCallback &&callback)
+{
+    auto &cache = client_.resultCache_;
+    if (!cache)
+        return std::move(callback);
+    if (!invalidatedTables_.empty())
+    {
+        return [callback = std::move(callback),
+                cache,
+                tables = invalidatedTables_](const Result &r) {
+            cache->invalidate(tables);
+            callback(r);
+        };
+    }
+    if (!cacheKey_.empty())
+    {
+        return [callback = std::move(callback),
+                cache,
+                key = std::move(cacheKey_),
+                tables = cacheTables_,
+                ttl = cacheTtl_,
+                epoch = cacheEpoch_](const Result &r) {
+            cache->insert(key, tables, ttl, r, epoch);
+            callback(r);
+        };
+    }
+    return std::move(callback);
+}
+
+std::string SqlBinder::resultCacheKey() const
+{
+    std::string key;
+    key.reserve(sql_.length() + parametersNumber_ * 16);
+    key.append(sql_);
+    for (size_t i = 0; i < parametersNumber_; ++i)
+    {
+        // Every parameter is encoded as its format, a null flag and, for
+        // non-null values, the length followed by the raw bytes.
+        key.append((const char *)&formats_[i], sizeof(int));
+        if (!parameters_[i])
+        {
+            key.push_back('\0');
+            continue;
+        }
+        key.push_back('\1');
+        size_t length = lengths_[i] > 0 ? lengths_[i]
+                                        : getFixedParameterLength(formats_[i]);
+        key.append((const char *)&length, sizeof(length));
+        key.append(parameters_[i], length);
+    }
+    return key;
+}
+
+size_t SqlBinder::getFixedParameterLength(int format) const
+{
+    // The length of a fixed size parameter is not set when binding it to a
+    // Mysql or Sqlite3 statement.
+    if (type_ == ClientType::Sqlite3)
+    {
+        switch (format)
+        {
+            case Sqlite3TypeChar:
+                return 1;
+            case Sqlite3TypeShort:
+                return 2;
+            case Sqlite3TypeInt:
+                return 4;
+            case Sqlite3TypeInt64:
+            case Sqlite3TypeDouble:
+                return 8;
+            default:
+                return 0;
+        }
+    }
+    else if (type_ == ClientType::Mysql)
+    {
+#if USE_MYSQL
+        switch (format)
+        {
+            case MYSQL_TYPE_TINY:
+                return 1;
+            case MYSQL_TYPE_SHORT:
+                return 2;
+            case MYSQL_TYPE_LONG:
+                return 4;
+            case MYSQL_TYPE_LONGLONG:
+                return 8;
+            default:
+                return 0;
+        }
+#endif
+    }
+    return 0;
+}
+
 SqlBinder::~SqlBinder()
 {
     destructed_ = true;
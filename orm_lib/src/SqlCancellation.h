@@ -0,0 +1,75 @@
+/**
+ *
+ *  SqlCancellation.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/orm/DbClient.h>
+#include <drogon/orm/Exception.h>
+#include <drogon/utils/CancellationToken.h>
+
+namespace drogon
+{
+namespace orm
+{
+/// Fail a sql command which is not executed because its request is
+/// cancelled.
+inline void cancelSqlCommand(const ExceptPtrCallback &exceptCallback)
+{
+    try
+    {
+        throw CommandCancelled("The request of the command is cancelled");
+    }
+    catch (...)
+    {
+        if (exceptCallback)
+            exceptCallback(std::current_exception());
+    }
+}
+
+/// Bind a sql command to the cancellation token of the current thread, it
+/// must be called in the thread issuing the command. The callbacks are
+/// wrapped to make the token current while they're called.
+/**
+ * @param token The token, nullptr if there is none.
+ * @return false if the token is cancelled already, the command is failed
+ * then and must not be executed.
+ */
+inline bool bindSqlCommand(CancellationTokenPtr &token,
+                           ResultCallback &rcb,
+                           ExceptPtrCallback &exceptCallback)
+{
+    auto current = CancellationToken::current();
+    if (!current)
+        return true;
+    if (current->isCancelled())
+    {
+        cancelSqlCommand(exceptCallback);
+        return false;
+    }
+    token = current->shared_from_this();
+    rcb = [token, callback = std::move(rcb)](const Result &r) {
+        CancellationToken::Scope scope(token.get());
+        callback(r);
+    };
+    exceptCallback = [token, callback = std::move(exceptCallback)](
+                         const std::exception_ptr &e) {
+        CancellationToken::Scope scope(token.get());
+        if (callback)
+            callback(e);
+    };
+    return true;
+}
+
+}  // namespace orm
+}  // namespace drogon
@@ -0,0 +1,178 @@
+/**
+ *
+ *  SqlMetricsCollector.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "SqlMetricsCollector.h"
+#include <drogon/utils/Metrics.h>
+#include <trantor/utils/Logger.h>
+
+using namespace drogon::orm;
+
+constexpr size_t SqlMetricsCollector::maxStatementsNumber_;
+
+// The mutex of a cache is only locked by the threads sharing the last metrics
+// slot.
+struct SqlMetricsCollector::StatementCaches
+{
+    struct Cache
+    {
+        std::mutex mutex_;
+        std::unordered_map<std::string, const Statement *> statements_;
+    };
+    drogon::internal::PerThreadCells<Cache> caches_;
+};
+
+SqlMetricsCollector::SqlMetricsCollector(double slowQueryThreshold)
+    : slowQueryThreshold_(slowQueryThreshold),
+      statementCaches_(new StatementCaches)
+{
+}
+
+SqlMetricsCollector::~SqlMetricsCollector()
+{
+}
+
+const SqlMetricsCollector::Statement &SqlMetricsCollector::statement(
+    const std::string &sql)
+{
+    auto &slot = drogon::internal::currentMetricsSlot();
+    auto &cache = statementCaches_->caches_.get(slot.index_);
+    std::unique_lock<std::mutex> lock(cache.mutex_, std::defer_lock);
+    if (!slot.exclusive_)
+        lock.lock();
+    auto iter = cache.statements_.find(sql);
+    if (iter != cache.statements_.end())
+        return *iter->second;
+    auto &stmt = sharedStatement(sql);
+    // The sql texts recorded in the <others> entry are not cached, so the
+    // caches are limited like the statements.
+    if (stmt.first == sql)
+        cache.statements_.emplace(sql, &stmt);
+    return stmt;
+}
+
+const SqlMetricsCollector::Statement &SqlMetricsCollector::sharedStatement(
+    const std::string &sql)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = statements_.find(sql);
+    if (iter != statements_.end())
+        return *iter;
+    if (statements_.size() >= maxStatementsNumber_)
+    {
+        iter = statements_.find("<others>");
+        if (iter != statements_.end())
+            return *iter;
+        return *statements_
+                    .emplace("<others>",
+                             std::unique_ptr<Latencies>(new Latencies))
+                    .first;
+    }
+    return *statements_.emplace(sql, std::unique_ptr<Latencies>(new Latencies))
+                .first;
+}
+
+void SqlMetricsCollector::instrument(const std::string &sql,
+                                     const Clock::time_point &enqueueTime,
+                                     bool queued,
+                                     ResultCallback &rcb,
+                                     ExceptPtrCallback &exceptCallback)
+{
+    auto sendTime = Clock::now();
+    if (queued)
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+    inFlight_.fetch_add(1, std::memory_order_relaxed);
+    auto &stmt = statement(sql);
+    // The key string and the latencies object live as long as this object.
+    auto sqlPtr = &stmt.first;
+    auto latencies = stmt.second.get();
+    total_.queueTime_.record(sendTime - enqueueTime);
+    latencies->queueTime_.record(sendTime - enqueueTime);
+
+    auto thisPtr = shared_from_this();
+    rcb = [thisPtr,
+           sqlPtr,
+           latencies,
+           sendTime,
+           callback = std::move(rcb)](const Result &r) {
+        auto receiveTime = Clock::now();
+        thisPtr->recordResult(
+            *sqlPtr, *latencies, sendTime, receiveTime, false);
+        callback(r);
+        auto callbackTime = Clock::now() - receiveTime;
+        thisPtr->total_.callbackTime_.record(callbackTime);
+        latencies->callbackTime_.record(callbackTime);
+    };
+    exceptCallback = [thisPtr,
+                      sqlPtr,
+                      latencies,
+                      sendTime,
+                      callback = std::move(exceptCallback)](
+                         const std::exception_ptr &e) {
+        thisPtr->recordResult(
+            *sqlPtr, *latencies, sendTime, Clock::now(), true);
+        if (callback)
+            callback(e);
+    };
+}
+
+void SqlMetricsCollector::recordResult(const std::string &sql,
+                                       Latencies &statement,
+                                       const Clock::time_point &sendTime,
+                                       const Clock::time_point &receiveTime,
+                                       bool isError)
+{
+    inFlight_.fetch_sub(1, std::memory_order_relaxed);
+    auto executionTime = receiveTime - sendTime;
+    total_.executionTime_.record(executionTime);
+    statement.executionTime_.record(executionTime);
+    if (isError)
+    {
+        total_.errors_.fetch_add(1, std::memory_order_relaxed);
+        statement.errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (slowQueryThreshold_ > 0)
+    {
+        auto seconds =
+            std::chrono::duration<double>(executionTime).count();
+        if (seconds > slowQueryThreshold_)
+        {
+            LOG_WARN << "Slow sql (" << seconds << "s): " << sql;
+        }
+    }
+}
+
+SqlLatencies SqlMetricsCollector::summary(const Latencies &latencies)
+{
+    SqlLatencies summary;
+    summary.queueTime_ = latencies.queueTime_.summary();
+    summary.executionTime_ = latencies.executionTime_.summary();
+    summary.callbackTime_ = latencies.callbackTime_.summary();
+    summary.errors_ = latencies.errors_.load(std::memory_order_relaxed);
+    return summary;
+}
+
+DbClientMetrics SqlMetricsCollector::metrics() const
+{
+    DbClientMetrics metrics;
+    metrics.inFlight_ = inFlight_.load(std::memory_order_relaxed);
+    metrics.pending_ = pending_.load(std::memory_order_relaxed);
+    metrics.total_ = summary(total_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    metrics.statements_.reserve(statements_.size());
+    for (auto const &stmt : statements_)
+    {
+        metrics.statements_.emplace_back(stmt.first, summary(*stmt.second));
+    }
+    return metrics;
+}
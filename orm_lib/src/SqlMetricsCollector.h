@@ -0,0 +1,106 @@
+/**
+ *
+ *  SqlMetricsCollector.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/orm/DbClient.h>
+#include <drogon/orm/SqlMetrics.h>
+#include <drogon/utils/LatencyHistogram.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace drogon
+{
+namespace orm
+{
+/**
+ * @brief Collects the latencies of the sql commands executed by a database
+ * client.
+ *
+ * Database clients call the commandQueued() method when a command is pushed
+ * into their buffers, the commandDropped() method when a queued command is
+ * dropped and the instrument() method right before a command is sent to a
+ * connection, which wraps the callbacks of the command to record the
+ * execution time and the callback time.
+ */
+class SqlMetricsCollector
+    : public trantor::NonCopyable,
+      public std::enable_shared_from_this<SqlMetricsCollector>
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit SqlMetricsCollector(double slowQueryThreshold);
+    ~SqlMetricsCollector();
+
+    void commandQueued()
+    {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void commandDropped()
+    {
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void instrument(const std::string &sql,
+                    const Clock::time_point &enqueueTime,
+                    bool queued,
+                    ResultCallback &rcb,
+                    ExceptPtrCallback &exceptCallback);
+
+    DbClientMetrics metrics() const;
+
+  private:
+    struct Latencies
+    {
+        LatencyHistogram queueTime_;
+        LatencyHistogram executionTime_;
+        LatencyHistogram callbackTime_;
+        std::atomic<uint64_t> errors_{0};
+    };
+
+    using Statement = std::pair<const std::string, std::unique_ptr<Latencies>>;
+    // The statements found by every thread, so that the threads executing
+    // commands don't contend on the mutex.
+    struct StatementCaches;
+
+    static SqlLatencies summary(const Latencies &latencies);
+    void recordResult(const std::string &sql,
+                      Latencies &statement,
+                      const Clock::time_point &sendTime,
+                      const Clock::time_point &receiveTime,
+                      bool isError);
+    const Statement &statement(const std::string &sql);
+    const Statement &sharedStatement(const std::string &sql);
+
+    const double slowQueryThreshold_;
+    Latencies total_;
+    std::atomic<size_t> inFlight_{0};
+    std::atomic<size_t> pending_{0};
+    // Statements are never removed, the number of them is limited by
+    // maxStatementsNumber_, others are recorded in one entry.
+    static constexpr size_t maxStatementsNumber_ = 1000;
+    std::unordered_map<std::string, std::unique_ptr<Latencies>> statements_;
+    mutable std::mutex mutex_;
+    std::unique_ptr<StatementCaches> statementCaches_;
+};
+
+}  // namespace orm
+}  // namespace drogon
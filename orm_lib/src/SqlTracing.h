@@ -0,0 +1,49 @@
+/**
+ *
+ *  SqlTracing.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/orm/DbClient.h>
+#include <drogon/utils/Tracing.h>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+namespace orm
+{
+/// Trace a sql command as a child span of the current trace context, it must
+/// be called in the thread executing the command, before the command is
+/// queued. The callbacks are wrapped only if the context is sampled.
+inline void traceSqlCommand(const std::string &sql,
+                            ResultCallback &rcb,
+                            ExceptPtrCallback &exceptCallback)
+{
+    if (!Tracer::currentContext().sampled_)
+        return;
+    auto call = std::make_shared<TracedCall>("sql", sql);
+    rcb = [call, callback = std::move(rcb)](const Result &r) {
+        Tracer::ContextScope scope(call->finish(0));
+        callback(r);
+    };
+    exceptCallback = [call, callback = std::move(exceptCallback)](
+                         const std::exception_ptr &e) {
+        Tracer::ContextScope scope(call->finish(1));
+        if (callback)
+            callback(e);
+    };
+}
+
+}  // namespace orm
+}  // namespace drogon
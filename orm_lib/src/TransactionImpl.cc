@@ -17,6 +17,27 @@
 
 using namespace drogon::orm;
 
+static void pipelinedRollback(const DbConnectionPtr &conn, bool retry)
+{
+    conn->execSql(
+        "rollback",
+        0,
+        std::vector<const char *>(),
+        std::vector<int>(),
+        std::vector<int>(),
+        [](const Result &) { LOG_TRACE << "Transaction roll back!"; },
+        [conn, retry](const std::exception_ptr &) {
+            // A rollback sent in the same batch as the failed command is
+            // skipped by the server, so send it again after the batch.
+            if (retry && conn->status() == ConnectStatus::Ok)
+            {
+                pipelinedRollback(conn, false);
+                return;
+            }
+            LOG_ERROR << "Transaction rool back error";
+        });
+}
+
 TransactionImpl::TransactionImpl(
     ClientType type,
     const DbConnectionPtr &connPtr,
@@ -25,7 +46,9 @@ TransactionImpl::TransactionImpl(
     : connectionPtr_(connPtr),
       usedUpCallback_(usedUpCallback),
       loop_(connPtr->loop()),
-      commitCallback_(commitCallback)
+      commitCallback_(commitCallback),
+      pipelining_(connPtr->supportsPipelining()),
+      failed_(std::make_shared<bool>(false))
 {
     type_ = type;
 }
@@ -38,7 +61,10 @@ TransactionImpl::~TransactionImpl()
         auto loop = connectionPtr_->loop();
         loop->queueInLoop([conn = connectionPtr_,
                            ucb = std::move(usedUpCallback_),
-                           commitCb = std::move(commitCallback_)]() {
+                           commitCb = std::move(commitCallback_),
+                           cache = std::move(clientResultCache_),
+                           tables = std::move(writtenTables_),
+                           failed = failed_]() {
             conn->setIdleCallback([ucb = std::move(ucb)]() {
                 if (ucb)
                     ucb();
@@ -49,8 +75,24 @@ TransactionImpl::~TransactionImpl()
                 std::vector<const char *>(),
                 std::vector<int>(),
                 std::vector<int>(),
-                [commitCb](const Result &) {
+                [commitCb, cache, tables, failed](const Result &) {
+                    if (*failed)
+                    {
+                        // The server rolls back a failed transaction on
+                        // commit.
+                        LOG_ERROR << "Transaction rolled back because a "
+                                     "pipelined command failed";
+                        if (commitCb)
+                        {
+                            commitCb(false);
+                        }
+                        return;
+                    }
                     LOG_TRACE << "Transaction commited!";
+                    if (cache && !tables.empty())
+                    {
+                        cache->invalidate(tables);
+                    }
                     if (commitCb)
                     {
                         commitCb(true);
@@ -73,6 +115,24 @@ TransactionImpl::~TransactionImpl()
                 });
         });
     }
+    else if (pipelining_)
+    {
+        // The rollback may be still running on the connection.
+        loop_->queueInLoop(
+            [conn = connectionPtr_, ucb = std::move(usedUpCallback_)]() {
+                if (conn->isWorking())
+                {
+                    conn->setIdleCallback([ucb = std::move(ucb)]() {
+                        if (ucb)
+                            ucb();
+                    });
+                }
+                else if (ucb)
+                {
+                    ucb();
+                }
+            });
+    }
     else
     {
         if (usedUpCallback_)
@@ -91,7 +151,17 @@ void TransactionImpl::execSqlInLoop(
     std::function<void(const std::exception_ptr &)> &&exceptCallback)
 {
     loop_->assertInLoopThread();
-    if (!isCommitedOrRolledback_)
+    if (pipelining_ && !isCommitedOrRolledback_)
+    {
+        execSqlPipelined(std::move(sql),
+                         paraNum,
+                         std::move(parameters),
+                         std::move(length),
+                         std::move(format),
+                         std::move(rcb),
+                         std::move(exceptCallback));
+    }
+    else if (!isCommitedOrRolledback_)
     {
         auto thisPtr = shared_from_this();
         if (!isWorking_)
@@ -140,6 +210,66 @@ void TransactionImpl::execSqlInLoop(
     }
 }
 
+void TransactionImpl::execSqlPipelined(
+    std::string &&sql,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    ResultCallback &&rcb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    std::weak_ptr<TransactionImpl> weakPtr = shared_from_this();
+    connectionPtr_->execSql(
+        std::move(sql),
+        paraNum,
+        std::move(parameters),
+        std::move(length),
+        std::move(format),
+        std::move(rcb),
+        [weakPtr,
+         failed = failed_,
+         exceptCallback = std::move(exceptCallback)](
+            const std::exception_ptr &ePtr) {
+            if (*failed)
+            {
+                // Only the command which failed first gets the error from
+                // the database, the commands sent after it fail because the
+                // transaction is aborted.
+                try
+                {
+                    throw TransactionRollback(
+                        "The transaction has been rolled back");
+                }
+                catch (...)
+                {
+                    if (exceptCallback)
+                        exceptCallback(std::current_exception());
+                }
+                return;
+            }
+            *failed = true;
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->rollback();
+            if (exceptCallback)
+                exceptCallback(ePtr);
+        });
+}
+
+void TransactionImpl::invalidateResultCache(
+    const std::vector<std::string> &tables)
+{
+    if (!clientResultCache_)
+        return;
+    clientResultCache_->invalidate(tables);
+    loop_->runInLoop([thisPtr = shared_from_this(), tables]() {
+        thisPtr->writtenTables_.insert(thisPtr->writtenTables_.end(),
+                                       tables.begin(),
+                                       tables.end());
+    });
+}
+
 void TransactionImpl::rollback()
 {
     auto thisPtr = shared_from_this();
@@ -147,6 +277,12 @@ void TransactionImpl::rollback()
     loop_->runInLoop([thisPtr]() {
         if (thisPtr->isCommitedOrRolledback_)
             return;
+        if (thisPtr->pipelining_)
+        {
+            thisPtr->isCommitedOrRolledback_ = true;
+            pipelinedRollback(thisPtr->connectionPtr_, true);
+            return;
+        }
         if (thisPtr->isWorking_)
         {
             // push sql cmd to buffer;
@@ -263,6 +399,11 @@ void TransactionImpl::execNewTask()
 void TransactionImpl::doBegin()
 {
     loop_->queueInLoop([thisPtr = shared_from_this()]() {
+        if (thisPtr->pipelining_)
+        {
+            thisPtr->doBeginPipelined();
+            return;
+        }
         std::weak_ptr<TransactionImpl> weakPtr = thisPtr;
         thisPtr->connectionPtr_->setIdleCallback([weakPtr]() {
             auto thisPtr = weakPtr.lock();
@@ -287,3 +428,26 @@ void TransactionImpl::doBegin()
             });
     });
 }
+
+void TransactionImpl::doBeginPipelined()
+{
+    // Commands are not buffered by the transaction, the connection is given
+    // back to the client by the callback set in the destructor.
+    connectionPtr_->setIdleCallback([]() {});
+    assert(!isCommitedOrRolledback_);
+    connectionPtr_->execSql(
+        "begin",
+        0,
+        std::vector<const char *>(),
+        std::vector<int>(),
+        std::vector<int>(),
+        [](const Result &) { LOG_TRACE << "Transaction begin!"; },
+        [weakPtr = std::weak_ptr<TransactionImpl>(shared_from_this()),
+         failed = failed_](const std::exception_ptr &) {
+            LOG_ERROR << "Error occurred in transaction begin";
+            *failed = true;
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->isCommitedOrRolledback_ = true;
+        });
+}
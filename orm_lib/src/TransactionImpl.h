@@ -16,6 +16,8 @@
 
 #include "DbConnection.h"
 #include <drogon/orm/DbClient.h>
+#include "QueryResultCache.h"
+#include "SqlTracing.h"
 #include <functional>
 #include <list>
 
@@ -38,6 +40,8 @@ class TransactionImpl : public Transaction,
     {
         commitCallback_ = commitCallback;
     }
+    virtual void invalidateResultCache(
+        const std::vector<std::string> &tables) override;
 
   private:
     DbConnectionPtr connectionPtr_;
@@ -50,6 +54,7 @@ class TransactionImpl : public Transaction,
                          std::function<void(const std::exception_ptr &)>
                              &&exceptCallback) override
     {
+        traceSqlCommand(sql, rcb, exceptCallback);
         if (loop_->isInLoopThread())
         {
             execSqlInLoop(std::move(sql),
@@ -123,9 +128,28 @@ class TransactionImpl : public Transaction,
     friend class DbClientImpl;
     friend class DbClientLockFree;
     void doBegin();
+    void doBeginPipelined();
     trantor::EventLoop *loop_;
     std::function<void(bool)> commitCallback_;
     std::shared_ptr<TransactionImpl> thisPtr_;
+    // The result cache of the client that created this transaction, results
+    // of the written tables are dropped again after commit.
+    std::shared_ptr<QueryResultCache> clientResultCache_;
+    std::vector<std::string> writtenTables_;
+    // If the connection supports pipelining, commands are sent as soon as
+    // they are executed instead of after the result of the previous one.
+    const bool pipelining_;
+    // Shared with the callbacks of the pipelined commands which may outlive
+    // the transaction, it's set when the first command fails.
+    std::shared_ptr<bool> failed_;
+    void execSqlPipelined(
+        std::string &&sql,
+        size_t paraNum,
+        std::vector<const char *> &&parameters,
+        std::vector<int> &&length,
+        std::vector<int> &&format,
+        ResultCallback &&rcb,
+        std::function<void(const std::exception_ptr &)> &&exceptCallback);
 };
 }  // namespace orm
 }  // namespace drogon
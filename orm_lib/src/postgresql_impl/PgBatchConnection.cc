@@ -387,12 +387,16 @@ void PgConnection::handleRead()
             continue;
         }
         auto type = PQresultStatus(res.get());
-        if (type == PGRES_BAD_RESPONSE || type == PGRES_FATAL_ERROR ||
-            type == PGRES_BATCH_ABORTED)
+        if (type == PGRES_BAD_RESPONSE || type == PGRES_FATAL_ERROR)
         {
             handleFatalError(false);
             continue;
         }
+        if (type == PGRES_BATCH_ABORTED)
+        {
+            handleFatalError(false, true);
+            continue;
+        }
         if (type == PGRES_BATCH_END)
         {
             if (batchCommandsForWaitingResults_.empty() &&
@@ -436,12 +440,19 @@ void PgConnection::doAfterPreparing()
 {
 }
 
-void PgConnection::handleFatalError(bool clearAll)
+void PgConnection::handleFatalError(bool clearAll, bool isAbortedBatch)
 {
-    LOG_ERROR << PQerrorMessage(connectionPtr_.get());
+    // The error message of the connection belongs to the command that failed
+    // first, the commands skipped after it get their own message.
+    std::string errorMessage =
+        isAbortedBatch ? "The command was not executed because an earlier "
+                         "command in the same batch failed"
+                       : PQerrorMessage(connectionPtr_.get());
+    if (!isAbortedBatch)
+        LOG_ERROR << errorMessage;
     try
     {
-        throw Failure(PQerrorMessage(connectionPtr_.get()));
+        throw Failure(errorMessage);
     }
     catch (...)
     {
@@ -86,6 +86,13 @@ class PgConnection : public DbConnection,
 
     virtual void disconnect() override;
 
+#if LIBPQ_SUPPORTS_BATCH_MODE
+    virtual bool supportsPipelining() const override
+    {
+        return true;
+    }
+#endif
+
   private:
     std::shared_ptr<PGconn> connectionPtr_;
     trantor::Channel channel_;
@@ -112,7 +119,7 @@ class PgConnection : public DbConnection,
     int flush();
     void handleFatalError();
 #if LIBPQ_SUPPORTS_BATCH_MODE
-    void handleFatalError(bool clearAll);
+    void handleFatalError(bool clearAll, bool isAbortedBatch = false);
     std::list<std::shared_ptr<SqlCmd>> batchCommandsForWaitingResults_;
     std::deque<std::shared_ptr<SqlCmd>> batchSqlCommands_;
     void sendBatchedSql();
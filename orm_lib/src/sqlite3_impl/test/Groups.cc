@@ -6,6 +6,7 @@
  */
 
 #include "Groups.h"
+#include <drogon/utils/JsonBinding.h>
 #include <drogon/utils/Utilities.h>
 #include <string>
 
@@ -1253,6 +1254,113 @@ Json::Value Groups::toJson() const
     return ret;
 }
 
+void Groups::appendJson(std::string &output) const
+{
+    output.append("{\"group_id\":");
+    if (getGroupId())
+    {
+        drogon::appendJson(getValueOfGroupId(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"group_name\":");
+    if (getGroupName())
+    {
+        drogon::appendJson(getValueOfGroupName(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"creater_id\":");
+    if (getCreaterId())
+    {
+        drogon::appendJson(getValueOfCreaterId(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"create_time\":");
+    if (getCreateTime())
+    {
+        drogon::appendJson(getValueOfCreateTime(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"inviting\":");
+    if (getInviting())
+    {
+        drogon::appendJson(getValueOfInviting(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"inviting_user_id\":");
+    if (getInvitingUserId())
+    {
+        drogon::appendJson(getValueOfInvitingUserId(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"avatar_id\":");
+    if (getAvatarId())
+    {
+        drogon::appendJson(getValueOfAvatarId(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"uuu\":");
+    if (getUuu())
+    {
+        drogon::appendJson(getValueOfUuu(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"text\":");
+    if (getText())
+    {
+        drogon::appendJson(getValueOfText(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"avatar\":");
+    if (getAvatar())
+    {
+        drogon::appendJson(drogon::utils::base64Encode(
+                               (const unsigned char *)getAvatar()->data(),
+                               getAvatar()->size()),
+                           output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"is_default\":");
+    if (getIsDefault())
+    {
+        drogon::appendJson(getValueOfIsDefault(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.push_back('}');
+}
+
 Json::Value Groups::toMasqueradedJson(
     const std::vector<std::string> &pMasqueradingVector) const
 {
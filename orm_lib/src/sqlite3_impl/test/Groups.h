@@ -241,6 +241,11 @@ class Groups
     Json::Value toJson() const;
     Json::Value toMasqueradedJson(
         const std::vector<std::string> &pMasqueradingVector) const;
+    /// Append the same members as the ones of toJson() to the output as json
+    /// text, without any Json::Value object. The members are written in the
+    /// order of the columns in the table, not sorted by name like the ones of
+    /// toJson().
+    void appendJson(std::string &output) const;
     /// Relationship interfaces
   private:
     friend Mapper<Groups>;
@@ -6,6 +6,7 @@
  */
 
 #include "Users.h"
+#include <drogon/utils/JsonBinding.h>
 #include <drogon/utils/Utilities.h>
 #include <string>
 
@@ -1040,6 +1041,92 @@ Json::Value Users::toJson() const
     return ret;
 }
 
+void Users::appendJson(std::string &output) const
+{
+    output.append("{\"user_id\":");
+    if (getUserId())
+    {
+        drogon::appendJson(getValueOfUserId(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"user_name\":");
+    if (getUserName())
+    {
+        drogon::appendJson(getValueOfUserName(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"password\":");
+    if (getPassword())
+    {
+        drogon::appendJson(getValueOfPassword(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"org_name\":");
+    if (getOrgName())
+    {
+        drogon::appendJson(getValueOfOrgName(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"signature\":");
+    if (getSignature())
+    {
+        drogon::appendJson(getValueOfSignature(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"avatar_id\":");
+    if (getAvatarId())
+    {
+        drogon::appendJson(getValueOfAvatarId(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"id\":");
+    if (getId())
+    {
+        drogon::appendJson(getValueOfId(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"salt\":");
+    if (getSalt())
+    {
+        drogon::appendJson(getValueOfSalt(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.append(",\"admin\":");
+    if (getAdmin())
+    {
+        drogon::appendJson(getValueOfAdmin(), output);
+    }
+    else
+    {
+        output.append("null");
+    }
+    output.push_back('}');
+}
+
 Json::Value Users::toMasqueradedJson(
     const std::vector<std::string> &pMasqueradingVector) const
 {
@@ -18,6 +18,7 @@
 #include <trantor/utils/Logger.h>
 #include <iostream>
 #include <chrono>
+#include <thread>
 #include <unistd.h>
 #include <stdlib.h>
 
@@ -27,7 +28,7 @@ using namespace drogon_model::postgres;
 #define RESET "\033[0m"
 #define RED "\033[31m"   /* Red */
 #define GREEN "\033[32m" /* Green */
-#define TEST_COUNT 36
+#define TEST_COUNT 42
 
 int counter = 0;
 int gLoops = 1;
@@ -564,6 +565,105 @@ void doTest(const drogon::orm::DbClientPtr &clientPtr)
         std::cerr << e.base().what() << std::endl;
         testOutput(false, "ORM mapper asynchronous interface(3)");
     }
+    /// 6 result cache
+    try
+    {
+        auto count = [&clientPtr]() {
+            auto r = clientPtr->execSqlSync(
+                "select count(*) from users where user_id=$1",
+                CacheQuery({"users"}, 60),
+                "cache");
+            return r[0]["count"].as<int64_t>();
+        };
+        auto c1 = count();
+        clientPtr->execSqlSync("insert into users (user_id) values($1)",
+                               "cache");
+        testOutput(count() == c1, "Result cache(0)");
+        clientPtr->execSqlSync("insert into users (user_id) values($1)",
+                               InvalidateCache({"users"}),
+                               "cache");
+        testOutput(count() == c1 + 2, "Result cache(1)");
+        clientPtr->invalidateResultCache({"users"});
+        testOutput(count() == c1 + 2, "Result cache(2)");
+        std::promise<bool> inLoop;
+        clientPtr->execSqlAsync(
+            "select count(*) from users where user_id=$1",
+            [&inLoop, id = std::this_thread::get_id()](const Result &) {
+                inLoop.set_value(std::this_thread::get_id() != id);
+            },
+            [&inLoop](const DrogonDbException &) { inLoop.set_value(false); },
+            CacheQuery({"users"}, 60),
+            "cache");
+        testOutput(inLoop.get_future().get(), "Result cache(3)");
+#ifdef __cpp_impl_coroutine
+        std::promise<int64_t> coroCount;
+        [](DbClientPtr clientPtr,
+           std::promise<int64_t> &coroCount) -> drogon::AsyncTask {
+            try
+            {
+                CacheQuery cache({"users"}, 60);
+                auto r = co_await clientPtr->execSqlCoro(
+                    "select count(*) from users where user_id=$1",
+                    cache,
+                    "cache");
+                coroCount.set_value(r[0]["count"].as<int64_t>());
+            }
+            catch (const DrogonDbException &)
+            {
+                coroCount.set_value(-1);
+            }
+        }(clientPtr, coroCount);
+        testOutput(coroCount.get_future().get() == c1 + 2, "Result cache(4)");
+#endif
+    }
+    catch (const DrogonDbException &e)
+    {
+        std::cerr << e.base().what() << std::endl;
+        testOutput(false, "Result cache");
+    }
+    /// 7 metrics
+    try
+    {
+        clientPtr->execSqlSync("select 1 where $1=$1", "metrics");
+        auto metrics = clientPtr->getMetrics();
+        bool found = false;
+        for (auto const &stmt : metrics.statements_)
+        {
+            if (stmt.first == "select 1 where $1=$1" &&
+                stmt.second.executionTime_.count_ > 0)
+                found = true;
+        }
+        testOutput(found && metrics.total_.executionTime_.count_ > 0,
+                   "SQL metrics");
+    }
+    catch (const DrogonDbException &e)
+    {
+        std::cerr << e.base().what() << std::endl;
+        testOutput(false, "SQL metrics");
+    }
+    /// 8 transaction errors, only the command which failed first gets the
+    /// error from the database
+    {
+        auto trans = clientPtr->newTransaction();
+        *trans << "select 1" >> [](const Result &r) {} >>
+            [](const DrogonDbException &e) {
+                std::cerr << e.base().what() << std::endl;
+            };
+        *trans << "select * from table_not_exists" >>
+            [](const Result &r) { testOutput(false, "Transaction(0)"); } >>
+            [](const DrogonDbException &e) {
+                testOutput(dynamic_cast<const TransactionRollback *>(&e) ==
+                               nullptr,
+                           "Transaction(0)");
+            };
+        *trans << "select 1" >>
+            [](const Result &r) { testOutput(false, "Transaction(1)"); } >>
+            [](const DrogonDbException &e) {
+                testOutput(dynamic_cast<const TransactionRollback *>(&e) !=
+                               nullptr,
+                           "Transaction(1)");
+            };
+    }
 }
 int main(int argc, char *argv[])
 {
@@ -571,6 +671,8 @@ int main(int argc, char *argv[])
 #if USE_POSTGRESQL
     auto clientPtr = DbClient::newPgClient(
         "host=127.0.0.1 port=5432 dbname=postgres user=postgres", 1);
+    clientPtr->enableResultCache();
+    clientPtr->enableMetrics(1.0);
 #endif
     LOG_DEBUG << "start!";
     sleep(1);
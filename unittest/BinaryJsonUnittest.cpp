@@ -0,0 +1,164 @@
+#include <drogon/utils/BinaryJson.h>
+#include <gtest/gtest.h>
+#include <limits>
+#include <string>
+
+using namespace drogon;
+
+static Json::Value parse(const std::string &text)
+{
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    std::string errs;
+    EXPECT_TRUE(
+        reader->parse(text.data(), text.data() + text.size(), &root, &errs));
+    return root;
+}
+
+static Json::Value sample()
+{
+    Json::Value value;
+    value["null"] = Json::Value();
+    value["bools"].append(true);
+    value["bools"].append(false);
+    for (auto i : {0LL,
+                   1LL,
+                   -1LL,
+                   -32LL,
+                   -33LL,
+                   127LL,
+                   128LL,
+                   255LL,
+                   256LL,
+                   -128LL,
+                   -129LL,
+                   65535LL,
+                   65536LL,
+                   -32768LL,
+                   -32769LL,
+                   4294967295LL,
+                   4294967296LL,
+                   -2147483648LL,
+                   -2147483649LL})
+        value["ints"].append(static_cast<Json::Int64>(i));
+    value["ints"].append(std::numeric_limits<Json::Int64>::min());
+    value["ints"].append(std::numeric_limits<Json::Int64>::max());
+    value["ints"].append(std::numeric_limits<Json::UInt64>::max());
+    value["reals"].append(0.1);
+    value["reals"].append(-2.5e300);
+    value["strings"].append("");
+    value["strings"].append("short");
+    value["strings"].append(std::string(31, 'a'));
+    value["strings"].append(std::string(32, 'b'));
+    value["strings"].append(std::string(300, 'c'));
+    value["strings"].append(std::string(70000, 'd'));
+    value["strings"].append("\xe4\xbd\xa0\xe5\xa5\xbd \"\\\n");
+    for (int i = 0; i < 20; ++i)
+        value["array"].append(i);
+    for (int i = 0; i < 20; ++i)
+        value["object"]["key" + std::to_string(i)] = i;
+    value["empty"]["array"] = Json::arrayValue;
+    value["empty"]["object"] = Json::objectValue;
+    return value;
+}
+
+TEST(BinaryJsonTest, roundTrip)
+{
+    auto value = sample();
+    for (auto type : {CT_APPLICATION_MSGPACK, CT_APPLICATION_CBOR})
+    {
+        std::string data;
+        encodeBinaryJson(value, type, data);
+        Json::Value decoded;
+        std::string err;
+        ASSERT_TRUE(decodeBinaryJson(data, type, decoded, &err)) << err;
+        EXPECT_EQ(decoded, value);
+
+        std::string text;
+        ASSERT_TRUE(binaryJsonToText(data, type, text, &err)) << err;
+        EXPECT_EQ(parse(text), value);
+
+        // Encoding the view of the text gives the same document.
+        auto view = JsonView::parse(text);
+        std::string fromView;
+        encodeBinaryJson(view, type, fromView);
+        EXPECT_EQ(fromView, data);
+    }
+}
+
+TEST(BinaryJsonTest, knownEncodings)
+{
+    Json::Value value;
+    value["a"] = 1;
+    value["b"].append(-1);
+    value["b"].append(true);
+    value["b"].append(Json::Value());
+    std::string msgpack;
+    encodeBinaryJson(value, CT_APPLICATION_MSGPACK, msgpack);
+    EXPECT_EQ(msgpack, std::string("\x82\xa1\x61\x01\xa1\x62\x93\xff\xc3\xc0"));
+    std::string cbor;
+    encodeBinaryJson(value, CT_APPLICATION_CBOR, cbor);
+    EXPECT_EQ(cbor, std::string("\xa2\x61\x61\x01\x61\x62\x83\x20\xf5\xf6"));
+}
+
+TEST(BinaryJsonTest, cborExtensions)
+{
+    // Indefinite lengths, a tag, a half float, a byte string, an integer key
+    // and undefined.
+    std::string data("\xbf\x61\x61\x9f\x01\xf9\x3c\x00\xff\x01\xc1\x1a\x00\x00"
+                     "\x00\x02\x62\x62\x73\x7f\x61\x78\x61\x79\xff\x63\x62\x69"
+                     "\x6e\x42\x01\x02\x61\x75\xf7\xff",
+                     36);
+    Json::Value value;
+    std::string err;
+    ASSERT_TRUE(decodeBinaryJson(data, CT_APPLICATION_CBOR, value, &err))
+        << err;
+    EXPECT_EQ(value["a"][0].asInt(), 1);
+    EXPECT_EQ(value["a"][1].asDouble(), 1.0);
+    EXPECT_EQ(value["1"].asInt(), 2);
+    EXPECT_EQ(value["bs"].asString(), "xy");
+    EXPECT_EQ(value["bin"].asString(), "\x01\x02");
+    EXPECT_TRUE(value["u"].isNull());
+}
+
+TEST(BinaryJsonTest, invalidData)
+{
+    std::vector<std::string> msgpack{"",
+                                     "\x92\x01",
+                                     "\xa5\x61\x62",
+                                     "\xc1",
+                                     "\xd4\x01\x02",
+                                     "\x81\xc0\x01",
+                                     "\x01\x02",
+                                     std::string(1001, '\x91') + "\xc0"};
+    for (auto &data : msgpack)
+    {
+        Json::Value value;
+        std::string err;
+        EXPECT_FALSE(
+            decodeBinaryJson(data, CT_APPLICATION_MSGPACK, value, &err));
+        EXPECT_FALSE(err.empty());
+    }
+    std::vector<std::string> cbor{"",
+                                  "\x82\x01",
+                                  "\x65\x61\x62",
+                                  "\x9f\x01",
+                                  "\x7f\x01\xff",
+                                  "\xa1\xf6\x01",
+                                  "\xf8\x10",
+                                  "\x1c"};
+    for (auto &data : cbor)
+    {
+        Json::Value value;
+        std::string err;
+        EXPECT_FALSE(decodeBinaryJson(data, CT_APPLICATION_CBOR, value, &err))
+            << data;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,58 @@
+#include <drogon/utils/CancellationToken.h>
+#include <gtest/gtest.h>
+#include <memory>
+using namespace drogon;
+TEST(CancellationTokenTest, cancelTest)
+{
+    auto token = std::make_shared<CancellationToken>();
+    EXPECT_FALSE(token->isCancelled());
+    int called = 0;
+    token->onCancel([&called]() { ++called; });
+    auto id = token->onCancel([&called]() { called += 10; });
+    token->removeCallback(id);
+    token->cancel();
+    EXPECT_TRUE(token->isCancelled());
+    EXPECT_EQ(1, called);
+    // Callbacks are called once, and not registered after the cancellation.
+    token->cancel();
+    EXPECT_EQ(1, called);
+    EXPECT_EQ(0U, token->onCancel([&called]() { ++called; }));
+    EXPECT_EQ(1, called);
+
+    token->reset();
+    EXPECT_FALSE(token->isCancelled());
+}
+
+TEST(CancellationTokenTest, deadlineTest)
+{
+    CancellationToken token;
+    EXPECT_EQ(0, token.deadline().microSecondsSinceEpoch());
+    token.setDeadline(trantor::Date::now().after(3600));
+    EXPECT_FALSE(token.isCancelled());
+    token.setDeadline(trantor::Date::now().after(-1));
+    EXPECT_TRUE(token.isCancelled());
+}
+
+TEST(CancellationTokenTest, scopeTest)
+{
+    CancellationToken outer, inner;
+    EXPECT_EQ(nullptr, CancellationToken::current());
+    {
+        CancellationToken::Scope outerScope(&outer);
+        EXPECT_EQ(&outer, CancellationToken::current());
+        {
+            CancellationToken::Scope innerScope(&inner);
+            EXPECT_EQ(&inner, CancellationToken::current());
+            CancellationToken::Scope emptyScope(nullptr);
+            EXPECT_EQ(nullptr, CancellationToken::current());
+        }
+        EXPECT_EQ(&outer, CancellationToken::current());
+    }
+    EXPECT_EQ(nullptr, CancellationToken::current());
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
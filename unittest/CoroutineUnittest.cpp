@@ -0,0 +1,64 @@
+#include <drogon/utils/coroutine.h>
+#include <gtest/gtest.h>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#ifdef __cpp_impl_coroutine
+using namespace drogon;
+TEST(CoroutineTest, synchronousCompletionTest)
+{
+    // The results set before await_suspend() returns must not resume the
+    // coroutine recursively, the stack would overflow.
+    std::promise<int> result;
+    [](std::promise<int> &result) -> AsyncTask {
+        int sum = 0;
+        for (int i = 0; i < 1000000; ++i)
+        {
+            sum += co_await internal::makeCallbackAwaiter<int>(
+                [](CallbackAwaiter<int> &awaiter) { awaiter.setValue(1); });
+        }
+        result.set_value(sum);
+    }(result);
+    EXPECT_EQ(1000000, result.get_future().get());
+}
+
+TEST(CoroutineTest, synchronousExceptionTest)
+{
+    std::promise<bool> result;
+    [](std::promise<bool> &result) -> AsyncTask {
+        try
+        {
+            co_await internal::makeCallbackAwaiter<void>(
+                [](CallbackAwaiter<void> &awaiter) {
+                    awaiter.setException(std::make_exception_ptr(
+                        std::runtime_error("failed")));
+                });
+            result.set_value(false);
+        }
+        catch (const std::runtime_error &)
+        {
+            result.set_value(true);
+        }
+    }(result);
+    EXPECT_TRUE(result.get_future().get());
+}
+
+TEST(CoroutineTest, asynchronousCompletionTest)
+{
+    std::promise<int> result;
+    [](std::promise<int> &result) -> AsyncTask {
+        auto value = co_await internal::makeCallbackAwaiter<int>(
+            [](CallbackAwaiter<int> &awaiter) {
+                std::thread([&awaiter]() { awaiter.setValue(42); }).detach();
+            });
+        result.set_value(value);
+    }(result);
+    EXPECT_EQ(42, result.get_future().get());
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,130 @@
+#include <drogon/utils/JsonBinding.h>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace api
+{
+struct Address
+{
+    std::string city;
+    uint16_t zip{0};
+};
+DROGON_JSON_FIELDS(Address, city, zip)
+
+struct User
+{
+    int64_t id{0};
+    std::string name;
+    bool admin{false};
+    double score{0};
+    std::vector<std::string> tags;
+    std::shared_ptr<Address> address;
+    std::map<std::string, int> counters;
+    Json::Value extra;
+};
+DROGON_JSON_FIELDS(User, id, name, admin, score, tags, address, counters, extra)
+}  // namespace api
+
+// A class which writes itself, like the ORM models.
+struct Model
+{
+    void appendJson(std::string &output) const
+    {
+        output.append("{\"model\":true}");
+    }
+};
+
+static Json::Value parse(const std::string &text)
+{
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    std::string errs;
+    EXPECT_TRUE(
+        reader->parse(text.data(), text.data() + text.size(), &root, &errs));
+    return root;
+}
+
+static api::User makeUser()
+{
+    api::User user;
+    user.id = -42;
+    user.name = "an \"tao\"\n\xe4\xbd\xa0";
+    user.admin = true;
+    user.score = 0.1;
+    user.tags = {"a", "b"};
+    user.address = std::make_shared<api::Address>();
+    user.address->city = "Shanghai";
+    user.address->zip = 65535;
+    user.counters["x"] = 1;
+    user.extra["k"] = Json::arrayValue;
+    return user;
+}
+
+TEST(JsonBindingTest, write)
+{
+    auto user = makeUser();
+    auto text = drogon::toJsonString(user);
+    EXPECT_EQ(text,
+              "{\"id\":-42,\"name\":\"an \\\"tao\\\"\\n\\u4f60\",\"admin\":true,"
+              "\"score\":0.10000000000000001,\"tags\":[\"a\",\"b\"],"
+              "\"address\":{\"city\":\"Shanghai\",\"zip\":65535},"
+              "\"counters\":{\"x\":1},\"extra\":{\"k\":[]}}");
+    user.address.reset();
+    auto json = parse(drogon::toJsonString(user));
+    EXPECT_TRUE(json["address"].isNull());
+    EXPECT_EQ(drogon::toJsonString(std::vector<Model>(2)),
+              "[{\"model\":true},{\"model\":true}]");
+    EXPECT_EQ(drogon::toJsonString(std::vector<api::Address>()), "[]");
+}
+
+TEST(JsonBindingTest, roundTrip)
+{
+    auto user = makeUser();
+    auto text = drogon::toJsonString(user);
+    api::User decoded;
+    ASSERT_TRUE(drogon::fromJson(drogon::JsonView::parse(text), decoded));
+    EXPECT_EQ(decoded.id, user.id);
+    EXPECT_EQ(decoded.name, user.name);
+    EXPECT_EQ(decoded.admin, user.admin);
+    EXPECT_EQ(decoded.score, user.score);
+    EXPECT_EQ(decoded.tags, user.tags);
+    ASSERT_TRUE(decoded.address);
+    EXPECT_EQ(decoded.address->city, "Shanghai");
+    EXPECT_EQ(decoded.address->zip, 65535);
+    EXPECT_EQ(decoded.counters, user.counters);
+    EXPECT_EQ(decoded.extra, user.extra);
+    EXPECT_EQ(drogon::toJsonString(decoded), text);
+}
+
+TEST(JsonBindingTest, read)
+{
+    api::User user;
+    std::string text = "{\"name\":\"x\",\"unknown\":[1,2],\"address\":null}";
+    ASSERT_TRUE(drogon::fromJson(drogon::JsonView::parse(text), user));
+    EXPECT_EQ(user.name, "x");
+    EXPECT_EQ(user.id, 0);
+    EXPECT_FALSE(user.address);
+
+    std::vector<std::string> mismatches{"[]",
+                                        "{\"id\":\"1\"}",
+                                        "{\"admin\":1}",
+                                        "{\"tags\":[\"a\",1]}",
+                                        "{\"address\":{\"zip\":65536}}",
+                                        "{\"address\":{\"zip\":-1}}",
+                                        "{\"counters\":{\"x\":true}}"};
+    for (auto &mismatch : mismatches)
+    {
+        api::User u;
+        EXPECT_FALSE(drogon::fromJson(drogon::JsonView::parse(mismatch), u))
+            << mismatch;
+    }
+    api::User u;
+    EXPECT_FALSE(drogon::fromJson(drogon::JsonView::parse("{bad"), u));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
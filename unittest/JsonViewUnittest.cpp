@@ -0,0 +1,164 @@
+#include <drogon/utils/JsonView.h>
+#include <gtest/gtest.h>
+#include <limits>
+#include <memory>
+#include <string>
+
+using namespace drogon;
+
+static Json::Value parseByJsoncpp(const std::string &text)
+{
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    std::string errs;
+    EXPECT_TRUE(
+        reader->parse(text.data(), text.data() + text.size(), &root, &errs));
+    return root;
+}
+
+TEST(JsonViewTest, sameAsJsoncpp)
+{
+    std::vector<std::string> texts{
+        "null",
+        "true",
+        " false ",
+        "0",
+        "-0",
+        "123",
+        "-9223372036854775808",
+        "9223372036854775807",
+        "9223372036854775808",
+        "18446744073709551615",
+        "18446744073709551616",
+        "-9223372036854775809",
+        "0.1",
+        "-2.5e-300",
+        "1E10",
+        "\"\"",
+        "\"Hello, World!\"",
+        "\"a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\"",
+        "\"\\u4f60\\u597d \\ud83d\\ude00 \\u00e9\"",
+        "\"\xe4\xbd\xa0\xe5\xa5\xbd, this is a long string without escapes\"",
+        "[]",
+        "{}",
+        "[1, [2, [3, []]], {\"a\": {}}]",
+        "{\"id\": 1, \"name\": \"drogon\", \"tags\": [\"web\", \"c++\"], "
+        "\"nested\": {\"k\\u0065y\": [true, false, null]}, \"ratio\": 0.5}"};
+    for (auto &text : texts)
+    {
+        std::string err;
+        auto view = JsonView::parse(text, &err);
+        EXPECT_TRUE(view.isValid()) << text << ": " << err;
+        EXPECT_EQ(view.toJsonValue(), parseByJsoncpp(text)) << text;
+    }
+}
+
+TEST(JsonViewTest, invalidTexts)
+{
+    std::vector<std::string> texts{"",
+                                   "   ",
+                                   "nul",
+                                   "truex",
+                                   "01",
+                                   "1.",
+                                   "-",
+                                   "1e",
+                                   ".5",
+                                   "\"unterminated",
+                                   "\"bad \\x escape\"",
+                                   "\"bad \\u12G4\"",
+                                   "\"control \x01 char\"",
+                                   "[1,]",
+                                   "[1 2]",
+                                   "{\"a\" 1}",
+                                   "{\"a\":1,}",
+                                   "{1:2}",
+                                   "[1}",
+                                   "{\"a\":1]",
+                                   "[[]",
+                                   "[] []",
+                                   std::string(1001, '[') +
+                                       std::string(1001, ']')};
+    for (auto &text : texts)
+    {
+        std::string err;
+        auto view = JsonView::parse(text, &err);
+        EXPECT_FALSE(view.isValid()) << text;
+        EXPECT_FALSE(err.empty()) << text;
+    }
+    auto deep = std::string(1000, '[') + std::string(1000, ']');
+    EXPECT_TRUE(JsonView::parse(deep).isValid());
+}
+
+TEST(JsonViewTest, access)
+{
+    std::string text =
+        "{\"user\": {\"id\": 42, \"name\": \"an\\ttao\", \"admin\": true},"
+        " \"items\": [1, {\"x\": [2, 3]}, \"4\", 5.5], \"esc\\u0061ped\": -7}";
+    auto root = JsonView::parse(text);
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(root.size(), 3);
+    EXPECT_EQ(root["user"]["id"].asInt64(), 42);
+    EXPECT_EQ(root["user"]["name"].asString(), "an\ttao");
+    EXPECT_TRUE(root["user"]["admin"].asBool());
+    EXPECT_EQ(root["user"]["id"].raw(), "42");
+    EXPECT_EQ(root["items"].size(), 4);
+    EXPECT_EQ(root["items"][1]["x"][1].asUInt64(), 3);
+    EXPECT_EQ(root["items"][2].asString(), "4");
+    EXPECT_DOUBLE_EQ(root["items"][3].asDouble(), 5.5);
+    EXPECT_EQ(root["items"][3].asInt64(), 5);
+    EXPECT_EQ(root["escaped"].asInt64(), -7);
+    EXPECT_EQ(root["escaped"].asUInt64(), 0);
+
+    // Missing values and wrong types give invalid views and default values.
+    EXPECT_FALSE(root["missing"].isValid());
+    EXPECT_FALSE(root["missing"]["id"][0].isValid());
+    EXPECT_FALSE(root["items"][4].isValid());
+    EXPECT_FALSE(root["items"][-1].isValid());
+    EXPECT_FALSE(root[0].isValid());
+    EXPECT_FALSE(root["items"]["x"].isValid());
+    EXPECT_EQ(root["user"].asInt64(), 0);
+    EXPECT_EQ(root["user"]["id"].asString(), "");
+
+    std::vector<std::string> keys;
+    root.forEachMember(
+        [&keys](const std::string &key, const JsonView &) {
+            keys.push_back(key);
+        });
+    EXPECT_EQ(keys,
+              (std::vector<std::string>{"user", "items", "escaped"}));
+    int64_t sum = 0;
+    root["items"][1]["x"].forEachElement(
+        [&sum](const JsonView &value) { sum += value.asInt64(); });
+    EXPECT_EQ(sum, 5);
+}
+
+TEST(JsonViewTest, largeArray)
+{
+    std::string text = "[";
+    for (int i = 0; i < 10000; ++i)
+    {
+        if (i > 0)
+            text.append(",");
+        text.append("{\"id\":")
+            .append(std::to_string(i))
+            .append(",\"name\":\"record with a rather long name ")
+            .append(std::to_string(i))
+            .append("\"}");
+    }
+    text.append("]");
+    auto root = JsonView::parse(text);
+    ASSERT_TRUE(root.isArray());
+    EXPECT_EQ(root.size(), 10000);
+    EXPECT_EQ(root[9999]["id"].asInt64(), 9999);
+    EXPECT_EQ(root[5000]["name"].asString(),
+              "record with a rather long name 5000");
+    EXPECT_EQ(root.toJsonValue(), parseByJsoncpp(text));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,102 @@
+#include "../lib/src/JsonWriter.h"
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+#include <string>
+#include <string.h>
+
+static std::string writeByJsoncpp(const Json::Value &value)
+{
+    Json::StreamWriterBuilder builder;
+    builder["commentStyle"] = "None";
+    builder["indentation"] = "";
+    return Json::writeString(builder, value);
+}
+
+TEST(JsonWriterTest, scalars)
+{
+    std::vector<Json::Value> values{
+        Json::Value(),
+        Json::Value(true),
+        Json::Value(false),
+        Json::Value(0),
+        Json::Value(-1),
+        Json::Value(std::numeric_limits<Json::Int64>::min()),
+        Json::Value(std::numeric_limits<Json::Int64>::max()),
+        Json::Value(std::numeric_limits<Json::UInt64>::max()),
+        Json::Value(0.1),
+        Json::Value(1.0),
+        Json::Value(-2.5e-300),
+        Json::Value(1e300),
+        Json::Value(std::numeric_limits<double>::quiet_NaN()),
+        Json::Value(std::numeric_limits<double>::infinity()),
+        Json::Value(-std::numeric_limits<double>::infinity()),
+        Json::Value(""),
+        Json::Value("Hello, World!"),
+        Json::Value("\"quoted\" \\ / \b\f\n\r\t \x01\x1f\x7f"),
+        Json::Value("\xe4\xbd\xa0\xe5\xa5\xbd \xf0\x9f\x98\x80 \xc3\xa9"),
+        Json::Value("bad \xc3 \xe4\xbd \xff \xed\xa0\x80 \xc0\x80"),
+        Json::Value(std::string("embedded\0null", 13)),
+        Json::Value(Json::arrayValue),
+        Json::Value(Json::objectValue)};
+    for (auto const &value : values)
+    {
+        EXPECT_EQ(writeByJsoncpp(value), drogon::writeJson(value));
+    }
+}
+
+TEST(JsonWriterTest, nested)
+{
+    Json::Value root;
+    root["message"] = "Hello, World!";
+    root["id"] = 42;
+    root["list"].append(1);
+    root["list"].append("two");
+    root["list"].append(3.5);
+    root["list"].append(Json::Value(Json::objectValue));
+    root["list"].append(Json::Value(Json::arrayValue));
+    root["object"]["nested"]["deep"] = Json::Value();
+    root[std::string("key\"with\nescapes", 16)] = false;
+    for (int i = 0; i < 30; ++i)
+        root["long"].append(i * 1000);
+    EXPECT_EQ(writeByJsoncpp(root), drogon::writeJson(root));
+}
+
+TEST(JsonWriterTest, randomStrings)
+{
+    std::mt19937 random(12345);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<int> length(0, 32);
+    for (int i = 0; i < 10000; ++i)
+    {
+        std::string str;
+        auto len = length(random);
+        for (int j = 0; j < len; ++j)
+            str.push_back(static_cast<char>(byte(random)));
+        Json::Value value;
+        value[str] = str;
+        ASSERT_EQ(writeByJsoncpp(value), drogon::writeJson(value));
+    }
+}
+
+TEST(JsonWriterTest, randomNumbers)
+{
+    std::mt19937_64 random(12345);
+    for (int i = 0; i < 10000; ++i)
+    {
+        auto bits = random();
+        double real;
+        memcpy(&real, &bits, sizeof(real));
+        Json::Value value;
+        value.append(real);
+        value.append(static_cast<Json::Int64>(bits));
+        value.append(static_cast<Json::UInt64>(bits >> (i % 64)));
+        ASSERT_EQ(writeByJsoncpp(value), drogon::writeJson(value));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,39 @@
+#include <drogon/utils/LatencyHistogram.h>
+#include <gtest/gtest.h>
+#include <chrono>
+using namespace drogon;
+TEST(LatencyHistogramTest, emptyTest)
+{
+    LatencyHistogram histogram;
+    auto summary = histogram.summary();
+    EXPECT_EQ(0, summary.count_);
+    EXPECT_EQ(0.0, summary.p99_);
+}
+TEST(LatencyHistogramTest, bucketTest)
+{
+    for (size_t i = 1; i < LatencyHistogram::bucketsNumber; ++i)
+    {
+        EXPECT_LT(LatencyHistogram::bucketUpperBound(i - 1),
+                  LatencyHistogram::bucketUpperBound(i));
+    }
+}
+TEST(LatencyHistogramTest, percentileTest)
+{
+    LatencyHistogram histogram;
+    for (uint64_t i = 1; i <= 1000; ++i)
+        histogram.record(std::chrono::microseconds(i * 10));
+    auto summary = histogram.summary();
+    EXPECT_EQ(1000, summary.count_);
+    EXPECT_DOUBLE_EQ(0.01, summary.max_);
+    // The relative error of a percentile is less than 25%
+    EXPECT_GE(summary.p50_, 0.005);
+    EXPECT_LT(summary.p50_, 0.005 * 1.25);
+    EXPECT_GE(summary.p99_, 0.0099);
+    EXPECT_LE(summary.p99_, 0.01);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,156 @@
+#include "../lib/src/RequestTimings.h"
+#include <drogon/utils/Metrics.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+using namespace drogon;
+TEST(MetricsTest, counterTest)
+{
+    MetricCounter counter;
+    EXPECT_EQ(0, counter.value());
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i)
+    {
+        threads.emplace_back([&counter]() {
+            for (int j = 0; j < 100000; ++j)
+                counter.add();
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_EQ(800000, counter.value());
+}
+TEST(MetricsTest, sharedSlotTest)
+{
+    // More threads than slots, some of them share the last slot.
+    MetricCounter counter;
+    MetricGauge gauge;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < internal::metricsSlotsNumber * 2; ++i)
+    {
+        threads.emplace_back([&counter, &gauge]() {
+            for (int j = 0; j < 1000; ++j)
+            {
+                counter.add(2);
+                gauge.add();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_EQ(internal::metricsSlotsNumber * 4000, counter.value());
+    EXPECT_EQ((int64_t)internal::metricsSlotsNumber * 2000, gauge.value());
+}
+TEST(MetricsTest, gaugeTest)
+{
+    MetricGauge gauge;
+    gauge.add(5);
+    std::thread([&gauge]() { gauge.sub(3); }).join();
+    EXPECT_EQ(2, gauge.value());
+    gauge.sub(4);
+    EXPECT_EQ(-2, gauge.value());
+}
+TEST(MetricsTest, histogramTest)
+{
+    MetricHistogram histogram;
+    histogram.record(std::chrono::microseconds(100));
+    histogram.record(std::chrono::milliseconds(3));
+    histogram.record(std::chrono::milliseconds(20));
+    histogram.record(std::chrono::seconds(30));
+    EXPECT_EQ(4, histogram.count());
+    EXPECT_NEAR(30.0231, histogram.sum(), 1e-9);
+    auto counts = histogram.cumulativeCounts({0.001, 0.01, 0.1, 1});
+    ASSERT_EQ(5, counts.size());
+    EXPECT_EQ(1, counts[0]);
+    EXPECT_EQ(2, counts[1]);
+    EXPECT_EQ(3, counts[2]);
+    EXPECT_EQ(3, counts[3]);
+    EXPECT_EQ(4, counts[4]);
+}
+TEST(MetricsTest, registryTest)
+{
+    MetricsRegistry &registry = MetricsRegistry::instance();
+    auto get = registry.counter("test_requests_total",
+                                "Requests",
+                                {{"method", "GET"}});
+    auto post = registry.counter("test_requests_total",
+                                 "Requests",
+                                 {{"method", "POST"}});
+    EXPECT_EQ(get,
+              registry.counter("test_requests_total",
+                               "Requests",
+                               {{"method", "GET"}}));
+    EXPECT_NE(get, post);
+    EXPECT_THROW(registry.gauge("test_requests_total", "Requests"),
+                 std::invalid_argument);
+    get->add(3);
+    post->add();
+    registry.gauge("test_in_flight", "In \"flight\"\n")->add(2);
+    registry.gaugeCallback("test_size",
+                           "Size",
+                           {{"name", "a\"b\\"}},
+                           []() { return 1.5; });
+    auto histogram = registry.histogram("test_duration_seconds", "Duration");
+    histogram->record(std::chrono::microseconds(250));
+    histogram->record(std::chrono::milliseconds(2));
+    auto text = registry.toPrometheusText({0.001, 0.01});
+    EXPECT_EQ(
+        "# HELP test_duration_seconds Duration\n"
+        "# TYPE test_duration_seconds histogram\n"
+        "test_duration_seconds_bucket{le=\"0.001\"} 1\n"
+        "test_duration_seconds_bucket{le=\"0.01\"} 2\n"
+        "test_duration_seconds_bucket{le=\"+Inf\"} 2\n"
+        "test_duration_seconds_sum 0.00225\n"
+        "test_duration_seconds_count 2\n"
+        "# HELP test_in_flight In \"flight\"\\n\n"
+        "# TYPE test_in_flight gauge\n"
+        "test_in_flight 2\n"
+        "# HELP test_requests_total Requests\n"
+        "# TYPE test_requests_total counter\n"
+        "test_requests_total{method=\"GET\"} 3\n"
+        "test_requests_total{method=\"POST\"} 1\n"
+        "# HELP test_size Size\n"
+        "# TYPE test_size gauge\n"
+        "test_size{name=\"a\\\"b\\\\\"} 1.5\n",
+        text);
+}
+
+TEST(MetricsTest, requestTimingsTest)
+{
+    RequestTimings timings;
+    timings.parseStart_ = 100;
+    timings.parsed_ = 150;
+    timings.routed_ = 160;
+    timings.handlerStart_ = 200;
+    timings.responded_ = 1200;
+    timings.serialize_ = 30;
+    int64_t durations[RequestTimings::kStagesNumber];
+    timings.stageDurations(1300, durations);
+    EXPECT_EQ(50, durations[RequestTimings::kParse]);
+    EXPECT_EQ(10, durations[RequestTimings::kQueue]);
+    EXPECT_EQ(40, durations[RequestTimings::kFilters]);
+    EXPECT_EQ(1000, durations[RequestTimings::kHandler]);
+    EXPECT_EQ(30, durations[RequestTimings::kSerialize]);
+    EXPECT_EQ(70, durations[RequestTimings::kWrite]);
+
+    // Answered by an advice before routing.
+    timings.routed_ = 0;
+    timings.handlerStart_ = 0;
+    timings.stageDurations(1300, durations);
+    EXPECT_EQ(1050, durations[RequestTimings::kQueue]);
+    EXPECT_EQ(0, durations[RequestTimings::kFilters]);
+    EXPECT_EQ(0, durations[RequestTimings::kHandler]);
+
+    // The stages which are not finished yet.
+    timings.stageDurations(1200, durations);
+    EXPECT_EQ(0, durations[RequestTimings::kSerialize]);
+    EXPECT_EQ(0, durations[RequestTimings::kWrite]);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,62 @@
+#include <drogon/utils/OStringStream.h>
+#include <gtest/gtest.h>
+#include <iomanip>
+#include <sstream>
+#include <string>
+using namespace drogon;
+TEST(OStringStreamTest, plainTest)
+{
+    OStringStream stream;
+    stream << "a" << std::string("b") << 'c' << 12 << -3 << 1.5 << true;
+    EXPECT_EQ("abc12-31.51", stream.str());
+}
+
+TEST(OStringStreamTest, manipulatorTest)
+{
+    // The state of the stream is kept between insertions like the one of a
+    // std::stringstream.
+    OStringStream stream;
+    std::stringstream expected;
+    stream << std::hex << 255 << " " << std::fixed << std::setprecision(2)
+           << 3.14159 << " " << std::setw(5) << 7 << std::setw(4) << "ab"
+           << std::dec << 255 << std::setfill('*') << std::setw(3) << 'x'
+           << std::endl;
+    expected << std::hex << 255 << " " << std::fixed << std::setprecision(2)
+             << 3.14159 << " " << std::setw(5) << 7 << std::setw(4) << "ab"
+             << std::dec << 255 << std::setfill('*') << std::setw(3) << 'x'
+             << std::endl;
+    EXPECT_EQ(expected.str(), stream.str());
+    EXPECT_EQ("ff 3.14     7  ab255**x\n", stream.str());
+}
+
+TEST(OStringStreamTest, ostreamTest)
+{
+    OStringStream stream;
+    stream << "x=";
+    std::ostream &os = stream;
+    os << std::setw(3) << 5;
+    stream << ";";
+    EXPECT_EQ("x=  5;", stream.str());
+}
+
+TEST(OStringStreamTest, sinkTest)
+{
+    std::string output;
+    OStringStream stream(
+        [&output](const char *data, size_t length) {
+            output.append(data, length);
+        },
+        4);
+    stream << "ab" << std::hex << 255;
+    EXPECT_EQ("abff", output);
+    EXPECT_TRUE(stream.str().empty());
+    stream << 1;
+    stream.flush();
+    EXPECT_EQ("abff1", output);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+#include <drogon/utils/Tracing.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace drogon;
+TEST(TracingTest, traceparentTest)
+{
+    TraceContext context;
+    EXPECT_TRUE(context.parseTraceparent(
+        "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"));
+    EXPECT_EQ(0x4bf92f3577b34da6ULL, context.traceIdHigh_);
+    EXPECT_EQ(0xa3ce929d0e0e4736ULL, context.traceIdLow_);
+    EXPECT_EQ(0x00f067aa0ba902b7ULL, context.parentSpanId_);
+    EXPECT_TRUE(context.sampled_);
+    EXPECT_EQ("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01",
+              context.toTraceparent());
+    context.spanId_ = 0x1234;
+    context.sampled_ = false;
+    EXPECT_EQ("00-4bf92f3577b34da6a3ce929d0e0e4736-0000000000001234-00",
+              context.toTraceparent());
+
+    // Malformed or invalid values are rejected.
+    TraceContext other;
+    EXPECT_FALSE(other.parseTraceparent(
+        "00-00000000000000000000000000000000-00f067aa0ba902b7-01"));
+    EXPECT_FALSE(other.parseTraceparent(
+        "00-4bf92f3577b34da6a3ce929d0e0e4736-0000000000000000-01"));
+    EXPECT_FALSE(other.parseTraceparent(
+        "00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01"));
+    EXPECT_FALSE(other.parseTraceparent(
+        "ff-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"));
+    EXPECT_FALSE(other.parseTraceparent(
+        "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-x"));
+    EXPECT_FALSE(other.valid());
+    // Future versions may append fields.
+    EXPECT_TRUE(other.parseTraceparent(
+        "01-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00-x"));
+    EXPECT_FALSE(other.sampled_);
+}
+TEST(TracingTest, samplingTest)
+{
+    auto &tracer = Tracer::instance();
+    TraceContext context;
+    // An unsampled parent is followed without a new span.
+    tracer.startTrace("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00",
+                      context);
+    EXPECT_TRUE(context.valid());
+    EXPECT_FALSE(context.sampled_);
+    EXPECT_EQ(0U, context.spanId_);
+
+    tracer.setSampleRate(0);
+    tracer.startTrace("", context);
+    EXPECT_FALSE(context.valid());
+    tracer.setSampleRate(1);
+    tracer.startTrace("malformed", context);
+    EXPECT_TRUE(context.valid());
+    EXPECT_TRUE(context.sampled_);
+    EXPECT_NE(0U, context.spanId_);
+    tracer.setSampleRate(0);
+}
+TEST(TracingTest, recordTest)
+{
+    auto &tracer = Tracer::instance();
+    std::vector<SpanData> spans;
+    tracer.drain(spans, 100000);
+    spans.clear();
+
+    TraceContext context;
+    tracer.setSampleRate(1);
+    tracer.startTrace("", context);
+    tracer.setSampleRate(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&context]() {
+            Tracer::ContextScope scope(context);
+            for (int j = 0; j < 100; ++j)
+            {
+                TracedCall call("sql", "select 1");
+                EXPECT_EQ(context.spanId_, call.context().parentSpanId_);
+                EXPECT_EQ(context.spanId_, call.finish(0).spanId_);
+                // A call is recorded once.
+                call.finish(1);
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_FALSE(Tracer::currentContext().valid());
+    // The rings of the exited threads are drained.
+    EXPECT_EQ(400U, tracer.drain(spans, 100000));
+    for (auto &span : spans)
+    {
+        EXPECT_EQ(context.traceIdLow_, span.traceIdLow_);
+        EXPECT_EQ(context.spanId_, span.parentSpanId_);
+        EXPECT_EQ(std::string("select 1"), span.detail_);
+        EXPECT_EQ(0, span.status_);
+    }
+    spans.clear();
+    EXPECT_EQ(0U, tracer.drain(spans, 100000));
+
+    // Calls outside of sampled traces are not recorded.
+    TracedCall call("http.client", "GET /");
+    call.finish(200);
+    EXPECT_EQ(0U, tracer.drain(spans, 100000));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
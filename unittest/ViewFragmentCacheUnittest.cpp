@@ -0,0 +1,63 @@
+#include <drogon/ViewFragmentCache.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+using namespace drogon;
+TEST(ViewFragmentCacheTest, putAndGet)
+{
+    auto &cache = ViewFragmentCache::instance();
+    cache.clear();
+    EXPECT_EQ(nullptr, cache.get("nav"));
+    cache.put("nav", "<nav></nav>", 0);
+    auto fragment = cache.get("nav");
+    ASSERT_NE(nullptr, fragment);
+    EXPECT_EQ("<nav></nav>", *fragment);
+    cache.put("nav", "<nav>new</nav>", 0);
+    EXPECT_EQ("<nav>new</nav>", *cache.get("nav"));
+}
+TEST(ViewFragmentCacheTest, timeout)
+{
+    auto &cache = ViewFragmentCache::instance();
+    cache.clear();
+    cache.put("footer", "<footer></footer>", 0.01);
+    EXPECT_NE(nullptr, cache.get("footer"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(nullptr, cache.get("footer"));
+    EXPECT_EQ(0, cache.size());
+}
+TEST(ViewFragmentCacheTest, invalidate)
+{
+    auto &cache = ViewFragmentCache::instance();
+    cache.clear();
+    cache.put("product:1:card", "1", 0);
+    cache.put("product:2:card", "2", 0);
+    cache.put("menu", "menu", 0);
+    cache.invalidate("menu");
+    EXPECT_EQ(nullptr, cache.get("menu"));
+    cache.invalidatePrefix("product:1:");
+    EXPECT_EQ(nullptr, cache.get("product:1:card"));
+    EXPECT_NE(nullptr, cache.get("product:2:card"));
+}
+TEST(ViewFragmentCacheTest, capacity)
+{
+    auto &cache = ViewFragmentCache::instance();
+    cache.clear();
+    cache.setCapacity(64 * 1024);
+    for (int i = 0; i < 1000; ++i)
+        cache.put("card" + std::to_string(i), std::string(1000, 'x'), 0);
+    EXPECT_LE(cache.size(), 64 * 1024);
+    // The most recently used fragments are kept.
+    EXPECT_NE(nullptr, cache.get("card999"));
+    EXPECT_EQ(nullptr, cache.get("card0"));
+    // A fragment larger than the capacity isn't cached but is returned.
+    auto fragment = cache.put("large", std::string(64 * 1024, 'x'), 0);
+    EXPECT_EQ(64 * 1024, fragment->length());
+    EXPECT_EQ(nullptr, cache.get("large"));
+    cache.setCapacity(32 * 1024 * 1024);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}